@@ -58,6 +58,24 @@ void kirana::Application::onScrollInput(double xOffset, double yOffset)
     m_inputManager.m_callScrollEvent(xOffset, yOffset);
 }
 
+void kirana::Application::onSceneLoadProgress(
+    const scene::SceneLoadProgress &progress)
+{
+    if (progress.stage == scene::SceneLoadStage::FINISHED)
+    {
+        m_logger.log(constants::LOG_CHANNEL_APPLICATION,
+                     utils::LogSeverity::debug,
+                     "Loaded default scene: " + m_sceneManager.getViewportScene()
+                                                    .getCurrentScene()
+                                                    .getName());
+    }
+    else if (progress.stage == scene::SceneLoadStage::FAILED)
+    {
+        m_logger.log(constants::LOG_CHANNEL_APPLICATION,
+                     utils::LogSeverity::error, "Failed to load default scene");
+    }
+}
+
 kirana::Application::Application()
     : m_logger{kirana::utils::Logger::get()},
       m_inputManager{utils::input::InputManager::get()},
@@ -119,17 +137,12 @@ void kirana::Application::init()
     m_viewport.init(m_viewportWindow.get(), scene);
     m_isViewportRunning = true;
 
-    if (m_sceneManager.loadScene())
-    {
-        m_logger.log(
-            constants::LOG_CHANNEL_APPLICATION, utils::LogSeverity::debug,
-            "Loaded default scene: " + scene.getCurrentScene().getName());
-    }
-    else
-    {
-        m_logger.log(constants::LOG_CHANNEL_APPLICATION,
-                     utils::LogSeverity::error, "Failed to load default scene");
-    }
+    // The scene is loaded in the background, while the viewport keeps
+    // rendering.
+    m_sceneLoadProgressListener =
+        m_sceneManager.addOnSceneLoadProgressEventListener(
+            std::bind(&Application::onSceneLoadProgress, this, _1));
+    m_sceneManager.loadSceneAsync();
 
     m_isRunning = true;
     m_logger.log(constants::LOG_CHANNEL_APPLICATION, utils::LogSeverity::trace,
@@ -173,6 +186,8 @@ void kirana::Application::clean()
     m_windowManager.removeOnScrollInputEventListener(m_scrollInputListener);
     m_windowManager.clean();
 
+    m_sceneManager.removeOnSceneLoadProgressEventListener(
+        m_sceneLoadProgressListener);
     m_sceneManager.clean();
 
     m_isRunning = false;
@@ -15,6 +15,7 @@ namespace kirana
 namespace scene
 {
 class SceneManager;
+struct SceneLoadProgress;
 }
 
 using viewport::Viewport;
@@ -57,6 +58,8 @@ class Application
     uint32_t m_keyboardInputListener = std::numeric_limits<unsigned int>::max();
     uint32_t m_mouseInputListener = std::numeric_limits<unsigned int>::max();
     uint32_t m_scrollInputListener = std::numeric_limits<unsigned int>::max();
+    uint32_t m_sceneLoadProgressListener =
+        std::numeric_limits<unsigned int>::max();
     WindowManager m_windowManager;
 
     InputManager &m_inputManager;
@@ -96,6 +99,11 @@ class Application
      * @param yOffset offset value in Y-axis. (Mouse scroll).
      */
     void onScrollInput(double xOffset, double yOffset);
+    /**
+     * Used as a callback function for scene load progress event.
+     * @param progress The current stage and its progress.
+     */
+    void onSceneLoadProgress(const scene::SceneLoadProgress &progress);
 
     /**
      * Loads the default scene into m_currentScene object.
@@ -64,6 +64,12 @@ class Bounds3
     {
         return getSize() * 0.5f;
     }
+    [[nodiscard]] inline float getSurfaceArea() const
+    {
+        const Vector3 size = getSize();
+        return 2.0f * (size[0] * size[1] + size[1] * size[2] +
+                       size[2] * size[0]);
+    }
 
     /**
      * Returns the position of the corner of bounding-box.
@@ -0,0 +1,255 @@
+#include "bounds3_array.hpp"
+
+#include "math_utils.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace simd = kirana::math::simd;
+
+namespace
+{
+// Ensures robustness of the far distances. (Refer PBRT book, Section 3.9.2)
+const float FAR_DISTANCE_SCALE = 1.0f + 2.0f * kirana::math::gammaf(3);
+} // namespace
+
+kirana::math::SlabRay::SlabRay(const Ray &ray)
+    : maxDistance{ray.getMaxDistance()}
+{
+    const Vector3 rayOrigin = ray.getOrigin();
+    const Vector3 rayDirection = ray.getDirection();
+    for (int i = 0; i < 3; i++)
+    {
+        const float inverse = 1.0f / rayDirection[i];
+        origin[i] = simd::splat(rayOrigin[i]);
+        inverseDirection[i] = simd::splat(inverse);
+        isDirectionNegative[i] = inverse < 0.0f;
+    }
+}
+
+kirana::math::Bounds3Array::Bounds3Array(const std::vector<Bounds3> &bounds)
+{
+    reserve(bounds.size());
+    for (const auto &b : bounds)
+        add(b);
+}
+
+void kirana::math::Bounds3Array::clear()
+{
+    for (int i = 0; i < 3; i++)
+    {
+        m_min[i].clear();
+        m_max[i].clear();
+    }
+    m_size = 0;
+}
+
+void kirana::math::Bounds3Array::reserve(size_t size)
+{
+    const size_t paddedSize = (size + WIDTH - 1) / WIDTH * WIDTH;
+    for (int i = 0; i < 3; i++)
+    {
+        m_min[i].reserve(paddedSize);
+        m_max[i].reserve(paddedSize);
+    }
+}
+
+void kirana::math::Bounds3Array::add(const Bounds3 &bounds)
+{
+    if (m_size % WIDTH == 0)
+    {
+        // Empty boxes are inverted, so no ray enters them before leaving.
+        for (int i = 0; i < 3; i++)
+        {
+            m_min[i].resize(m_size + WIDTH, std::numeric_limits<float>::max());
+            m_max[i].resize(m_size + WIDTH,
+                            std::numeric_limits<float>::lowest());
+        }
+    }
+    set(m_size++, bounds);
+}
+
+void kirana::math::Bounds3Array::set(size_t index, const Bounds3 &bounds)
+{
+    const Vector3 min = bounds.getMin();
+    const Vector3 max = bounds.getMax();
+    for (int i = 0; i < 3; i++)
+    {
+        m_min[i][index] = min[i];
+        m_max[i][index] = max[i];
+    }
+}
+
+void kirana::math::Bounds3Array::append(const Bounds3Array &array)
+{
+    // The padding of this array is replaced by the boxes of the other one,
+    // and the padding after them is resized to the new size.
+    const size_t size = m_size + array.m_size;
+    const size_t paddedSize = (size + WIDTH - 1) / WIDTH * WIDTH;
+    for (int i = 0; i < 3; i++)
+    {
+        m_min[i].resize(m_size);
+        m_min[i].insert(m_min[i].end(), array.m_min[i].begin(),
+                        array.m_min[i].end());
+        m_min[i].resize(paddedSize, std::numeric_limits<float>::max());
+        m_max[i].resize(m_size);
+        m_max[i].insert(m_max[i].end(), array.m_max[i].begin(),
+                        array.m_max[i].end());
+        m_max[i].resize(paddedSize, std::numeric_limits<float>::lowest());
+    }
+    m_size = size;
+}
+
+kirana::math::Bounds3 kirana::math::Bounds3Array::get(size_t index) const
+{
+    return Bounds3(Vector3(m_min[0][index], m_min[1][index], m_min[2][index]),
+                   Vector3(m_max[0][index], m_max[1][index], m_max[2][index]));
+}
+
+int kirana::math::Bounds3Array::intersect(size_t first, const SlabRay &ray,
+                                          float maxDistance,
+                                          float distances[WIDTH]) const
+{
+    // Slab test, with the entry and exit planes picked by the direction of
+    // the ray. Refer: Section 3.1.2, PBRT 3rd Edition, by Matt Pharr
+    simd::Float4 tEnter = simd::splat(0.0f);
+    simd::Float4 tExit = simd::splat(maxDistance);
+    for (int i = 0; i < 3; i++)
+    {
+        const float *nearPlanes =
+            ray.isDirectionNegative[i] ? m_max[i].data() : m_min[i].data();
+        const float *farPlanes =
+            ray.isDirectionNegative[i] ? m_min[i].data() : m_max[i].data();
+        const simd::Float4 tNear =
+            simd::mul(simd::sub(simd::load(nearPlanes + first), ray.origin[i]),
+                      ray.inverseDirection[i]);
+        const simd::Float4 tFar = simd::mul(
+            simd::mul(simd::sub(simd::load(farPlanes + first), ray.origin[i]),
+                      ray.inverseDirection[i]),
+            simd::splat(FAR_DISTANCE_SCALE));
+        // A ray lying in a slab plane gives NaN distances, which min() and
+        // max() ignore when passed as the first operand.
+        tEnter = simd::max(tNear, tEnter);
+        tExit = simd::min(tFar, tExit);
+    }
+    simd::store(distances, tEnter);
+    return simd::moveMask(simd::lessEqual(tEnter, tExit));
+}
+
+uint32_t kirana::math::Bounds3Array::intersectNearest(const Ray &ray,
+                                                      float *distance) const
+{
+    return intersectNearest(SlabRay(ray), distance);
+}
+
+uint32_t kirana::math::Bounds3Array::intersectNearest(const SlabRay &ray,
+                                                      float *distance) const
+{
+    uint32_t nearest = INVALID_INDEX;
+    float nearestDistance = ray.maxDistance;
+    float distances[WIDTH];
+    for (size_t first = 0; first < m_size; first += WIDTH)
+    {
+        // Boxes beyond the nearest one so far are culled by the test.
+        int mask = intersect(first, ray, nearestDistance, distances);
+        for (size_t i = 0; mask != 0; i++, mask >>= 1)
+        {
+            if ((mask & 1) != 0 && (nearest == INVALID_INDEX ||
+                                    distances[i] < nearestDistance))
+            {
+                nearest = static_cast<uint32_t>(first + i);
+                nearestDistance = distances[i];
+            }
+        }
+    }
+    if (nearest != INVALID_INDEX && distance != nullptr)
+        *distance = nearestDistance;
+    return nearest;
+}
+
+void kirana::math::Bounds3Array::intersectNearest(const Ray *rays,
+                                                  size_t rayCount,
+                                                  uint32_t *indices,
+                                                  float *distances) const
+{
+    const simd::Float4 zero = simd::splat(0.0f);
+    const simd::Float4 farScale = simd::splat(FAR_DISTANCE_SCALE);
+    for (size_t first = 0; first < rayCount; first += WIDTH)
+    {
+        // Each lane is a ray. Lanes past the last ray repeat it.
+        const size_t count = std::min(WIDTH, rayCount - first);
+        float values[3][2][WIDTH];
+        float nearestDistances[WIDTH];
+        uint32_t nearest[WIDTH];
+        for (size_t r = 0; r < WIDTH; r++)
+        {
+            const Ray &ray = rays[first + std::min(r, count - 1)];
+            const Vector3 origin = ray.getOrigin();
+            const Vector3 direction = ray.getDirection();
+            for (int i = 0; i < 3; i++)
+            {
+                values[i][0][r] = origin[i];
+                values[i][1][r] = 1.0f / direction[i];
+            }
+            nearestDistances[r] = ray.getMaxDistance();
+            nearest[r] = INVALID_INDEX;
+        }
+        simd::Float4 origin[3];
+        simd::Float4 inverseDirection[3];
+        simd::Float4 isDirectionNegative[3];
+        for (int i = 0; i < 3; i++)
+        {
+            origin[i] = simd::load(values[i][0]);
+            inverseDirection[i] = simd::load(values[i][1]);
+            isDirectionNegative[i] = simd::lessEqual(inverseDirection[i], zero);
+        }
+
+        simd::Float4 nearestDistance = simd::load(nearestDistances);
+        for (size_t b = 0; b < m_size; b++)
+        {
+            simd::Float4 tEnter = zero;
+            simd::Float4 tExit = nearestDistance;
+            for (int i = 0; i < 3; i++)
+            {
+                const simd::Float4 min = simd::splat(m_min[i][b]);
+                const simd::Float4 max = simd::splat(m_max[i][b]);
+                const simd::Float4 tNear = simd::mul(
+                    simd::sub(simd::select(isDirectionNegative[i], max, min),
+                              origin[i]),
+                    inverseDirection[i]);
+                const simd::Float4 tFar = simd::mul(
+                    simd::mul(simd::sub(simd::select(isDirectionNegative[i],
+                                                     min, max),
+                                        origin[i]),
+                              inverseDirection[i]),
+                    farScale);
+                tEnter = simd::max(tNear, tEnter);
+                tExit = simd::min(tFar, tExit);
+            }
+
+            int mask = simd::moveMask(simd::lessEqual(tEnter, tExit));
+            if (mask == 0)
+                continue;
+            float enterDistances[WIDTH];
+            simd::store(enterDistances, tEnter);
+            for (size_t r = 0; mask != 0; r++, mask >>= 1)
+            {
+                if ((mask & 1) != 0 &&
+                    (nearest[r] == INVALID_INDEX ||
+                     enterDistances[r] < nearestDistances[r]))
+                {
+                    nearest[r] = static_cast<uint32_t>(b);
+                    nearestDistances[r] = enterDistances[r];
+                }
+            }
+            nearestDistance = simd::load(nearestDistances);
+        }
+
+        for (size_t r = 0; r < count; r++)
+        {
+            indices[first + r] = nearest[r];
+            if (distances != nullptr)
+                distances[first + r] = nearestDistances[r];
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef KIRANA_MATH_BOUNDS3_ARRAY_HPP
+#define KIRANA_MATH_BOUNDS3_ARRAY_HPP
+
+#include "bounds3.hpp"
+#include "ray.hpp"
+#include "simd.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace kirana::math
+{
+/**
+ * Ray prepared for slab tests, so that the reciprocal of the direction and its
+ * signs are only calculated once for all the boxes tested against it.
+ */
+struct SlabRay
+{
+    simd::Float4 origin[3];
+    simd::Float4 inverseDirection[3];
+    // Picks the slab planes the ray enters through, per axis.
+    bool isDirectionNegative[3];
+    float maxDistance;
+
+    explicit SlabRay(const Ray &ray);
+};
+
+/**
+ * Axis-aligned bounding-boxes stored as separate arrays for each axis (SoA),
+ * so that a ray is tested against 4 boxes at a time with a SIMD slab test.
+ * Used for picking, and as the building block of BVH traversal.
+ */
+class Bounds3Array
+{
+  public:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+    /// Number of boxes tested at a time.
+    static constexpr size_t WIDTH = 4;
+
+    Bounds3Array() = default;
+    explicit Bounds3Array(const std::vector<Bounds3> &bounds);
+    ~Bounds3Array() = default;
+
+    Bounds3Array(const Bounds3Array &array) = default;
+    Bounds3Array &operator=(const Bounds3Array &array) = default;
+
+    [[nodiscard]] inline size_t size() const
+    {
+        return m_size;
+    }
+    [[nodiscard]] inline bool empty() const
+    {
+        return m_size == 0;
+    }
+    void clear();
+    void reserve(size_t size);
+    void add(const Bounds3 &bounds);
+    void set(size_t index, const Bounds3 &bounds);
+    /// Adds all the boxes of the given array.
+    void append(const Bounds3Array &array);
+    [[nodiscard]] Bounds3 get(size_t index) const;
+
+    /**
+     * Tests the ray against the WIDTH boxes starting at the given index. Rays
+     * that start inside a box enter it at distance 0.
+     * @param first Index of the first box, a multiple of WIDTH.
+     * @param ray The ray to test.
+     * @param maxDistance Boxes entered beyond this distance are ignored.
+     * @param distances Entry distance of each box hit.
+     * @return Bit mask of the boxes hit, box first + i in bit i.
+     */
+    int intersect(size_t first, const SlabRay &ray, float maxDistance,
+                  float distances[WIDTH]) const;
+    /**
+     * Finds the nearest box hit by the ray, within its maximum distance.
+     * @param ray The ray to test.
+     * @param distance Entry distance of the nearest box. Written out only if a
+     * box is hit.
+     * @return The index of the nearest box, INVALID_INDEX if none is hit.
+     */
+    uint32_t intersectNearest(const Ray &ray, float *distance = nullptr) const;
+    uint32_t intersectNearest(const SlabRay &ray,
+                              float *distance = nullptr) const;
+    /**
+     * Finds the nearest box hit by each ray of a packet. Rays are tested in
+     * groups of 4 against one box at a time, which suits coherent rays, such
+     * as the ones from neighbouring pixels.
+     * @param rays The rays to test.
+     * @param rayCount Number of rays.
+     * @param indices Index of the nearest box of each ray, INVALID_INDEX if
+     * none is hit.
+     * @param distances Entry distance of the nearest box of each ray, or its
+     * maximum distance if none is hit. Can be nullptr.
+     */
+    void intersectNearest(const Ray *rays, size_t rayCount, uint32_t *indices,
+                          float *distances = nullptr) const;
+
+  private:
+    // Minimum and maximum of each axis, padded to a multiple of WIDTH with
+    // empty boxes, which are never hit.
+    std::vector<float> m_min[3];
+    std::vector<float> m_max[3];
+    size_t m_size = 0;
+};
+} // namespace kirana::math
+
+#endif // KIRANA_MATH_BOUNDS3_ARRAY_HPP
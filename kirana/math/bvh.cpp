@@ -0,0 +1,573 @@
+#include "bvh.hpp"
+
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace simd = kirana::math::simd;
+
+namespace
+{
+// Number of bins the primitive centers are sorted into along each axis to
+// evaluate the SAH.
+constexpr int BIN_COUNT = 16;
+// Number of primitives processed by each task of the parallel loops.
+constexpr uint32_t CHUNK_SIZE = kirana::math::BVH::PARALLEL_BUILD_THRESHOLD / 2;
+
+/// @return The number of nodes to reserve for the given number of primitives.
+/// The leaves are about half full, and a 4-wide tree has about a third as
+/// many nodes as leaves.
+inline size_t estimateNodeCount(uint32_t primitiveCount)
+{
+    using kirana::math::BVH;
+    return primitiveCount / (BVH::MAX_LEAF_SIZE / 2 * (BVH::WIDTH - 1)) + 1;
+}
+
+/// Bounding-box kept in SIMD registers, with the last lane unused.
+struct Box
+{
+    simd::Float4 min = simd::splat(std::numeric_limits<float>::max());
+    simd::Float4 max = simd::splat(std::numeric_limits<float>::lowest());
+
+    inline void encapsulate(simd::Float4 point)
+    {
+        min = simd::min(min, point);
+        max = simd::max(max, point);
+    }
+    inline void encapsulate(const Box &box)
+    {
+        min = simd::min(min, box.min);
+        max = simd::max(max, box.max);
+    }
+    [[nodiscard]] inline simd::Float4 getCenter() const
+    {
+        return simd::mul(simd::add(min, max), simd::splat(0.5f));
+    }
+    [[nodiscard]] inline float getSurfaceArea() const
+    {
+        float size[4];
+        simd::store(size, simd::sub(max, min));
+        return 2.0f * (size[0] * size[1] + size[1] * size[2] +
+                       size[2] * size[0]);
+    }
+    [[nodiscard]] kirana::math::Bounds3 toBounds3() const
+    {
+        float boxMin[4], boxMax[4];
+        simd::store(boxMin, min);
+        simd::store(boxMax, max);
+        return kirana::math::Bounds3(
+            kirana::math::Vector3(boxMin[0], boxMin[1], boxMin[2]),
+            kirana::math::Vector3(boxMax[0], boxMax[1], boxMax[2]));
+    }
+};
+
+struct Bin
+{
+    Box bounds;
+    Box centerBounds;
+    uint32_t count = 0;
+};
+
+/// The bins of all the axes.
+struct BinSet
+{
+    Bin bins[3][BIN_COUNT];
+
+    void merge(const BinSet &binSet)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (int i = 0; i < BIN_COUNT; i++)
+            {
+                Bin &bin = bins[axis][i];
+                const Bin &other = binSet.bins[axis][i];
+                bin.bounds.encapsulate(other.bounds);
+                bin.centerBounds.encapsulate(other.centerBounds);
+                bin.count += other.count;
+            }
+        }
+    }
+};
+} // namespace
+
+struct kirana::math::BVH::BuildContext
+{
+    /// The primitives are reordered along with their bounds, so that each
+    /// range reads its primitives in order.
+    struct Primitive
+    {
+        Box bounds;
+        uint32_t index;
+    };
+    // Shared by all the subtrees, which only reorder their own range.
+    std::vector<Primitive> primitives;
+    bool parallel = true;
+    // The tree being built. Only its nodes build their children as separate
+    // subtrees, so that the nodes of the subtrees are copied once.
+    const BVH *tree = nullptr;
+};
+
+struct kirana::math::BVH::BuildRange
+{
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    Box bounds;
+    // Bounds of the centers of the primitives, which the bins divide.
+    Box centerBounds;
+};
+
+kirana::math::BVH::BVH(const std::vector<Bounds3> &primitiveBounds)
+{
+    build(primitiveBounds);
+}
+
+void kirana::math::BVH::build(const std::vector<Bounds3> &primitiveBounds,
+                              bool parallel)
+{
+    clear();
+    if (primitiveBounds.empty())
+        return;
+
+    const auto count = static_cast<uint32_t>(primitiveBounds.size());
+    BuildContext context;
+    context.primitives.resize(count);
+    context.parallel = parallel;
+    context.tree = this;
+
+    // The bounds are converted in chunks, each of which also calculates the
+    // bounds of its primitives and their centers.
+    const uint32_t chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<BuildRange> chunks(chunkCount);
+    const auto convertChunk = [&](size_t c) {
+        const auto begin = static_cast<uint32_t>(c * CHUNK_SIZE);
+        const uint32_t end = std::min(begin + CHUNK_SIZE, count);
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const Vector3 min = primitiveBounds[i].getMin();
+            const Vector3 max = primitiveBounds[i].getMax();
+            context.primitives[i].index = i;
+            Box &box = context.primitives[i].bounds;
+            box.min = simd::set(min[0], min[1], min[2], 0.0f);
+            box.max = simd::set(max[0], max[1], max[2], 0.0f);
+            chunks[c].bounds.encapsulate(box);
+            chunks[c].centerBounds.encapsulate(box.getCenter());
+        }
+    };
+    if (parallel && count >= PARALLEL_BUILD_THRESHOLD)
+        utils::ThreadPool::get().parallelFor(chunkCount, convertChunk);
+    else
+        for (uint32_t c = 0; c < chunkCount; c++)
+            convertChunk(c);
+
+    BuildRange range;
+    range.end = count;
+    for (const auto &chunk : chunks)
+    {
+        range.bounds.encapsulate(chunk.bounds);
+        range.centerBounds.encapsulate(chunk.centerBounds);
+    }
+
+    m_nodes.reserve(estimateNodeCount(count));
+    m_childBounds.reserve(m_nodes.capacity() * WIDTH);
+    buildNode(context, range, 0);
+
+    m_primitiveIndices.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+        m_primitiveIndices[i] = context.primitives[i].index;
+    m_weightedArea = calculateWeightedArea();
+}
+
+uint32_t kirana::math::BVH::buildNode(BuildContext &context,
+                                      const BuildRange &range, uint32_t depth)
+{
+    const auto node = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+    for (size_t i = 0; i < WIDTH; i++)
+        m_childBounds.add(Bounds3());
+
+    // The SAH can split off a few primitives at a time, so past half the
+    // maximum depth the ranges are halved instead, which keeps the rest of
+    // the tree within it.
+    const bool useMedian = depth >= MAX_DEPTH / 2;
+    BuildRange ranges[WIDTH] = {range};
+    size_t rangeCount = 1;
+    while (rangeCount < WIDTH)
+    {
+        // Split the range that is the most likely to be entered by a ray.
+        size_t largest = WIDTH;
+        for (size_t i = 0; i < rangeCount; i++)
+        {
+            if (ranges[i].end - ranges[i].begin <= MAX_LEAF_SIZE)
+                continue;
+            if (largest == WIDTH || ranges[i].bounds.getSurfaceArea() >
+                                        ranges[largest].bounds.getSurfaceArea())
+                largest = i;
+        }
+        if (largest == WIDTH)
+            break;
+        splitRange(context, useMedian, &ranges[largest],
+                   &ranges[rangeCount++]);
+    }
+
+    for (size_t i = 0; i < WIDTH; i++)
+    {
+        m_nodes[node].children[i] = INVALID_INDEX;
+        m_nodes[node].primitiveCounts[i] = 0;
+    }
+    for (size_t i = 0; i < rangeCount; i++)
+    {
+        m_childBounds.set(node * WIDTH + i, ranges[i].bounds.toBounds3());
+        const uint32_t count = ranges[i].end - ranges[i].begin;
+        if (count <= MAX_LEAF_SIZE)
+        {
+            m_nodes[node].children[i] = ranges[i].begin;
+            m_nodes[node].primitiveCounts[i] = count;
+        }
+    }
+
+    if (context.parallel && context.tree == this &&
+        range.end - range.begin >= PARALLEL_BUILD_THRESHOLD)
+    {
+        // The child nodes are built as separate trees on the thread pool,
+        // and appended in order, which gives the same tree as building them
+        // one after another. The subtrees don't split again, since their
+        // nodes would be copied at every level, but still bin their large
+        // nodes in parallel.
+        BVH subtrees[WIDTH];
+        utils::ThreadPool::get().parallelFor(rangeCount, [&](size_t i) {
+            const uint32_t count = ranges[i].end - ranges[i].begin;
+            if (count <= MAX_LEAF_SIZE)
+                return;
+            subtrees[i].m_nodes.reserve(estimateNodeCount(count));
+            subtrees[i].m_childBounds.reserve(
+                subtrees[i].m_nodes.capacity() * WIDTH);
+            subtrees[i].buildNode(context, ranges[i], depth + 1);
+        });
+        for (size_t i = 0; i < rangeCount; i++)
+            if (!subtrees[i].m_nodes.empty())
+                m_nodes[node].children[i] = appendSubtree(subtrees[i]);
+        return node;
+    }
+    for (size_t i = 0; i < rangeCount; i++)
+    {
+        if (ranges[i].end - ranges[i].begin <= MAX_LEAF_SIZE)
+            continue;
+        // The nodes can be reallocated by the recursion.
+        const uint32_t child = buildNode(context, ranges[i], depth + 1);
+        m_nodes[node].children[i] = child;
+    }
+    return node;
+}
+
+void kirana::math::BVH::splitRange(BuildContext &context,
+                                   bool useMedian, BuildRange *range,
+                                   BuildRange *splitRange)
+{
+    const uint32_t begin = range->begin;
+    const uint32_t end = range->end;
+    BuildContext::Primitive *const primitives = context.primitives.data();
+    float size[4];
+    simd::store(size, simd::sub(range->centerBounds.max,
+                                range->centerBounds.min));
+
+    if (!useMedian)
+    {
+        // Binned SAH: the centers are sorted into bins along each axis, and
+        // the planes between the bins are evaluated. The cost of a split is
+        // the number of primitives on each side weighted by the surface area
+        // of its bounds. (Refer: Section 4.3.2, PBRT 3rd Edition)
+        float scales[4] = {};
+        for (int axis = 0; axis < 3; axis++)
+            scales[axis] = size[axis] > 0.0f
+                               ? static_cast<float>(BIN_COUNT) / size[axis]
+                               : 0.0f;
+        const simd::Float4 min = range->centerBounds.min;
+        const simd::Float4 scale = simd::load(scales);
+        // The bins of all the axes are calculated at once.
+        const auto getBins = [&](simd::Float4 center, int bins[3]) {
+            float positions[4];
+            simd::store(positions, simd::mul(simd::sub(center, min), scale));
+            for (int axis = 0; axis < 3; axis++)
+                bins[axis] =
+                    std::min(BIN_COUNT - 1, static_cast<int>(positions[axis]));
+        };
+        const auto binPrimitives = [&](uint32_t first, uint32_t last,
+                                       BinSet *binSet) {
+            for (uint32_t i = first; i < last; i++)
+            {
+                const Box &bounds = primitives[i].bounds;
+                const simd::Float4 center = bounds.getCenter();
+                int bins[3];
+                getBins(center, bins);
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    Bin &bin = binSet->bins[axis][bins[axis]];
+                    bin.bounds.encapsulate(bounds);
+                    bin.centerBounds.encapsulate(center);
+                    bin.count++;
+                }
+            }
+        };
+
+        BinSet binSet;
+        if (context.parallel && end - begin >= PARALLEL_BUILD_THRESHOLD)
+        {
+            const uint32_t chunkCount =
+                (end - begin + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            std::vector<BinSet> chunks(chunkCount);
+            utils::ThreadPool::get().parallelFor(chunkCount, [&](size_t c) {
+                const auto first =
+                    static_cast<uint32_t>(begin + c * CHUNK_SIZE);
+                binPrimitives(first, std::min(first + CHUNK_SIZE, end),
+                              &chunks[c]);
+            });
+            for (const auto &chunk : chunks)
+                binSet.merge(chunk);
+        }
+        else
+            binPrimitives(begin, end, &binSet);
+
+        float bestCost = std::numeric_limits<float>::max();
+        int bestAxis = -1;
+        int bestPlane = 0;
+        Bin bestBins[2];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (size[axis] <= 0.0f)
+                continue;
+            const Bin *bins = binSet.bins[axis];
+            // Bins right of each plane, swept from the right.
+            Bin rightBins[BIN_COUNT];
+            Bin bin;
+            for (int plane = BIN_COUNT - 1; plane > 0; plane--)
+            {
+                bin.bounds.encapsulate(bins[plane].bounds);
+                bin.centerBounds.encapsulate(bins[plane].centerBounds);
+                bin.count += bins[plane].count;
+                rightBins[plane] = bin;
+            }
+            bin = Bin();
+            for (int plane = 1; plane < BIN_COUNT; plane++)
+            {
+                bin.bounds.encapsulate(bins[plane - 1].bounds);
+                bin.centerBounds.encapsulate(bins[plane - 1].centerBounds);
+                bin.count += bins[plane - 1].count;
+                if (bin.count == 0 || rightBins[plane].count == 0)
+                    continue;
+                const float cost =
+                    bin.bounds.getSurfaceArea() *
+                        static_cast<float>(bin.count) +
+                    rightBins[plane].bounds.getSurfaceArea() *
+                        static_cast<float>(rightBins[plane].count);
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestPlane = plane;
+                    bestBins[0] = bin;
+                    bestBins[1] = rightBins[plane];
+                }
+            }
+        }
+
+        if (bestAxis >= 0)
+        {
+            const uint32_t middle = static_cast<uint32_t>(
+                std::partition(primitives + begin, primitives + end,
+                               [&](const BuildContext::Primitive &primitive) {
+                                   int bins[3];
+                                   getBins(primitive.bounds.getCenter(), bins);
+                                   return bins[bestAxis] < bestPlane;
+                               }) -
+                primitives);
+            *range = {begin, middle, bestBins[0].bounds,
+                      bestBins[0].centerBounds};
+            *splitRange = {middle, end, bestBins[1].bounds,
+                           bestBins[1].centerBounds};
+            return;
+        }
+    }
+
+    // Split at the median of the centers along the longest axis. Also used
+    // when all the centers are at the same point.
+    const int axis = size[0] > size[1] ? (size[0] > size[2] ? 0 : 2)
+                                       : (size[1] > size[2] ? 1 : 2);
+    const auto getCenter = [&](const BuildContext::Primitive &primitive) {
+        float center[4];
+        simd::store(center, primitive.bounds.getCenter());
+        return center[axis];
+    };
+    const uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(primitives + begin, primitives + middle,
+                     primitives + end,
+                     [&](const BuildContext::Primitive &lhs,
+                         const BuildContext::Primitive &rhs) {
+                         return getCenter(lhs) < getCenter(rhs);
+                     });
+    *range = {begin, middle, Box(), Box()};
+    *splitRange = {middle, end, Box(), Box()};
+    for (BuildRange *half : {range, splitRange})
+    {
+        for (uint32_t i = half->begin; i < half->end; i++)
+        {
+            const Box &bounds = primitives[i].bounds;
+            half->bounds.encapsulate(bounds);
+            half->centerBounds.encapsulate(bounds.getCenter());
+        }
+    }
+}
+
+uint32_t kirana::math::BVH::appendSubtree(const BVH &subtree)
+{
+    const auto offset = static_cast<uint32_t>(m_nodes.size());
+    for (Node node : subtree.m_nodes)
+    {
+        for (size_t i = 0; i < WIDTH; i++)
+            if (node.primitiveCounts[i] == 0 &&
+                node.children[i] != INVALID_INDEX)
+                node.children[i] += offset;
+        m_nodes.push_back(node);
+    }
+    m_childBounds.append(subtree.m_childBounds);
+    return offset;
+}
+
+void kirana::math::BVH::refit(const std::vector<Bounds3> &primitiveBounds)
+{
+    // Children are always created after their parents, so walking the nodes
+    // backwards calculates the children first.
+    for (size_t n = m_nodes.size(); n-- > 0;)
+        refitNode(primitiveBounds, static_cast<uint32_t>(n));
+    // Recalculated from scratch, so that the rounding errors of the updates
+    // don't add up.
+    m_weightedArea = calculateWeightedArea();
+}
+
+void kirana::math::BVH::refit(const std::vector<Bounds3> &primitiveBounds,
+                              const std::vector<uint32_t> &primitives)
+{
+    if (m_nodes.empty())
+        return;
+    if (m_parents.empty())
+        linkNodes();
+
+    // The paths share the nodes near the root, so each path stops at the
+    // first node already in the list.
+    std::vector<bool> isListed(m_nodes.size(), false);
+    std::vector<uint32_t> nodes;
+    for (const auto p : primitives)
+    {
+        for (uint32_t n = m_primitiveNodes[p];
+             n != INVALID_INDEX && !isListed[n]; n = m_parents[n])
+        {
+            isListed[n] = true;
+            nodes.push_back(n);
+        }
+    }
+    std::sort(nodes.begin(), nodes.end(), std::greater<>());
+    for (const auto n : nodes)
+        refitNode(primitiveBounds, n);
+}
+
+void kirana::math::BVH::clear()
+{
+    m_nodes.clear();
+    m_childBounds.clear();
+    m_primitiveIndices.clear();
+    m_weightedArea = 0.0;
+    m_parents.clear();
+    m_primitiveNodes.clear();
+}
+
+kirana::math::Bounds3 kirana::math::BVH::getBounds() const
+{
+    return m_nodes.empty() ? Bounds3() : getNodeBounds(0);
+}
+
+float kirana::math::BVH::getCost() const
+{
+    // Every ray enters the root.
+    const float rootArea = getBounds().getSurfaceArea();
+    if (m_nodes.empty() || rootArea <= 0.0f)
+        return 0.0f;
+    return TRAVERSAL_COST + static_cast<float>(m_weightedArea / rootArea);
+}
+
+kirana::math::Bounds3 kirana::math::BVH::getNodeBounds(uint32_t node) const
+{
+    Bounds3 bounds;
+    for (size_t i = 0; i < WIDTH; i++)
+        if (m_nodes[node].children[i] != INVALID_INDEX)
+            bounds.encapsulate(m_childBounds.get(node * WIDTH + i));
+    return bounds;
+}
+
+void kirana::math::BVH::refitNode(const std::vector<Bounds3> &primitiveBounds,
+                                  uint32_t node)
+{
+    for (uint32_t i = 0; i < WIDTH; i++)
+    {
+        const uint32_t child = m_nodes[node].children[i];
+        if (child == INVALID_INDEX)
+            continue;
+        Bounds3 bounds;
+        if (m_nodes[node].primitiveCounts[i] == 0)
+            bounds = getNodeBounds(child);
+        else
+        {
+            const uint32_t end = child + m_nodes[node].primitiveCounts[i];
+            for (uint32_t p = child; p < end; p++)
+                bounds.encapsulate(primitiveBounds[m_primitiveIndices[p]]);
+        }
+        const size_t index = node * WIDTH + i;
+        m_weightedArea += getChildCost(node, i) *
+                          (static_cast<double>(bounds.getSurfaceArea()) -
+                           m_childBounds.get(index).getSurfaceArea());
+        m_childBounds.set(index, bounds);
+    }
+}
+
+float kirana::math::BVH::getChildCost(uint32_t node, size_t child) const
+{
+    const uint32_t count = m_nodes[node].primitiveCounts[child];
+    return count == 0 ? TRAVERSAL_COST
+                      : static_cast<float>(count) * INTERSECTION_COST;
+}
+
+double kirana::math::BVH::calculateWeightedArea() const
+{
+    double weightedArea = 0.0;
+    for (uint32_t n = 0; n < m_nodes.size(); n++)
+        for (size_t i = 0; i < WIDTH; i++)
+            if (m_nodes[n].children[i] != INVALID_INDEX)
+                weightedArea += getChildCost(n, i) *
+                                static_cast<double>(
+                                    m_childBounds.get(n * WIDTH + i)
+                                        .getSurfaceArea());
+    return weightedArea;
+}
+
+void kirana::math::BVH::linkNodes()
+{
+    m_parents.assign(m_nodes.size(), INVALID_INDEX);
+    m_primitiveNodes.assign(m_primitiveIndices.size(), INVALID_INDEX);
+    for (uint32_t n = 0; n < m_nodes.size(); n++)
+    {
+        const Node &node = m_nodes[n];
+        for (size_t i = 0; i < WIDTH; i++)
+        {
+            if (node.children[i] == INVALID_INDEX)
+                continue;
+            if (node.primitiveCounts[i] == 0)
+            {
+                m_parents[node.children[i]] = n;
+                continue;
+            }
+            const uint32_t end = node.children[i] + node.primitiveCounts[i];
+            for (uint32_t p = node.children[i]; p < end; p++)
+                m_primitiveNodes[m_primitiveIndices[p]] = n;
+        }
+    }
+}
@@ -0,0 +1,328 @@
+#ifndef KIRANA_MATH_BVH_HPP
+#define KIRANA_MATH_BVH_HPP
+
+#include "bounds3_array.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace kirana::math
+{
+/**
+ * Bounding volume hierarchy over a set of primitives, given by their
+ * bounding-boxes. Each node has up to WIDTH children, whose bounds are stored
+ * next to each other in a Bounds3Array, so that a ray is tested against all
+ * of them with a single SIMD slab test.
+ *
+ * The tree only stores primitive indices. What a primitive is, and how a ray
+ * intersects it, is up to the caller of intersectNearest(). Large trees are
+ * built on the thread pool.
+ */
+class BVH
+{
+  public:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+    static constexpr size_t WIDTH = Bounds3Array::WIDTH;
+    /// Maximum number of primitives in a leaf.
+    static constexpr uint32_t MAX_LEAF_SIZE = 4;
+    /// Maximum depth of the tree, which bounds the traversal stack.
+    static constexpr uint32_t MAX_DEPTH = 64;
+    /// Minimum number of primitives of a node for its children to be built
+    /// in parallel.
+    static constexpr uint32_t PARALLEL_BUILD_THRESHOLD = 4096;
+    /// Costs of visiting a node and of intersecting a primitive, relative to
+    /// each other, used by getCost().
+    static constexpr float TRAVERSAL_COST = 1.0f;
+    static constexpr float INTERSECTION_COST = 1.0f;
+
+    struct Node
+    {
+        /// Index of the child node, or for leaves, of the first primitive
+        /// index in getPrimitiveIndices(). INVALID_INDEX for unused children.
+        uint32_t children[WIDTH];
+        /// Number of primitives in each leaf child, 0 for the other children.
+        uint32_t primitiveCounts[WIDTH];
+    };
+    // Half a cache line. The bounds of the children are kept separately.
+    static_assert(sizeof(Node) == 32);
+
+    BVH() = default;
+    explicit BVH(const std::vector<Bounds3> &primitiveBounds);
+    ~BVH() = default;
+
+    BVH(const BVH &bvh) = default;
+    BVH &operator=(const BVH &bvh) = default;
+    BVH(BVH &&bvh) = default;
+    BVH &operator=(BVH &&bvh) = default;
+
+    /**
+     * Builds the tree with the surface area heuristic (SAH), which splits the
+     * primitives where the expected cost of tracing a ray through the
+     * children is the lowest. The primitives are sorted into bins to find the
+     * split. Large nodes bin their primitives in parallel, and the children
+     * of the root are built as separate subtrees in parallel, which are then
+     * appended in order, so the tree is the same as the one built serially.
+     * @param primitiveBounds Bounding-box of each primitive.
+     * @param parallel If true, nodes with many primitives are built on the
+     * thread pool.
+     */
+    void build(const std::vector<Bounds3> &primitiveBounds,
+               bool parallel = true);
+    /**
+     * Recalculates the bounds of the nodes from the new bounds of the
+     * primitives, keeping the structure of the tree. Much faster than
+     * rebuilding, but the tree gets worse as the primitives move further.
+     * @param primitiveBounds Bounding-box of each primitive, in the order
+     * they were given to build().
+     */
+    void refit(const std::vector<Bounds3> &primitiveBounds);
+    /**
+     * Same as refit(), but only recalculates the nodes on the paths from the
+     * given primitives to the root, which suits a few primitives moving.
+     * @param primitiveBounds Bounding-box of each primitive, in the order
+     * they were given to build().
+     * @param primitives Indices of the primitives whose bounds changed.
+     */
+    void refit(const std::vector<Bounds3> &primitiveBounds,
+               const std::vector<uint32_t> &primitives);
+    void clear();
+
+    /// @return The number of primitives in the tree.
+    [[nodiscard]] inline size_t size() const
+    {
+        return m_primitiveIndices.size();
+    }
+    [[nodiscard]] inline bool empty() const
+    {
+        return m_primitiveIndices.empty();
+    }
+    [[nodiscard]] inline const std::vector<Node> &getNodes() const
+    {
+        return m_nodes;
+    }
+    [[nodiscard]] inline const std::vector<uint32_t> &getPrimitiveIndices()
+        const
+    {
+        return m_primitiveIndices;
+    }
+    /// @return The bounding-box of all the primitives.
+    [[nodiscard]] Bounds3 getBounds() const;
+    /**
+     * The SAH cost of the tree: the expected cost of tracing a ray through
+     * it, given that the probability of a ray entering a node is
+     * proportional to its surface area. Kept up to date by refit(), so that
+     * a tree degraded by refitting can be detected and rebuilt.
+     * @return The cost, in units of TRAVERSAL_COST and INTERSECTION_COST.
+     */
+    [[nodiscard]] float getCost() const;
+
+    /**
+     * Finds the nearest primitive hit by the ray. Nodes are visited front to
+     * back, and the ones beyond the nearest hit so far are skipped.
+     * @param ray The ray to test.
+     * @param intersectPrimitive Called as bool(uint32_t primitive, float
+     * *distance) for the primitives of the leaves the ray enters. The distance
+     * is the nearest hit so far, or the maximum distance of the ray. If the
+     * primitive is hit nearer than that, it should write the distance of the
+     * hit and return true.
+     * @param distance Distance of the nearest hit. Written out only if a
+     * primitive is hit.
+     * @return The index of the nearest primitive, INVALID_INDEX if none is hit.
+     */
+    template <typename PrimitiveIntersector>
+    uint32_t intersectNearest(const Ray &ray,
+                              PrimitiveIntersector &&intersectPrimitive,
+                              float *distance = nullptr) const;
+    /**
+     * Same as intersectNearest(), but the primitives of a leaf are tested all
+     * at once, such as with a SIMD test.
+     * @param intersectLeaf Called as uint32_t(const uint32_t *primitives,
+     * uint32_t count, float *distance) for the leaves the ray enters, with the
+     * indices of the primitives of the leaf. It should return the nearest
+     * primitive hit nearer than the distance, and write the distance of the
+     * hit, or return INVALID_INDEX.
+     */
+    template <typename LeafIntersector>
+    uint32_t intersectNearestInLeaves(const Ray &ray,
+                                      LeafIntersector &&intersectLeaf,
+                                      float *distance = nullptr) const;
+    /**
+     * Finds any primitive hit by the ray, such as for shadow rays, which only
+     * need to know whether something is in the way. The traversal stops at
+     * the first hit, so the nodes aren't sorted by distance.
+     * @param intersectLeaf Same as for intersectNearestInLeaves(), with the
+     * maximum distance of the ray.
+     * @return The index of the primitive hit, INVALID_INDEX if none is hit.
+     */
+    template <typename LeafIntersector>
+    uint32_t intersectAnyInLeaves(const Ray &ray,
+                                  LeafIntersector &&intersectLeaf) const;
+
+  private:
+    struct StackEntry
+    {
+        uint32_t node;
+        float distance;
+    };
+
+    std::vector<Node> m_nodes;
+    // Bounds of the children of node i, at indices [i * WIDTH, i * WIDTH +
+    // WIDTH).
+    Bounds3Array m_childBounds;
+    // Primitive indices, ordered so that each leaf has a contiguous range.
+    std::vector<uint32_t> m_primitiveIndices;
+    // Sum of the surface area of each child weighted by its cost. Divided by
+    // the area of the root, it gives the SAH cost of the tree.
+    double m_weightedArea = 0.0;
+    // Parent of each node, and the node whose leaf holds each primitive. Only
+    // calculated for refitting a few primitives.
+    std::vector<uint32_t> m_parents;
+    std::vector<uint32_t> m_primitiveNodes;
+
+    // Defined with the builder, since they hold SIMD data.
+    struct BuildContext;
+    struct BuildRange;
+
+    uint32_t buildNode(BuildContext &context, const BuildRange &range,
+                       uint32_t depth);
+    static void splitRange(BuildContext &context, bool useMedian,
+                           BuildRange *range, BuildRange *splitRange);
+    /// Appends the nodes of a subtree built separately.
+    /// @return The index of the root of the subtree.
+    uint32_t appendSubtree(const BVH &subtree);
+    Bounds3 getNodeBounds(uint32_t node) const;
+    /// Recalculates the bounds of the children of the node, given that its
+    /// child nodes are up to date.
+    void refitNode(const std::vector<Bounds3> &primitiveBounds,
+                   uint32_t node);
+    /// @return The cost of entering the child, per unit of its surface area.
+    float getChildCost(uint32_t node, size_t child) const;
+    double calculateWeightedArea() const;
+    void linkNodes();
+};
+} // namespace kirana::math
+
+template <typename PrimitiveIntersector>
+uint32_t kirana::math::BVH::intersectNearest(
+    const Ray &ray, PrimitiveIntersector &&intersectPrimitive,
+    float *distance) const
+{
+    return intersectNearestInLeaves(
+        ray,
+        [&](const uint32_t *primitives, uint32_t count, float *leafDistance) {
+            uint32_t nearest = INVALID_INDEX;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float primitiveDistance = *leafDistance;
+                if (intersectPrimitive(primitives[i], &primitiveDistance) &&
+                    primitiveDistance <= *leafDistance)
+                {
+                    nearest = primitives[i];
+                    *leafDistance = primitiveDistance;
+                }
+            }
+            return nearest;
+        },
+        distance);
+}
+
+template <typename LeafIntersector>
+uint32_t kirana::math::BVH::intersectNearestInLeaves(
+    const Ray &ray, LeafIntersector &&intersectLeaf, float *distance) const
+{
+    if (m_nodes.empty())
+        return INVALID_INDEX;
+
+    const SlabRay slabRay(ray);
+    uint32_t nearest = INVALID_INDEX;
+    float nearestDistance = ray.getMaxDistance();
+
+    // Every level pushes at most WIDTH - 1 siblings of the child it visits
+    // next.
+    StackEntry stack[MAX_DEPTH * (WIDTH - 1) + 1];
+    size_t stackSize = 0;
+    stack[stackSize++] = {0, 0.0f};
+    float distances[WIDTH];
+    while (stackSize > 0)
+    {
+        const StackEntry entry = stack[--stackSize];
+        if (entry.distance > nearestDistance)
+            continue;
+        const Node &node = m_nodes[entry.node];
+        int mask = m_childBounds.intersect(entry.node * WIDTH, slabRay,
+                                           nearestDistance, distances);
+
+        // Leaves are tested right away. Child nodes are pushed far to near,
+        // so that the nearest one is visited first.
+        const size_t firstChild = stackSize;
+        for (uint32_t i = 0; mask != 0; i++, mask >>= 1)
+        {
+            if ((mask & 1) == 0 || distances[i] > nearestDistance)
+                continue;
+            if (node.primitiveCounts[i] == 0)
+            {
+                size_t j = stackSize++;
+                for (; j > firstChild && stack[j - 1].distance < distances[i];
+                     j--)
+                    stack[j] = stack[j - 1];
+                stack[j] = {node.children[i], distances[i]};
+                continue;
+            }
+            float leafDistance = nearestDistance;
+            const uint32_t primitive =
+                intersectLeaf(&m_primitiveIndices[node.children[i]],
+                              node.primitiveCounts[i], &leafDistance);
+            if (primitive != INVALID_INDEX && leafDistance <= nearestDistance)
+            {
+                nearest = primitive;
+                nearestDistance = leafDistance;
+            }
+        }
+    }
+    if (nearest != INVALID_INDEX && distance != nullptr)
+        *distance = nearestDistance;
+    return nearest;
+}
+
+template <typename LeafIntersector>
+uint32_t kirana::math::BVH::intersectAnyInLeaves(
+    const Ray &ray, LeafIntersector &&intersectLeaf) const
+{
+    if (m_nodes.empty())
+        return INVALID_INDEX;
+
+    const SlabRay slabRay(ray);
+    const float maxDistance = ray.getMaxDistance();
+    // Every level pushes at most WIDTH children, one of which is popped
+    // right away.
+    uint32_t stack[MAX_DEPTH * (WIDTH - 1) + 1];
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+    float distances[WIDTH];
+    while (stackSize > 0)
+    {
+        const uint32_t nodeIndex = stack[--stackSize];
+        const Node &node = m_nodes[nodeIndex];
+        int mask = m_childBounds.intersect(nodeIndex * WIDTH, slabRay,
+                                           maxDistance, distances);
+        for (uint32_t i = 0; mask != 0; i++, mask >>= 1)
+        {
+            if ((mask & 1) == 0)
+                continue;
+            if (node.primitiveCounts[i] == 0)
+            {
+                stack[stackSize++] = node.children[i];
+                continue;
+            }
+            float leafDistance = maxDistance;
+            const uint32_t primitive =
+                intersectLeaf(&m_primitiveIndices[node.children[i]],
+                              node.primitiveCounts[i], &leafDistance);
+            if (primitive != INVALID_INDEX)
+                return primitive;
+        }
+    }
+    return INVALID_INDEX;
+}
+
+#endif // KIRANA_MATH_BVH_HPP
@@ -3,14 +3,955 @@
 #include "vector3.hpp"
 #include "vector4.hpp"
 #include "matrix4x4.hpp"
+#include "quaternion.hpp"
 #include "transform.hpp"
+#include "transform_hierarchy.hpp"
 #include "bounds3.hpp"
+#include "bounds3_array.hpp"
+#include "bvh.hpp"
+#include "triangle.hpp"
 #include "bounds2.hpp"
 #include "ray.hpp"
 
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
 
 using namespace kirana::math;
+
+// Scalar versions of the SIMD operations, used as the baseline and to check
+// the results.
+
+Vector3 scalarMultiply(const Matrix4x4 &mat, const Vector3 &vec3)
+{
+    Vector3 result;
+    for (int i = 0; i < 3; i++)
+        result[i] = mat[i][0] * vec3[0] + mat[i][1] * vec3[1] +
+                    mat[i][2] * vec3[2] + mat[i][3];
+    return result;
+}
+
+Bounds3 scalarTransformBounds(const Matrix4x4 &m, const Bounds3 &bounds)
+{
+    Vector3 min(m[0][3], m[1][3], m[2][3]);
+    Vector3 max(min);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            const float a = m[j][i] * bounds.getMin()[i];
+            const float b = m[j][i] * bounds.getMax()[i];
+            min[j] += std::fminf(a, b);
+            max[j] += std::fmaxf(a, b);
+        }
+    }
+    return Bounds3(min, max);
+}
+
+Matrix4x4 scalarInverse(const Matrix4x4 &mat)
+{
+    // Gauss Jordan Elimination with full pivoting.
+    int indxc[4], indxr[4];
+    int ipiv[4] = {0, 0, 0, 0};
+    Matrix4x4 minv(mat);
+    for (int i = 0; i < 4; i++)
+    {
+        int irow = 0, icol = 0;
+        float big = 0.0f;
+        for (int j = 0; j < 4; j++)
+        {
+            if (ipiv[j] == 1)
+                continue;
+            for (int k = 0; k < 4; k++)
+            {
+                if (ipiv[k] == 0 && std::abs(minv[j][k]) >= big)
+                {
+                    big = std::abs(minv[j][k]);
+                    irow = j;
+                    icol = k;
+                }
+            }
+        }
+        ++ipiv[icol];
+        if (irow != icol)
+            for (int k = 0; k < 4; ++k)
+                std::swap(minv[irow][k], minv[icol][k]);
+        indxr[i] = irow;
+        indxc[i] = icol;
+        if (minv[icol][icol] == 0.f)
+            return Matrix4x4::IDENTITY;
+
+        const float pivinv = 1.0f / minv[icol][icol];
+        minv[icol][icol] = 1.0f;
+        for (int j = 0; j < 4; j++)
+            minv[icol][j] *= pivinv;
+        for (int j = 0; j < 4; j++)
+        {
+            if (j == icol)
+                continue;
+            const float save = minv[j][icol];
+            minv[j][icol] = 0;
+            for (int k = 0; k < 4; k++)
+                minv[j][k] -= minv[icol][k] * save;
+        }
+    }
+    for (int j = 3; j >= 0; j--)
+        if (indxr[j] != indxc[j])
+            for (int k = 0; k < 4; k++)
+                std::swap(minv[k][indxr[j]], minv[k][indxc[j]]);
+    return minv;
+}
+
+float maxDifference(const Matrix4x4 &lhs, const Matrix4x4 &rhs)
+{
+    float difference = 0.0f;
+    for (size_t i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            difference = std::fmax(difference, std::abs(lhs[i][j] - rhs[i][j]));
+    return difference;
+}
+
+template <typename Function> double measure(int iterations, Function function)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++)
+        function();
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::high_resolution_clock::now() - startTime;
+    return duration.count();
+}
+
+void printResult(const std::string &name, double scalarTime, double simdTime,
+                 float difference, const std::string &scalarName = "scalar",
+                 const std::string &simdName = "SIMD")
+{
+    std::cout << name << ": " << scalarTime << " ms " << scalarName << ", "
+              << simdTime << " ms " << simdName << " ("
+              << scalarTime / simdTime << "x), "
+              << difference << " max difference "
+              << (difference < 1e-3f ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * Compares the SIMD matrix and vector operations against scalar versions on a
+ * set of random affine transforms, similar to updating a transform hierarchy
+ * and its bounds every frame. The data fits in the L1 cache, so that the
+ * arithmetic is measured rather than memory bandwidth. The products with a
+ * matrix and with a Vector4 are plain scalar code, which the compiler
+ * vectorizes, so they aren't compared.
+ */
+void benchmarkMatrixOperations()
+{
+    const size_t count = 128;
+    const int iterations = 6400;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    std::vector<Matrix4x4> matrices(count);
+    std::vector<Vector4> vectors(count);
+    std::vector<Bounds3> bounds(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        matrices[i] =
+            Matrix4x4::translation(
+                Vector3(value(random), value(random), value(random))) *
+            Matrix4x4::rotation(
+                Vector3(angle(random), angle(random), angle(random))) *
+            Matrix4x4::scale(
+                Vector3(scale(random), scale(random), scale(random)));
+        vectors[i] = Vector4(value(random), value(random), value(random), 1.0f);
+        const Vector3 center(value(random), value(random), value(random));
+        bounds[i] = Bounds3(center - Vector3::ONE, center + Vector3::ONE);
+    }
+
+    std::vector<Matrix4x4> scalarMatrices(count), simdMatrices(count);
+    std::vector<Bounds3> scalarBounds(count), simdBounds(count);
+
+    // Point transformation.
+    std::vector<Vector3> points(vectors.begin(), vectors.end());
+    std::vector<Vector3> scalarPoints(count), simdPoints(count);
+    double scalarTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            scalarPoints[i] = scalarMultiply(matrices[i], points[i]);
+    });
+    double simdTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            simdPoints[i] = matrices[i] * points[i];
+    });
+    float difference = 0.0f;
+    for (size_t i = 0; i < count; i++)
+        for (int j = 0; j < 3; j++)
+            difference = std::fmax(
+                difference, std::abs(scalarPoints[i][j] - simdPoints[i][j]));
+    printResult("Matrix4x4 * Vector3", scalarTime, simdTime, difference);
+
+    // Bounds transformation.
+    std::vector<Transform> transforms(matrices.begin(), matrices.end());
+    scalarTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            scalarBounds[i] = scalarTransformBounds(matrices[i], bounds[i]);
+    });
+    simdTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            simdBounds[i] = transforms[i].transformBounds(bounds[i]);
+    });
+    difference = 0.0f;
+    for (size_t i = 0; i < count; i++)
+        for (int j = 0; j < 3; j++)
+            difference = std::fmax(
+                difference,
+                std::fmax(std::abs(scalarBounds[i].getMin()[j] -
+                                   simdBounds[i].getMin()[j]),
+                          std::abs(scalarBounds[i].getMax()[j] -
+                                   simdBounds[i].getMax()[j])));
+    printResult("Transform::transformBounds", scalarTime, simdTime,
+                difference);
+
+    // Inverse.
+    scalarTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            scalarMatrices[i] = scalarInverse(matrices[i]);
+    });
+    simdTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            simdMatrices[i] = Matrix4x4::inverse(matrices[i]);
+    });
+    difference = 0.0f;
+    for (size_t i = 0; i < count; i++)
+        difference = std::fmax(
+            difference, maxDifference(scalarMatrices[i], simdMatrices[i]));
+    printResult("Matrix4x4::inverse", scalarTime, simdTime, difference);
+
+    // Transpose.
+    scalarTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+        {
+            Matrix4x4 &result = scalarMatrices[i];
+            for (size_t j = 0; j < 4; j++)
+                for (size_t k = 0; k < 4; k++)
+                    result[j][static_cast<int>(k)] =
+                        matrices[i][k][static_cast<int>(j)];
+        }
+    });
+    simdTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            simdMatrices[i] = Matrix4x4::transpose(matrices[i]);
+    });
+    difference = 0.0f;
+    for (size_t i = 0; i < count; i++)
+        difference = std::fmax(
+            difference, maxDifference(scalarMatrices[i], simdMatrices[i]));
+    printResult("Matrix4x4::transpose", scalarTime, simdTime, difference);
+}
+
+/**
+ * Compares the affine and rigid inverse and the TRS decomposition against the
+ * general routines, on random TRS and TR matrices.
+ */
+void benchmarkAffineOperations()
+{
+    const size_t count = 4096;
+    const int iterations = 200;
+    std::mt19937 random(17);
+    std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    std::vector<Matrix4x4> matrices(count), rigidMatrices(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        rigidMatrices[i] =
+            Matrix4x4::translation(
+                Vector3(value(random), value(random), value(random))) *
+            Matrix4x4::rotation(
+                Vector3(angle(random), angle(random), angle(random)));
+        matrices[i] = rigidMatrices[i] *
+                      Matrix4x4::scale(Vector3(scale(random), scale(random),
+                                               scale(random)));
+    }
+
+    std::vector<Matrix4x4> generalMatrices(count), affineMatrices(count);
+    double generalTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            generalMatrices[i] = Matrix4x4::inverse(matrices[i]);
+    });
+    double affineTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            affineMatrices[i] = Matrix4x4::affineInverse(matrices[i]);
+    });
+    float difference = 0.0f;
+    for (size_t i = 0; i < count; i++)
+        difference = std::fmax(
+            difference, maxDifference(generalMatrices[i], affineMatrices[i]));
+    printResult("Matrix4x4::affineInverse", generalTime, affineTime,
+                difference, "general", "affine");
+
+    generalTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            generalMatrices[i] = Matrix4x4::inverse(rigidMatrices[i]);
+    });
+    affineTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            affineMatrices[i] = Matrix4x4::rigidInverse(rigidMatrices[i]);
+    });
+    difference = 0.0f;
+    for (size_t i = 0; i < count; i++)
+        difference = std::fmax(
+            difference, maxDifference(generalMatrices[i], affineMatrices[i]));
+    printResult("Matrix4x4::rigidInverse", generalTime, affineTime,
+                difference, "general", "rigid");
+
+    // Decomposition into translation, rotation and scale, the way the
+    // transforms are created from imported matrices. The euler angles of
+    // decompose() don't round-trip through Quaternion::euler(), so the
+    // rotations are checked by recomposing the matrices instead.
+    std::vector<Vector3> generalScales(count), affineScales(count);
+    std::vector<Vector3> generalRotations(count);
+    std::vector<Quaternion> affineRotations(count);
+    std::vector<Vector3> positions(count);
+    generalTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            Matrix4x4::decompose(matrices[i], &positions[i], &generalScales[i],
+                                 nullptr, &generalRotations[i]);
+    });
+    affineTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < count; i++)
+            Matrix4x4::decomposeTRS(matrices[i], &positions[i],
+                                    &affineRotations[i], &affineScales[i]);
+    });
+    difference = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        const Matrix4x4 recomposed = Matrix4x4::translation(positions[i]) *
+                                     affineRotations[i].getMatrix() *
+                                     Matrix4x4::scale(affineScales[i]);
+        difference =
+            std::fmax(difference, maxDifference(matrices[i], recomposed));
+        for (int j = 0; j < 3; j++)
+            difference = std::fmax(
+                difference, std::abs(generalScales[i][j] - affineScales[i][j]));
+    }
+    printResult("Matrix4x4::decomposeTRS", generalTime, affineTime,
+                difference, "general", "TRS");
+
+    // World rotation and scale of transforms with a scaled parent, which are
+    // decomposed from their world matrices.
+    difference = 0.0f;
+    for (size_t i = 0; i + 1 < 64; i += 2)
+    {
+        TransformHierarchy parent(rigidMatrices[i] *
+                                  Matrix4x4::scale(Vector3::ONE * 2.0f));
+        const TransformHierarchy child(rigidMatrices[i + 1], &parent);
+        const Quaternion expected =
+            parent.getRotation(TransformHierarchy::Space::Local) *
+            child.getRotation(TransformHierarchy::Space::Local);
+        difference = std::fmax(
+            difference,
+            maxDifference(expected.getMatrix(),
+                          child.getRotation(TransformHierarchy::Space::World)
+                              .getMatrix()));
+        const Vector3 scale = child.getScale(TransformHierarchy::Space::World);
+        for (int j = 0; j < 3; j++)
+            difference = std::fmax(difference, std::abs(scale[j] - 2.0f));
+    }
+    std::cout << "TransformHierarchy world rotation and scale: " << difference
+              << " max difference "
+              << (difference < 1e-3f ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * Finds the nearest box hit by a ray with Bounds3::intersectWithRay(), used as
+ * the baseline. The direction of the ray must be normalized.
+ */
+uint32_t scalarIntersectNearest(const std::vector<Bounds3> &bounds,
+                                const Ray &ray, float *distance)
+{
+    uint32_t nearest = Bounds3Array::INVALID_INDEX;
+    for (size_t i = 0; i < bounds.size(); i++)
+    {
+        Vector3 enterPoint;
+        if (!bounds[i].intersectWithRay(ray, &enterPoint, nullptr))
+            continue;
+        const float d = (enterPoint - ray.getOrigin()).length();
+        if (nearest == Bounds3Array::INVALID_INDEX || d < *distance)
+        {
+            nearest = static_cast<uint32_t>(i);
+            *distance = d;
+        }
+    }
+    return nearest;
+}
+
+/**
+ * Compares the batched ray-box tests against testing each box in a loop, the
+ * way objects are picked in the viewport.
+ */
+void benchmarkRayBoxIntersection()
+{
+    const size_t boxCount = 4096;
+    const size_t rayCount = 1024;
+    const int iterations = 5;
+    std::mt19937 random(19);
+    std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+
+    std::vector<Bounds3> bounds(boxCount);
+    for (auto &b : bounds)
+        b = Bounds3::createFromCenterSize(
+            Vector3(value(random), value(random), value(random)),
+            Vector3(size(random), size(random), size(random)));
+    const Bounds3Array boundsArray(bounds);
+
+    // Coherent rays from a camera outside the boxes, like picking rays.
+    std::vector<Ray> rays;
+    rays.reserve(rayCount);
+    const Vector3 eye(0.0f, 0.0f, 250.0f);
+    for (size_t i = 0; i < rayCount; i++)
+    {
+        const Vector3 target(value(random) * 0.5f, value(random) * 0.5f, 0.0f);
+        rays.emplace_back(eye, Vector3::normalize(target - eye));
+    }
+
+    std::vector<uint32_t> scalarIndices(rayCount), simdIndices(rayCount),
+        packetIndices(rayCount);
+    std::vector<float> scalarDistances(rayCount), simdDistances(rayCount),
+        packetDistances(rayCount);
+    const double scalarTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < rayCount; i++)
+            scalarIndices[i] =
+                scalarIntersectNearest(bounds, rays[i], &scalarDistances[i]);
+    });
+    const double simdTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < rayCount; i++)
+            simdIndices[i] =
+                boundsArray.intersectNearest(rays[i], &simdDistances[i]);
+    });
+    const double packetTime = measure(iterations, [&]() {
+        boundsArray.intersectNearest(rays.data(), rayCount,
+                                     packetIndices.data(),
+                                     packetDistances.data());
+    });
+    // The BVH hits the boxes themselves as its primitives.
+    const BVH bvh(bounds);
+    std::vector<uint32_t> bvhIndices(rayCount);
+    std::vector<float> bvhDistances(rayCount);
+    const double bvhTime = measure(iterations, [&]() {
+        for (size_t i = 0; i < rayCount; i++)
+        {
+            const Ray &ray = rays[i];
+            bvhIndices[i] = bvh.intersectNearest(
+                ray,
+                [&](uint32_t box, float *distance) {
+                    Vector3 enterPoint;
+                    if (!bounds[box].intersectWithRay(
+                            Ray(ray.getOrigin(), ray.getDirection(),
+                                *distance),
+                            &enterPoint, nullptr))
+                        return false;
+                    *distance = Vector3::dot(enterPoint - ray.getOrigin(),
+                                             ray.getDirection());
+                    return true;
+                },
+                &bvhDistances[i]);
+        }
+    });
+
+    // The boxes may overlap, so the distances are compared instead of the
+    // indices.
+    float difference = 0.0f;
+    size_t hitCount = 0;
+    for (size_t i = 0; i < rayCount; i++)
+    {
+        if (scalarIndices[i] != simdIndices[i] &&
+            (scalarIndices[i] == Bounds3Array::INVALID_INDEX ||
+             simdIndices[i] == Bounds3Array::INVALID_INDEX))
+        {
+            difference = std::numeric_limits<float>::infinity();
+            continue;
+        }
+        if (scalarIndices[i] == Bounds3Array::INVALID_INDEX)
+            continue;
+        hitCount++;
+        difference = std::fmax(
+            difference, std::abs(scalarDistances[i] - simdDistances[i]));
+        if (packetIndices[i] != simdIndices[i])
+            difference = std::fmax(
+                difference, std::abs(packetDistances[i] - simdDistances[i]));
+        if (bvhIndices[i] == BVH::INVALID_INDEX)
+            difference = std::numeric_limits<float>::infinity();
+        else
+            difference = std::fmax(
+                difference, std::abs(bvhDistances[i] - scalarDistances[i]));
+    }
+    printResult("Bounds3Array::intersectNearest of " +
+                    std::to_string(rayCount) + " rays, " +
+                    std::to_string(hitCount) + " hits",
+                scalarTime, simdTime, difference);
+    printResult("Bounds3Array::intersectNearest of ray packets", scalarTime,
+                packetTime, difference);
+    printResult("BVH::intersectNearest", scalarTime, bvhTime, difference,
+                "scalar", "BVH");
+}
+
+/// World matrix calculated by walking the parent chain, used as the baseline.
+Matrix4x4 uncachedWorldMatrix(const TransformHierarchy &transform)
+{
+    const Matrix4x4 &local =
+        transform.getMatrix(TransformHierarchy::Space::Local);
+    if (transform.getParent() == nullptr)
+        return local;
+    return uncachedWorldMatrix(*transform.getParent()) * local;
+}
+
+/**
+ * Compares the SIMD watertight triangle test against the single triangle
+ * test, and checks that rays aimed at the shared vertices and edges of a grid
+ * of triangles never pass through it.
+ */
+void benchmarkTriangleIntersection()
+{
+    const size_t triangleCount = 4096;
+    const size_t rayCount = 256;
+    const int iterations = 5;
+    std::mt19937 random(29);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+
+    // Vertices of the triangles, indexed as [group][vertex][axis][triangle].
+    std::vector<std::array<std::array<std::array<float, Triangle::WIDTH>, 3>,
+                           3>>
+        groups(triangleCount / Triangle::WIDTH);
+    for (auto &group : groups)
+        for (auto &vertex : group)
+            for (auto &axis : vertex)
+                for (auto &v : axis)
+                    v = value(random);
+    std::vector<TriangleRay> rays;
+    for (size_t i = 0; i < rayCount; i++)
+    {
+        const Vector3 origin(value(random), value(random), value(random));
+        const Vector3 target(value(random), value(random), value(random));
+        rays.emplace_back(Ray(origin, Vector3::normalize(target - origin)));
+    }
+
+    std::vector<int> scalarMasks(groups.size() * rayCount);
+    std::vector<int> simdMasks(groups.size() * rayCount);
+    std::vector<float> scalarDistances(triangleCount * rayCount);
+    std::vector<float> simdDistances(triangleCount * rayCount);
+    const float maxDistance = std::numeric_limits<float>::max();
+    const double scalarTime = measure(iterations, [&]() {
+        for (size_t r = 0; r < rayCount; r++)
+        {
+            for (size_t g = 0; g < groups.size(); g++)
+            {
+                int mask = 0;
+                for (int i = 0; i < Triangle::WIDTH; i++)
+                {
+                    const auto &v = groups[g];
+                    const Vector3 v0(v[0][0][i], v[0][1][i], v[0][2][i]);
+                    const Vector3 v1(v[1][0][i], v[1][1][i], v[1][2][i]);
+                    const Vector3 v2(v[2][0][i], v[2][1][i], v[2][2][i]);
+                    const size_t d =
+                        (r * groups.size() + g) * Triangle::WIDTH + i;
+                    if (Triangle::intersect(rays[r], v0, v1, v2, maxDistance,
+                                            &scalarDistances[d]))
+                        mask |= 1 << i;
+                }
+                scalarMasks[r * groups.size() + g] = mask;
+            }
+        }
+    });
+    const double simdTime = measure(iterations, [&]() {
+        for (size_t r = 0; r < rayCount; r++)
+        {
+            for (size_t g = 0; g < groups.size(); g++)
+            {
+                float vertices[3][3][Triangle::WIDTH];
+                std::memcpy(vertices, groups[g].data(), sizeof(vertices));
+                simdMasks[r * groups.size() + g] = Triangle::intersect(
+                    rays[r], vertices, maxDistance,
+                    &simdDistances[(r * groups.size() + g) * Triangle::WIDTH]);
+            }
+        }
+    });
+
+    float difference = 0.0f;
+    size_t hitCount = 0;
+    for (size_t i = 0; i < scalarMasks.size(); i++)
+    {
+        if (scalarMasks[i] != simdMasks[i])
+            difference = std::numeric_limits<float>::infinity();
+        for (int t = 0; t < Triangle::WIDTH; t++)
+        {
+            if ((scalarMasks[i] & simdMasks[i] & (1 << t)) == 0)
+                continue;
+            const size_t d = i * Triangle::WIDTH + t;
+            hitCount++;
+            difference =
+                std::fmax(difference, std::abs(scalarDistances[d] -
+                                               simdDistances[d]) /
+                                          std::fmax(1.0f, scalarDistances[d]));
+        }
+    }
+
+    // Rays through the vertices and the edge midpoints of a grid in the xy
+    // plane, which are shared by two to six triangles.
+    const int gridSize = 64;
+    size_t missCount = 0;
+    std::uniform_int_distribution<int> cell(1, gridSize - 1);
+    for (size_t i = 0; i < rayCount * 4; i++)
+    {
+        const float x = static_cast<float>(cell(random)) / gridSize;
+        const float y = static_cast<float>(cell(random)) / gridSize;
+        const float offset = i % 2 == 0 ? 0.0f : 0.5f / gridSize;
+        const Vector3 target(x + offset, y + (i % 4 == 3 ? offset : 0.0f),
+                             0.0f);
+        const Vector3 origin(value(random), value(random),
+                             11.0f + value(random));
+        const TriangleRay ray(Ray(origin, target - origin));
+        // Only the triangles around the target can be hit.
+        const int cx = static_cast<int>(target[0] * gridSize);
+        const int cy = static_cast<int>(target[1] * gridSize);
+        bool isHit = false;
+        for (int gy = cy - 1; gy <= cy + 1; gy++)
+        {
+            for (int gx = cx - 1; gx <= cx + 1; gx++)
+            {
+                const Vector3 p00(static_cast<float>(gx) / gridSize,
+                                  static_cast<float>(gy) / gridSize, 0.0f);
+                const Vector3 p10(static_cast<float>(gx + 1) / gridSize,
+                                  static_cast<float>(gy) / gridSize, 0.0f);
+                const Vector3 p01(static_cast<float>(gx) / gridSize,
+                                  static_cast<float>(gy + 1) / gridSize, 0.0f);
+                const Vector3 p11(static_cast<float>(gx + 1) / gridSize,
+                                  static_cast<float>(gy + 1) / gridSize, 0.0f);
+                float distance = 0.0f;
+                isHit = isHit ||
+                        Triangle::intersect(ray, p00, p10, p11, maxDistance,
+                                            &distance) ||
+                        Triangle::intersect(ray, p00, p11, p01, maxDistance,
+                                            &distance);
+            }
+        }
+        missCount += isHit ? 0 : 1;
+    }
+    if (missCount > 0)
+        difference = std::numeric_limits<float>::infinity();
+
+    printResult("Triangle::intersect of " + std::to_string(rayCount) +
+                    " rays and " + std::to_string(triangleCount) +
+                    " triangles, " + std::to_string(hitCount) + " hits, " +
+                    std::to_string(missCount) + " misses through edges",
+                scalarTime, simdTime, difference);
+}
+
+/**
+ * Builds a BVH over a large set of random boxes serially and on the thread
+ * pool, checks that both give the same tree, and that it finds the same
+ * nearest boxes as testing all of them.
+ */
+void benchmarkBVHBuild()
+{
+    const size_t boxCount = 1 << 20;
+    const size_t rayCount = 256;
+    std::mt19937 random(23);
+    std::uniform_real_distribution<float> value(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+
+    std::vector<Bounds3> bounds(boxCount);
+    for (auto &b : bounds)
+        b = Bounds3::createFromCenterSize(
+            Vector3(value(random), value(random), value(random)),
+            Vector3(size(random), size(random), size(random)));
+
+    BVH serialBVH, parallelBVH;
+    const double serialTime =
+        measure(1, [&]() { serialBVH.build(bounds, false); });
+    const double parallelTime =
+        measure(1, [&]() { parallelBVH.build(bounds, true); });
+
+    // Both builds have to give the same tree, with every box in it once.
+    bool isValid =
+        serialBVH.getPrimitiveIndices() == parallelBVH.getPrimitiveIndices() &&
+        serialBVH.getNodes().size() == parallelBVH.getNodes().size() &&
+        std::memcmp(serialBVH.getNodes().data(), parallelBVH.getNodes().data(),
+                    serialBVH.getNodes().size() * sizeof(BVH::Node)) == 0;
+    std::vector<uint32_t> indices = parallelBVH.getPrimitiveIndices();
+    std::sort(indices.begin(), indices.end());
+    for (size_t i = 0; i < indices.size() && isValid; i++)
+        isValid = indices[i] == i;
+
+    const Bounds3Array boundsArray(bounds);
+    const Vector3 eye(0.0f, 0.0f, 2000.0f);
+    for (size_t i = 0; i < rayCount && isValid; i++)
+    {
+        const Vector3 target(value(random), value(random), 0.0f);
+        const Ray ray(eye, Vector3::normalize(target - eye));
+        float expectedDistance = 0.0f;
+        float distance = 0.0f;
+        const uint32_t expected =
+            boundsArray.intersectNearest(ray, &expectedDistance);
+        const uint32_t box = parallelBVH.intersectNearest(
+            ray,
+            [&](uint32_t primitive, float *primitiveDistance) {
+                float distances[Bounds3Array::WIDTH];
+                const Bounds3Array primitiveArray({bounds[primitive]});
+                if ((primitiveArray.intersect(0, SlabRay(ray),
+                                              *primitiveDistance, distances) &
+                     1) == 0)
+                    return false;
+                *primitiveDistance = distances[0];
+                return true;
+            },
+            &distance);
+        isValid = (box == BVH::INVALID_INDEX) ==
+                      (expected == Bounds3Array::INVALID_INDEX) &&
+                  (box == BVH::INVALID_INDEX ||
+                   std::abs(distance - expectedDistance) < 1e-3f);
+    }
+
+    const auto getRate = [&](double time) {
+        return static_cast<double>(boxCount) / (time * 1000.0);
+    };
+    std::cout << "BVH::build of " << boxCount << " boxes, "
+              << parallelBVH.getNodes().size() << " nodes: " << serialTime
+              << " ms serial (" << getRate(serialTime) << " Mprims/s), "
+              << parallelTime << " ms on "
+              << kirana::utils::ThreadPool::get().getThreadCount() + 1
+              << " threads (" << getRate(parallelTime) << " Mprims/s) "
+              << (isValid ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * Moves a few boxes of a BVH at a time, and compares refitting the paths from
+ * them to the root against refitting the whole tree. Both have to give the
+ * same SAH cost, which grows as the boxes move further.
+ */
+void benchmarkBVHRefit()
+{
+    const size_t boxCount = 1 << 16;
+    const size_t movedCount = boxCount / 100;
+    const int iterations = 10;
+    std::mt19937 random(29);
+    std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.5f, 2.0f);
+
+    std::vector<Bounds3> bounds(boxCount);
+    for (auto &b : bounds)
+        b = Bounds3::createFromCenterSize(
+            Vector3(value(random), value(random), value(random)),
+            Vector3(size(random), size(random), size(random)));
+    BVH partialBVH(bounds);
+    BVH fullBVH = partialBVH;
+    const float builtCost = partialBVH.getCost();
+
+    double partialTime = 0.0;
+    double fullTime = 0.0;
+    float difference = 0.0f;
+    std::vector<uint32_t> moved(movedCount);
+    for (int i = 0; i < iterations; i++)
+    {
+        for (auto &m : moved)
+        {
+            m = static_cast<uint32_t>(random() % boxCount);
+            bounds[m] = Bounds3::createFromCenterSize(
+                Vector3(value(random), value(random), value(random)),
+                bounds[m].getSize());
+        }
+        partialTime += measure(1, [&]() { partialBVH.refit(bounds, moved); });
+        fullTime += measure(1, [&]() { fullBVH.refit(bounds); });
+        difference =
+            std::fmax(difference, std::abs(partialBVH.getCost() -
+                                           fullBVH.getCost()) /
+                                      fullBVH.getCost());
+    }
+    Bounds3 expectedBounds;
+    for (const auto &b : bounds)
+        expectedBounds.encapsulate(b);
+    if (partialBVH.getBounds() != expectedBounds)
+        difference = std::numeric_limits<float>::infinity();
+    const float refitCost = partialBVH.getCost();
+    partialBVH.build(bounds);
+    std::cout << "BVH SAH cost of " << boxCount << " boxes: " << builtCost
+              << " built, " << refitCost << " after moving "
+              << movedCount * iterations << " of them, "
+              << partialBVH.getCost() << " rebuilt" << std::endl;
+    printResult("BVH::refit of " + std::to_string(movedCount) + " boxes",
+                fullTime / iterations, partialTime / iterations, difference,
+                "whole tree", "paths");
+}
+
+/**
+ * Queries the world matrices of a deep hierarchy, with and without changes in
+ * between, and compares them against walking the parent chain.
+ */
+void benchmarkTransformHierarchy()
+{
+    const size_t chainCount = 64;
+    const size_t depth = 32;
+    const int iterations = 50;
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> angle(-30.0f, 30.0f);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    // Chains of transforms, similar to the node hierarchy of a skinned FBX.
+    std::vector<std::unique_ptr<TransformHierarchy>> transforms;
+    transforms.reserve(chainCount * depth);
+    for (size_t c = 0; c < chainCount; c++)
+    {
+        for (size_t d = 0; d < depth; d++)
+        {
+            transforms.emplace_back(std::make_unique<TransformHierarchy>(
+                d == 0 ? nullptr : transforms.back().get()));
+            transforms.back()->setPosition(
+                Vector3(value(random), value(random), value(random)),
+                TransformHierarchy::Space::Local);
+            transforms.back()->setRotation(
+                Vector3(angle(random), angle(random), angle(random)),
+                TransformHierarchy::Space::Local);
+        }
+    }
+
+    float checksum = 0.0f;
+    const double uncachedTime = measure(iterations, [&]() {
+        for (const auto &t : transforms)
+            checksum += uncachedWorldMatrix(*t)[0][3];
+    });
+    const double cachedTime = measure(iterations, [&]() {
+        for (const auto &t : transforms)
+            checksum += t->getMatrix()[0][3];
+    });
+    // Move the root of every chain before each query pass.
+    const double changedTime = measure(iterations, [&]() {
+        for (size_t c = 0; c < chainCount; c++)
+            transforms[c * depth]->translate(Vector3(0.001f, 0.0f, 0.0f),
+                                             TransformHierarchy::Space::Local);
+        for (const auto &t : transforms)
+            checksum += t->getMatrix()[0][3];
+    });
+
+    float difference = 0.0f;
+    for (const auto &t : transforms)
+        difference = std::fmax(
+            difference, maxDifference(uncachedWorldMatrix(*t), t->getMatrix()));
+    std::cout << "World matrices of " << transforms.size() << " transforms ("
+              << depth << " deep): " << uncachedTime << " ms uncached, "
+              << cachedTime << " ms cached (" << uncachedTime / cachedTime
+              << "x), " << changedTime << " ms cached with changes ("
+              << uncachedTime / changedTime << "x), " << difference
+              << " max difference "
+              << (difference < 1e-3f && std::isfinite(checksum) ? "passed"
+                                                                 : "failed")
+              << std::endl;
+}
+
+/**
+ * Updates the world matrices of a large scene stored in a TransformStore, with
+ * all, some and none of the transforms changed since the last update.
+ */
+void benchmarkTransformStore()
+{
+    const size_t treeCount = 1000;
+    const size_t treeSize = 100;
+    const int iterations = 20;
+    std::mt19937 random(13);
+    std::uniform_real_distribution<float> angle(-30.0f, 30.0f);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    // Trees of random shape, with each transform parented to an earlier one
+    // of the same tree.
+    const auto store = std::make_shared<TransformStore>();
+    std::vector<std::unique_ptr<TransformHierarchy>> transforms;
+    transforms.reserve(treeCount * treeSize);
+    for (size_t t = 0; t < treeCount; t++)
+    {
+        const size_t root = transforms.size();
+        for (size_t i = 0; i < treeSize; i++)
+        {
+            TransformHierarchy *parent =
+                i == 0 ? nullptr : transforms[root + random() % i].get();
+            transforms.emplace_back(
+                std::make_unique<TransformHierarchy>(parent, store));
+            transforms.back()->setPosition(
+                Vector3(value(random), value(random), value(random)),
+                TransformHierarchy::Space::Local);
+            transforms.back()->setRotation(
+                Vector3(angle(random), angle(random), angle(random)),
+                TransformHierarchy::Space::Local);
+        }
+    }
+
+    // The first update sorts the transforms by depth, which is measured
+    // separately.
+    const double sortTime = measure(1, [&]() { store->update(); });
+
+    // Only the update is measured, not the changes before it.
+    const auto measureUpdate = [&](size_t changeStride, bool parallel) {
+        double time = 0.0;
+        for (int i = 0; i < iterations; i++)
+        {
+            for (size_t t = i; changeStride > 0 && t < transforms.size();
+                 t += changeStride)
+                transforms[t]->translate(Vector3(0.001f, 0.0f, 0.0f),
+                                         TransformHierarchy::Space::Local);
+            time += measure(1, [&]() { store->update(parallel); });
+        }
+        return time / iterations;
+    };
+    const size_t someChangedStride = 101;
+    const double allSerialTime = measureUpdate(1, false);
+    const double allTime = measureUpdate(1, true);
+    const double someTime = measureUpdate(someChangedStride, true);
+    const double unchangedTime = measureUpdate(0, true);
+
+    float difference = 0.0f;
+    for (size_t i = 0; i < transforms.size(); i += 97)
+        difference = std::fmax(
+            difference, maxDifference(uncachedWorldMatrix(*transforms[i]),
+                                      transforms[i]->getMatrix()));
+
+    // Reparent a transform of every tree, and destroy the last one of some
+    // trees, which has no children, so that the store is sorted again.
+    const size_t transformCount = store->size();
+    for (size_t t = 0; t < treeCount; t++)
+    {
+        const size_t root = t * treeSize;
+        const size_t i = 1 + random() % (treeSize - 1);
+        transforms[root + i]->setParent(transforms[root + random() % i].get());
+        if (t % 10 == 0)
+            transforms[root + treeSize - 1].reset();
+    }
+    const double resortTime = measure(1, [&]() { store->update(); });
+    for (size_t i = 0; i < transforms.size(); i += 97)
+        if (transforms[i] != nullptr)
+            difference = std::fmax(
+                difference, maxDifference(uncachedWorldMatrix(*transforms[i]),
+                                          transforms[i]->getMatrix()));
+    const bool isResized = store->size() == transformCount - treeCount / 10;
+
+    std::cout << "TransformStore::update() of " << transformCount
+              << " transforms: " << sortTime << " ms first update, "
+              << allSerialTime
+              << " ms all changed (serial), " << allTime
+              << " ms all changed, " << someTime << " ms 1/"
+              << someChangedStride << " changed, " << unchangedTime
+              << " ms unchanged, " << resortTime
+              << " ms after changing the hierarchy, " << difference
+              << " max difference "
+              << (difference < 1e-3f && isResized ? "passed" : "failed")
+              << std::endl;
+}
+
 int main(int argc, char **argv)
 {
     std::cout << "Size of Vector2: " << sizeof(Vector2) << std::endl;
@@ -84,5 +1025,14 @@ int main(int argc, char **argv)
     std::cout << "Intersection Points: " << enterPoint << ", " << exitPoint
               << std::endl;
 
+    benchmarkMatrixOperations();
+    benchmarkAffineOperations();
+    benchmarkRayBoxIntersection();
+    benchmarkTriangleIntersection();
+    benchmarkBVHBuild();
+    benchmarkBVHRefit();
+    benchmarkTransformHierarchy();
+    benchmarkTransformStore();
+
     return 0;
 }
\ No newline at end of file
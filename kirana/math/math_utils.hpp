@@ -2,6 +2,8 @@
 #define MATH_UTILS_HPP
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 
 namespace kirana::math
@@ -92,6 +94,82 @@ inline float wrapAngle(float angle)
            (DEGREE_360 * std::floorf((angle + DEGREE_180) / DEGREE_360));
 }
 
+/**
+ * Converts a 32-bit float to a 16-bit (IEEE 754 half precision) float with
+ * round-to-nearest-even. Values out of the half range become infinity.
+ * @param value The float to convert.
+ * @return Bits of the half float.
+ */
+inline uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    const uint32_t absBits = bits & 0x7FFFFFFFu;
+
+    // Infinity and NaN
+    if (absBits >= 0x7F800000u)
+        return sign | 0x7C00u | (absBits > 0x7F800000u ? 0x0200u : 0u);
+    // Rounds to infinity (>= 65520.0)
+    if (absBits >= 0x477FF000u)
+        return sign | 0x7C00u;
+    // Half subnormals and zero (< 2^-14)
+    if (absBits < 0x38800000u)
+    {
+        if (absBits < 0x33000000u)
+            return sign;
+        const uint32_t mantissa = (absBits & 0x007FFFFFu) | 0x00800000u;
+        const uint32_t shift = 126u - (absBits >> 23);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1u);
+        if (remainder > halfway || (remainder == halfway && (half & 1u)))
+            half++;
+        return sign | static_cast<uint16_t>(half);
+    }
+    // Re-bias the exponent from 127 to 15.
+    uint32_t half = (absBits - 0x38000000u) >> 13;
+    const uint32_t remainder = absBits & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+        half++;
+    return sign | static_cast<uint16_t>(half);
+}
+
+/**
+ * Converts a 16-bit (IEEE 754 half precision) float to a 32-bit float.
+ * @param half Bits of the half float.
+ * @return The float value.
+ */
+inline float halfToFloat(uint16_t half)
+{
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x03FFu;
+
+    uint32_t bits;
+    if (exponent == 0x1Fu)
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    else if (exponent != 0)
+        bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+    else if (mantissa == 0)
+        bits = sign;
+    else
+    {
+        // Normalize the subnormal half.
+        exponent = 113u;
+        while ((mantissa & 0x0400u) == 0)
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x03FFu) << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
 } // namespace kirana::math
 
 #endif
\ No newline at end of file
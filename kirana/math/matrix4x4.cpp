@@ -1,5 +1,6 @@
 #include "math_utils.hpp"
 #include "quaternion.hpp"
+#include "simd.hpp"
 
 #include <algorithm>
 #include <string>
@@ -7,6 +8,69 @@
 using kirana::math::Matrix4x4;
 using kirana::math::Vector3;
 using kirana::math::Vector4;
+namespace simd = kirana::math::simd;
+
+namespace
+{
+inline void loadRows(const Matrix4x4 &mat, simd::Float4 rows[4])
+{
+    for (size_t i = 0; i < 4; i++)
+        rows[i] = simd::load(mat[i].data());
+}
+
+inline void storeRows(const simd::Float4 rows[4], Matrix4x4 *mat)
+{
+    for (size_t i = 0; i < 4; i++)
+        simd::store((*mat)[i].data(), rows[i]);
+}
+
+/// @return true if the last row is (0, 0, 0, 1).
+inline bool isAffine(const Matrix4x4 &mat)
+{
+    return mat[3][0] == 0.0f && mat[3][1] == 0.0f && mat[3][2] == 0.0f &&
+           mat[3][3] == 1.0f;
+}
+
+/**
+ * Stores the affine matrix made of the basis vectors c0 to c2 and the
+ * translation t. The last row of the result isn't written.
+ */
+inline void storeColumns(simd::Float4 c0, simd::Float4 c1, simd::Float4 c2,
+                         simd::Float4 t, Matrix4x4 *result)
+{
+    simd::transpose(c0, c1, c2, t);
+    simd::store((*result)[0].data(), c0);
+    simd::store((*result)[1].data(), c1);
+    simd::store((*result)[2].data(), c2);
+}
+
+// 2x2 matrix helpers for inverse(). The matrices are stored as
+// (m00, m01, m10, m11).
+
+/// @return a * b
+inline simd::Float4 multiply2x2(simd::Float4 a, simd::Float4 b)
+{
+    return simd::mulAdd(a, simd::swizzle<0, 3, 0, 3>(b),
+                        simd::mul(simd::swizzle<1, 0, 3, 2>(a),
+                                  simd::swizzle<2, 1, 2, 1>(b)));
+}
+
+/// @return adjugate(a) * b
+inline simd::Float4 adjugateMultiply2x2(simd::Float4 a, simd::Float4 b)
+{
+    return simd::sub(simd::mul(simd::swizzle<3, 3, 0, 0>(a), b),
+                     simd::mul(simd::swizzle<1, 1, 2, 2>(a),
+                               simd::swizzle<2, 3, 0, 1>(b)));
+}
+
+/// @return a * adjugate(b)
+inline simd::Float4 multiplyAdjugate2x2(simd::Float4 a, simd::Float4 b)
+{
+    return simd::sub(simd::mul(a, simd::swizzle<3, 0, 3, 0>(b)),
+                     simd::mul(simd::swizzle<1, 0, 3, 2>(a),
+                               simd::swizzle<2, 1, 2, 1>(b)));
+}
+} // namespace
 
 const Matrix4x4 Matrix4x4::IDENTITY = Matrix4x4();
 
@@ -29,29 +93,6 @@ float Matrix4x4::m_determinant3x3(float m00, float m01, float m02, float m10,
            m02 * m_determinant2x2(m10, m11, m20, m21);
 }
 
-Matrix4x4::Matrix4x4(const Matrix4x4 &mat)
-{
-    if (&mat != this)
-        m_current = mat.m_current;
-}
-
-Matrix4x4 &Matrix4x4::operator=(const Matrix4x4 &mat)
-{
-    if (&mat != this)
-        m_current = mat.m_current;
-    return *this;
-}
-
-const Vector4 &Matrix4x4::operator[](size_t i) const
-{
-    return m_current[i];
-}
-
-Vector4 &Matrix4x4::operator[](size_t i)
-{
-    return m_current[i];
-}
-
 
 bool Matrix4x4::operator==(const Matrix4x4 &mat) const
 {
@@ -87,98 +128,10 @@ kirana::math::Matrix4x4::operator std::string() const
 
 Matrix4x4 &Matrix4x4::operator*=(const Matrix4x4 &rhs)
 {
-    Vector4 temp[4]{m_current[0], m_current[1], m_current[2], m_current[3]};
-    m_current[0][0] = temp[0][0] * rhs[0][0] + temp[0][1] * rhs[1][0] +
-                      temp[0][2] * rhs[2][0] + temp[0][3] * rhs[3][0];
-    m_current[0][1] = temp[0][0] * rhs[0][1] + temp[0][1] * rhs[1][1] +
-                      temp[0][2] * rhs[2][1] + temp[0][3] * rhs[3][1];
-    m_current[0][2] = temp[0][0] * rhs[0][2] + temp[0][1] * rhs[1][2] +
-                      temp[0][2] * rhs[2][2] + temp[0][3] * rhs[3][2];
-    m_current[0][3] = temp[0][0] * rhs[0][3] + temp[0][1] * rhs[1][3] +
-                      temp[0][2] * rhs[2][3] + temp[0][3] * rhs[3][3];
-
-    m_current[1][0] = temp[1][0] * rhs[0][0] + temp[1][1] * rhs[1][0] +
-                      temp[1][2] * rhs[2][0] + temp[1][3] * rhs[3][0];
-    m_current[1][1] = temp[1][0] * rhs[0][1] + temp[1][1] * rhs[1][1] +
-                      temp[1][2] * rhs[2][1] + temp[1][3] * rhs[3][1];
-    m_current[1][2] = temp[1][0] * rhs[0][2] + temp[1][1] * rhs[1][2] +
-                      temp[1][2] * rhs[2][2] + temp[1][3] * rhs[3][2];
-    m_current[1][3] = temp[1][0] * rhs[0][3] + temp[1][1] * rhs[1][3] +
-                      temp[1][2] * rhs[2][3] + temp[1][3] * rhs[3][3];
-
-    m_current[2][0] = temp[2][0] * rhs[0][0] + temp[2][1] * rhs[1][0] +
-                      temp[2][2] * rhs[2][0] + temp[2][3] * rhs[3][0];
-    m_current[2][1] = temp[2][0] * rhs[0][1] + temp[2][1] * rhs[1][1] +
-                      temp[2][2] * rhs[2][1] + temp[2][3] * rhs[3][1];
-    m_current[2][2] = temp[2][0] * rhs[0][2] + temp[2][1] * rhs[1][2] +
-                      temp[2][2] * rhs[2][2] + temp[2][3] * rhs[3][2];
-    m_current[2][3] = temp[2][0] * rhs[0][3] + temp[2][1] * rhs[1][3] +
-                      temp[2][2] * rhs[2][3] + temp[2][3] * rhs[3][3];
-
-    m_current[3][0] = temp[3][0] * rhs[0][0] + temp[3][1] * rhs[1][0] +
-                      temp[3][2] * rhs[2][0] + temp[3][3] * rhs[3][0];
-    m_current[3][1] = temp[3][0] * rhs[0][1] + temp[3][1] * rhs[1][1] +
-                      temp[3][2] * rhs[2][1] + temp[3][3] * rhs[3][1];
-    m_current[3][2] = temp[3][0] * rhs[0][2] + temp[3][1] * rhs[1][2] +
-                      temp[3][2] * rhs[2][2] + temp[3][3] * rhs[3][2];
-    m_current[3][3] = temp[3][0] * rhs[0][3] + temp[3][1] * rhs[1][3] +
-                      temp[3][2] * rhs[2][3] + temp[3][3] * rhs[3][3];
+    *this = *this * rhs;
     return *this;
 }
 
-Matrix4x4 kirana::math::operator*(const Matrix4x4 &mat1, const Matrix4x4 &mat2)
-{
-    return Matrix4x4(mat1[0][0] * mat2[0][0] + mat1[0][1] * mat2[1][0] +
-                         mat1[0][2] * mat2[2][0] + mat1[0][3] * mat2[3][0],
-                     mat1[0][0] * mat2[0][1] + mat1[0][1] * mat2[1][1] +
-                         mat1[0][2] * mat2[2][1] + mat1[0][3] * mat2[3][1],
-                     mat1[0][0] * mat2[0][2] + mat1[0][1] * mat2[1][2] +
-                         mat1[0][2] * mat2[2][2] + mat1[0][3] * mat2[3][2],
-                     mat1[0][0] * mat2[0][3] + mat1[0][1] * mat2[1][3] +
-                         mat1[0][2] * mat2[2][3] + mat1[0][3] * mat2[3][3],
-                     mat1[1][0] * mat2[0][0] + mat1[1][1] * mat2[1][0] +
-                         mat1[1][2] * mat2[2][0] + mat1[1][3] * mat2[3][0],
-                     mat1[1][0] * mat2[0][1] + mat1[1][1] * mat2[1][1] +
-                         mat1[1][2] * mat2[2][1] + mat1[1][3] * mat2[3][1],
-                     mat1[1][0] * mat2[0][2] + mat1[1][1] * mat2[1][2] +
-                         mat1[1][2] * mat2[2][2] + mat1[1][3] * mat2[3][2],
-                     mat1[1][0] * mat2[0][3] + mat1[1][1] * mat2[1][3] +
-                         mat1[1][2] * mat2[2][3] + mat1[1][3] * mat2[3][3],
-                     mat1[2][0] * mat2[0][0] + mat1[2][1] * mat2[1][0] +
-                         mat1[2][2] * mat2[2][0] + mat1[2][3] * mat2[3][0],
-                     mat1[2][0] * mat2[0][1] + mat1[2][1] * mat2[1][1] +
-                         mat1[2][2] * mat2[2][1] + mat1[2][3] * mat2[3][1],
-                     mat1[2][0] * mat2[0][2] + mat1[2][1] * mat2[1][2] +
-                         mat1[2][2] * mat2[2][2] + mat1[2][3] * mat2[3][2],
-                     mat1[2][0] * mat2[0][3] + mat1[2][1] * mat2[1][3] +
-                         mat1[2][2] * mat2[2][3] + mat1[2][3] * mat2[3][3],
-                     mat1[3][0] * mat2[0][0] + mat1[3][1] * mat2[1][0] +
-                         mat1[3][2] * mat2[2][0] + mat1[3][3] * mat2[3][0],
-                     mat1[3][0] * mat2[0][1] + mat1[3][1] * mat2[1][1] +
-                         mat1[3][2] * mat2[2][1] + mat1[3][3] * mat2[3][1],
-                     mat1[3][0] * mat2[0][2] + mat1[3][1] * mat2[1][2] +
-                         mat1[3][2] * mat2[2][2] + mat1[3][3] * mat2[3][2],
-                     mat1[3][0] * mat2[0][3] + mat1[3][1] * mat2[1][3] +
-                         mat1[3][2] * mat2[2][3] + mat1[3][3] * mat2[3][3]);
-}
-
-Vector4 kirana::math::operator*(const Matrix4x4 &mat, const Vector4 &vec4)
-{
-    return Vector4(mat[0][0] * vec4[0] + mat[0][1] * vec4[1] +
-                       mat[0][2] * vec4[2] + mat[0][3] * vec4[3],
-                   mat[1][0] * vec4[0] + mat[1][1] * vec4[1] +
-                       mat[1][2] * vec4[2] + mat[1][3] * vec4[3],
-                   mat[2][0] * vec4[0] + mat[2][1] * vec4[1] +
-                       mat[2][2] * vec4[2] + mat[2][3] * vec4[3],
-                   mat[3][0] * vec4[0] + mat[3][1] * vec4[1] +
-                       mat[3][2] * vec4[2] + mat[3][3] * vec4[3]);
-}
-
-Vector3 kirana::math::operator*(const Matrix4x4 &mat, const Vector3 &vec3)
-{
-    return static_cast<Vector3>(mat * ::Vector4(vec3, 1.0f));
-}
-
 std::ostream &kirana::math::operator<<(std::ostream &out, const Matrix4x4 &mat)
 {
     return out << static_cast<std::string>(mat);
@@ -207,10 +160,12 @@ float Matrix4x4::determinant() const
 
 Matrix4x4 Matrix4x4::transpose(const Matrix4x4 &mat)
 {
-    return Matrix4x4(mat[0][0], mat[1][0], mat[2][0], mat[3][0], mat[0][1],
-                     mat[1][1], mat[2][1], mat[3][1], mat[0][2], mat[1][2],
-                     mat[2][2], mat[3][2], mat[0][3], mat[1][3], mat[2][3],
-                     mat[3][3]);
+    simd::Float4 rows[4];
+    loadRows(mat, rows);
+    simd::transpose(rows[0], rows[1], rows[2], rows[3]);
+    Matrix4x4 result;
+    storeRows(rows, &result);
+    return result;
 }
 
 Matrix4x4 Matrix4x4::multiply(const Matrix4x4 &mat1, const Matrix4x4 &mat2)
@@ -220,77 +175,114 @@ Matrix4x4 Matrix4x4::multiply(const Matrix4x4 &mat1, const Matrix4x4 &mat2)
 
 Matrix4x4 Matrix4x4::inverse(const Matrix4x4 &mat)
 {
-    // Gauss Jordan Elimination method of finding inverse.
-
-    int indxc[4], indxr[4];
-    int ipiv[4] = {0, 0, 0, 0};
-    std::array<Vector4, 4> minv {mat[0], mat[1], mat[2], mat[3]};
-    for (int i = 0; i < 4; i++)
-    {
-        int irow = 0, icol = 0;
-        float big = 0.0f;
-        // Choose pivot
-        for (int j = 0; j < 4; j++)
-        {
-            if (ipiv[j] != 1)
-            {
-                for (int k = 0; k < 4; k++)
-                {
-                    if (ipiv[k] == 0)
-                    {
-                        if (std::abs(minv[j][k]) >= big)
-                        {
-                            big = std::fabsf(minv[j][k]);
-                            irow = j;
-                            icol = k;
-                        }
-                    }
-                    else if (ipiv[k] > 1)
-                        return Matrix4x4::IDENTITY; // Singular matrix, cannot
-                                                    // find inverse.
-                }
-            }
-        }
-        ++ipiv[icol];
-        // Swap rows _irow_ and _icol_ for pivot
-        if (irow != icol)
-        {
-            for (int k = 0; k < 4; ++k)
-                std::swap(minv[irow][k], minv[icol][k]);
-        }
-        indxr[i] = irow;
-        indxc[i] = icol;
-        if (minv[icol][icol] == 0.f)
-            return Matrix4x4::IDENTITY; // Singular matrix, cannot find inverse.
-
-        // Set $m[icol][icol]$ to one by scaling row _icol_ appropriately
-        float pivinv = 1.0f / minv[icol][icol];
-        minv[icol][icol] = 1.;
-        for (int j = 0; j < 4; j++)
-            minv[icol][j] *= pivinv;
-
-        // Subtract this row from others to zero out their columns
-        for (int j = 0; j < 4; j++)
-        {
-            if (j != icol)
-            {
-                float save = minv[j][icol];
-                minv[j][icol] = 0;
-                for (int k = 0; k < 4; k++)
-                    minv[j][k] -= minv[icol][k] * save;
-            }
-        }
-    }
-    // Swap columns to reflect permutation
-    for (int j = 3; j >= 0; j--)
-    {
-        if (indxr[j] != indxc[j])
-        {
-            for (int k = 0; k < 4; k++)
-                std::swap(minv[k][indxr[j]], minv[k][indxc[j]]);
-        }
-    }
-    return Matrix4x4(minv);
+    // Blockwise inversion, treating the matrix as the 2x2 blocks
+    // | A B |
+    // | C D |
+    // Based on Eric Zhang, "Fast 4x4 Matrix Inverse with SSE SIMD, Explained".
+    // @link
+    // {https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html}
+
+    simd::Float4 rows[4];
+    loadRows(mat, rows);
+    const simd::Float4 a = simd::shuffle<0, 1, 0, 1>(rows[0], rows[1]);
+    const simd::Float4 b = simd::shuffle<2, 3, 2, 3>(rows[0], rows[1]);
+    const simd::Float4 c = simd::shuffle<0, 1, 0, 1>(rows[2], rows[3]);
+    const simd::Float4 d = simd::shuffle<2, 3, 2, 3>(rows[2], rows[3]);
+
+    // Determinants of A, B, C and D.
+    const simd::Float4 subDeterminants = simd::sub(
+        simd::mul(simd::shuffle<0, 2, 0, 2>(rows[0], rows[2]),
+                  simd::shuffle<1, 3, 1, 3>(rows[1], rows[3])),
+        simd::mul(simd::shuffle<1, 3, 1, 3>(rows[0], rows[2]),
+                  simd::shuffle<0, 2, 0, 2>(rows[1], rows[3])));
+    const simd::Float4 detA = simd::splat<0>(subDeterminants);
+    const simd::Float4 detB = simd::splat<1>(subDeterminants);
+    const simd::Float4 detC = simd::splat<2>(subDeterminants);
+    const simd::Float4 detD = simd::splat<3>(subDeterminants);
+
+    const simd::Float4 adjDC = adjugateMultiply2x2(d, c);
+    const simd::Float4 adjAB = adjugateMultiply2x2(a, b);
+    // |D|A - B(D#C), |A|D - C(A#B), |B|C - D(A#B)#, |C|B - A(D#C)#
+    simd::Float4 x = simd::sub(simd::mul(detD, a), multiply2x2(b, adjDC));
+    simd::Float4 w = simd::sub(simd::mul(detA, d), multiply2x2(c, adjAB));
+    simd::Float4 y =
+        simd::sub(simd::mul(detB, c), multiplyAdjugate2x2(d, adjAB));
+    simd::Float4 z =
+        simd::sub(simd::mul(detC, b), multiplyAdjugate2x2(a, adjDC));
+
+    // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    const simd::Float4 trace = simd::horizontalAdd(
+        simd::mul(adjAB, simd::swizzle<0, 2, 1, 3>(adjDC)));
+    const simd::Float4 determinant = simd::sub(
+        simd::mulAdd(detA, detD, simd::mul(detB, detC)), trace);
+    if (simd::getX(determinant) == 0.0f)
+        return Matrix4x4::IDENTITY; // Singular matrix, cannot find inverse.
+
+    const simd::Float4 invDeterminant =
+        simd::div(simd::set(1.0f, -1.0f, -1.0f, 1.0f), determinant);
+    x = simd::mul(x, invDeterminant);
+    y = simd::mul(y, invDeterminant);
+    z = simd::mul(z, invDeterminant);
+    w = simd::mul(w, invDeterminant);
+
+    // Apply the adjugate of each block while writing out the rows.
+    rows[0] = simd::shuffle<3, 1, 3, 1>(x, y);
+    rows[1] = simd::shuffle<2, 0, 2, 0>(x, y);
+    rows[2] = simd::shuffle<3, 1, 3, 1>(z, w);
+    rows[3] = simd::shuffle<2, 0, 2, 0>(z, w);
+    Matrix4x4 result;
+    storeRows(rows, &result);
+    return result;
+}
+
+Matrix4x4 Matrix4x4::affineInverse(const Matrix4x4 &mat)
+{
+    if (!isAffine(mat))
+        return inverse(mat);
+
+    // The inverse of | A t | is | A^-1  -A^-1 t |. The columns of A^-1 are the
+    // cross products of the rows of A, divided by the determinant. The
+    // translation in the w lanes doesn't affect the cross products, and the
+    // w lanes of the results end up in the last row, which isn't stored.
+    simd::Float4 rows[4];
+    loadRows(mat, rows);
+    simd::Float4 c0 = simd::cross3(rows[1], rows[2]);
+    simd::Float4 c1 = simd::cross3(rows[2], rows[0]);
+    simd::Float4 c2 = simd::cross3(rows[0], rows[1]);
+    const float determinant = simd::dot3(rows[0], c0);
+    if (determinant == 0.0f)
+        return Matrix4x4::IDENTITY; // Singular matrix, cannot find inverse.
+
+    const simd::Float4 invDeterminant = simd::splat(1.0f / determinant);
+    c0 = simd::mul(c0, invDeterminant);
+    c1 = simd::mul(c1, invDeterminant);
+    c2 = simd::mul(c2, invDeterminant);
+    simd::Float4 t = simd::mul(c0, simd::splat<3>(rows[0]));
+    t = simd::mulAdd(c1, simd::splat<3>(rows[1]), t);
+    t = simd::mulAdd(c2, simd::splat<3>(rows[2]), t);
+
+    Matrix4x4 result;
+    storeColumns(c0, c1, c2, simd::sub(simd::splat(0.0f), t), &result);
+    return result;
+}
+
+Matrix4x4 Matrix4x4::rigidInverse(const Matrix4x4 &mat)
+{
+    if (!isAffine(mat))
+        return inverse(mat);
+
+    // The inverse of | R t | is | R^T  -R^T t |, so the columns of the
+    // inverse are the rows of R.
+    simd::Float4 rows[4];
+    loadRows(mat, rows);
+    simd::Float4 t = simd::mul(rows[0], simd::splat<3>(rows[0]));
+    t = simd::mulAdd(rows[1], simd::splat<3>(rows[1]), t);
+    t = simd::mulAdd(rows[2], simd::splat<3>(rows[2]), t);
+
+    Matrix4x4 result;
+    storeColumns(rows[0], rows[1], rows[2], simd::sub(simd::splat(0.0f), t),
+                 &result);
+    return result;
 }
 
 bool Matrix4x4::decompose(const Matrix4x4 &mat, Vector3 *translation,
@@ -392,6 +384,54 @@ bool Matrix4x4::decompose(const Matrix4x4 &mat, Vector3 *translation,
     return true;
 }
 
+bool Matrix4x4::decomposeTRS(const Matrix4x4 &mat, Vector3 *translation,
+                             Quaternion *rotation, Vector3 *scale)
+{
+    if (!isAffine(mat))
+        return false;
+    if (translation != nullptr)
+        *translation = Vector3(mat[0][3], mat[1][3], mat[2][3]);
+    if (rotation == nullptr && scale == nullptr)
+        return true;
+
+    simd::Float4 columns[4];
+    loadRows(mat, columns);
+    simd::transpose(columns[0], columns[1], columns[2], columns[3]);
+
+    // Lengths of the basis vectors, in the xyz lanes.
+    simd::Float4 lengths[4] = {simd::mul(columns[0], columns[0]),
+                               simd::mul(columns[1], columns[1]),
+                               simd::mul(columns[2], columns[2]),
+                               simd::splat(0.0f)};
+    simd::transpose(lengths[0], lengths[1], lengths[2], lengths[3]);
+    simd::Float4 scales = simd::sqrt(
+        simd::add(simd::add(lengths[0], lengths[1]), lengths[2]));
+    // Negative determinant, flip all the axes like decompose().
+    if (simd::dot3(columns[0], simd::cross3(columns[1], columns[2])) < 0.0f)
+        scales = simd::sub(simd::splat(0.0f), scales);
+
+    float scaleValues[4];
+    simd::store(scaleValues, scales);
+    if (scale != nullptr)
+        *scale = Vector3(scaleValues[0], scaleValues[1], scaleValues[2]);
+    if (rotation == nullptr)
+        return true;
+    if (scaleValues[0] == 0.0f || scaleValues[1] == 0.0f ||
+        scaleValues[2] == 0.0f)
+        return false;
+
+    // Rotation matrix from the normalized basis vectors.
+    simd::Float4 rows[4] = {
+        simd::div(columns[0], simd::splat<0>(scales)),
+        simd::div(columns[1], simd::splat<1>(scales)),
+        simd::div(columns[2], simd::splat<2>(scales)), simd::splat(0.0f)};
+    simd::transpose(rows[0], rows[1], rows[2], rows[3]);
+    Matrix4x4 rotationMatrix;
+    storeRows(rows, &rotationMatrix);
+    *rotation = Quaternion::matrix(rotationMatrix);
+    return true;
+}
+
 bool Matrix4x4::decomposeProjection(const Matrix4x4 &mat, Vector4 *perspective,
                                     Vector3 *translation, Vector3 *scale,
                                     Vector3 *skew, Vector3 *rotation)
@@ -1,12 +1,13 @@
 #ifndef MATRIX4X4_HPP
 #define MATRIX4X4_HPP
 
+#include "simd.hpp"
+#include "vector3.hpp"
 #include "vector4.hpp"
 #include <iostream>
 
 namespace kirana::math
 {
-class Vector3;
 class Quaternion;
 /**
  * Row-Major (storage) 4x4 Matrix. First three columns represent the basis
@@ -60,11 +61,17 @@ class Matrix4x4
           } {};
     ~Matrix4x4() = default;
 
-    Matrix4x4(const Matrix4x4 &mat);
-    Matrix4x4 &operator=(const Matrix4x4 &mat);
+    Matrix4x4(const Matrix4x4 &mat) = default;
+    Matrix4x4 &operator=(const Matrix4x4 &mat) = default;
 
-    const Vector4 &operator[](size_t i) const;
-    Vector4 &operator[](size_t i);
+    inline const Vector4 &operator[](size_t i) const
+    {
+        return m_current[i];
+    }
+    inline Vector4 &operator[](size_t i)
+    {
+        return m_current[i];
+    }
 
     bool operator==(const Matrix4x4 &mat) const;
     bool operator!=(const Matrix4x4 &mat) const;
@@ -73,9 +80,6 @@ class Matrix4x4
 
     Matrix4x4 &operator*=(const Matrix4x4 &rhs);
 
-    friend Matrix4x4 operator*(const Matrix4x4 &mat1, const Matrix4x4 &mat2);
-    friend Vector4 operator*(const Matrix4x4 &mat, const Vector4 &vec4);
-    friend Vector3 operator*(const Matrix4x4 &mat, const Vector3 &vec3);
     friend std::ostream &operator<<(std::ostream &out, const Matrix4x4 &mat);
 
     [[nodiscard]] inline size_t size() const
@@ -94,6 +98,19 @@ class Matrix4x4
     static Matrix4x4 transpose(const Matrix4x4 &mat);
     static Matrix4x4 multiply(const Matrix4x4 &mat1, const Matrix4x4 &mat2);
     static Matrix4x4 inverse(const Matrix4x4 &mat);
+    /**
+     * Inverse of an affine matrix, whose last row is (0, 0, 0, 1), such as
+     * any combination of translation, rotation and scale. Faster than
+     * inverse(), which is used for other matrices.
+     * @return The inverse, or the identity matrix if the matrix is singular.
+     */
+    static Matrix4x4 affineInverse(const Matrix4x4 &mat);
+    /**
+     * Inverse of a matrix with only translation and rotation. The result is
+     * undefined if the matrix has scale or skew. Uses inverse() for matrices
+     * that aren't affine.
+     */
+    static Matrix4x4 rigidInverse(const Matrix4x4 &mat);
 
     // Transformation functions
     /**
@@ -127,6 +144,22 @@ class Matrix4x4
      */
     static bool decompose(const Matrix4x4 &mat, Vector3 *translation,
                           Quaternion *rotation);
+    /**
+     * Decomposes an affine matrix into translation, rotation and scale. Faster
+     * than decompose(), but doesn't remove skew. The scale is the length of
+     * each basis vector.
+     * @param mat The matrix to decompose.
+     * @param translation Pointer to Vector3 object to which translation will be
+     * written out to.
+     * @param rotation Pointer to Quaternion object to which rotation will be
+     * written out to.
+     * @param scale Pointer to Vector3 object to which scale will be written
+     * out to.
+     * @return false if the matrix isn't affine, or the rotation is requested
+     * and the matrix has zero scale.
+     */
+    static bool decomposeTRS(const Matrix4x4 &mat, Vector3 *translation,
+                             Quaternion *rotation, Vector3 *scale = nullptr);
     /**
      * Decomposes the given transformation matrix into individual transformation
      * components.
@@ -175,6 +208,47 @@ class Matrix4x4
                                            bool graphicsAPI = false,
                                            bool flipY = false);
 };
+
+// The products are defined here so that they're inlined into the loops that
+// use them, like the transform hierarchy, which matters more than the
+// arithmetic itself for such small operations. The compiler vectorizes the
+// products with a matrix and with a Vector4 as well as intrinsics do, so only
+// the product with a Vector3, which it keeps scalar, uses them.
+
+inline Matrix4x4 operator*(const Matrix4x4 &mat1, const Matrix4x4 &mat2)
+{
+    Matrix4x4 result;
+    for (size_t i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            result[i][j] = mat1[i][0] * mat2[0][j] + mat1[i][1] * mat2[1][j] +
+                           mat1[i][2] * mat2[2][j] + mat1[i][3] * mat2[3][j];
+    return result;
+}
+
+inline Vector4 operator*(const Matrix4x4 &mat, const Vector4 &vec4)
+{
+    Vector4 result;
+    for (int i = 0; i < 4; i++)
+        result[i] = mat[i][0] * vec4[0] + mat[i][1] * vec4[1] +
+                    mat[i][2] * vec4[2] + mat[i][3] * vec4[3];
+    return result;
+}
+
+inline Vector3 operator*(const Matrix4x4 &mat, const Vector3 &vec3)
+{
+    // Same as with a Vector4 whose w is 1, without the last row.
+    const simd::Float4 v = simd::add(simd::load3(vec3.data()),
+                                     simd::set(0.0f, 0.0f, 0.0f, 1.0f));
+    simd::Float4 p0 = simd::mul(simd::load(mat[0].data()), v);
+    simd::Float4 p1 = simd::mul(simd::load(mat[1].data()), v);
+    simd::Float4 p2 = simd::mul(simd::load(mat[2].data()), v);
+    simd::Float4 p3 = simd::splat(0.0f);
+    simd::transpose(p0, p1, p2, p3);
+    Vector3 result;
+    simd::store3(result.data(),
+                 simd::add(simd::add(p0, p1), simd::add(p2, p3)));
+    return result;
+}
 } // namespace kirana::math
 
 #endif
\ No newline at end of file
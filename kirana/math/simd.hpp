@@ -0,0 +1,368 @@
+#ifndef KIRANA_MATH_SIMD_HPP
+#define KIRANA_MATH_SIMD_HPP
+
+#include <cmath>
+
+#if defined(KIRANA_MATH_SIMD_DISABLED)
+// Scalar fallback only, used to compare against the SIMD backends.
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define KIRANA_MATH_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define KIRANA_MATH_SIMD_FMA
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define KIRANA_MATH_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/**
+ * Thin wrapper over 4-wide float SIMD registers, so that the vector and matrix
+ * operations are written once for SSE2 (with FMA where available), NEON and a
+ * scalar fallback. All loads and stores are unaligned, which keeps the memory
+ * layout of Vector4 and Matrix4x4 unchanged.
+ */
+namespace kirana::math::simd
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+using Float4 = __m128;
+#elif defined(KIRANA_MATH_SIMD_NEON)
+using Float4 = float32x4_t;
+#else
+struct Float4
+{
+    float v[4];
+};
+#endif
+
+/// Loads 4 floats.
+inline Float4 load(const float *data)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_loadu_ps(data);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vld1q_f32(data);
+#else
+    return Float4{{data[0], data[1], data[2], data[3]}};
+#endif
+}
+
+/// Loads 3 floats, w is set to 0. Never reads past data[2].
+inline Float4 load3(const float *data)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    const __m128 xy =
+        _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(data)));
+    return _mm_movelh_ps(xy, _mm_load_ss(data + 2));
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vcombine_f32(vld1_f32(data),
+                        vset_lane_f32(data[2], vdup_n_f32(0.0f), 0));
+#else
+    return Float4{{data[0], data[1], data[2], 0.0f}};
+#endif
+}
+
+/// Stores 4 floats.
+inline void store(float *data, Float4 a)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    _mm_storeu_ps(data, a);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    vst1q_f32(data, a);
+#else
+    for (int i = 0; i < 4; i++)
+        data[i] = a.v[i];
+#endif
+}
+
+/// Stores x, y and z. Never writes past data[2].
+inline void store3(float *data, Float4 a)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    _mm_store_sd(reinterpret_cast<double *>(data), _mm_castps_pd(a));
+    _mm_store_ss(data + 2, _mm_movehl_ps(a, a));
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    vst1_f32(data, vget_low_f32(a));
+    vst1q_lane_f32(data + 2, a, 2);
+#else
+    for (int i = 0; i < 3; i++)
+        data[i] = a.v[i];
+#endif
+}
+
+inline Float4 set(float x, float y, float z, float w)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_setr_ps(x, y, z, w);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    const float data[4]{x, y, z, w};
+    return vld1q_f32(data);
+#else
+    return Float4{{x, y, z, w}};
+#endif
+}
+
+/// Sets all the lanes to the value.
+inline Float4 splat(float value)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_set1_ps(value);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vdupq_n_f32(value);
+#else
+    return Float4{{value, value, value, value}};
+#endif
+}
+
+/// @return The first lane.
+inline float getX(Float4 a)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_cvtss_f32(a);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vgetq_lane_f32(a, 0);
+#else
+    return a.v[0];
+#endif
+}
+
+/**
+ * Picks lanes X and Y from a and lanes Z and W from b, like _mm_shuffle_ps().
+ */
+template <int X, int Y, int Z, int W> inline Float4 shuffle(Float4 a, Float4 b)
+{
+    static_assert(X >= 0 && X < 4 && Y >= 0 && Y < 4 && Z >= 0 && Z < 4 &&
+                  W >= 0 && W < 4);
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    Float4 result = vdupq_n_f32(vgetq_lane_f32(a, X));
+    result = vsetq_lane_f32(vgetq_lane_f32(a, Y), result, 1);
+    result = vsetq_lane_f32(vgetq_lane_f32(b, Z), result, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(b, W), result, 3);
+#else
+    return Float4{{a.v[X], a.v[Y], b.v[Z], b.v[W]}};
+#endif
+}
+
+/// Reorders the lanes of a.
+template <int X, int Y, int Z, int W> inline Float4 swizzle(Float4 a)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_castsi128_ps(
+        _mm_shuffle_epi32(_mm_castps_si128(a), _MM_SHUFFLE(W, Z, Y, X)));
+#else
+    return shuffle<X, Y, Z, W>(a, a);
+#endif
+}
+
+/// Sets all the lanes to lane I of a.
+template <int I> inline Float4 splat(Float4 a)
+{
+#if defined(KIRANA_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vdupq_laneq_f32(a, I);
+#else
+    return swizzle<I, I, I, I>(a);
+#endif
+}
+
+inline Float4 add(Float4 a, Float4 b)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_add_ps(a, b);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vaddq_f32(a, b);
+#else
+    return Float4{{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2],
+                   a.v[3] + b.v[3]}};
+#endif
+}
+
+inline Float4 sub(Float4 a, Float4 b)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_sub_ps(a, b);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vsubq_f32(a, b);
+#else
+    return Float4{{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2],
+                   a.v[3] - b.v[3]}};
+#endif
+}
+
+inline Float4 mul(Float4 a, Float4 b)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_mul_ps(a, b);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vmulq_f32(a, b);
+#else
+    return Float4{{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2],
+                   a.v[3] * b.v[3]}};
+#endif
+}
+
+inline Float4 div(Float4 a, Float4 b)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_div_ps(a, b);
+#elif defined(KIRANA_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vdivq_f32(a, b);
+#else
+    float lhs[4], rhs[4];
+    store(lhs, a);
+    store(rhs, b);
+    return set(lhs[0] / rhs[0], lhs[1] / rhs[1], lhs[2] / rhs[2],
+               lhs[3] / rhs[3]);
+#endif
+}
+
+inline Float4 sqrt(Float4 a)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_sqrt_ps(a);
+#elif defined(KIRANA_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vsqrtq_f32(a);
+#else
+    float values[4];
+    store(values, a);
+    return set(std::sqrt(values[0]), std::sqrt(values[1]),
+               std::sqrt(values[2]), std::sqrt(values[3]));
+#endif
+}
+
+/// @return a * b + c, fused where the target supports it.
+inline Float4 mulAdd(Float4 a, Float4 b, Float4 c)
+{
+#if defined(KIRANA_MATH_SIMD_FMA)
+    return _mm_fmadd_ps(a, b, c);
+#elif defined(KIRANA_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vfmaq_f32(c, a, b);
+#else
+    return add(mul(a, b), c);
+#endif
+}
+
+inline Float4 min(Float4 a, Float4 b)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_min_ps(a, b);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vminq_f32(a, b);
+#else
+    return Float4{{std::fmin(a.v[0], b.v[0]), std::fmin(a.v[1], b.v[1]),
+                   std::fmin(a.v[2], b.v[2]), std::fmin(a.v[3], b.v[3])}};
+#endif
+}
+
+inline Float4 max(Float4 a, Float4 b)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_max_ps(a, b);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vmaxq_f32(a, b);
+#else
+    return Float4{{std::fmax(a.v[0], b.v[0]), std::fmax(a.v[1], b.v[1]),
+                   std::fmax(a.v[2], b.v[2]), std::fmax(a.v[3], b.v[3])}};
+#endif
+}
+
+/// @return A mask with the lanes where a <= b set.
+inline Float4 lessEqual(Float4 a, Float4 b)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_cmple_ps(a, b);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vreinterpretq_f32_u32(vcleq_f32(a, b));
+#else
+    // Only the sign bit of the mask is used by select() and moveMask().
+    Float4 result;
+    for (int i = 0; i < 4; i++)
+        result.v[i] = a.v[i] <= b.v[i] ? -1.0f : 0.0f;
+    return result;
+#endif
+}
+
+/// @return The lanes of a where the mask is set, and of b elsewhere.
+inline Float4 select(Float4 mask, Float4 a, Float4 b)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+#else
+    return Float4{{std::signbit(mask.v[0]) ? a.v[0] : b.v[0],
+                   std::signbit(mask.v[1]) ? a.v[1] : b.v[1],
+                   std::signbit(mask.v[2]) ? a.v[2] : b.v[2],
+                   std::signbit(mask.v[3]) ? a.v[3] : b.v[3]}};
+#endif
+}
+
+/// @return The sign bits of the lanes, lane 0 in bit 0.
+inline int moveMask(Float4 a)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    return _mm_movemask_ps(a);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    const uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(a), 31);
+    return static_cast<int>(vgetq_lane_u32(bits, 0) |
+                            (vgetq_lane_u32(bits, 1) << 1) |
+                            (vgetq_lane_u32(bits, 2) << 2) |
+                            (vgetq_lane_u32(bits, 3) << 3));
+#else
+    return (std::signbit(a.v[0]) ? 1 : 0) | (std::signbit(a.v[1]) ? 2 : 0) |
+           (std::signbit(a.v[2]) ? 4 : 0) | (std::signbit(a.v[3]) ? 8 : 0);
+#endif
+}
+
+/// Sum of all the lanes, in every lane.
+inline Float4 horizontalAdd(Float4 a)
+{
+    const Float4 sum = add(a, swizzle<1, 0, 3, 2>(a));
+    return add(sum, swizzle<2, 3, 0, 1>(sum));
+}
+
+inline float dot4(Float4 a, Float4 b)
+{
+    return getX(horizontalAdd(mul(a, b)));
+}
+
+/// Dot product of the xyz lanes.
+inline float dot3(Float4 a, Float4 b)
+{
+    const Float4 product = mul(a, b);
+    return getX(add(add(product, splat<1>(product)), splat<2>(product)));
+}
+
+/// Cross product of the xyz lanes. The w lane is unspecified.
+inline Float4 cross3(Float4 a, Float4 b)
+{
+    const Float4 product =
+        sub(mul(a, swizzle<1, 2, 0, 3>(b)), mul(swizzle<1, 2, 0, 3>(a), b));
+    return swizzle<1, 2, 0, 3>(product);
+}
+
+/// Transposes the 4x4 matrix made of the rows r0 to r3 in place.
+inline void transpose(Float4 &r0, Float4 &r1, Float4 &r2, Float4 &r3)
+{
+#if defined(KIRANA_MATH_SIMD_SSE2)
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+#elif defined(KIRANA_MATH_SIMD_NEON)
+    const float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    const float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+#else
+    const Float4 t0 = r0, t1 = r1, t2 = r2, t3 = r3;
+    r0 = Float4{{t0.v[0], t1.v[0], t2.v[0], t3.v[0]}};
+    r1 = Float4{{t0.v[1], t1.v[1], t2.v[1], t3.v[1]}};
+    r2 = Float4{{t0.v[2], t1.v[2], t2.v[2], t3.v[2]}};
+    r3 = Float4{{t0.v[3], t1.v[3], t2.v[3], t3.v[3]}};
+#endif
+}
+} // namespace kirana::math::simd
+
+#endif // KIRANA_MATH_SIMD_HPP
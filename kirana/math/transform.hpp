@@ -4,6 +4,7 @@
 #include "quaternion.hpp"
 #include "bounds3.hpp"
 #include "ray.hpp"
+#include "simd.hpp"
 
 namespace kirana::math
 {
@@ -233,34 +234,35 @@ class Transform
         // Algorithm taken from Graphic Gems: "Transforming Axis-Aligned
         // Bounding Boxes", by James Arvo.
 
+        // Each column of the matrix is scaled by the min and max of the
+        // corresponding axis, the smaller and larger products are added to the
+        // translation.
         const Matrix4x4 &m = getMatrix();
-        const Vector3 &translation = Vector3(m[0][3], m[1][3], m[2][3]);
-        Bounds3 tBounds(translation, translation);
-
-        float a = 0.0f, b = 0.0f;
-        for (int i = 0; i < 3; i++)
-        {
-            // x-axis
-            a = m[0][i] * bounds.m_min[i];
-            b = m[0][i] * bounds.m_max[i];
-
-            tBounds.m_min[0] += std::fminf(a, b);
-            tBounds.m_max[0] += std::fmaxf(a, b);
-
-            // y-axis
-            a = m[1][i] * bounds.m_min[i];
-            b = m[1][i] * bounds.m_max[i];
-
-            tBounds.m_min[1] += std::fminf(a, b);
-            tBounds.m_max[1] += std::fmaxf(a, b);
-
-            // z-axis
-            a = m[2][i] * bounds.m_min[i];
-            b = m[2][i] * bounds.m_max[i];
-
-            tBounds.m_min[2] += std::fminf(a, b);
-            tBounds.m_max[2] += std::fmaxf(a, b);
-        }
+        simd::Float4 columns[4]{
+            simd::load(m[0].data()), simd::load(m[1].data()),
+            simd::load(m[2].data()), simd::load(m[3].data())};
+        simd::transpose(columns[0], columns[1], columns[2], columns[3]);
+
+        const simd::Float4 bMin = simd::load3(bounds.m_min.data());
+        const simd::Float4 bMax = simd::load3(bounds.m_max.data());
+        simd::Float4 a = simd::mul(columns[0], simd::splat<0>(bMin));
+        simd::Float4 b = simd::mul(columns[0], simd::splat<0>(bMax));
+        simd::Float4 tMin = simd::add(columns[3], simd::min(a, b));
+        simd::Float4 tMax = simd::add(columns[3], simd::max(a, b));
+
+        a = simd::mul(columns[1], simd::splat<1>(bMin));
+        b = simd::mul(columns[1], simd::splat<1>(bMax));
+        tMin = simd::add(tMin, simd::min(a, b));
+        tMax = simd::add(tMax, simd::max(a, b));
+
+        a = simd::mul(columns[2], simd::splat<2>(bMin));
+        b = simd::mul(columns[2], simd::splat<2>(bMax));
+        tMin = simd::add(tMin, simd::min(a, b));
+        tMax = simd::add(tMax, simd::max(a, b));
+
+        Bounds3 tBounds;
+        simd::store3(tBounds.m_min.data(), tMin);
+        simd::store3(tBounds.m_max.data(), tMax);
         return tBounds;
     }
 
@@ -4,82 +4,135 @@
 #include "vector4.hpp"
 
 
+void kirana::math::TransformHierarchy::calculateLocalRigidMatrix()
+{
+    // Same as translation * rotation.
+    Matrix4x4 &mat = localRigidMatrix();
+    const Vector3 &position = localPosition();
+    mat = localRotation().getMatrix();
+    mat[0][3] = position[0];
+    mat[1][3] = position[1];
+    mat[2][3] = position[2];
+}
+
 void kirana::math::TransformHierarchy::calculateLocalMatrix()
 {
-    m_localMatrix = Matrix4x4::translation(m_localPosition) *
-                    m_localRotation.getMatrix() *
-                    Matrix4x4::scale(m_localScale);
+    // Same as translation * rotation * scale.
+    calculateLocalRigidMatrix();
+    Matrix4x4 &mat = localMatrix();
+    const Vector3 &scale = localScale();
+    mat = localRigidMatrix();
+    for (int i = 0; i < 3; i++)
+    {
+        mat[i][0] *= scale[0];
+        mat[i][1] *= scale[1];
+        mat[i][2] *= scale[2];
+    }
+    markDirty();
 }
 
+void kirana::math::TransformHierarchy::setParent(TransformHierarchy *transform)
+{
+    if (transform == nullptr || transform == this)
+        m_store->setParent(m_index, TransformStore::INVALID_INDEX);
+    else if (transform->m_store == m_store)
+        m_store->setParent(m_index, transform->m_index);
+}
 
 kirana::math::Matrix4x4 kirana::math::TransformHierarchy::getParentMatrix(
     bool includeScale) const
 {
-    if (m_parent != nullptr && m_parent != this)
-        return m_parent->getWorldMatrix(includeScale);
-    return Matrix4x4::IDENTITY;
+    if (!hasParent())
+        return Matrix4x4::IDENTITY;
+    const uint32_t parent = m_store->m_parents[m_index];
+    if (!includeScale)
+    {
+        m_store->updateWorldRigidMatrix(parent);
+        return m_store->m_worldRigidMatrices[parent];
+    }
+    m_store->updateWorldMatrix(parent);
+    return m_store->m_worldMatrices[parent];
 }
 
 kirana::math::Matrix4x4 kirana::math::TransformHierarchy::getWorldMatrix(
     bool includeScale) const
 {
-    if (includeScale)
-    {
-        if (m_parent != nullptr && m_parent != this)
-            return m_parent->getWorldMatrix(includeScale) * m_localMatrix;
-        return m_localMatrix;
-    }
-    else
+    if (!includeScale)
     {
-        if (m_parent != nullptr && m_parent != this)
-            return m_parent->getWorldMatrix(includeScale) *
-                   Matrix4x4::translation(m_localPosition) *
-                   m_localRotation.getMatrix();
-        return Matrix4x4::translation(m_localPosition) *
-               m_localRotation.getMatrix();
+        m_store->updateWorldRigidMatrix(m_index);
+        return m_store->m_worldRigidMatrices[m_index];
     }
+    m_store->updateWorldMatrix(m_index);
+    return m_store->m_worldMatrices[m_index];
 }
 
-kirana::math::TransformHierarchy::TransformHierarchy(TransformHierarchy *parent)
-    : m_parent{parent}, m_localMatrix{Matrix4x4::IDENTITY}, m_localPosition{},
-      m_localRotation{}, m_localScale{Vector3::ONE}
+kirana::math::TransformHierarchy::TransformHierarchy(
+    TransformHierarchy *parent, std::shared_ptr<TransformStore> store)
+    : TransformHierarchy(Matrix4x4::IDENTITY, parent, std::move(store))
 {
 }
 
-kirana::math::TransformHierarchy::TransformHierarchy(const Matrix4x4 &mat,
-                                                     TransformHierarchy *parent)
-    : m_parent{parent}, m_localMatrix{mat}
+kirana::math::TransformHierarchy::TransformHierarchy(
+    const Matrix4x4 &mat, TransformHierarchy *parent,
+    std::shared_ptr<TransformStore> store)
 {
-    Vector3 eulerAngles;
-    Matrix4x4::decompose(m_localMatrix, &m_localPosition, &m_localScale,
-                         nullptr, &eulerAngles);
-    m_localRotation = Quaternion::euler(eulerAngles);
+    if (parent != nullptr)
+        m_store = parent->m_store;
+    else if (store != nullptr)
+        m_store = std::move(store);
+    else
+        m_store = TransformStore::getDefault();
+    m_index = m_store->add(this, parent != nullptr
+                                     ? parent->m_index
+                                     : TransformStore::INVALID_INDEX);
+
+    localMatrix() = mat;
+    if (!Matrix4x4::decomposeTRS(mat, &localPosition(), &localRotation(),
+                                 &localScale()))
+    {
+        Vector3 eulerAngles;
+        Matrix4x4::decompose(mat, &localPosition(), &localScale(), nullptr,
+                             &eulerAngles);
+        localRotation() = Quaternion::euler(eulerAngles);
+    }
+    calculateLocalRigidMatrix();
 }
 
+kirana::math::TransformHierarchy::~TransformHierarchy()
+{
+    m_store->remove(m_index);
+}
 
 kirana::math::TransformHierarchy::TransformHierarchy(
-    const TransformHierarchy &TransformHierarchy)
+    const TransformHierarchy &transform)
+    : m_store{transform.m_store}
 {
-    if (this != &TransformHierarchy)
-    {
-        m_parent = TransformHierarchy.m_parent;
-        m_localMatrix = TransformHierarchy.m_localMatrix;
-        m_localPosition = TransformHierarchy.m_localPosition;
-        m_localRotation = TransformHierarchy.m_localRotation;
-        m_localScale = TransformHierarchy.m_localScale;
-    }
+    m_index = m_store->add(this, m_store->m_parents[transform.m_index]);
+    localMatrix() = transform.localMatrix();
+    localRigidMatrix() = transform.localRigidMatrix();
+    localPosition() = transform.localPosition();
+    localRotation() = transform.localRotation();
+    localScale() = transform.localScale();
 }
 
 kirana::math::TransformHierarchy &kirana::math::TransformHierarchy::operator=(
-    const TransformHierarchy &TransformHierarchy)
+    const TransformHierarchy &transform)
 {
-    if (this != &TransformHierarchy)
+    if (this != &transform)
     {
-        m_parent = TransformHierarchy.m_parent;
-        m_localMatrix = TransformHierarchy.m_localMatrix;
-        m_localPosition = TransformHierarchy.m_localPosition;
-        m_localRotation = TransformHierarchy.m_localRotation;
-        m_localScale = TransformHierarchy.m_localScale;
+        if (m_store != transform.m_store)
+        {
+            m_store->remove(m_index);
+            m_store = transform.m_store;
+            m_index = m_store->add(this, TransformStore::INVALID_INDEX);
+        }
+        m_store->setParent(m_index, m_store->m_parents[transform.m_index]);
+        localMatrix() = transform.localMatrix();
+        localRigidMatrix() = transform.localRigidMatrix();
+        localPosition() = transform.localPosition();
+        localRotation() = transform.localRotation();
+        localScale() = transform.localScale();
+        markDirty();
     }
     return *this;
 }
@@ -87,7 +140,7 @@ kirana::math::TransformHierarchy &kirana::math::TransformHierarchy::operator=(
 bool kirana::math::TransformHierarchy::operator==(
     const TransformHierarchy &rhs) const
 {
-    return m_localMatrix == rhs.m_localMatrix && m_parent == rhs.m_parent;
+    return localMatrix() == rhs.localMatrix() && getParent() == rhs.getParent();
 }
 
 bool kirana::math::TransformHierarchy::operator!=(
@@ -101,7 +154,7 @@ kirana::math::Matrix4x4 kirana::math::TransformHierarchy::getMatrix(
 {
     if (space == Space::World)
         return getWorldMatrix();
-    return m_localMatrix;
+    return localMatrix();
 }
 
 kirana::math::Vector3 kirana::math::TransformHierarchy::getRight(
@@ -140,17 +193,18 @@ void kirana::math::TransformHierarchy::setForward(const Vector3 &forward,
         right = Vector3::cross(Vector3::UP, forward);
         up = Vector3::cross(forward, right);
     }
-    m_localMatrix[0][0] = right[0];
-    m_localMatrix[1][0] = right[1];
-    m_localMatrix[2][0] = right[2];
-    m_localMatrix[0][1] = up[0];
-    m_localMatrix[1][1] = up[1];
-    m_localMatrix[2][1] = up[2];
-    m_localMatrix[0][2] = forward[0];
-    m_localMatrix[1][2] = forward[1];
-    m_localMatrix[2][2] = forward[2];
-
-    Matrix4x4::decompose(m_localMatrix, nullptr, &m_localRotation);
+    localMatrix()[0][0] = right[0];
+    localMatrix()[1][0] = right[1];
+    localMatrix()[2][0] = right[2];
+    localMatrix()[0][1] = up[0];
+    localMatrix()[1][1] = up[1];
+    localMatrix()[2][1] = up[2];
+    localMatrix()[0][2] = forward[0];
+    localMatrix()[1][2] = forward[1];
+    localMatrix()[2][2] = forward[2];
+
+    if (!Matrix4x4::decomposeTRS(localMatrix(), nullptr, &localRotation()))
+        Matrix4x4::decompose(localMatrix(), nullptr, &localRotation());
     calculateLocalMatrix();
 }
 
@@ -162,7 +216,7 @@ kirana::math::Vector3 kirana::math::TransformHierarchy::getPosition(
         Matrix4x4 globalMat = getWorldMatrix();
         return Vector3(globalMat[0][3], globalMat[1][3], globalMat[2][3]);
     }
-    return m_localPosition;
+    return localPosition();
 }
 
 kirana::math::Quaternion kirana::math::TransformHierarchy::getRotation(
@@ -170,14 +224,16 @@ kirana::math::Quaternion kirana::math::TransformHierarchy::getRotation(
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
+            const Matrix4x4 worldMat = getWorldMatrix(false);
             Quaternion rot;
-            Matrix4x4::decompose(getWorldMatrix(false), nullptr, &rot);
+            if (!Matrix4x4::decomposeTRS(worldMat, nullptr, &rot))
+                Matrix4x4::decompose(worldMat, nullptr, &rot);
             return rot;
         }
     }
-    return m_localRotation;
+    return localRotation();
 }
 
 kirana::math::Vector3 kirana::math::TransformHierarchy::getScale(
@@ -185,15 +241,16 @@ kirana::math::Vector3 kirana::math::TransformHierarchy::getScale(
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
+            const Matrix4x4 worldMat = getWorldMatrix();
             Vector3 scale;
-            Matrix4x4::decompose(getWorldMatrix(), nullptr, &scale, nullptr,
-                                 nullptr);
+            if (!Matrix4x4::decomposeTRS(worldMat, nullptr, nullptr, &scale))
+                Matrix4x4::decompose(worldMat, nullptr, &scale);
             return scale;
         }
     }
-    return m_localScale;
+    return localScale();
 }
 
 void kirana::math::TransformHierarchy::setPosition(const Vector3 &position,
@@ -201,16 +258,17 @@ void kirana::math::TransformHierarchy::setPosition(const Vector3 &position,
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localPosition = Matrix4x4::inverse(getParentMatrix()) * position;
+            localPosition() =
+                Matrix4x4::affineInverse(getParentMatrix()) * position;
         }
         else
-            m_localPosition = position;
+            localPosition() = position;
     }
     else
     {
-        m_localPosition = position;
+        localPosition() = position;
     }
     calculateLocalMatrix();
 }
@@ -218,9 +276,9 @@ void kirana::math::TransformHierarchy::setPosition(const Vector3 &position,
 void kirana::math::TransformHierarchy::setPositionInLocalAxis(
     const Vector3 &position)
 {
-    m_localPosition = getForward() * position[2];
-    m_localPosition = getUp() * position[1];
-    m_localPosition = getRight() * position[0];
+    localPosition() = getForward() * position[2];
+    localPosition() = getUp() * position[1];
+    localPosition() = getRight() * position[0];
     calculateLocalMatrix();
 }
 
@@ -235,24 +293,25 @@ void kirana::math::TransformHierarchy::setRotation(const Quaternion &rotation,
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localRotation =
-                Quaternion::matrix(Matrix4x4::inverse(getParentMatrix())) *
+            localRotation() =
+                Quaternion::matrix(
+                    Matrix4x4::rigidInverse(getParentMatrix(false))) *
                 rotation;
         }
         else
-            m_localRotation = rotation;
+            localRotation() = rotation;
     }
     else
-        m_localRotation = rotation;
+        localRotation() = rotation;
 
     calculateLocalMatrix();
 }
 
 void kirana::math::TransformHierarchy::setLocalScale(const Vector3 &scale)
 {
-    m_localScale = scale;
+    localScale() = scale;
     calculateLocalMatrix();
 }
 
@@ -262,8 +321,8 @@ kirana::math::Vector3 kirana::math::TransformHierarchy::transformVector(
     if (space == Space::World)
         return static_cast<Vector3>(getWorldMatrix() * Vector4(vector, 0.0f));
     else
-        return static_cast<Vector3>(Matrix4x4::inverse(getWorldMatrix()) *
-                                    Vector4(vector, 0.0f));
+        return static_cast<Vector3>(
+            Matrix4x4::affineInverse(getWorldMatrix()) * Vector4(vector, 0.0f));
 }
 
 
@@ -273,8 +332,9 @@ kirana::math::Vector3 kirana::math::TransformHierarchy::transformPosition(
     if (space == Space::World)
         return static_cast<Vector3>(getWorldMatrix() * Vector4(position, 1.0f));
     else
-        return static_cast<Vector3>(Matrix4x4::inverse(getWorldMatrix()) *
-                                    Vector4(position, 1.0f));
+        return static_cast<Vector3>(
+            Matrix4x4::affineInverse(getWorldMatrix()) *
+            Vector4(position, 1.0f));
 }
 
 
@@ -285,8 +345,9 @@ kirana::math::Vector3 kirana::math::TransformHierarchy::transformDirection(
         return static_cast<Vector3>(getWorldMatrix(false) *
                                     Vector4(direction, 0.0f));
     else
-        return static_cast<Vector3>(Matrix4x4::inverse(getWorldMatrix(false)) *
-                                    Vector4(direction, 0.0f));
+        return static_cast<Vector3>(
+            Matrix4x4::rigidInverse(getWorldMatrix(false)) *
+            Vector4(direction, 0.0f));
 }
 
 kirana::math::Bounds3 kirana::math::TransformHierarchy::transformBounds(
@@ -297,7 +358,7 @@ kirana::math::Bounds3 kirana::math::TransformHierarchy::transformBounds(
 
     const Matrix4x4 &m = space == Space::World
                              ? getWorldMatrix()
-                             : Matrix4x4::inverse(getWorldMatrix());
+                             : Matrix4x4::affineInverse(getWorldMatrix());
     const Vector3 &translation = Vector3(m[0][3], m[1][3], m[2][3]);
     Bounds3 tBounds(translation, translation);
 
@@ -334,20 +395,20 @@ void kirana::math::TransformHierarchy::translate(
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localPosition =
-                Matrix4x4::inverse(getParentMatrix()) *
-                (translation + getParentMatrix() * m_localPosition);
+            localPosition() =
+                Matrix4x4::affineInverse(getParentMatrix()) *
+                (translation + getParentMatrix() * localPosition());
         }
         else
         {
-            m_localPosition += translation;
+            localPosition() += translation;
         }
     }
     else
     {
-        m_localPosition += translation;
+        localPosition() += translation;
     }
 
     calculateLocalMatrix();
@@ -356,9 +417,9 @@ void kirana::math::TransformHierarchy::translate(
 void kirana::math::TransformHierarchy::translateInLocalAxis(
     const Vector3 &translation)
 {
-    m_localPosition += getForward() * translation[2];
-    m_localPosition += getUp() * translation[1];
-    m_localPosition += getRight() * translation[0];
+    localPosition() += getForward() * translation[2];
+    localPosition() += getUp() * translation[1];
+    localPosition() += getRight() * translation[0];
     calculateLocalMatrix();
 }
 
@@ -366,19 +427,20 @@ void kirana::math::TransformHierarchy::rotateX(float angle, Space space)
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localRotation =
-                Quaternion::matrix(Matrix4x4::inverse(getParentMatrix())) *
+            localRotation() =
+                Quaternion::matrix(
+                    Matrix4x4::rigidInverse(getParentMatrix(false))) *
                 Quaternion::matrix(Matrix4x4::rotationX(angle)) *
-                Quaternion::matrix(getParentMatrix()) * m_localRotation;
+                Quaternion::matrix(getParentMatrix(false)) * localRotation();
         }
         else
-            m_localRotation = Quaternion::matrix(Matrix4x4::rotationX(angle)) *
-                              m_localRotation;
+            localRotation() = Quaternion::matrix(Matrix4x4::rotationX(angle)) *
+                              localRotation();
     }
     else
-        m_localRotation *= Quaternion::matrix(Matrix4x4::rotationX(angle));
+        localRotation() *= Quaternion::matrix(Matrix4x4::rotationX(angle));
 
     calculateLocalMatrix();
 }
@@ -387,19 +449,20 @@ void kirana::math::TransformHierarchy::rotateY(float angle, Space space)
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localRotation =
-                Quaternion::matrix(Matrix4x4::inverse(getParentMatrix())) *
+            localRotation() =
+                Quaternion::matrix(
+                    Matrix4x4::rigidInverse(getParentMatrix(false))) *
                 Quaternion::matrix(Matrix4x4::rotationY(angle)) *
-                Quaternion::matrix(getParentMatrix()) * m_localRotation;
+                Quaternion::matrix(getParentMatrix(false)) * localRotation();
         }
         else
-            m_localRotation = Quaternion::matrix(Matrix4x4::rotationY(angle)) *
-                              m_localRotation;
+            localRotation() = Quaternion::matrix(Matrix4x4::rotationY(angle)) *
+                              localRotation();
     }
     else
-        m_localRotation *= Quaternion::matrix(Matrix4x4::rotationY(angle));
+        localRotation() *= Quaternion::matrix(Matrix4x4::rotationY(angle));
 
     calculateLocalMatrix();
 }
@@ -408,19 +471,20 @@ void kirana::math::TransformHierarchy::rotateZ(float angle, Space space)
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localRotation =
-                Quaternion::matrix(Matrix4x4::inverse(getParentMatrix())) *
+            localRotation() =
+                Quaternion::matrix(
+                    Matrix4x4::rigidInverse(getParentMatrix(false))) *
                 Quaternion::matrix(Matrix4x4::rotationZ(angle)) *
-                Quaternion::matrix(getParentMatrix()) * m_localRotation;
+                Quaternion::matrix(getParentMatrix(false)) * localRotation();
         }
         else
-            m_localRotation = Quaternion::matrix(Matrix4x4::rotationZ(angle)) *
-                              m_localRotation;
+            localRotation() = Quaternion::matrix(Matrix4x4::rotationZ(angle)) *
+                              localRotation();
     }
     else
-        m_localRotation *= Quaternion::matrix(Matrix4x4::rotationZ(angle));
+        localRotation() *= Quaternion::matrix(Matrix4x4::rotationZ(angle));
 
     calculateLocalMatrix();
 }
@@ -430,18 +494,19 @@ void kirana::math::TransformHierarchy::rotate(const Vector3 &rotation,
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localRotation =
-                Quaternion::matrix(Matrix4x4::inverse(getParentMatrix())) *
+            localRotation() =
+                Quaternion::matrix(
+                    Matrix4x4::rigidInverse(getParentMatrix(false))) *
                 Quaternion::euler(rotation) *
-                Quaternion::matrix(getParentMatrix()) * m_localRotation;
+                Quaternion::matrix(getParentMatrix(false)) * localRotation();
         }
         else
-            m_localRotation = Quaternion::euler(rotation) * m_localRotation;
+            localRotation() = Quaternion::euler(rotation) * localRotation();
     }
     else
-        m_localRotation *= Quaternion::euler(rotation);
+        localRotation() *= Quaternion::euler(rotation);
 
     calculateLocalMatrix();
 }
@@ -452,18 +517,19 @@ void kirana::math::TransformHierarchy::rotate(const Quaternion &rotation,
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localRotation =
-                Quaternion::matrix(Matrix4x4::inverse(getParentMatrix())) *
-                rotation * Quaternion::matrix(getParentMatrix()) *
-                m_localRotation;
+            localRotation() =
+                Quaternion::matrix(
+                    Matrix4x4::rigidInverse(getParentMatrix(false))) *
+                rotation * Quaternion::matrix(getParentMatrix(false)) *
+                localRotation();
         }
         else
-            m_localRotation = rotation * m_localRotation;
+            localRotation() = rotation * localRotation();
     }
     else
-        m_localRotation *= rotation;
+        localRotation() *= rotation;
 
     calculateLocalMatrix();
 }
@@ -474,19 +540,20 @@ void kirana::math::TransformHierarchy::rotateAround(float angle,
 {
     if (space == Space::World)
     {
-        if (m_parent != nullptr && m_parent != this)
+        if (hasParent())
         {
-            m_localRotation =
-                Quaternion::matrix(Matrix4x4::inverse(getParentMatrix())) *
+            localRotation() =
+                Quaternion::matrix(
+                    Matrix4x4::rigidInverse(getParentMatrix(false))) *
                 Quaternion::angleAxis(angle, axis) *
-                Quaternion::matrix(getParentMatrix()) * m_localRotation;
+                Quaternion::matrix(getParentMatrix(false)) * localRotation();
         }
         else
-            m_localRotation =
-                Quaternion::angleAxis(angle, axis) * m_localRotation;
+            localRotation() =
+                Quaternion::angleAxis(angle, axis) * localRotation();
     }
     else
-        m_localRotation *= Quaternion::angleAxis(angle, axis);
+        localRotation() *= Quaternion::angleAxis(angle, axis);
 
     calculateLocalMatrix();
 }
@@ -505,7 +572,8 @@ void kirana::math::TransformHierarchy::lookAt(const Vector3 &position,
 
     Vector3 worldPos;
     Quaternion worldRot;
-    Matrix4x4::decompose(worldMat, &worldPos, &worldRot);
+    if (!Matrix4x4::decomposeTRS(worldMat, &worldPos, &worldRot))
+        Matrix4x4::decompose(worldMat, &worldPos, &worldRot);
 
     setRotation(worldRot);
     setPosition(worldPos);
@@ -1,13 +1,29 @@
-#ifndef KIRANA_MATH_TRANSFORM_HPP
-#define KIRANA_MATH_TRANSFORM_HPP
+#ifndef KIRANA_MATH_TRANSFORM_HIERARCHY_HPP
+#define KIRANA_MATH_TRANSFORM_HIERARCHY_HPP
 
 #include "quaternion.hpp"
 #include "bounds3.hpp"
 #include "ray.hpp"
+#include "transform_store.hpp"
+
+#include <cstdint>
+#include <memory>
 
 namespace kirana::math
 {
 
+/**
+ * Transform with an optional parent. The transform is a handle to an entry in
+ * a TransformStore, which holds the data of all the transforms of a scene.
+ * Children are always added to the store of their parent.
+ *
+ * World matrices are cached and only recalculated when the local matrix of the
+ * transform or of one of its parents changes. Every change takes a new value
+ * from the generation counter of the store, so reads return the cached matrix
+ * in O(1) while nothing changed, and otherwise only recalculate the part of
+ * the parent chain that changed. TransformStore::update() recalculates all of
+ * them at once. The cache is updated by const getters and isn't thread-safe.
+ */
 class TransformHierarchy
 {
   public:
@@ -17,9 +33,18 @@ class TransformHierarchy
         World = 1
     };
 
-    explicit TransformHierarchy(TransformHierarchy *parent = nullptr);
-    explicit TransformHierarchy(const Matrix4x4 &mat, TransformHierarchy *parent = nullptr);
-    ~TransformHierarchy() = default;
+    /**
+     * @param parent The parent transform, if any.
+     * @param store The store to add the transform to. Ignored if the transform
+     * has a parent. If nullptr, the default store is used.
+     */
+    explicit TransformHierarchy(
+        TransformHierarchy *parent = nullptr,
+        std::shared_ptr<TransformStore> store = nullptr);
+    explicit TransformHierarchy(
+        const Matrix4x4 &mat, TransformHierarchy *parent = nullptr,
+        std::shared_ptr<TransformStore> store = nullptr);
+    ~TransformHierarchy();
 
     TransformHierarchy(const TransformHierarchy &transform);
     TransformHierarchy &operator=(const TransformHierarchy &transform);
@@ -29,13 +54,28 @@ class TransformHierarchy
 
     [[nodiscard]] inline TransformHierarchy *getParent() const
     {
-        return m_parent;
+        const uint32_t parent = m_store->m_parents[m_index];
+        return parent != TransformStore::INVALID_INDEX
+                   ? m_store->m_handles[parent]
+                   : nullptr;
     }
-    inline void setParent(TransformHierarchy *transform)
+    /**
+     * Sets the parent transform. The local matrix is kept as it is. Parents
+     * from other stores, and parents that would create a cycle, are ignored.
+     * @param transform The parent transform, nullptr to remove the parent.
+     */
+    void setParent(TransformHierarchy *transform);
+
+    [[nodiscard]] inline const std::shared_ptr<TransformStore> &getStore() const
     {
-        m_parent = transform;
+        return m_store;
     }
 
+    /**
+     * Returns a copy of the matrix, since the store moves its matrices when
+     * transforms are added or reparented. Updates the world matrix first if
+     * it's outdated, so it isn't thread-safe.
+     */
     [[nodiscard]] Matrix4x4 getMatrix(Space space = Space::World) const;
 
     [[nodiscard]] Vector3 getRight(Space space = Space::World) const;
@@ -106,7 +146,9 @@ class TransformHierarchy
     [[nodiscard]] Bounds3 transformBounds(const Bounds3 &bounds,
                                           Space space = Space::World) const;
     /**
-     * Transforms the given ray to world/local space.
+     * Transforms the given ray to world/local space. The direction is affected
+     * by the scale of the transform, so that a distance along the ray is the
+     * same in both spaces.
      * @param ray The ray to transform.
      * @param space If Space::World, the given local-space ray is transformed
      * into a world space ray. If Space::Local, the given world-space ray is
@@ -117,7 +159,7 @@ class TransformHierarchy
                                           Space space = Space::World) const
     {
         return {transformPosition(ray.m_origin, space),
-                transformDirection(ray.m_direction, space), ray.m_tMax};
+                transformVector(ray.m_direction, space), ray.m_tMax};
     }
 
     void translate(const Vector3 &translation, Space space = Space::World);
@@ -132,12 +174,43 @@ class TransformHierarchy
     void lookAt(const Vector3 &position, const Vector3 &up);
 
   private:
-    TransformHierarchy *m_parent = nullptr;
-    Matrix4x4 m_localMatrix;
-    Vector3 m_localPosition;
-    Quaternion m_localRotation;
-    Vector3 m_localScale;
+    // The store moves the transforms when it sorts them.
+    friend class TransformStore;
+
+    std::shared_ptr<TransformStore> m_store;
+    uint32_t m_index = TransformStore::INVALID_INDEX;
+
+    [[nodiscard]] inline bool hasParent() const
+    {
+        return m_store->hasParent(m_index);
+    }
+    inline Vector3 &localPosition() const
+    {
+        return m_store->m_localPositions[m_index];
+    }
+    inline Quaternion &localRotation() const
+    {
+        return m_store->m_localRotations[m_index];
+    }
+    inline Vector3 &localScale() const
+    {
+        return m_store->m_localScales[m_index];
+    }
+    inline Matrix4x4 &localMatrix() const
+    {
+        return m_store->m_localMatrices[m_index];
+    }
+    inline Matrix4x4 &localRigidMatrix() const
+    {
+        return m_store->m_localRigidMatrices[m_index];
+    }
 
+    /// Invalidates the world matrices of the transform and its children.
+    inline void markDirty()
+    {
+        m_store->markDirty(m_index);
+    }
+    void calculateLocalRigidMatrix();
     void calculateLocalMatrix();
     /**
      * Returns the world matrix of only the parent. Does not include the local
@@ -0,0 +1,296 @@
+#include "transform_store.hpp"
+#include "transform_hierarchy.hpp"
+
+#include <thread_pool.hpp>
+
+#include <algorithm>
+
+namespace
+{
+/**
+ * Reorders the elements so that the i-th one is the order[i]-th one of
+ * before. Elements missing from the order are removed.
+ * @param buffer The array to move the elements into, which is swapped with
+ * the elements, so that it holds the previous ones afterwards.
+ */
+template <typename T>
+void permute(const std::vector<uint32_t> &order, std::vector<T> *elements,
+             std::vector<T> *buffer)
+{
+    buffer->resize(order.size());
+    for (size_t i = 0; i < order.size(); i++)
+        (*buffer)[i] = std::move((*elements)[order[i]]);
+    elements->swap(*buffer);
+}
+
+template <typename T>
+void permute(const std::vector<uint32_t> &order, std::vector<T> *elements)
+{
+    std::vector<T> buffer;
+    permute(order, elements, &buffer);
+}
+} // namespace
+
+uint32_t kirana::math::TransformStore::add(TransformHierarchy *handle,
+                                           uint32_t parent)
+{
+    uint32_t index = 0;
+    if (!m_freeIndices.empty())
+    {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+        m_handles[index] = handle;
+        m_parents[index] = INVALID_INDEX;
+        m_childCounts[index] = 0;
+        m_localPositions[index] = Vector3::ZERO;
+        m_localRotations[index] = Quaternion::IDENTITY;
+        m_localScales[index] = Vector3::ONE;
+        m_localMatrices[index] = Matrix4x4::IDENTITY;
+        m_localRigidMatrices[index] = Matrix4x4::IDENTITY;
+        m_worldGenerations[index] = 0;
+        m_validatedGenerations[index] = 0;
+        m_worldRigidGenerations[index] = 0;
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_parents.size());
+        m_handles.emplace_back(handle);
+        m_parents.emplace_back(INVALID_INDEX);
+        m_childCounts.emplace_back(0);
+        m_localPositions.emplace_back(Vector3::ZERO);
+        m_localRotations.emplace_back(Quaternion::IDENTITY);
+        m_localScales.emplace_back(Vector3::ONE);
+        m_localMatrices.emplace_back(Matrix4x4::IDENTITY);
+        m_localRigidMatrices.emplace_back(Matrix4x4::IDENTITY);
+        m_worldMatrices.emplace_back(Matrix4x4::IDENTITY);
+        m_worldRigidMatrices.emplace_back(Matrix4x4::IDENTITY);
+        m_localGenerations.emplace_back(0);
+        m_worldGenerations.emplace_back(0);
+        m_validatedGenerations.emplace_back(0);
+        m_worldRigidGenerations.emplace_back(0);
+    }
+    setParent(index, parent);
+    return index;
+}
+
+void kirana::math::TransformStore::remove(uint32_t index)
+{
+    m_handles[index] = nullptr;
+    // Keep the transform until its children are gone.
+    if (m_childCounts[index] == 0)
+        release(index);
+}
+
+void kirana::math::TransformStore::release(uint32_t index)
+{
+    const uint32_t parent = m_parents[index];
+    m_parents[index] = INVALID_INDEX;
+    m_freeIndices.push_back(index);
+    m_isOrderValid = false;
+
+    if (parent != INVALID_INDEX && --m_childCounts[parent] == 0 &&
+        m_handles[parent] == nullptr)
+        release(parent);
+}
+
+void kirana::math::TransformStore::setParent(uint32_t index, uint32_t parent)
+{
+    // Ignore parents that would create a cycle.
+    for (uint32_t p = parent; p != INVALID_INDEX; p = m_parents[p])
+    {
+        if (p == index)
+        {
+            parent = INVALID_INDEX;
+            break;
+        }
+    }
+
+    const uint32_t previousParent = m_parents[index];
+    if (parent != INVALID_INDEX)
+        m_childCounts[parent]++;
+    m_parents[index] = parent;
+    if (previousParent != INVALID_INDEX &&
+        --m_childCounts[previousParent] == 0 &&
+        m_handles[previousParent] == nullptr)
+        release(previousParent);
+
+    m_isOrderValid = false;
+    markDirty(index);
+}
+
+void kirana::math::TransformStore::updateWorldMatrix(uint32_t index)
+{
+    // update() validates every transform without marking them.
+    if (m_validatedGenerations[index] == m_generation ||
+        m_updatedGeneration == m_generation)
+        return;
+    if (hasParent(index))
+        updateWorldMatrix(m_parents[index]);
+    calculateWorldMatrix(index);
+    m_validatedGenerations[index] = m_generation;
+}
+
+void kirana::math::TransformStore::calculateWorldMatrix(uint32_t index)
+{
+    const uint32_t parent = m_parents[index];
+    // A change anywhere in the parent chain takes a new, larger generation,
+    // so the maximum identifies the current state of the chain.
+    const uint64_t worldGeneration =
+        parent != INVALID_INDEX ? std::max(m_localGenerations[index],
+                                           m_worldGenerations[parent])
+                                : m_localGenerations[index];
+    if (worldGeneration != m_worldGenerations[index])
+    {
+        m_worldMatrices[index] =
+            parent != INVALID_INDEX
+                ? m_worldMatrices[parent] * m_localMatrices[index]
+                : m_localMatrices[index];
+        m_worldGenerations[index] = worldGeneration;
+    }
+}
+
+void kirana::math::TransformStore::updateWorldRigidMatrix(uint32_t index)
+{
+    updateWorldMatrix(index);
+    validateWorldRigidMatrix(index);
+}
+
+void kirana::math::TransformStore::validateWorldRigidMatrix(uint32_t index)
+{
+    // The world generation identifies the state of the parent chain, so the
+    // rigid matrix is up to date if it was calculated for the same one.
+    if (m_worldRigidGenerations[index] == m_worldGenerations[index])
+        return;
+    const uint32_t parent = m_parents[index];
+    if (parent != INVALID_INDEX)
+    {
+        validateWorldRigidMatrix(parent);
+        m_worldRigidMatrices[index] =
+            m_worldRigidMatrices[parent] * m_localRigidMatrices[index];
+    }
+    else
+        m_worldRigidMatrices[index] = m_localRigidMatrices[index];
+    m_worldRigidGenerations[index] = m_worldGenerations[index];
+}
+
+void kirana::math::TransformStore::sortByDepth()
+{
+    const auto count = static_cast<uint32_t>(m_parents.size());
+    std::vector<bool> isFree(count, false);
+    for (const auto i : m_freeIndices)
+        isFree[i] = true;
+
+    // Children of each transform, at [childOffsets[i], childOffsets[i + 1])
+    // in children.
+    std::vector<uint32_t> childOffsets(count + 1, 0);
+    for (uint32_t i = 0; i < count; i++)
+        if (!isFree[i] && hasParent(i))
+            childOffsets[m_parents[i] + 1]++;
+    for (uint32_t i = 0; i < count; i++)
+        childOffsets[i + 1] += childOffsets[i];
+    std::vector<uint32_t> children(childOffsets.back());
+    std::vector<uint32_t> positions(childOffsets.begin(),
+                                    childOffsets.end() - 1);
+    for (uint32_t i = 0; i < count; i++)
+        if (!isFree[i] && hasParent(i))
+            children[positions[m_parents[i]]++] = i;
+
+    // Breadth-first order, starting from the roots. Besides sorting the
+    // transforms by depth, it keeps the children of each depth in the order
+    // of their parents, so that update() reads the parents sequentially too.
+    std::vector<uint32_t> order;
+    order.reserve(count - m_freeIndices.size());
+    for (uint32_t i = 0; i < count; i++)
+        if (!isFree[i] && !hasParent(i))
+            order.emplace_back(i);
+    m_levelOffsets.assign(1, 0);
+    for (size_t begin = 0; begin < order.size();)
+    {
+        const size_t end = order.size();
+        m_levelOffsets.emplace_back(end);
+        for (size_t i = begin; i < end; i++)
+            order.insert(order.end(), children.begin() + childOffsets[order[i]],
+                         children.begin() + childOffsets[order[i] + 1]);
+        begin = end;
+    }
+
+    // Move the transforms into that order, so that update() reads the arrays
+    // sequentially. The free indices are dropped, since the transforms are
+    // now packed at the start of the arrays.
+    std::vector<uint32_t> &newIndices = positions;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(order.size()); i++)
+        newIndices[order[i]] = i;
+    for (auto &p : m_parents)
+        if (p != INVALID_INDEX)
+            p = newIndices[p];
+    permute(order, &m_handles);
+    permute(order, &m_parents);
+    permute(order, &m_childCounts);
+    permute(order, &m_localPositions);
+    permute(order, &m_localRotations);
+    permute(order, &m_localScales);
+    permute(order, &m_localGenerations);
+    // The world matrices aren't moved, but recalculated by the update that
+    // sorts the transforms. They end up with the same world generations, so
+    // the transforms aren't reported as moved. A world generation is never
+    // 0, which invalidates the world rigid matrices. Their arrays are reused
+    // for the local matrices, since allocating new ones costs more than
+    // moving the matrices.
+    permute(order, &m_localMatrices, &m_worldMatrices);
+    permute(order, &m_localRigidMatrices, &m_worldRigidMatrices);
+    m_worldMatrices.resize(order.size());
+    m_worldRigidMatrices.resize(order.size());
+    m_worldGenerations.assign(order.size(), 0);
+    m_validatedGenerations.assign(order.size(), 0);
+    m_worldRigidGenerations.assign(order.size(), 0);
+    m_freeIndices.clear();
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_handles.size()); i++)
+        if (m_handles[i] != nullptr)
+            m_handles[i]->m_index = i;
+    m_isOrderValid = true;
+}
+
+void kirana::math::TransformStore::update(bool parallel)
+{
+    if (m_updatedGeneration == m_generation)
+        return;
+    if (!m_isOrderValid)
+        sortByDepth();
+
+    // Each depth only reads the world matrices of the previous one, so the
+    // transforms within a depth can be updated in any order.
+    const size_t grainSize = PARALLEL_UPDATE_THRESHOLD / 4;
+    for (size_t d = 0; d + 1 < m_levelOffsets.size(); d++)
+    {
+        const size_t begin = m_levelOffsets[d];
+        const size_t end = m_levelOffsets[d + 1];
+        if (parallel && end - begin >= PARALLEL_UPDATE_THRESHOLD)
+        {
+            utils::ThreadPool::get().parallelFor(
+                end - begin,
+                [&](size_t i) {
+                    calculateWorldMatrix(static_cast<uint32_t>(begin + i));
+                },
+                grainSize);
+        }
+        else
+        {
+            for (size_t i = begin; i < end; i++)
+                calculateWorldMatrix(static_cast<uint32_t>(i));
+        }
+    }
+    m_updatedGeneration = m_generation;
+}
+
+void kirana::math::TransformStore::getMovedTransforms(
+    uint64_t generation, std::vector<TransformHierarchy *> *transforms)
+{
+    // The world generation of a transform is the latest change in its
+    // parent chain, so it's newer than the given generation if any of them
+    // changed since.
+    update();
+    transforms->clear();
+    for (size_t i = 0; i < m_handles.size(); i++)
+        if (m_handles[i] != nullptr && m_worldGenerations[i] > generation)
+            transforms->emplace_back(m_handles[i]);
+}
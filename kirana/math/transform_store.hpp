@@ -0,0 +1,153 @@
+#ifndef KIRANA_MATH_TRANSFORM_STORE_HPP
+#define KIRANA_MATH_TRANSFORM_STORE_HPP
+
+#include "quaternion.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace kirana::math
+{
+class TransformHierarchy;
+
+/**
+ * Scene-wide storage for the data of TransformHierarchy objects, laid out as
+ * contiguous arrays indexed by transform. A TransformHierarchy is a handle to
+ * an entry in a store.
+ *
+ * World matrices are calculated lazily when queried (see TransformHierarchy),
+ * or for all changed transforms at once by update(). When the hierarchy
+ * changes, update() first moves the transforms in the arrays so that they're
+ * sorted by depth, which puts every parent before its children, and then
+ * walks the arrays in order. World matrices without scale are only needed
+ * for a few queries, so they are always calculated lazily.
+ *
+ * A transform that is destroyed while it still has children is kept in the
+ * store until its children are gone, so that their world matrices remain
+ * valid. getParent() of those children returns nullptr.
+ *
+ * The store isn't thread-safe.
+ */
+class TransformStore
+{
+    friend class TransformHierarchy;
+
+  public:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+    /// Depth levels with at least this many transforms are updated in
+    /// parallel.
+    static constexpr size_t PARALLEL_UPDATE_THRESHOLD = 8192;
+
+    TransformStore() = default;
+    ~TransformStore() = default;
+    TransformStore(const TransformStore &store) = delete;
+    TransformStore &operator=(const TransformStore &store) = delete;
+
+    /// Store of the transforms that aren't part of a scene, such as cameras.
+    static const std::shared_ptr<TransformStore> &getDefault()
+    {
+        static const std::shared_ptr<TransformStore> store =
+            std::make_shared<TransformStore>();
+        return store;
+    }
+
+    /// @return The number of transforms in the store.
+    [[nodiscard]] inline size_t size() const
+    {
+        return m_parents.size() - m_freeIndices.size();
+    }
+    /// @return A counter incremented whenever a transform or a parent
+    /// changes.
+    [[nodiscard]] inline uint64_t getGeneration() const
+    {
+        return m_generation;
+    }
+
+    /**
+     * Recalculates the world matrices of all the transforms that changed, or
+     * whose parents changed, since the last update. Returns immediately if
+     * nothing changed.
+     * @param parallel If true, depth levels with many transforms are split
+     * across the thread pool.
+     */
+    void update(bool parallel = true);
+    /**
+     * Finds the transforms whose world matrix changed since the given
+     * generation, because they or one of their parents changed. Used to only
+     * update what depends on the transforms that moved, such as their bounds.
+     * Updates the world matrices first.
+     * @param generation A previous value of getGeneration().
+     * @param transforms The transforms that moved.
+     */
+    void getMovedTransforms(uint64_t generation,
+                            std::vector<TransformHierarchy *> *transforms);
+
+  private:
+    // Per transform data.
+    std::vector<TransformHierarchy *> m_handles;
+    std::vector<uint32_t> m_parents;
+    std::vector<uint32_t> m_childCounts;
+    std::vector<Vector3> m_localPositions;
+    std::vector<Quaternion> m_localRotations;
+    std::vector<Vector3> m_localScales;
+    std::vector<Matrix4x4> m_localMatrices;
+    // Local matrices without scale.
+    std::vector<Matrix4x4> m_localRigidMatrices;
+    std::vector<Matrix4x4> m_worldMatrices;
+    // World matrices without scale. Only calculated when queried.
+    std::vector<Matrix4x4> m_worldRigidMatrices;
+    // Generation of the local data and the parent.
+    std::vector<uint64_t> m_localGenerations;
+    // Latest local generation in the parent chain when the world matrices
+    // were calculated.
+    std::vector<uint64_t> m_worldGenerations;
+    // Store generation when the world matrices were last validated by a
+    // query. update() validates all of them, which m_updatedGeneration
+    // records instead.
+    std::vector<uint64_t> m_validatedGenerations;
+    // World generation when the world rigid matrix was calculated.
+    std::vector<uint64_t> m_worldRigidGenerations;
+
+    std::vector<uint32_t> m_freeIndices;
+    // Incremented whenever a transform or a parent changes.
+    uint64_t m_generation = 0;
+    uint64_t m_updatedGeneration = 0;
+
+    // Start of each depth in the arrays, valid while m_isOrderValid is.
+    std::vector<size_t> m_levelOffsets;
+    bool m_isOrderValid = true;
+
+    uint32_t add(TransformHierarchy *handle, uint32_t parent);
+    void remove(uint32_t index);
+    void release(uint32_t index);
+    void setParent(uint32_t index, uint32_t parent);
+
+    inline void markDirty(uint32_t index)
+    {
+        m_localGenerations[index] = ++m_generation;
+    }
+    inline bool hasParent(uint32_t index) const
+    {
+        return m_parents[index] != INVALID_INDEX;
+    }
+
+    /// Recalculates the world matrices of the transform and its parents if
+    /// any of them changed.
+    void updateWorldMatrix(uint32_t index);
+    /// Recalculates the world matrix of the transform if it or its parent
+    /// changed, given that the parent is up to date.
+    void calculateWorldMatrix(uint32_t index);
+    /// Recalculates the world matrix without scale of the transform and its
+    /// parents if any of them changed.
+    void updateWorldRigidMatrix(uint32_t index);
+    /// Validates the world matrix without scale of the transform, given that
+    /// the world matrices of the transform and its parents are up to date.
+    void validateWorldRigidMatrix(uint32_t index);
+    /// Moves the transforms so that they're sorted by depth, and updates the
+    /// indices of their handles. Released transforms are removed.
+    void sortByDepth();
+};
+} // namespace kirana::math
+
+#endif // KIRANA_MATH_TRANSFORM_STORE_HPP
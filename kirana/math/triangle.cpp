@@ -0,0 +1,158 @@
+#include "triangle.hpp"
+
+#include <cmath>
+#include <utility>
+
+namespace simd = kirana::math::simd;
+
+kirana::math::TriangleRay::TriangleRay(const Ray &ray)
+    : origin{ray.getOrigin()}, maxDistance{ray.getMaxDistance()}
+{
+    const Vector3 direction = ray.getDirection();
+    int z = 0;
+    for (int i = 1; i < 3; i++)
+        if (std::fabs(direction[i]) > std::fabs(direction[z]))
+            z = i;
+    int x = (z + 1) % 3;
+    int y = (x + 1) % 3;
+    // Keeps the winding of the triangles when the direction is flipped.
+    if (direction[z] < 0.0f)
+        std::swap(x, y);
+    axes[0] = x;
+    axes[1] = y;
+    axes[2] = z;
+
+    shear[0] = -direction[x] / direction[z];
+    shear[1] = -direction[y] / direction[z];
+    shear[2] = 1.0f / direction[z];
+    for (int i = 0; i < 3; i++)
+    {
+        simdOrigin[i] = simd::splat(origin[i]);
+        simdShear[i] = simd::splat(shear[i]);
+    }
+}
+
+bool kirana::math::Triangle::intersect(const TriangleRay &ray,
+                                       const Vector3 &v0, const Vector3 &v1,
+                                       const Vector3 &v2, float maxDistance,
+                                       float *distance)
+{
+    const int x = ray.axes[0];
+    const int y = ray.axes[1];
+    const int z = ray.axes[2];
+    const Vector3 a = v0 - ray.origin;
+    const Vector3 b = v1 - ray.origin;
+    const Vector3 c = v2 - ray.origin;
+
+    // Vertices sheared into the space of the ray.
+    const float ax = a[x] + ray.shear[0] * a[z];
+    const float ay = a[y] + ray.shear[1] * a[z];
+    const float bx = b[x] + ray.shear[0] * b[z];
+    const float by = b[y] + ray.shear[1] * b[z];
+    const float cx = c[x] + ray.shear[0] * c[z];
+    const float cy = c[y] + ray.shear[1] * c[z];
+
+    // Edge functions, which give the side of each edge the ray passes.
+    float u = cx * by - cy * bx;
+    float v = ax * cy - ay * cx;
+    float w = bx * ay - by * ax;
+    // The ray passes through an edge or a vertex. The edge functions are
+    // recalculated in double precision, so that the triangles sharing the
+    // edge agree on the side.
+    if (u == 0.0f || v == 0.0f || w == 0.0f)
+    {
+        u = static_cast<float>(static_cast<double>(cx) * by -
+                               static_cast<double>(cy) * bx);
+        v = static_cast<float>(static_cast<double>(ax) * cy -
+                               static_cast<double>(ay) * cx);
+        w = static_cast<float>(static_cast<double>(bx) * ay -
+                               static_cast<double>(by) * ax);
+    }
+    if ((u < 0.0f || v < 0.0f || w < 0.0f) &&
+        (u > 0.0f || v > 0.0f || w > 0.0f))
+        return false;
+
+    const float determinant = u + v + w;
+    if (determinant == 0.0f)
+        return false;
+
+    // The distance is scaled by the determinant, so that the division is
+    // only done for hits.
+    const float az = ray.shear[2] * a[z];
+    const float bz = ray.shear[2] * b[z];
+    const float cz = ray.shear[2] * c[z];
+    const float t = u * az + v * bz + w * cz;
+    if (determinant < 0.0f && (t >= 0.0f || t < maxDistance * determinant))
+        return false;
+    if (determinant > 0.0f && (t <= 0.0f || t > maxDistance * determinant))
+        return false;
+    *distance = t / determinant;
+    return true;
+}
+
+int kirana::math::Triangle::intersect(const TriangleRay &ray,
+                                      const float vertices[3][3][WIDTH],
+                                      float maxDistance,
+                                      float distances[WIDTH])
+{
+    const simd::Float4 zero = simd::splat(0.0f);
+    const auto isZero = [&](simd::Float4 value) {
+        return simd::moveMask(simd::lessEqual(value, zero)) &
+               simd::moveMask(simd::lessEqual(zero, value));
+    };
+
+    // The same calculations as the single triangle test, with one triangle
+    // in each lane.
+    simd::Float4 px[3], py[3], pz[3];
+    for (int i = 0; i < 3; i++)
+    {
+        const simd::Float4 x = simd::sub(simd::load(vertices[i][ray.axes[0]]),
+                                         ray.simdOrigin[ray.axes[0]]);
+        const simd::Float4 y = simd::sub(simd::load(vertices[i][ray.axes[1]]),
+                                         ray.simdOrigin[ray.axes[1]]);
+        const simd::Float4 z = simd::sub(simd::load(vertices[i][ray.axes[2]]),
+                                         ray.simdOrigin[ray.axes[2]]);
+        px[i] = simd::add(x, simd::mul(ray.simdShear[0], z));
+        py[i] = simd::add(y, simd::mul(ray.simdShear[1], z));
+        pz[i] = simd::mul(ray.simdShear[2], z);
+    }
+    const simd::Float4 u =
+        simd::sub(simd::mul(px[2], py[1]), simd::mul(py[2], px[1]));
+    const simd::Float4 v =
+        simd::sub(simd::mul(px[0], py[2]), simd::mul(py[0], px[2]));
+    const simd::Float4 w =
+        simd::sub(simd::mul(px[1], py[0]), simd::mul(py[1], px[0]));
+
+    const int edgeMask =
+        simd::moveMask(simd::lessEqual(zero, simd::min(simd::min(u, v), w))) |
+        simd::moveMask(simd::lessEqual(simd::max(simd::max(u, v), w), zero));
+    // Triangles with a zero edge function are tested one at a time, with the
+    // double precision fallback.
+    const int fallbackMask = isZero(u) | isZero(v) | isZero(w);
+
+    const simd::Float4 determinant = simd::add(simd::add(u, v), w);
+    const simd::Float4 t = simd::div(
+        simd::add(simd::add(simd::mul(u, pz[0]), simd::mul(v, pz[1])),
+                  simd::mul(w, pz[2])),
+        determinant);
+    const int distanceMask =
+        ~simd::moveMask(simd::lessEqual(t, zero)) &
+        simd::moveMask(simd::lessEqual(t, simd::splat(maxDistance)));
+    simd::store(distances, t);
+    int mask = edgeMask & ~isZero(determinant) & distanceMask & ~fallbackMask;
+
+    for (int i = 0; i < WIDTH; i++)
+    {
+        if ((fallbackMask & (1 << i)) == 0)
+            continue;
+        const Vector3 v0(vertices[0][0][i], vertices[0][1][i],
+                         vertices[0][2][i]);
+        const Vector3 v1(vertices[1][0][i], vertices[1][1][i],
+                         vertices[1][2][i]);
+        const Vector3 v2(vertices[2][0][i], vertices[2][1][i],
+                         vertices[2][2][i]);
+        if (intersect(ray, v0, v1, v2, maxDistance, &distances[i]))
+            mask |= 1 << i;
+    }
+    return mask;
+}
@@ -0,0 +1,74 @@
+#ifndef KIRANA_MATH_TRIANGLE_HPP
+#define KIRANA_MATH_TRIANGLE_HPP
+
+#include "ray.hpp"
+#include "simd.hpp"
+
+namespace kirana::math
+{
+/**
+ * Ray prepared for watertight ray-triangle tests. The triangles are moved to
+ * a space where the ray starts at the origin and points along +z, so that
+ * only the 2D edge functions of the triangle have to be evaluated. The axes
+ * and the shear are calculated once for all the triangles tested against the
+ * ray.
+ */
+struct TriangleRay
+{
+    Vector3 origin;
+    /// The axes mapped to x, y and z. z is the largest axis of the direction.
+    int axes[3];
+    /// Shear that aligns the direction with +z.
+    float shear[3];
+    float maxDistance;
+
+    simd::Float4 simdOrigin[3];
+    simd::Float4 simdShear[3];
+
+    explicit TriangleRay(const Ray &ray);
+};
+
+/**
+ * Watertight ray-triangle intersection. Rays through a shared edge or vertex
+ * hit at least one of the triangles sharing it, so rays don't slip through
+ * closed meshes. Both faces of the triangles are hit.
+ * Refer: "Watertight Ray/Triangle Intersection", by Woop, Benthin and Wald,
+ * and Section 3.6.2, PBRT 3rd Edition.
+ */
+class Triangle
+{
+  public:
+    /// Number of triangles tested at a time.
+    static constexpr int WIDTH = 4;
+
+    Triangle() = delete;
+
+    /**
+     * Tests the ray against a triangle.
+     * @param ray The ray to test.
+     * @param v0 First vertex of the triangle.
+     * @param v1 Second vertex of the triangle.
+     * @param v2 Third vertex of the triangle.
+     * @param maxDistance Hits beyond this distance are ignored.
+     * @param distance Distance of the hit along the ray. Written out only if
+     * the triangle is hit.
+     * @return true if the triangle is hit.
+     */
+    static bool intersect(const TriangleRay &ray, const Vector3 &v0,
+                          const Vector3 &v1, const Vector3 &v2,
+                          float maxDistance, float *distance);
+    /**
+     * Tests the ray against WIDTH triangles at a time.
+     * @param ray The ray to test.
+     * @param vertices Vertex positions, indexed as [vertex][axis][triangle].
+     * @param maxDistance Hits beyond this distance are ignored.
+     * @param distances Distance of the hit of each triangle hit.
+     * @return Bit mask of the triangles hit, triangle i in bit i.
+     */
+    static int intersect(const TriangleRay &ray,
+                         const float vertices[3][3][WIDTH], float maxDistance,
+                         float distances[WIDTH]);
+};
+} // namespace kirana::math
+
+#endif // KIRANA_MATH_TRIANGLE_HPP
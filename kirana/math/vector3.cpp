@@ -19,14 +19,6 @@ const Vector3 Vector3::RIGHT{1.0f, 0.0f, 0.0f};
 const Vector3 Vector3::FORWARD{0.0f, 0.0f, 1.0f};
 const Vector3 Vector3::BACK{0.0f, 0.0f, -1.0f};
 
-Vector3::Vector3(std::array<float, 3> vector) : m_current{vector}
-{
-}
-
-Vector3::Vector3(float x, float y, float z) : m_current{x, y, z}
-{
-}
-
 Vector3::Vector3(const Vector2 &vec2) : m_current{vec2[0], vec2[1], 0.0f}
 {
 }
@@ -35,19 +27,6 @@ Vector3::Vector3(const Vector4 &vec4) : m_current{vec4[0], vec4[1], vec4[2]}
 {
 }
 
-Vector3::Vector3(const Vector3 &vec3)
-{
-    if (this != &vec3)
-        m_current = vec3.m_current;
-}
-
-Vector3 &Vector3::operator=(const Vector3 &vec3)
-{
-    if (this != &vec3)
-        m_current = vec3.m_current;
-    return *this;
-}
-
 bool Vector3::operator==(const Vector3 &rhs) const
 {
     return approximatelyEqual(m_current[0], rhs.m_current[0]) &&
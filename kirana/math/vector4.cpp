@@ -2,6 +2,7 @@
 #include "vector2.hpp"
 #include "vector3.hpp"
 #include "math_utils.hpp"
+#include "simd.hpp"
 
 #include <string>
 
@@ -9,16 +10,8 @@ using kirana::math::Vector4;
 using kirana::math::Vector2;
 using kirana::math::Vector3;
 
-const Vector4 ZERO{0.0f, 0.0f, 0.0f, 0.0f};
-const Vector4 ONE{1.0f, 1.0f, 1.0f, 1.0f};
-
-Vector4::Vector4(std::array<float, 4> vector) : m_current{vector}
-{
-}
-
-Vector4::Vector4(float x, float y, float z, float w) : m_current{x, y, z, w}
-{
-}
+const Vector4 Vector4::ZERO{0.0f, 0.0f, 0.0f, 0.0f};
+const Vector4 Vector4::ONE{1.0f, 1.0f, 1.0f, 1.0f};
 
 Vector4::Vector4(const Vector2 &vec2, float z, float w)
     : m_current{vec2[0], vec2[1], z, w}
@@ -30,19 +23,6 @@ Vector4::Vector4(const Vector3 &vec3, float w)
 {
 }
 
-Vector4::Vector4(const Vector4 &vec4)
-{
-    if (this != &vec4)
-        m_current = vec4.m_current;
-}
-
-Vector4 &Vector4::operator=(const Vector4 &vec4)
-{
-    if (this != &vec4)
-        m_current = vec4.m_current;
-    return *this;
-}
-
 bool Vector4::operator==(const Vector4 &rhs) const
 {
     return approximatelyEqual(m_current[0], rhs.m_current[0]) &&
@@ -75,33 +55,29 @@ Vector4::operator std::string() const
 
 Vector4 Vector4::operator-() const
 {
-    return Vector4(-m_current[0], -m_current[1], -m_current[2], -m_current[3]);
+    Vector4 result;
+    simd::store(result.data(), simd::sub(simd::splat(0.0f),
+                                         simd::load(m_current.data())));
+    return result;
 }
 
 Vector4 &Vector4::operator+=(const Vector4 &rhs)
 {
-    m_current[0] += rhs[0];
-    m_current[1] += rhs[1];
-    m_current[2] += rhs[2];
-    m_current[3] += rhs[3];
-
+    simd::store(m_current.data(), simd::add(simd::load(m_current.data()),
+                                            simd::load(rhs.data())));
     return *this;
 }
 Vector4 &Vector4::operator-=(const Vector4 &rhs)
 {
-    m_current[0] -= rhs[0];
-    m_current[1] -= rhs[1];
-    m_current[2] -= rhs[2];
-    m_current[3] -= rhs[3];
+    simd::store(m_current.data(), simd::sub(simd::load(m_current.data()),
+                                            simd::load(rhs.data())));
     return *this;
 }
 
 Vector4 &Vector4::operator*=(const float rhs)
 {
-    m_current[0] *= rhs;
-    m_current[1] *= rhs;
-    m_current[2] *= rhs;
-    m_current[3] *= rhs;
+    simd::store(m_current.data(), simd::mul(simd::load(m_current.data()),
+                                            simd::splat(rhs)));
     return *this;
 }
 
@@ -118,8 +94,8 @@ float Vector4::length() const
 
 float Vector4::lengthSquared() const
 {
-    return (m_current[0] * m_current[0]) + (m_current[1] * m_current[1]) +
-           (m_current[2] * m_current[2]) + (m_current[3] * m_current[3]);
+    const simd::Float4 v = simd::load(m_current.data());
+    return simd::dot4(v, v);
 }
 
 void Vector4::normalize()
@@ -134,25 +110,37 @@ Vector4 Vector4::normalize(const Vector4 &vec4)
 
 Vector4 Vector4::lerp(const Vector4 &v, const Vector4 &w, float t)
 {
-    return (1 - t) * v + t * w;
+    Vector4 result;
+    simd::store(result.data(),
+                simd::mulAdd(simd::splat(t), simd::load(w.data()),
+                             simd::mul(simd::splat(1 - t),
+                                       simd::load(v.data()))));
+    return result;
 }
 
 
 Vector4 kirana::math::operator+(const Vector4 &lhs, const Vector4 &rhs)
 {
-    return Vector4(lhs[0] + rhs[0], lhs[1] + rhs[1], lhs[2] + rhs[2],
-                   lhs[3] + rhs[3]);
+    Vector4 result;
+    simd::store(result.data(),
+                simd::add(simd::load(lhs.data()), simd::load(rhs.data())));
+    return result;
 }
 
 Vector4 kirana::math::operator-(const Vector4 &lhs, const Vector4 &rhs)
 {
-    return Vector4(lhs[0] - rhs[0], lhs[1] - rhs[1], lhs[2] - rhs[2],
-                   lhs[3] - rhs[3]);
+    Vector4 result;
+    simd::store(result.data(),
+                simd::sub(simd::load(lhs.data()), simd::load(rhs.data())));
+    return result;
 }
 
 Vector4 kirana::math::operator*(float lhs, const Vector4 &rhs)
 {
-    return Vector4(rhs[0] * lhs, rhs[1] * lhs, rhs[2] * lhs, rhs[3] * lhs);
+    Vector4 result;
+    simd::store(result.data(),
+                simd::mul(simd::splat(lhs), simd::load(rhs.data())));
+    return result;
 }
 
 Vector4 kirana::math::operator*(const Vector4 &lhs, float rhs)
@@ -25,13 +25,14 @@ class Vector4
 
     Vector4() = default;
     ~Vector4() = default;
-    explicit Vector4(std::array<float, 4> vector);
-    explicit Vector4(float x, float y, float z, float w);
+    explicit Vector4(std::array<float, 4> vector) : m_current{vector} {};
+    explicit Vector4(float x, float y, float z, float w)
+        : m_current{x, y, z, w} {};
     explicit Vector4(const Vector2 &vec2, float z = 0.0f, float w = 0.0f);
     explicit Vector4(const Vector3 &vec3, float w = 0.0f);
 
-    Vector4(const Vector4 &vec4);
-    Vector4 &operator=(const Vector4 &vec4);
+    Vector4(const Vector4 &vec4) = default;
+    Vector4 &operator=(const Vector4 &vec4) = default;
     bool operator==(const Vector4 &rhs) const;
     bool operator!=(const Vector4 &rhs) const;
 
@@ -44,11 +45,11 @@ class Vector4
 
     inline const float &operator[](int i) const
     {
-        return i < 0 ? m_current[0] : (i > 3 ? m_current[3] : m_current.at(i));
+        return m_current[i < 0 ? 0 : (i > 3 ? 3 : i)];
     }
     inline float &operator[](int i)
     {
-        return i < 0 ? m_current[0] : (i > 3 ? m_current[3] : m_current.at(i));
+        return m_current[i < 0 ? 0 : (i > 3 ? 3 : i)];
     }
 
     // Current Vector operations
@@ -72,6 +73,10 @@ class Vector4
     {
         return m_current.data();
     }
+    [[nodiscard]] inline float *data()
+    {
+        return m_current.data();
+    }
 
     static Vector4 normalize(const Vector4 &vec4);
     static Vector4 lerp(const Vector4 &v, const Vector4 &w, float t);
@@ -3,6 +3,7 @@
 
 #include <vector2.hpp>
 #include <math_utils.hpp>
+#include <algorithm>
 
 
 kirana::scene::Camera::Camera(std::array<uint32_t, 2> windowResolution,
@@ -87,6 +88,18 @@ kirana::math::Ray kirana::scene::Camera::screenPositionToRay(
     return {origin, direction};
 }
 
+float kirana::scene::Camera::getProjectedSize(const math::Vector3 &worldPos,
+                                              float size) const
+{
+    // w is the view depth for perspective projections and 1 for orthographic
+    // projections. Positions closer than the near plane are clamped to it.
+    const math::Vector4 pos =
+        getViewProjectionMatrix() * math::Vector4(worldPos, 1.0f);
+    const float w = std::max(pos[3], std::min(m_nearPlane, 1.0f));
+    return size * std::abs(m_projection[1][1]) / w * 0.5f *
+           static_cast<float>(m_windowResolution[1]);
+}
+
 void kirana::scene::Camera::setResolution(std::array<uint32_t, 2> resolution)
 {
     m_windowResolution = resolution;
@@ -95,6 +95,14 @@ class Camera
         const math::Vector3 &worldPos) const;
     [[nodiscard]] math::Ray screenPositionToRay(
         const math::Vector2 &screenPos) const;
+    /**
+     * Returns the height in pixels of a screen-aligned line projected onto
+     * the screen.
+     * @param worldPos Center of the line in world-space.
+     * @param size Length of the line in world-space.
+     */
+    [[nodiscard]] float getProjectedSize(const math::Vector3 &worldPos,
+                                         float size) const;
 
     virtual void fitBoundsToView(const math::Vector3 &lookAtPosition,
                                  const math::Bounds3 &bounds,
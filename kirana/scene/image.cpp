@@ -1,12 +1,18 @@
 #include "image.hpp"
+#include "image_cache.hpp"
+#include "image_compression.hpp"
+#include "image_processing.hpp"
 
 #include <assimp/texture.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include <utility>
+#include <constants.h>
 #include <file_system.hpp>
 
+namespace constants = kirana::utils::constants;
+
 kirana::scene::Image::Image(std::string filepath, std::string name,
                             uint32_t index, ImageProperties properties)
     : m_filepath{std::move(filepath)}, m_name{std::move(name)}, m_index{index},
@@ -40,28 +46,77 @@ void *kirana::scene::Image::load()
 {
     free();
     if (!utils::filesystem::fileExists(m_filepath))
-        return m_pixelData;
+        return nullptr;
+
+    if (constants::IMAGE_CACHE_ENABLED && ImageCache::get().loadImage(this))
+        return m_pixelData.data();
 
     const int desiredChannels = static_cast<int>(m_properties.channels);
     int fileChannels = 0;
-    if (m_properties.colorSpace == ColorSpace::sRGB)
-        m_pixelData = reinterpret_cast<void *>(
+    void *pixels = nullptr;
+    // Linear images are only decoded to floats if the file holds HDR data.
+    if (m_properties.colorSpace == ColorSpace::sRGB ||
+        !stbi_is_hdr(m_filepath.c_str()))
+    {
+        m_dataType = PixelDataType::UNORM8;
+        pixels = reinterpret_cast<void *>(
             stbi_load(m_filepath.c_str(), &m_size[0], &m_size[1], &fileChannels,
                       desiredChannels));
+    }
     else
-        m_pixelData = reinterpret_cast<void *>(
+    {
+        m_dataType = PixelDataType::FLOAT32;
+        pixels = reinterpret_cast<void *>(
             stbi_loadf(m_filepath.c_str(), &m_size[0], &m_size[1],
                        &fileChannels, desiredChannels));
-
+    }
+    if (pixels == nullptr)
+        return nullptr;
     m_properties.fileChannels = static_cast<Channels>(fileChannels);
-    return m_pixelData;
+
+    m_mipLevels = image_processing::generateMipChain(
+        pixels, m_size, static_cast<uint32_t>(m_properties.channels),
+        m_dataType, m_properties.colorSpace,
+        m_properties.generateMipMaps ? 0 : 1, &m_pixelData);
+    stbi_image_free(pixels);
+
+    // HDR data is uploaded as half floats. RGB is expanded to RGBA, since most
+    // devices can't sample 3 channel half float textures.
+    m_channels = m_properties.channels;
+    if (m_dataType == PixelDataType::FLOAT32)
+    {
+        if (m_channels == Channels::RGB)
+            m_channels = Channels::RGBA;
+        std::vector<uint8_t> halfData;
+        m_mipLevels = image_processing::convertMipChainToHalf(
+            m_pixelData, m_mipLevels,
+            static_cast<uint32_t>(m_properties.channels),
+            static_cast<uint32_t>(m_channels), &halfData);
+        m_pixelData = std::move(halfData);
+        m_dataType = PixelDataType::FLOAT16;
+    }
+
+    m_compression =
+        image_compression::getCompression(m_properties, m_dataType);
+    if (m_compression != ImageCompression::NONE)
+    {
+        std::vector<uint8_t> compressedData;
+        m_mipLevels = image_compression::compressMipChain(
+            m_pixelData, m_mipLevels,
+            static_cast<uint32_t>(m_properties.channels), m_compression,
+            &compressedData);
+        m_pixelData = std::move(compressedData);
+    }
+
+    if (constants::IMAGE_CACHE_ENABLED)
+        ImageCache::get().saveImage(*this);
+    return m_pixelData.data();
 }
 
 void kirana::scene::Image::free()
 {
-    if (m_pixelData != nullptr)
-    {
-        stbi_image_free(m_pixelData);
-        m_pixelData = nullptr;
-    }
-}
\ No newline at end of file
+    m_compression = ImageCompression::NONE;
+    m_mipLevels.clear();
+    m_pixelData.clear();
+    m_pixelData.shrink_to_fit();
+}
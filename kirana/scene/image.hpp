@@ -3,6 +3,8 @@
 
 #include "image_types.hpp"
 
+#include <cstdint>
+
 struct aiTexture;
 
 namespace kirana::scene
@@ -19,9 +21,20 @@ class Image
     Image(const Image &image) = delete;
     Image &operator=(const Image &image) = delete;
 
+    /**
+     * Decodes the image file, generates its mip chain and block compresses it,
+     * or reads the result from the image cache. Different images can be loaded
+     * concurrently.
+     * @return The pixel data of all the mip levels, nullptr on failure.
+     */
     void *load();
     void free();
 
+    [[nodiscard]] inline bool isLoaded() const
+    {
+        return !m_pixelData.empty();
+    }
+
     [[nodiscard]] inline const std::string &getFilepath() const
     {
         return m_filepath;
@@ -47,15 +60,39 @@ class Image
         return m_properties;
     }
 
+    [[nodiscard]] inline PixelDataType getDataType() const
+    {
+        return m_dataType;
+    }
+
+    /// Channels of the pixel data. May have more channels than requested by
+    /// the properties, since RGB half float data is expanded to RGBA.
+    [[nodiscard]] inline Channels getChannels() const
+    {
+        return m_channels;
+    }
+
+    /// Block compression format of the pixel data of every mip level.
+    [[nodiscard]] inline ImageCompression getCompression() const
+    {
+        return m_compression;
+    }
+
+    /// Levels of the mip chain, starting with the full size image.
+    [[nodiscard]] inline const std::vector<ImageMipLevel> &getMipLevels() const
+    {
+        return m_mipLevels;
+    }
+
     [[nodiscard]] inline const void *getPixelData() const
     {
-        return m_pixelData;
+        return m_pixelData.empty() ? nullptr : m_pixelData.data();
     }
 
+    /// Size of the pixel data of all the mip levels in bytes.
     [[nodiscard]] inline size_t getPixelDataSize() const
     {
-        return static_cast<size_t>(m_size[0] * m_size[1]) *
-               static_cast<size_t>(m_properties.channels);
+        return m_pixelData.size();
     }
 
   private:
@@ -64,8 +101,14 @@ class Image
     uint32_t m_index;
     std::array<int, 2> m_size = {0, 0};
     ImageProperties m_properties;
+    PixelDataType m_dataType = PixelDataType::UNORM8;
+    Channels m_channels = Channels::RGBA;
+    ImageCompression m_compression = ImageCompression::NONE;
+
+    std::vector<ImageMipLevel> m_mipLevels;
+    std::vector<uint8_t> m_pixelData;
 
-    void *m_pixelData = nullptr;
+    friend class ImageCache;
 };
 }; // namespace kirana::scene
 
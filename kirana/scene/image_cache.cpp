@@ -0,0 +1,201 @@
+#include "image_cache.hpp"
+
+#include "image.hpp"
+#include "image_compression.hpp"
+
+#include <constants.h>
+#include <logger.hpp>
+#include <file_system.hpp>
+#include <hash.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <type_traits>
+
+using kirana::utils::Logger;
+using kirana::utils::LogSeverity;
+namespace constants = kirana::utils::constants;
+
+namespace
+{
+const char IMAGE_CACHE_MAGIC[4] = {'K', 'I', 'M', 'G'};
+
+template <typename T> inline void write(std::ofstream *stream, const T &value)
+{
+    static_assert(std::is_arithmetic_v<T>);
+    stream->write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> inline T read(std::ifstream *stream)
+{
+    static_assert(std::is_arithmetic_v<T>);
+    T value{};
+    stream->read(reinterpret_cast<char *>(&value), sizeof(T));
+    return value;
+}
+} // namespace
+
+uint64_t kirana::scene::ImageCache::getCacheKey(
+    const std::string &path, int64_t lastWriteTime,
+    const ImageProperties &properties)
+{
+    uint64_t key = utils::hash::fnv1a(path);
+    key = utils::hash::fnv1aValue(lastWriteTime, key);
+    key = utils::hash::fnv1aValue(static_cast<int>(properties.channels), key);
+    key = utils::hash::fnv1aValue(static_cast<int>(properties.colorSpace), key);
+    key = utils::hash::fnv1aValue(static_cast<int>(properties.usage), key);
+    key = utils::hash::fnv1aValue(properties.generateMipMaps, key);
+    key = utils::hash::fnv1aValue(properties.enableCompression, key);
+    key = utils::hash::fnv1aValue(constants::IMAGE_COMPRESSION_ENABLED, key);
+    key = utils::hash::fnv1aValue(image_compression::isEnabled(), key);
+    key = utils::hash::fnv1aValue(constants::IMAGE_COMPRESSION_PREFER_BC7, key);
+    key = utils::hash::fnv1aValue(constants::IMAGE_CACHE_VERSION, key);
+    return key;
+}
+
+std::string kirana::scene::ImageCache::getCachePath(const Image &image) const
+{
+    const std::string &path = image.getFilepath();
+    const int64_t lastWriteTime = utils::filesystem::getLastWriteTime(path);
+    if (lastWriteTime == 0)
+        return "";
+
+    std::stringstream filename;
+    filename << utils::filesystem::getFilename(path).first << "_" << std::hex
+             << std::setw(16) << std::setfill('0')
+             << getCacheKey(path, lastWriteTime, image.getProperties());
+    return utils::filesystem::combinePath(
+        constants::CACHE_DIR_PATH,
+        {constants::IMAGE_CACHE_DIR_NAME, filename.str()},
+        constants::IMAGE_CACHE_EXTENSION);
+}
+
+bool kirana::scene::ImageCache::loadImage(Image *image) const
+{
+    const std::string cachePath = getCachePath(*image);
+    if (cachePath.empty() || !utils::filesystem::fileExists(cachePath))
+        return false;
+
+    std::ifstream stream(cachePath, std::ios::binary);
+    if (!stream.good())
+        return false;
+
+    // Header
+    char magic[4]{};
+    stream.read(magic, sizeof(magic));
+    const auto version = read<uint32_t>(&stream);
+    const auto key = read<uint64_t>(&stream);
+    if (!stream.good() || memcmp(magic, IMAGE_CACHE_MAGIC, 4) != 0 ||
+        version != constants::IMAGE_CACHE_VERSION ||
+        key != getCacheKey(image->getFilepath(),
+                           utils::filesystem::getLastWriteTime(
+                               image->getFilepath()),
+                           image->getProperties()))
+    {
+        Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::warning,
+                          "Ignoring outdated image cache: " + cachePath);
+        return false;
+    }
+
+    std::array<int, 2> size{};
+    size[0] = read<int32_t>(&stream);
+    size[1] = read<int32_t>(&stream);
+    const auto fileChannels = read<int32_t>(&stream);
+    const auto channels = read<int32_t>(&stream);
+    const auto dataType = read<int32_t>(&stream);
+    const auto compression = read<int32_t>(&stream);
+    std::vector<ImageMipLevel> mipLevels(read<uint32_t>(&stream));
+    const auto dataSize = static_cast<size_t>(read<uint64_t>(&stream));
+    for (auto &l : mipLevels)
+    {
+        l.size[0] = read<int32_t>(&stream);
+        l.size[1] = read<int32_t>(&stream);
+        l.offset = static_cast<size_t>(read<uint64_t>(&stream));
+        l.dataSize = static_cast<size_t>(read<uint64_t>(&stream));
+        if (l.offset + l.dataSize > dataSize)
+            return false;
+    }
+    if (!stream.good() || mipLevels.empty())
+        return false;
+
+    std::vector<uint8_t> pixelData(dataSize);
+    stream.read(reinterpret_cast<char *>(pixelData.data()),
+                static_cast<std::streamsize>(dataSize));
+    if (!stream.good())
+        return false;
+
+    image->m_size = size;
+    image->m_properties.fileChannels = static_cast<Channels>(fileChannels);
+    image->m_channels = static_cast<Channels>(channels);
+    image->m_dataType = static_cast<PixelDataType>(dataType);
+    image->m_compression = static_cast<ImageCompression>(compression);
+    image->m_mipLevels = std::move(mipLevels);
+    image->m_pixelData = std::move(pixelData);
+    return true;
+}
+
+bool kirana::scene::ImageCache::saveImage(const Image &image) const
+{
+    if (!image.isLoaded())
+        return false;
+
+    const std::string cachePath = getCachePath(image);
+    if (cachePath.empty() ||
+        !utils::filesystem::createDirectory(
+            utils::filesystem::getFolder(cachePath)))
+        return false;
+
+    // Write to a temporary file first so that a failed write never leaves a
+    // partial cache file behind.
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream.good())
+            return false;
+
+        // Header
+        stream.write(IMAGE_CACHE_MAGIC, sizeof(IMAGE_CACHE_MAGIC));
+        write(&stream, constants::IMAGE_CACHE_VERSION);
+        write(&stream, getCacheKey(image.getFilepath(),
+                                   utils::filesystem::getLastWriteTime(
+                                       image.getFilepath()),
+                                   image.getProperties()));
+        write(&stream, static_cast<int32_t>(image.getSize()[0]));
+        write(&stream, static_cast<int32_t>(image.getSize()[1]));
+        write(&stream,
+              static_cast<int32_t>(image.getProperties().fileChannels));
+        write(&stream, static_cast<int32_t>(image.getChannels()));
+        write(&stream, static_cast<int32_t>(image.getDataType()));
+        write(&stream, static_cast<int32_t>(image.getCompression()));
+        write(&stream, static_cast<uint32_t>(image.getMipLevels().size()));
+        write(&stream, static_cast<uint64_t>(image.getPixelDataSize()));
+        for (const auto &l : image.getMipLevels())
+        {
+            write(&stream, static_cast<int32_t>(l.size[0]));
+            write(&stream, static_cast<int32_t>(l.size[1]));
+            write(&stream, static_cast<uint64_t>(l.offset));
+            write(&stream, static_cast<uint64_t>(l.dataSize));
+        }
+
+        // Pixel data
+        stream.write(reinterpret_cast<const char *>(image.getPixelData()),
+                     static_cast<std::streamsize>(image.getPixelDataSize()));
+        if (!stream.good())
+        {
+            Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::error,
+                              "Failed to write image cache: " + tempPath);
+            return false;
+        }
+    }
+
+    std::remove(cachePath.c_str());
+    if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef KIRANA_SCENE_IMAGE_CACHE_HPP
+#define KIRANA_SCENE_IMAGE_CACHE_HPP
+
+#include "image_types.hpp"
+
+#include <string>
+
+namespace kirana::scene
+{
+class Image;
+
+/**
+ * Stores decoded images together with their (block compressed) mip chain, so
+ * that re-opening a scene skips decoding, downsampling and compression. Cache
+ * files are keyed by the source path, the last write time of the source file
+ * and the image properties that affect the pixel data.
+ */
+class ImageCache
+{
+  public:
+    ImageCache(const ImageCache &imageCache) = delete;
+
+    static ImageCache &get()
+    {
+        static ImageCache instance;
+        return instance;
+    }
+
+    /**
+     * Returns the path of the cache file for the given image.
+     * @param image The image.
+     * @return Path of the cache file. Empty if the source file doesn't exist.
+     */
+    [[nodiscard]] std::string getCachePath(const Image &image) const;
+
+    /**
+     * Reads the pixel data and mip levels of the image from its cache file.
+     * @param image The image to load. Left untouched on failure.
+     * @return true if a valid cache file was found and read.
+     */
+    bool loadImage(Image *image) const;
+
+    /**
+     * Writes the pixel data and mip levels of the given (loaded) image to its
+     * cache file.
+     * @param image The loaded image.
+     * @return true if the cache file was written.
+     */
+    bool saveImage(const Image &image) const;
+
+  private:
+    ImageCache() = default;
+    ~ImageCache() = default;
+
+    static uint64_t getCacheKey(const std::string &path, int64_t lastWriteTime,
+                                const ImageProperties &properties);
+};
+} // namespace kirana::scene
+
+#endif // KIRANA_SCENE_IMAGE_CACHE_HPP
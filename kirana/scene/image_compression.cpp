@@ -0,0 +1,722 @@
+#include "image_compression.hpp"
+
+#include <constants.h>
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace constants = kirana::utils::constants;
+
+namespace
+{
+using kirana::scene::ImageCompression;
+
+std::atomic<bool> isCompressionEnabled{true};
+
+/// Weights of the endpoints of BC1 color indices. The weight of the second
+/// endpoint is 1 - weight.
+constexpr float BC1_WEIGHTS[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+/// Interpolation weights of 4-bit BC7 indices, in 64ths.
+constexpr int BC7_WEIGHTS[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                 34, 38, 43, 47, 51, 55, 60, 64};
+
+/// Writes the bits of a zeroed block, least significant bit first.
+class BitWriter
+{
+  public:
+    explicit BitWriter(uint8_t *data) : m_data{data}
+    {
+    }
+
+    void write(uint32_t value, int bitCount)
+    {
+        for (int i = 0; i < bitCount; i++, m_position++)
+        {
+            if ((value >> i) & 1u)
+                m_data[m_position / 8] |= static_cast<uint8_t>(
+                    1u << (m_position % 8));
+        }
+    }
+
+  private:
+    uint8_t *m_data;
+    int m_position = 0;
+};
+
+/// Reads the bits of a block, least significant bit first.
+class BitReader
+{
+  public:
+    explicit BitReader(const uint8_t *data) : m_data{data}
+    {
+    }
+
+    uint32_t read(int bitCount)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < bitCount; i++, m_position++)
+            value |= ((m_data[m_position / 8] >> (m_position % 8)) & 1u) << i;
+        return value;
+    }
+
+  private:
+    const uint8_t *m_data;
+    int m_position = 0;
+};
+
+/// Reads the 4x4 block at the given block coordinates as RGBA. Pixels outside
+/// the image repeat the last row and column.
+void loadBlock(const uint8_t *pixels, const std::array<int, 2> &size,
+               uint32_t channels, int blockX, int blockY, uint8_t block[64])
+{
+    for (int y = 0; y < 4; y++)
+    {
+        const int py = std::min(blockY * 4 + y, size[1] - 1);
+        for (int x = 0; x < 4; x++)
+        {
+            const int px = std::min(blockX * 4 + x, size[0] - 1);
+            const uint8_t *src =
+                pixels + (static_cast<size_t>(py) * size[0] + px) * channels;
+            uint8_t *dst = block + (y * 4 + x) * 4;
+            switch (channels)
+            {
+            case 1:
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3] = 255;
+                break;
+            case 2:
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3] = src[1];
+                break;
+            case 3:
+                std::memcpy(dst, src, 3);
+                dst[3] = 255;
+                break;
+            default:
+                std::memcpy(dst, src, 4);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Fits a line through the first N channels of the pixels of the block. The
+ * direction is the principal axis of the pixels, found with a few power
+ * iterations on their covariance matrix.
+ * @param start The pixel with the smallest projection onto the line.
+ * @param end The pixel with the largest projection onto the line.
+ */
+template <int N>
+void fitLine(const uint8_t block[64], float start[N], float end[N])
+{
+    float mean[N]{};
+    float minValue[N], maxValue[N];
+    std::fill_n(minValue, N, 255.0f);
+    std::fill_n(maxValue, N, 0.0f);
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < N; c++)
+        {
+            const auto value = static_cast<float>(block[i * 4 + c]);
+            mean[c] += value;
+            minValue[c] = std::min(minValue[c], value);
+            maxValue[c] = std::max(maxValue[c], value);
+        }
+    }
+    for (int c = 0; c < N; c++)
+        mean[c] /= 16.0f;
+
+    float covariance[N][N]{};
+    for (int i = 0; i < 16; i++)
+    {
+        float offset[N];
+        for (int c = 0; c < N; c++)
+            offset[c] = static_cast<float>(block[i * 4 + c]) - mean[c];
+        for (int a = 0; a < N; a++)
+            for (int b = 0; b < N; b++)
+                covariance[a][b] += offset[a] * offset[b];
+    }
+
+    // Start from the diagonal of the bounding box.
+    float axis[N];
+    for (int c = 0; c < N; c++)
+        axis[c] = maxValue[c] - minValue[c];
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[N]{};
+        float largest = 0.0f;
+        for (int a = 0; a < N; a++)
+        {
+            for (int b = 0; b < N; b++)
+                next[a] += covariance[a][b] * axis[b];
+            largest = std::max(largest, std::abs(next[a]));
+        }
+        if (largest <= std::numeric_limits<float>::epsilon())
+            break;
+        for (int c = 0; c < N; c++)
+            axis[c] = next[c] / largest;
+    }
+
+    float lengthSquared = 0.0f;
+    for (int c = 0; c < N; c++)
+        lengthSquared += axis[c] * axis[c];
+    if (lengthSquared <= std::numeric_limits<float>::epsilon())
+    {
+        std::copy_n(mean, N, start);
+        std::copy_n(mean, N, end);
+        return;
+    }
+
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = std::numeric_limits<float>::lowest();
+    for (int i = 0; i < 16; i++)
+    {
+        float projection = 0.0f;
+        for (int c = 0; c < N; c++)
+            projection +=
+                (static_cast<float>(block[i * 4 + c]) - mean[c]) * axis[c];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+    for (int c = 0; c < N; c++)
+    {
+        start[c] = std::clamp(
+            mean[c] + axis[c] * minProjection / lengthSquared, 0.0f, 255.0f);
+        end[c] = std::clamp(mean[c] + axis[c] * maxProjection / lengthSquared,
+                            0.0f, 255.0f);
+    }
+}
+
+inline uint16_t packRGB565(const float color[3])
+{
+    const auto quantize = [](float value, int maxValue) {
+        return static_cast<uint16_t>(std::lround(
+            std::clamp(value, 0.0f, 255.0f) * static_cast<float>(maxValue) /
+            255.0f));
+    };
+    return static_cast<uint16_t>(quantize(color[0], 31) << 11 |
+                                 quantize(color[1], 63) << 5 |
+                                 quantize(color[2], 31));
+}
+
+inline void unpackRGB565(uint16_t color, int rgb[3])
+{
+    const int r = color >> 11;
+    const int g = (color >> 5) & 63;
+    const int b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+/// Builds the palette of a BC1 color block.
+void getColorPalette(uint16_t color0, uint16_t color1, bool isFourColor,
+                     int palette[4][3])
+{
+    unpackRGB565(color0, palette[0]);
+    unpackRGB565(color1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        if (isFourColor)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+/**
+ * Picks the closest palette entry for every pixel of a BC1 color block in 4
+ * color mode. Swaps the endpoints if they are out of order.
+ * @return The squared error of the block.
+ */
+int selectColorIndices(const uint8_t block[64], uint16_t *color0,
+                       uint16_t *color1, uint32_t *indices)
+{
+    if (*color0 < *color1)
+        std::swap(*color0, *color1);
+
+    int palette[4][3];
+    getColorPalette(*color0, *color1, true, palette);
+    // Equal endpoints select 3 color mode, so only the first entry is valid.
+    const int paletteSize = *color0 == *color1 ? 1 : 4;
+
+    int error = 0;
+    *indices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int bestIndex = 0;
+        int bestDistance = std::numeric_limits<int>::max();
+        for (int p = 0; p < paletteSize; p++)
+        {
+            int distance = 0;
+            for (int c = 0; c < 3; c++)
+            {
+                const int d = block[i * 4 + c] - palette[p][c];
+                distance += d * d;
+            }
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                bestIndex = p;
+            }
+        }
+        *indices |= static_cast<uint32_t>(bestIndex) << (2 * i);
+        error += bestDistance;
+    }
+    return error;
+}
+
+/// Encodes the RGB channels of the block as a BC1 color block (8 bytes).
+void encodeColorBlock(const uint8_t block[64], uint8_t *result)
+{
+    float start[3], end[3];
+    fitLine<3>(block, start, end);
+    uint16_t color0 = packRGB565(end);
+    uint16_t color1 = packRGB565(start);
+    uint32_t indices = 0;
+    int error = selectColorIndices(block, &color0, &color1, &indices);
+
+    // Refit the endpoints to the selected indices with least squares.
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3]{}, bx[3]{};
+    for (int i = 0; i < 16; i++)
+    {
+        const float a = BC1_WEIGHTS[(indices >> (2 * i)) & 3u];
+        const float b = 1.0f - a;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (int c = 0; c < 3; c++)
+        {
+            ax[c] += a * block[i * 4 + c];
+            bx[c] += b * block[i * 4 + c];
+        }
+    }
+    const float determinant = aa * bb - ab * ab;
+    if (error > 0 && std::abs(determinant) > 1e-6f)
+    {
+        float refined0[3], refined1[3];
+        for (int c = 0; c < 3; c++)
+        {
+            refined0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            refined1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+        uint16_t refinedColor0 = packRGB565(refined0);
+        uint16_t refinedColor1 = packRGB565(refined1);
+        uint32_t refinedIndices = 0;
+        const int refinedError = selectColorIndices(
+            block, &refinedColor0, &refinedColor1, &refinedIndices);
+        if (refinedError < error)
+        {
+            color0 = refinedColor0;
+            color1 = refinedColor1;
+            indices = refinedIndices;
+        }
+    }
+
+    std::memset(result, 0, 8);
+    BitWriter stream(result);
+    stream.write(color0, 16);
+    stream.write(color1, 16);
+    stream.write(indices, 32);
+}
+
+/// Builds the palette of a BC4 block.
+void getChannelPalette(int value0, int value1, int palette[8])
+{
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1)
+    {
+        for (int i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+    }
+    else
+    {
+        for (int i = 1; i < 5; i++)
+            palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+/// Encodes a single channel of the block as a BC4 block (8 bytes).
+void encodeChannelBlock(const uint8_t block[64], int channel, uint8_t *result)
+{
+    int minValue = 255, maxValue = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        minValue = std::min(minValue, static_cast<int>(block[i * 4 + channel]));
+        maxValue = std::max(maxValue, static_cast<int>(block[i * 4 + channel]));
+    }
+
+    std::memset(result, 0, 8);
+    BitWriter stream(result);
+    stream.write(static_cast<uint32_t>(maxValue), 8);
+    stream.write(static_cast<uint32_t>(minValue), 8);
+    if (maxValue == minValue)
+        return;
+
+    int palette[8];
+    getChannelPalette(maxValue, minValue, palette);
+    for (int i = 0; i < 16; i++)
+    {
+        const int value = block[i * 4 + channel];
+        int bestIndex = 0;
+        for (int p = 1; p < 8; p++)
+        {
+            if (std::abs(value - palette[p]) <
+                std::abs(value - palette[bestIndex]))
+                bestIndex = p;
+        }
+        stream.write(static_cast<uint32_t>(bestIndex), 3);
+    }
+}
+
+inline int interpolateBC7(int value0, int value1, int weight)
+{
+    return ((64 - weight) * value0 + weight * value1 + 32) >> 6;
+}
+
+/**
+ * Picks the closest of the 16 interpolated colors for every pixel of a BC7
+ * block. The index is estimated by projecting the pixel onto the endpoints
+ * and refined with its neighbours, since the weights aren't uniform.
+ * @return The squared error of the block.
+ */
+int selectBC7Indices(const uint8_t block[64], const int endpoint0[4],
+                     const int endpoint1[4], uint8_t indices[16])
+{
+    int palette[16][4];
+    float direction[4];
+    float lengthSquared = 0.0f;
+    for (int c = 0; c < 4; c++)
+    {
+        for (int w = 0; w < 16; w++)
+            palette[w][c] =
+                interpolateBC7(endpoint0[c], endpoint1[c], BC7_WEIGHTS[w]);
+        direction[c] = static_cast<float>(endpoint1[c] - endpoint0[c]);
+        lengthSquared += direction[c] * direction[c];
+    }
+
+    int error = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        const uint8_t *pixel = block + i * 4;
+        int estimate = 0;
+        if (lengthSquared > 0.0f)
+        {
+            float projection = 0.0f;
+            for (int c = 0; c < 4; c++)
+                projection +=
+                    static_cast<float>(pixel[c] - endpoint0[c]) * direction[c];
+            estimate = std::clamp(
+                static_cast<int>(std::lround(projection / lengthSquared * 15)),
+                0, 15);
+        }
+
+        int bestIndex = estimate;
+        int bestDistance = std::numeric_limits<int>::max();
+        for (int w = std::max(estimate - 1, 0); w <= std::min(estimate + 1, 15);
+             w++)
+        {
+            int distance = 0;
+            for (int c = 0; c < 4; c++)
+            {
+                const int d = pixel[c] - palette[w][c];
+                distance += d * d;
+            }
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                bestIndex = w;
+            }
+        }
+        indices[i] = static_cast<uint8_t>(bestIndex);
+        error += bestDistance;
+    }
+    return error;
+}
+
+/**
+ * Encodes the block as a mode 6 BC7 block (16 bytes): a single subset with
+ * 7-bit RGBA endpoints, a p-bit per endpoint and 4-bit indices. Every
+ * combination of p-bits is tried.
+ */
+void encodeBC7Block(const uint8_t block[64], uint8_t *result)
+{
+    float start[4], end[4];
+    fitLine<4>(block, start, end);
+
+    int bestError = std::numeric_limits<int>::max();
+    int bestEndpoints[2][4]{};
+    uint8_t bestIndices[16]{};
+    for (int pBits = 0; pBits < 4; pBits++)
+    {
+        const int p0 = pBits & 1;
+        const int p1 = pBits >> 1;
+        int endpoint0[4], endpoint1[4];
+        for (int c = 0; c < 4; c++)
+        {
+            const auto quantize = [](float value, int pBit) {
+                return std::clamp(static_cast<int>(std::lround(
+                                      (value - static_cast<float>(pBit)) *
+                                      0.5f)),
+                                  0, 127);
+            };
+            endpoint0[c] = (quantize(start[c], p0) << 1) | p0;
+            endpoint1[c] = (quantize(end[c], p1) << 1) | p1;
+        }
+        uint8_t indices[16];
+        const int error =
+            selectBC7Indices(block, endpoint0, endpoint1, indices);
+        if (error < bestError)
+        {
+            bestError = error;
+            std::copy_n(endpoint0, 4, bestEndpoints[0]);
+            std::copy_n(endpoint1, 4, bestEndpoints[1]);
+            std::copy_n(indices, 16, bestIndices);
+        }
+    }
+
+    // The most significant bit of the first index is implicitly 0.
+    if (bestIndices[0] & 8u)
+    {
+        std::swap(bestEndpoints[0], bestEndpoints[1]);
+        for (auto &index : bestIndices)
+            index = static_cast<uint8_t>(15 - index);
+    }
+
+    std::memset(result, 0, 16);
+    BitWriter stream(result);
+    stream.write(1u << 6, 7);
+    for (int c = 0; c < 4; c++)
+    {
+        stream.write(static_cast<uint32_t>(bestEndpoints[0][c] >> 1), 7);
+        stream.write(static_cast<uint32_t>(bestEndpoints[1][c] >> 1), 7);
+    }
+    stream.write(static_cast<uint32_t>(bestEndpoints[0][0] & 1), 1);
+    stream.write(static_cast<uint32_t>(bestEndpoints[1][0] & 1), 1);
+    stream.write(bestIndices[0], 3);
+    for (int i = 1; i < 16; i++)
+        stream.write(bestIndices[i], 4);
+}
+
+void encodeBlock(const uint8_t block[64], ImageCompression compression,
+                 uint8_t *result)
+{
+    switch (compression)
+    {
+    case ImageCompression::BC1:
+        encodeColorBlock(block, result);
+        break;
+    case ImageCompression::BC3:
+        encodeChannelBlock(block, 3, result);
+        encodeColorBlock(block, result + 8);
+        break;
+    case ImageCompression::BC5:
+        encodeChannelBlock(block, 0, result);
+        encodeChannelBlock(block, 1, result + 8);
+        break;
+    case ImageCompression::BC7:
+        encodeBC7Block(block, result);
+        break;
+    default:
+        break;
+    }
+}
+
+void decodeColorBlock(const uint8_t *block, bool isBC1, uint8_t pixels[64])
+{
+    BitReader stream(block);
+    const auto color0 = static_cast<uint16_t>(stream.read(16));
+    const auto color1 = static_cast<uint16_t>(stream.read(16));
+    // BC3 color blocks always use 4 color mode.
+    int palette[4][3];
+    getColorPalette(color0, color1, !isBC1 || color0 > color1, palette);
+    for (int i = 0; i < 16; i++)
+    {
+        const uint32_t index = stream.read(2);
+        for (int c = 0; c < 3; c++)
+            pixels[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+    }
+}
+
+void decodeChannelBlock(const uint8_t *block, int channel, uint8_t pixels[64])
+{
+    BitReader stream(block);
+    const auto value0 = static_cast<int>(stream.read(8));
+    const auto value1 = static_cast<int>(stream.read(8));
+    int palette[8];
+    getChannelPalette(value0, value1, palette);
+    for (int i = 0; i < 16; i++)
+        pixels[i * 4 + channel] = static_cast<uint8_t>(palette[stream.read(3)]);
+}
+
+bool decodeBC7Block(const uint8_t *block, uint8_t pixels[64])
+{
+    BitReader stream(block);
+    if (stream.read(7) != 1u << 6)
+        return false;
+
+    int endpoints[2][4];
+    for (int c = 0; c < 4; c++)
+    {
+        endpoints[0][c] = static_cast<int>(stream.read(7)) << 1;
+        endpoints[1][c] = static_cast<int>(stream.read(7)) << 1;
+    }
+    const auto p0 = static_cast<int>(stream.read(1));
+    const auto p1 = static_cast<int>(stream.read(1));
+    for (int c = 0; c < 4; c++)
+    {
+        endpoints[0][c] |= p0;
+        endpoints[1][c] |= p1;
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        const int weight = BC7_WEIGHTS[stream.read(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; c++)
+            pixels[i * 4 + c] = static_cast<uint8_t>(
+                interpolateBC7(endpoints[0][c], endpoints[1][c], weight));
+    }
+    return true;
+}
+} // namespace
+
+void kirana::scene::image_compression::setEnabled(bool isEnabled)
+{
+    isCompressionEnabled = isEnabled;
+}
+
+bool kirana::scene::image_compression::isEnabled()
+{
+    return isCompressionEnabled;
+}
+
+kirana::scene::ImageCompression kirana::scene::image_compression::
+    getCompression(const ImageProperties &properties, PixelDataType dataType)
+{
+    if (!constants::IMAGE_COMPRESSION_ENABLED || !isEnabled() ||
+        !properties.enableCompression || dataType != PixelDataType::UNORM8)
+        return ImageCompression::NONE;
+    if (properties.usage == ImageUsage::NORMAL)
+        return ImageCompression::BC5;
+    if (constants::IMAGE_COMPRESSION_PREFER_BC7)
+        return ImageCompression::BC7;
+
+    const auto hasAlpha = [](Channels channels) {
+        return channels == Channels::GRAYSCALE_ALPHA ||
+               channels == Channels::RGBA;
+    };
+    return hasAlpha(properties.channels) && hasAlpha(properties.fileChannels)
+               ? ImageCompression::BC3
+               : ImageCompression::BC1;
+}
+
+size_t kirana::scene::image_compression::getBlockSize(
+    ImageCompression compression)
+{
+    switch (compression)
+    {
+    case ImageCompression::BC1:
+        return 8;
+    case ImageCompression::BC3:
+    case ImageCompression::BC5:
+    case ImageCompression::BC7:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+size_t kirana::scene::image_compression::getCompressedSize(
+    const std::array<int, 2> &size, ImageCompression compression)
+{
+    return static_cast<size_t>((size[0] + 3) / 4) *
+           static_cast<size_t>((size[1] + 3) / 4) * getBlockSize(compression);
+}
+
+void kirana::scene::image_compression::compress(
+    const uint8_t *pixels, const std::array<int, 2> &size, uint32_t channels,
+    ImageCompression compression, uint8_t *result)
+{
+    const int blockCountX = (size[0] + 3) / 4;
+    const int blockCountY = (size[1] + 3) / 4;
+    const size_t blockSize = getBlockSize(compression);
+    utils::ThreadPool::get().parallelFor(
+        static_cast<size_t>(blockCountY), [&](size_t blockY) {
+            uint8_t block[64];
+            for (int blockX = 0; blockX < blockCountX; blockX++)
+            {
+                loadBlock(pixels, size, channels, blockX,
+                          static_cast<int>(blockY), block);
+                encodeBlock(block, compression,
+                            result + (blockY * blockCountX + blockX) *
+                                         blockSize);
+            }
+        });
+}
+
+std::vector<kirana::scene::ImageMipLevel> kirana::scene::image_compression::
+    compressMipChain(const std::vector<uint8_t> &mipChain,
+                     const std::vector<ImageMipLevel> &levels,
+                     uint32_t channels, ImageCompression compression,
+                     std::vector<uint8_t> *compressedChain)
+{
+    std::vector<ImageMipLevel> compressedLevels(levels.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        compressedLevels[i].size = levels[i].size;
+        compressedLevels[i].offset = offset;
+        compressedLevels[i].dataSize =
+            getCompressedSize(levels[i].size, compression);
+        offset += compressedLevels[i].dataSize;
+    }
+
+    compressedChain->resize(offset);
+    for (size_t i = 0; i < levels.size(); i++)
+        compress(mipChain.data() + levels[i].offset, levels[i].size, channels,
+                 compression, compressedChain->data() +
+                                  compressedLevels[i].offset);
+    return compressedLevels;
+}
+
+bool kirana::scene::image_compression::decompressBlock(
+    const uint8_t *block, ImageCompression compression, uint8_t pixels[64])
+{
+    for (int i = 0; i < 16; i++)
+    {
+        std::fill_n(pixels + i * 4, 3, 0);
+        pixels[i * 4 + 3] = 255;
+    }
+    switch (compression)
+    {
+    case ImageCompression::BC1:
+        decodeColorBlock(block, true, pixels);
+        return true;
+    case ImageCompression::BC3:
+        decodeChannelBlock(block, 3, pixels);
+        decodeColorBlock(block + 8, false, pixels);
+        return true;
+    case ImageCompression::BC5:
+        decodeChannelBlock(block, 0, pixels);
+        decodeChannelBlock(block + 8, 1, pixels);
+        return true;
+    case ImageCompression::BC7:
+        return decodeBC7Block(block, pixels);
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef KIRANA_SCENE_IMAGE_COMPRESSION_HPP
+#define KIRANA_SCENE_IMAGE_COMPRESSION_HPP
+
+#include "image_types.hpp"
+
+#include <cstdint>
+
+/**
+ * Block compresses 8-bit pixel data on the CPU, so that textures take a
+ * fraction of the GPU memory. Compression is slow compared to decoding, which
+ * is why compressed mip chains are stored in the image cache.
+ */
+namespace kirana::scene::image_compression
+{
+/**
+ * Enables or disables block compression at runtime, such as when the GPU
+ * can't sample block compressed textures. Images loaded while it's disabled
+ * keep their uncompressed mip chain. Enabled by default.
+ */
+void setEnabled(bool isEnabled);
+[[nodiscard]] bool isEnabled();
+
+/**
+ * Picks the block compression format for an image, if compression is
+ * enabled. Normal maps are compressed to BC5. Color is compressed to BC7, or
+ * to BC1 and BC3 (with alpha) if constants::IMAGE_COMPRESSION_PREFER_BC7 is
+ * disabled.
+ * @param properties The properties of the image.
+ * @param dataType The type of the decoded pixel data. Only UNORM8 images can
+ * be compressed.
+ * @return The block compression format, NONE if the image isn't compressed.
+ */
+ImageCompression getCompression(const ImageProperties &properties,
+                                PixelDataType dataType);
+
+/**
+ * @return The size of a 4x4 block in bytes, 0 if not compressed.
+ */
+size_t getBlockSize(ImageCompression compression);
+
+/**
+ * @return The size of the compressed image in bytes. Partial blocks at the
+ * edges take the size of a full block.
+ */
+size_t getCompressedSize(const std::array<int, 2> &size,
+                         ImageCompression compression);
+
+/**
+ * Compresses an image. Partial blocks at the edges are padded by repeating the
+ * last row and column.
+ * @param pixels The UNORM8 pixel data of the image.
+ * @param size The size of the image.
+ * @param channels The number of channels per pixel. Grayscale is expanded to
+ * RGB, missing alpha is opaque.
+ * @param compression The block compression format.
+ * @param result The compressed blocks in row-major order. Must be
+ * getCompressedSize() bytes.
+ */
+void compress(const uint8_t *pixels, const std::array<int, 2> &size,
+              uint32_t channels, ImageCompression compression,
+              uint8_t *result);
+
+/**
+ * Compresses every level of a mip chain generated by
+ * image_processing::generateMipChain().
+ * @param mipChain The UNORM8 pixel data of all the levels.
+ * @param levels The levels within mipChain.
+ * @param channels The number of channels per pixel.
+ * @param compression The block compression format.
+ * @param compressedChain The compressed blocks of all the levels.
+ * @return The levels within compressedChain.
+ */
+std::vector<ImageMipLevel> compressMipChain(
+    const std::vector<uint8_t> &mipChain,
+    const std::vector<ImageMipLevel> &levels, uint32_t channels,
+    ImageCompression compression, std::vector<uint8_t> *compressedChain);
+
+/**
+ * Decompresses a single block to RGBA. Channels missing from the format are
+ * 0, alpha is 255. Only mode 6 BC7 blocks, which is all compress() writes,
+ * are supported.
+ * @param block The compressed block.
+ * @param compression The block compression format.
+ * @param pixels The 4x4 RGBA pixels of the block in row-major order.
+ * @return false if the block can't be decompressed.
+ */
+bool decompressBlock(const uint8_t *block, ImageCompression compression,
+                     uint8_t pixels[64]);
+} // namespace kirana::scene::image_compression
+
+#endif // KIRANA_SCENE_IMAGE_COMPRESSION_HPP
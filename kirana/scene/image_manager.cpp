@@ -1,8 +1,18 @@
 #include "image_manager.hpp"
 
+#include <constants.h>
 #include <file_system.hpp>
+#include <thread_pool.hpp>
 #include <assimp/texture.h>
 
+#include <condition_variable>
+#include <future>
+
+
+kirana::scene::ImageManager::ImageManager()
+{
+    m_statistics.memoryBudget = utils::constants::IMAGE_MEMORY_BUDGET;
+}
 
 int kirana::scene::ImageManager::addImage(const std::string &filepath,
                                           const std::string &name,
@@ -12,6 +22,7 @@ int kirana::scene::ImageManager::addImage(const std::string &filepath,
     if (!kirana::utils::filesystem::fileExists(filepath))
         return -1;
 
+    std::lock_guard<std::mutex> lock(m_mutex);
     if (m_imageIndexTable.find(filepath) != m_imageIndexTable.end())
         return static_cast<int>(m_imageIndexTable.at(filepath));
 
@@ -20,4 +31,153 @@ int kirana::scene::ImageManager::addImage(const std::string &filepath,
         std::make_unique<Image>(filepath, name, imgIndex, properties)));
     m_imageIndexTable[filepath] = imgIndex;
     return static_cast<int>(imgIndex);
-}
\ No newline at end of file
+}
+
+void kirana::scene::ImageManager::loadImages(
+    const std::vector<Image *> &images,
+    const std::function<void(Image *)> &onImageLoaded)
+{
+    std::mutex loadedMutex;
+    std::condition_variable loadedCondition;
+    std::vector<Image *> loadedImages;
+
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(images.size());
+    for (Image *image : images)
+    {
+        tasks.emplace_back(utils::ThreadPool::get().submit([&, image]() {
+            loadImageInternal(image, true);
+            {
+                std::lock_guard<std::mutex> lock(loadedMutex);
+                loadedImages.push_back(image);
+            }
+            loadedCondition.notify_one();
+        }));
+    }
+
+    // Hand over the decoded images in batches, while the rest are decoding.
+    std::vector<Image *> batch;
+    size_t handedCount = 0;
+    while (handedCount < images.size())
+    {
+        {
+            std::unique_lock<std::mutex> lock(loadedMutex);
+            loadedCondition.wait(
+                lock, [&loadedImages]() { return !loadedImages.empty(); });
+            batch.swap(loadedImages);
+        }
+        for (Image *image : batch)
+        {
+            onImageLoaded(image);
+            unpinImage(image);
+        }
+        handedCount += batch.size();
+        batch.clear();
+    }
+    for (auto &t : tasks)
+        t.wait();
+}
+
+bool kirana::scene::ImageManager::loadImage(Image *image)
+{
+    return loadImageInternal(image, false);
+}
+
+bool kirana::scene::ImageManager::loadImageInternal(Image *image, bool pin)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_loadedImages.find(image);
+        // Images freed directly are loaded again.
+        if (it != m_loadedImages.end() && !image->isLoaded())
+        {
+            freeImageInternal(image);
+            it = m_loadedImages.end();
+        }
+        if (it != m_loadedImages.end())
+        {
+            m_statistics.hits++;
+            m_lruImages.splice(m_lruImages.begin(), m_lruImages,
+                               it->second.lruPosition);
+            if (pin)
+                it->second.pinCount++;
+            return true;
+        }
+        // Images loaded directly are only added to the budget.
+        if (!image->isLoaded())
+            m_statistics.misses++;
+    }
+
+    // Decode outside the lock, so that other images can load concurrently.
+    if (!image->isLoaded() && image->load() == nullptr)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_loadedImages.find(image) != m_loadedImages.end())
+    {
+        // Added by another thread in the meantime.
+        m_loadedImages.at(image).pinCount += pin ? 1 : 0;
+        return true;
+    }
+    m_lruImages.push_front(image);
+    LoadedImage &loadedImage = m_loadedImages[image];
+    loadedImage.lruPosition = m_lruImages.begin();
+    loadedImage.memorySize = image->getPixelDataSize();
+    loadedImage.pinCount = pin ? 1 : 0;
+    m_statistics.usedMemory += loadedImage.memorySize;
+    evictImages(image);
+    return true;
+}
+
+void kirana::scene::ImageManager::unpinImage(Image *image)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_loadedImages.find(image);
+    if (it != m_loadedImages.end() && it->second.pinCount > 0)
+        it->second.pinCount--;
+    evictImages();
+}
+
+void kirana::scene::ImageManager::freeImage(Image *image)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    freeImageInternal(image);
+}
+
+void kirana::scene::ImageManager::setMemoryBudget(size_t memoryBudget)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.memoryBudget = memoryBudget;
+    evictImages();
+}
+
+void kirana::scene::ImageManager::evictImages(const Image *keepImage)
+{
+    // Walk from the least recently used image to the most recently used one.
+    auto it = m_lruImages.end();
+    while (m_statistics.usedMemory > m_statistics.memoryBudget &&
+           it != m_lruImages.begin())
+    {
+        --it;
+        Image *image = *it;
+        if (image == keepImage || m_loadedImages.at(image).pinCount > 0)
+            continue;
+        // Step back past the image, so that erasing it doesn't invalidate the
+        // iterator.
+        ++it;
+        freeImageInternal(image);
+        m_statistics.evictions++;
+    }
+}
+
+void kirana::scene::ImageManager::freeImageInternal(Image *image)
+{
+    const auto it = m_loadedImages.find(image);
+    if (it != m_loadedImages.end())
+    {
+        m_statistics.usedMemory -= it->second.memorySize;
+        m_lruImages.erase(it->second.lruPosition);
+        m_loadedImages.erase(it);
+    }
+    image->free();
+}
@@ -3,13 +3,36 @@
 
 #include "image.hpp"
 
+#include <functional>
+#include <list>
+#include <mutex>
+
 struct aiTexture;
 
 namespace kirana::scene
 {
+/**
+ * Owns every image of the session. The decoded pixel data of the images is
+ * kept within a memory budget: when loading an image exceeds the budget, the
+ * least recently used images are freed. Freed images are loaded again the next
+ * time they are requested.
+ */
 class ImageManager
 {
   public:
+    struct MemoryStatistics
+    {
+        /// Requests for images which were already loaded.
+        uint64_t hits = 0;
+        /// Requests for images which had to be loaded.
+        uint64_t misses = 0;
+        /// Images freed to stay within the budget.
+        uint64_t evictions = 0;
+        /// Size of the pixel data of all the loaded images in bytes.
+        size_t usedMemory = 0;
+        size_t memoryBudget = 0;
+    };
+
     ImageManager(const ImageManager &textureManager) = delete;
 
     static ImageManager &get()
@@ -20,40 +43,116 @@ class ImageManager
 
     [[nodiscard]] inline Image *getImage(uint32_t index)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         return index < m_images.size() ? m_images[index].get() : nullptr;
     }
 
     [[nodiscard]] inline Image *getImage(const std::string &path)
     {
-        return m_imageIndexTable.find(path) != m_imageIndexTable.end()
-                   ? getImage(m_imageIndexTable.at(path))
-                   : nullptr;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_imageIndexTable.find(path);
+        return it != m_imageIndexTable.end() ? m_images[it->second].get()
+                                             : nullptr;
     }
 
+    /// Registers the image at the given path. Can be called from multiple
+    /// threads.
     int addImage(const std::string &filepath, const std::string &name = "", const ImageProperties &properties = {});
 
+    /**
+     * Loads the image if it isn't loaded and marks it as the most recently
+     * used image. Frees the least recently used images if the budget is
+     * exceeded. The pixel data of the image stays valid until the image is
+     * freed or evicted by a later call. Different images can be loaded
+     * concurrently.
+     * @param image The image to load.
+     * @return true if the image is loaded.
+     */
+    bool loadImage(Image *image);
+
+    /// Frees the pixel data of the image. It's loaded again when requested.
+    void freeImage(Image *image);
+
+    /**
+     * Sets the maximum size of the pixel data of all the loaded images.
+     * Frees the least recently used images if the new budget is exceeded.
+     * @param memoryBudget The budget in bytes.
+     */
+    void setMemoryBudget(size_t memoryBudget);
+
+    [[nodiscard]] MemoryStatistics getMemoryStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    /**
+     * Decodes the given images concurrently on the thread pool. Each image is
+     * handed to the callback on the calling thread as soon as it's decoded, so
+     * it can be uploaded while the remaining images are still being decoded.
+     * Images which are already loaded aren't decoded again. Images aren't
+     * evicted until the callback has returned.
+     * @param images The images to decode. Each image must only be listed once.
+     * @param onImageLoaded Called with every image in the order they finish
+     * decoding. The image isn't loaded if its file couldn't be decoded.
+     */
+    void loadImages(const std::vector<Image *> &images,
+                    const std::function<void(Image *)> &onImageLoaded);
+
     void removeImage(uint32_t index)
     {
-        if (index < m_images.size())
-        {
-            const std::string &name = m_images[index]->getName();
-            m_imageIndexTable.erase(name);
-            m_images.erase(m_images.begin() + index);
-        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        removeImageInternal(index);
     }
 
     inline void removeImage(const std::string &path)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         if (m_imageIndexTable.find(path) != m_imageIndexTable.end())
-            removeImage(m_imageIndexTable.at(path));
+            removeImageInternal(m_imageIndexTable.at(path));
     }
 
   private:
-    ImageManager() = default;
+    /// A loaded image in the least recently used list.
+    struct LoadedImage
+    {
+        std::list<Image *>::iterator lruPosition;
+        size_t memorySize = 0;
+        /// The image can't be evicted while it's pinned.
+        uint32_t pinCount = 0;
+    };
+
+    ImageManager();
     ~ImageManager() = default;
 
+    std::mutex m_mutex;
     std::unordered_map<std::string, uint32_t> m_imageIndexTable;
     std::vector<std::unique_ptr<Image>> m_images;
+
+    /// Loaded images, most recently used first.
+    std::list<Image *> m_lruImages;
+    std::unordered_map<const Image *, LoadedImage> m_loadedImages;
+    MemoryStatistics m_statistics;
+
+    bool loadImageInternal(Image *image, bool pin);
+    void unpinImage(Image *image);
+    /// Frees the least recently used images, except for the given one, until
+    /// the used memory is within the budget. Must be called with the mutex
+    /// locked.
+    void evictImages(const Image *keepImage = nullptr);
+    /// Must be called with the mutex locked.
+    void freeImageInternal(Image *image);
+
+    void removeImageInternal(uint32_t index)
+    {
+        if (index < m_images.size())
+        {
+            freeImageInternal(m_images[index].get());
+            const std::string &name = m_images[index]->getName();
+            m_imageIndexTable.erase(name);
+            m_images.erase(m_images.begin() + index);
+        }
+    }
 };
 } // namespace kirana::scene
 
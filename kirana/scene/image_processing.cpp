@@ -0,0 +1,559 @@
+#include "image_processing.hpp"
+
+#include <math_utils.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define KIRANA_IMAGE_PROCESSING_SSE2
+#include <emmintrin.h>
+#endif
+// F16C is only used if the CPU supports it, so it's compiled in with a
+// function target instead of a compiler flag.
+#if defined(KIRANA_IMAGE_PROCESSING_SSE2) &&                                   \
+    (defined(__GNUC__) || defined(_MSC_VER))
+#define KIRANA_IMAGE_PROCESSING_F16C
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define KIRANA_TARGET_F16C
+#else
+#include <cpuid.h>
+#define KIRANA_TARGET_F16C __attribute__((target("f16c")))
+#endif
+#endif
+
+namespace
+{
+// Linear values are quantized to this many steps before they are encoded to
+// sRGB through a table. Fine enough to be exact within 1 step of 8 bits.
+constexpr int SRGB_ENCODE_TABLE_SIZE = 4096;
+
+inline float srgbToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f
+                             : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+inline float linearToSRGB(float value)
+{
+    return value <= 0.0031308f
+               ? value * 12.92f
+               : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+struct SRGBTables
+{
+    float toLinear[256];
+    uint8_t fromLinear[SRGB_ENCODE_TABLE_SIZE];
+
+    SRGBTables()
+    {
+        for (int i = 0; i < 256; i++)
+            toLinear[i] = srgbToLinear(static_cast<float>(i) / 255.0f);
+        for (int i = 0; i < SRGB_ENCODE_TABLE_SIZE; i++)
+        {
+            const float linear = static_cast<float>(i) /
+                                 static_cast<float>(SRGB_ENCODE_TABLE_SIZE - 1);
+            fromLinear[i] = static_cast<uint8_t>(
+                std::lround(linearToSRGB(linear) * 255.0f));
+        }
+    }
+
+    [[nodiscard]] inline uint8_t encode(float linear) const
+    {
+        const float clamped = std::min(std::max(linear, 0.0f), 1.0f);
+        return fromLinear[static_cast<int>(
+            clamped * static_cast<float>(SRGB_ENCODE_TABLE_SIZE - 1) + 0.5f)];
+    }
+};
+
+const SRGBTables &getSRGBTables()
+{
+    static const SRGBTables tables;
+    return tables;
+}
+
+/// The number of leading channels which hold color. The last channel of 2 and
+/// 4 channel images is alpha.
+inline uint32_t getColorChannelCount(uint32_t channels)
+{
+    return channels == 2 || channels == 4 ? channels - 1 : channels;
+}
+
+#ifdef KIRANA_IMAGE_PROCESSING_SSE2
+/**
+ * Downsamples a row of RGBA8 pixels, two destination pixels at a time.
+ * @return The number of destination pixels written.
+ */
+int downsampleRowRGBA8(const uint8_t *row0, const uint8_t *row1, int srcWidth,
+                       int dstWidth, uint8_t *dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; x + 1 < dstWidth && 2 * x + 3 < srcWidth; x += 2)
+    {
+        const __m128i a =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8));
+        const __m128i b =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8));
+        // Sums of the vertically neighbouring pixels 0, 1 and 2, 3.
+        const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                          _mm_unpacklo_epi8(b, zero));
+        const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                           _mm_unpackhi_epi8(b, zero));
+        const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high),
+                                          _mm_unpackhi_epi64(low, high));
+        const __m128i average = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x * 4),
+                         _mm_packus_epi16(average, average));
+    }
+    return x;
+}
+
+/**
+ * Downsamples a row of sRGB RGBA8 pixels. The color is averaged in linear
+ * space and encoded back to sRGB through the table.
+ * @return The number of destination pixels written.
+ */
+int downsampleRowSRGBA8(const uint8_t *row0, const uint8_t *row1,
+                        int srcWidth, int dstWidth, uint8_t *dst)
+{
+    const SRGBTables &tables = getSRGBTables();
+    const auto load = [&tables](const uint8_t *pixel) {
+        return _mm_setr_ps(tables.toLinear[pixel[0]], tables.toLinear[pixel[1]],
+                           tables.toLinear[pixel[2]], 0.0f);
+    };
+    // Color is scaled to the table size.
+    const float tableMax = static_cast<float>(SRGB_ENCODE_TABLE_SIZE - 1);
+    const __m128 scale = _mm_set1_ps(0.25f * tableMax);
+    const __m128 maxValue = _mm_set1_ps(tableMax);
+    const __m128 zero = _mm_setzero_ps();
+
+    alignas(16) int32_t values[4];
+    int x = 0;
+    for (; x < dstWidth && 2 * x + 1 < srcWidth; x++)
+    {
+        const uint8_t *a = row0 + x * 8;
+        const uint8_t *b = row1 + x * 8;
+        const __m128 sum = _mm_add_ps(_mm_add_ps(load(a), load(a + 4)),
+                                      _mm_add_ps(load(b), load(b + 4)));
+        const __m128 scaled =
+            _mm_max_ps(_mm_min_ps(_mm_mul_ps(sum, scale), maxValue), zero);
+        _mm_store_si128(reinterpret_cast<__m128i *>(values),
+                        _mm_cvtps_epi32(scaled));
+        dst[x * 4] = tables.fromLinear[values[0]];
+        dst[x * 4 + 1] = tables.fromLinear[values[1]];
+        dst[x * 4 + 2] = tables.fromLinear[values[2]];
+        // Alpha is averaged in integers, rounding half up like the other
+        // paths.
+        dst[x * 4 + 3] =
+            static_cast<uint8_t>((a[3] + a[7] + b[3] + b[7] + 2) >> 2);
+    }
+    return x;
+}
+
+/**
+ * Downsamples a row of RGBA32F pixels.
+ * @return The number of destination pixels written.
+ */
+int downsampleRowRGBA32F(const float *row0, const float *row1, int srcWidth,
+                         int dstWidth, float *dst)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    int x = 0;
+    for (; x < dstWidth && 2 * x + 1 < srcWidth; x++)
+    {
+        const float *a = row0 + x * 8;
+        const float *b = row1 + x * 8;
+        const __m128 sum =
+            _mm_add_ps(_mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(a + 4)),
+                       _mm_add_ps(_mm_loadu_ps(b), _mm_loadu_ps(b + 4)));
+        _mm_storeu_ps(dst + x * 4, _mm_mul_ps(sum, quarter));
+    }
+    return x;
+}
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/// Converts 4 floats to half floats, returned in the lower 64 bits.
+inline __m128i convertToHalf4(__m128 values)
+{
+    // Same as math::floatToHalf(), with every case computed and selected by
+    // masks.
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i denormalMagic = _mm_set1_epi32(126 << 23);
+
+    __m128i bits = _mm_castps_si128(values);
+    const __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(INT32_MIN));
+    bits = _mm_xor_si128(bits, sign);
+
+    const __m128i denormal = _mm_sub_epi32(
+        _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits),
+                                    _mm_castsi128_ps(denormalMagic))),
+        denormalMagic);
+    const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), one);
+    const __m128i normal = _mm_srli_epi32(
+        _mm_add_epi32(
+            _mm_add_epi32(bits, _mm_set1_epi32(-(112 << 23) + 0xfff)),
+            mantissaOdd),
+        13);
+    const __m128i isNaN = _mm_cmpgt_epi32(bits, _mm_set1_epi32(255 << 23));
+    const __m128i special =
+        _mm_or_si128(_mm_set1_epi32(0x7c00),
+                     _mm_and_si128(isNaN, _mm_set1_epi32(0x0200)));
+
+    __m128i result = select(_mm_cmplt_epi32(bits, _mm_set1_epi32(113 << 23)),
+                            denormal, normal);
+    result = select(_mm_cmpgt_epi32(bits, _mm_set1_epi32((143 << 23) - 1)),
+                    special, result);
+    result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+    // Sign extend, so that the signed saturation of the pack keeps the bits.
+    result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+    return _mm_packs_epi32(result, result);
+}
+
+/**
+ * Converts the values to half floats 4 at a time, expanding RGB pixels to
+ * RGBA. The rest are left to math::floatToHalf().
+ * @return The number of values converted if the channels match, otherwise
+ * the number of pixels converted.
+ */
+size_t convertToHalfSSE2(const float *pixels, size_t pixelCount,
+                         uint32_t channels, uint32_t resultChannels,
+                         uint16_t *result)
+{
+    size_t i = 0;
+    if (channels == resultChannels)
+    {
+        const size_t count = pixelCount * channels;
+        for (; i + 4 <= count; i += 4)
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(result + i),
+                             convertToHalf4(_mm_loadu_ps(pixels + i)));
+    }
+    else if (channels == 3 && resultChannels == 4)
+    {
+        // Loads 4 floats per pixel, so the last pixel is left.
+        const __m128 colorMask =
+            _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 alpha = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+        for (; i + 1 < pixelCount; i++)
+        {
+            const __m128 pixel = _mm_or_ps(
+                _mm_and_ps(_mm_loadu_ps(pixels + i * 3), colorMask), alpha);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(result + i * 4),
+                             convertToHalf4(pixel));
+        }
+    }
+    return i;
+}
+#endif
+
+#ifdef KIRANA_IMAGE_PROCESSING_F16C
+/// @return true if the CPU and the OS support the F16C instructions, which
+/// use the AVX registers.
+bool isF16CSupported()
+{
+    static const bool isSupported = []() {
+        constexpr uint32_t F16C_BIT = 1u << 29;
+        constexpr uint32_t OSXSAVE_BIT = 1u << 27;
+        uint32_t ecx = 0;
+#ifdef _MSC_VER
+        int registers[4];
+        __cpuid(registers, 1);
+        ecx = static_cast<uint32_t>(registers[2]);
+#else
+        uint32_t eax, ebx, edx;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+            return false;
+#endif
+        if ((ecx & F16C_BIT) == 0 || (ecx & OSXSAVE_BIT) == 0)
+            return false;
+        // The OS has to save the SSE and AVX state.
+#ifdef _MSC_VER
+        const uint64_t xcr0 = _xgetbv(0);
+#else
+        uint32_t xcr0Low, xcr0High;
+        __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+        const uint64_t xcr0 = xcr0Low;
+#endif
+        return (xcr0 & 6) == 6;
+    }();
+    return isSupported;
+}
+
+/// Converts 4 floats to half floats with F16C, returned in the lower 64 bits.
+KIRANA_TARGET_F16C inline __m128i convertToHalf4F16C(__m128 values)
+{
+    // F16C keeps the payload of NaNs, so they're replaced by a quiet NaN of
+    // the same sign to match math::floatToHalf().
+    const __m128 isNaN = _mm_cmpunord_ps(values, values);
+    const __m128 payload = _mm_castsi128_ps(_mm_set1_epi32(0x003fffff));
+    const __m128 quietBit = _mm_castsi128_ps(_mm_set1_epi32(0x00400000));
+    values = _mm_or_ps(_mm_andnot_ps(_mm_and_ps(isNaN, payload), values),
+                       _mm_and_ps(isNaN, quietBit));
+    return _mm_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+}
+
+/// Same as convertToHalfSSE2(), with the F16C conversion.
+KIRANA_TARGET_F16C size_t convertToHalfF16C(const float *pixels,
+                                            size_t pixelCount,
+                                            uint32_t channels,
+                                            uint32_t resultChannels,
+                                            uint16_t *result)
+{
+    size_t i = 0;
+    if (channels == resultChannels)
+    {
+        const size_t count = pixelCount * channels;
+        for (; i + 4 <= count; i += 4)
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(result + i),
+                             convertToHalf4F16C(_mm_loadu_ps(pixels + i)));
+    }
+    else if (channels == 3 && resultChannels == 4)
+    {
+        const __m128 colorMask =
+            _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 alpha = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+        for (; i + 1 < pixelCount; i++)
+        {
+            const __m128 pixel = _mm_or_ps(
+                _mm_and_ps(_mm_loadu_ps(pixels + i * 3), colorMask), alpha);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(result + i * 4),
+                             convertToHalf4F16C(pixel));
+        }
+    }
+    return i;
+}
+#endif
+
+void downsampleUNORM8(const uint8_t *src, int width, int height,
+                      uint32_t channels, bool isSRGB, uint8_t *dst)
+{
+    const SRGBTables &tables = getSRGBTables();
+    const uint32_t colorChannels = isSRGB ? getColorChannelCount(channels) : 0;
+    const int dstWidth = std::max(width / 2, 1);
+    const int dstHeight = std::max(height / 2, 1);
+    const size_t rowSize = static_cast<size_t>(width) * channels;
+
+    for (int y = 0; y < dstHeight; y++)
+    {
+        const uint8_t *row0 = src + std::min(2 * y, height - 1) * rowSize;
+        const uint8_t *row1 = src + std::min(2 * y + 1, height - 1) * rowSize;
+        uint8_t *dstRow = dst + static_cast<size_t>(y) * dstWidth * channels;
+
+        int x = 0;
+#ifdef KIRANA_IMAGE_PROCESSING_SSE2
+        if (channels == 4)
+            x = isSRGB ? downsampleRowSRGBA8(row0, row1, width, dstWidth,
+                                             dstRow)
+                       : downsampleRowRGBA8(row0, row1, width, dstWidth,
+                                            dstRow);
+#endif
+        // Odd sizes clamp to the last column.
+        for (; x < dstWidth; x++)
+        {
+            const size_t x0 =
+                static_cast<size_t>(std::min(2 * x, width - 1)) * channels;
+            const size_t x1 =
+                static_cast<size_t>(std::min(2 * x + 1, width - 1)) * channels;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                if (c < colorChannels)
+                {
+                    const float sum = tables.toLinear[row0[x0 + c]] +
+                                      tables.toLinear[row0[x1 + c]] +
+                                      tables.toLinear[row1[x0 + c]] +
+                                      tables.toLinear[row1[x1 + c]];
+                    dstRow[x * channels + c] = tables.encode(sum * 0.25f);
+                }
+                else
+                {
+                    dstRow[x * channels + c] = static_cast<uint8_t>(
+                        (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] +
+                         row1[x1 + c] + 2) >>
+                        2);
+                }
+            }
+        }
+    }
+}
+
+void downsampleFLOAT32(const float *src, int width, int height,
+                       uint32_t channels, float *dst)
+{
+    const int dstWidth = std::max(width / 2, 1);
+    const int dstHeight = std::max(height / 2, 1);
+    const size_t rowSize = static_cast<size_t>(width) * channels;
+
+    for (int y = 0; y < dstHeight; y++)
+    {
+        const float *row0 = src + std::min(2 * y, height - 1) * rowSize;
+        const float *row1 = src + std::min(2 * y + 1, height - 1) * rowSize;
+        float *dstRow = dst + static_cast<size_t>(y) * dstWidth * channels;
+
+        int x = 0;
+#ifdef KIRANA_IMAGE_PROCESSING_SSE2
+        if (channels == 4)
+            x = downsampleRowRGBA32F(row0, row1, width, dstWidth, dstRow);
+#endif
+        for (; x < dstWidth; x++)
+        {
+            const size_t x0 =
+                static_cast<size_t>(std::min(2 * x, width - 1)) * channels;
+            const size_t x1 =
+                static_cast<size_t>(std::min(2 * x + 1, width - 1)) * channels;
+            for (uint32_t c = 0; c < channels; c++)
+                dstRow[x * channels + c] = (row0[x0 + c] + row0[x1 + c] +
+                                            row1[x0 + c] + row1[x1 + c]) *
+                                           0.25f;
+        }
+    }
+}
+} // namespace
+
+size_t kirana::scene::image_processing::getPixelSize(uint32_t channels,
+                                                     PixelDataType dataType)
+{
+    switch (dataType)
+    {
+    case PixelDataType::FLOAT32:
+        return channels * sizeof(float);
+    case PixelDataType::FLOAT16:
+        return channels * sizeof(uint16_t);
+    case PixelDataType::UNORM8:
+    default:
+        return channels * sizeof(uint8_t);
+    }
+}
+
+void kirana::scene::image_processing::convertToHalf(const float *pixels,
+                                                    size_t pixelCount,
+                                                    uint32_t channels,
+                                                    uint32_t resultChannels,
+                                                    uint16_t *result)
+{
+#if defined(KIRANA_IMAGE_PROCESSING_F16C)
+    size_t i = isF16CSupported() ? convertToHalfF16C(pixels, pixelCount,
+                                                     channels, resultChannels,
+                                                     result)
+                                 : convertToHalfSSE2(pixels, pixelCount,
+                                                     channels, resultChannels,
+                                                     result);
+#elif defined(KIRANA_IMAGE_PROCESSING_SSE2)
+    size_t i = convertToHalfSSE2(pixels, pixelCount, channels, resultChannels,
+                                 result);
+#else
+    size_t i = 0;
+#endif
+    if (channels == resultChannels)
+    {
+        for (; i < pixelCount * channels; i++)
+            result[i] = math::floatToHalf(pixels[i]);
+        return;
+    }
+
+    const bool hasAlpha = resultChannels == 2 || resultChannels == 4;
+    for (; i < pixelCount; i++)
+    {
+        for (uint32_t c = 0; c < resultChannels; c++)
+        {
+            float value = hasAlpha && c == resultChannels - 1 ? 1.0f : 0.0f;
+            if (c < channels)
+                value = pixels[i * channels + c];
+            result[i * resultChannels + c] = math::floatToHalf(value);
+        }
+    }
+}
+
+std::vector<kirana::scene::ImageMipLevel> kirana::scene::image_processing::
+    convertMipChainToHalf(const std::vector<uint8_t> &mipChain,
+                          const std::vector<ImageMipLevel> &levels,
+                          uint32_t channels, uint32_t resultChannels,
+                          std::vector<uint8_t> *halfChain)
+{
+    const size_t pixelSize = getPixelSize(channels, PixelDataType::FLOAT32);
+    const size_t halfPixelSize =
+        getPixelSize(resultChannels, PixelDataType::FLOAT16);
+
+    std::vector<ImageMipLevel> halfLevels(levels);
+    for (auto &l : halfLevels)
+    {
+        l.offset = l.offset / pixelSize * halfPixelSize;
+        l.dataSize = l.dataSize / pixelSize * halfPixelSize;
+    }
+
+    // The levels are tightly packed, so the chain is converted in one go.
+    const size_t pixelCount = mipChain.size() / pixelSize;
+    halfChain->resize(pixelCount * halfPixelSize);
+    convertToHalf(reinterpret_cast<const float *>(mipChain.data()), pixelCount,
+                  channels, resultChannels,
+                  reinterpret_cast<uint16_t *>(halfChain->data()));
+    return halfLevels;
+}
+
+uint32_t kirana::scene::image_processing::getMipLevelCount(
+    const std::array<int, 2> &size)
+{
+    uint32_t levelCount = 1;
+    int maxSize = std::max(size[0], size[1]);
+    while (maxSize > 1)
+    {
+        maxSize /= 2;
+        levelCount++;
+    }
+    return levelCount;
+}
+
+void kirana::scene::image_processing::downsample(
+    const void *pixels, const std::array<int, 2> &size, uint32_t channels,
+    PixelDataType dataType, ColorSpace colorSpace, void *result)
+{
+    if (dataType == PixelDataType::FLOAT32)
+        downsampleFLOAT32(reinterpret_cast<const float *>(pixels), size[0],
+                          size[1], channels, reinterpret_cast<float *>(result));
+    else
+        downsampleUNORM8(reinterpret_cast<const uint8_t *>(pixels), size[0],
+                         size[1], channels, colorSpace == ColorSpace::sRGB,
+                         reinterpret_cast<uint8_t *>(result));
+}
+
+std::vector<kirana::scene::ImageMipLevel> kirana::scene::image_processing::
+    generateMipChain(const void *pixels, const std::array<int, 2> &size,
+                     uint32_t channels, PixelDataType dataType,
+                     ColorSpace colorSpace, uint32_t levelCount,
+                     std::vector<uint8_t> *mipChain)
+{
+    const uint32_t maxLevelCount = getMipLevelCount(size);
+    levelCount =
+        levelCount == 0 ? maxLevelCount : std::min(levelCount, maxLevelCount);
+    const size_t pixelSize = getPixelSize(channels, dataType);
+
+    std::vector<ImageMipLevel> levels(levelCount);
+    std::array<int, 2> levelSize = size;
+    size_t offset = 0;
+    for (auto &l : levels)
+    {
+        l.size = levelSize;
+        l.offset = offset;
+        l.dataSize =
+            static_cast<size_t>(levelSize[0]) * levelSize[1] * pixelSize;
+        offset += l.dataSize;
+        levelSize = {std::max(levelSize[0] / 2, 1),
+                     std::max(levelSize[1] / 2, 1)};
+    }
+
+    mipChain->resize(offset);
+    std::memcpy(mipChain->data(), pixels, levels[0].dataSize);
+    for (size_t i = 1; i < levels.size(); i++)
+        downsample(mipChain->data() + levels[i - 1].offset, levels[i - 1].size,
+                   channels, dataType, colorSpace,
+                   mipChain->data() + levels[i].offset);
+    return levels;
+}
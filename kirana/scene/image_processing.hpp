@@ -0,0 +1,92 @@
+#ifndef KIRANA_SCENE_IMAGE_PROCESSING_HPP
+#define KIRANA_SCENE_IMAGE_PROCESSING_HPP
+
+#include "image_types.hpp"
+
+#include <cstdint>
+
+/**
+ * Processes decoded pixel data on the CPU before it's uploaded. The inner
+ * loops of the common 4 channel formats use SSE2 where it's available, half
+ * float conversion uses F16C where it's available.
+ */
+namespace kirana::scene::image_processing
+{
+/**
+ * @return The size of a pixel in bytes.
+ */
+size_t getPixelSize(uint32_t channels, PixelDataType dataType);
+
+/**
+ * @return The number of mip levels of a full mip chain down to 1x1,
+ * including the base level.
+ */
+uint32_t getMipLevelCount(const std::array<int, 2> &size);
+
+/**
+ * Downsamples the image to half its size (rounded down, at least 1) with a
+ * 2x2 box filter. sRGB color channels are averaged in linear space, alpha
+ * channels are averaged as they are.
+ * @param pixels The pixel data of the image.
+ * @param size The size of the image.
+ * @param channels The number of channels per pixel.
+ * @param dataType The type of every channel.
+ * @param colorSpace The color space of the pixel data.
+ * @param result The downsampled pixel data. Must be large enough to hold the
+ * downsampled image.
+ */
+void downsample(const void *pixels, const std::array<int, 2> &size,
+                uint32_t channels, PixelDataType dataType,
+                ColorSpace colorSpace, void *result);
+
+/**
+ * Converts 32-bit float pixel data to half floats.
+ * @param pixels The FLOAT32 pixel data.
+ * @param pixelCount The number of pixels.
+ * @param channels The number of channels per pixel.
+ * @param resultChannels The number of channels per converted pixel. Missing
+ * channels are 0, except for alpha which is 1. Used to expand RGB to RGBA,
+ * since most devices can't sample 3 channel half float textures.
+ * @param result The FLOAT16 pixel data.
+ */
+void convertToHalf(const float *pixels, size_t pixelCount, uint32_t channels,
+                   uint32_t resultChannels, uint16_t *result);
+
+/**
+ * Converts a FLOAT32 mip chain generated by generateMipChain() to FLOAT16.
+ * @param mipChain The FLOAT32 pixel data of all the levels.
+ * @param levels The levels within mipChain.
+ * @param channels The number of channels per pixel.
+ * @param resultChannels The number of channels per converted pixel.
+ * @param halfChain The FLOAT16 pixel data of all the levels.
+ * @return The levels within halfChain.
+ */
+std::vector<ImageMipLevel> convertMipChainToHalf(
+    const std::vector<uint8_t> &mipChain,
+    const std::vector<ImageMipLevel> &levels, uint32_t channels,
+    uint32_t resultChannels, std::vector<uint8_t> *halfChain);
+
+/**
+ * Generates a mip chain by repeatedly downsampling the image with
+ * downsample().
+ * @param pixels The pixel data of the base level.
+ * @param size The size of the base level.
+ * @param channels The number of channels per pixel.
+ * @param dataType The type of every channel.
+ * @param colorSpace The color space of the pixel data.
+ * @param levelCount The number of levels including the base level. If 0, the
+ * full mip chain is generated.
+ * @param mipChain The tightly packed pixel data of all the levels, starting
+ * with a copy of the base level.
+ * @return The levels within mipChain.
+ */
+std::vector<ImageMipLevel> generateMipChain(const void *pixels,
+                                            const std::array<int, 2> &size,
+                                            uint32_t channels,
+                                            PixelDataType dataType,
+                                            ColorSpace colorSpace,
+                                            uint32_t levelCount,
+                                            std::vector<uint8_t> *mipChain);
+} // namespace kirana::scene::image_processing
+
+#endif // KIRANA_SCENE_IMAGE_PROCESSING_HPP
@@ -23,6 +23,40 @@ enum class ColorSpace
     sRGB = 0,
     Linear = 1
 };
+/// Type of every channel of the decoded pixel data.
+enum class PixelDataType
+{
+    /// 8-bit unsigned integer normalized to [0, 1].
+    UNORM8 = 0,
+    FLOAT32 = 1,
+    /// 16-bit IEEE 754 half float.
+    FLOAT16 = 2
+};
+
+/// What the pixel data of an image represents.
+enum class ImageUsage
+{
+    COLOR = 0,
+    /// Tangent space normals. Only the X and Y components are kept when
+    /// compressed, Z is reconstructed in the shaders.
+    NORMAL = 1
+};
+
+/// Block compression format of the pixel data. Every 4x4 block of pixels is
+/// stored in a fixed number of bytes.
+enum class ImageCompression
+{
+    NONE = 0,
+    /// RGB, 8 bytes per block.
+    BC1 = 1,
+    /// RGBA with BC1 color and a BC4 alpha block, 16 bytes per block.
+    BC3 = 2,
+    /// Two BC4 channels (RG), 16 bytes per block.
+    BC5 = 3,
+    /// RGBA, 16 bytes per block.
+    BC7 = 4
+};
+
 enum class Filter
 {
     NEAREST = 0,
@@ -48,6 +82,7 @@ struct ImageProperties
     Channels channels = Channels::RGBA;
     Channels fileChannels = Channels::RGBA;
     ColorSpace colorSpace = ColorSpace::sRGB;
+    ImageUsage usage = ImageUsage::COLOR;
     Filter magFilter = Filter::LINEAR;
     Filter minFilter = Filter::LINEAR;
     MipMapFilter mipMapFilter = MipMapFilter::LINEAR;
@@ -56,6 +91,18 @@ struct ImageProperties
     uint32_t mipLODBias = 0;
     bool enableAnisotropicFiltering = true;
     uint32_t anisotropicLevel = 16;
+    /// Generate the full mip chain when the image is loaded.
+    bool generateMipMaps = true;
+    /// Block compress the mip chain when the image is loaded.
+    bool enableCompression = true;
+};
+
+/// Location of a mip level within the pixel data of an image.
+struct ImageMipLevel
+{
+    std::array<int, 2> size = {0, 0};
+    size_t offset = 0;
+    size_t dataSize = 0;
 };
 } // namespace kirana::scene
 
@@ -0,0 +1,252 @@
+#include "image_writer.hpp"
+
+#include "image_processing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+// Version 2 of the format, for single-part scan line images.
+constexpr int32_t EXR_MAGIC = 20000630;
+constexpr int32_t EXR_VERSION = 2;
+constexpr int32_t EXR_PIXEL_TYPE_HALF = 1;
+
+const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+// Color types of 1 to 4 channels.
+const uint8_t PNG_COLOR_TYPES[4] = {0, 4, 2, 6};
+// Largest size of an uncompressed deflate block.
+constexpr size_t DEFLATE_BLOCK_SIZE = 65535;
+
+template <typename T>
+inline void append(std::vector<uint8_t> *buffer, const T &value)
+{
+    static_assert(std::is_arithmetic_v<T>);
+    const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+    buffer->insert(buffer->end(), bytes, bytes + sizeof(T));
+}
+
+inline void appendString(std::vector<uint8_t> *buffer, const char *value)
+{
+    do
+        buffer->emplace_back(static_cast<uint8_t>(*value));
+    while (*value++ != '\0');
+}
+
+inline void appendBigEndian(std::vector<uint8_t> *buffer, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+        buffer->emplace_back(static_cast<uint8_t>(value >> shift));
+}
+
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+{
+    static const auto table = []() {
+        std::array<uint32_t, 256> values{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++)
+                value = (value & 1) != 0 ? 0xEDB88320u ^ (value >> 1)
+                                         : value >> 1;
+            values[i] = value;
+        }
+        return values;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t adler32(const uint8_t *data, size_t size)
+{
+    // Sums of up to 5552 bytes can't overflow before the modulo.
+    constexpr uint32_t MODULO = 65521;
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (size_t first = 0; first < size; first += 5552)
+    {
+        const size_t last = std::min(size, first + 5552);
+        for (size_t i = first; i < last; i++)
+        {
+            a += data[i];
+            b += a;
+        }
+        a %= MODULO;
+        b %= MODULO;
+    }
+    return (b << 16) | a;
+}
+
+void writePNGChunk(std::ofstream *stream, const char type[4],
+                   const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> chunk;
+    chunk.reserve(data.size() + 12);
+    appendBigEndian(&chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    // The CRC covers the type and the data, not the length.
+    appendBigEndian(&chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    stream->write(reinterpret_cast<const char *>(chunk.data()),
+                  static_cast<std::streamsize>(chunk.size()));
+}
+} // namespace
+
+bool kirana::scene::image_writer::writeEXR(const std::string &path,
+                                           const float *pixels,
+                                           const std::array<int, 2> &size,
+                                           uint32_t channels)
+{
+    if (channels < 1 || channels > 4 || size[0] <= 0 || size[1] <= 0)
+        return false;
+    // Channels are stored in the alphabetical order of their names, each
+    // with the index of its channel in the pixel data.
+    static const char *const CHANNEL_NAMES[4][4] = {
+        {"Y"}, {"A", "Y"}, {"B", "G", "R"}, {"A", "B", "G", "R"}};
+    static const uint32_t CHANNEL_INDICES[4][4] = {
+        {0}, {1, 0}, {2, 1, 0}, {3, 2, 1, 0}};
+    const char *const *names = CHANNEL_NAMES[channels - 1];
+    const uint32_t *indices = CHANNEL_INDICES[channels - 1];
+
+    std::vector<uint8_t> header;
+    append(&header, EXR_MAGIC);
+    append(&header, EXR_VERSION);
+    const auto appendAttribute = [&](const char *name, const char *type,
+                                     int32_t valueSize) {
+        appendString(&header, name);
+        appendString(&header, type);
+        append(&header, valueSize);
+    };
+    // Each channel is its name, the pixel type, the linear flag, 3 reserved
+    // bytes and the sampling in x and y.
+    int32_t channelListSize = 1;
+    for (uint32_t c = 0; c < channels; c++)
+        channelListSize += static_cast<int32_t>(std::strlen(names[c])) + 17;
+    appendAttribute("channels", "chlist", channelListSize);
+    for (uint32_t c = 0; c < channels; c++)
+    {
+        appendString(&header, names[c]);
+        append(&header, EXR_PIXEL_TYPE_HALF);
+        append(&header, static_cast<uint32_t>(0));
+        append(&header, static_cast<int32_t>(1));
+        append(&header, static_cast<int32_t>(1));
+    }
+    header.emplace_back(0);
+    appendAttribute("compression", "compression", 1);
+    header.emplace_back(0);
+    for (const char *window : {"dataWindow", "displayWindow"})
+    {
+        appendAttribute(window, "box2i", 16);
+        append(&header, static_cast<int32_t>(0));
+        append(&header, static_cast<int32_t>(0));
+        append(&header, static_cast<int32_t>(size[0] - 1));
+        append(&header, static_cast<int32_t>(size[1] - 1));
+    }
+    appendAttribute("lineOrder", "lineOrder", 1);
+    header.emplace_back(0);
+    appendAttribute("pixelAspectRatio", "float", 4);
+    append(&header, 1.0f);
+    appendAttribute("screenWindowCenter", "v2f", 8);
+    append(&header, 0.0f);
+    append(&header, 0.0f);
+    appendAttribute("screenWindowWidth", "float", 4);
+    append(&header, 1.0f);
+    header.emplace_back(0);
+
+    // Uncompressed images have a block per scan line, which starts with its
+    // y coordinate and the size of its data.
+    const size_t width = static_cast<size_t>(size[0]);
+    const size_t lineDataSize = width * channels * sizeof(uint16_t);
+    const size_t blockSize = sizeof(int32_t) * 2 + lineDataSize;
+    const uint64_t firstBlock =
+        header.size() + sizeof(uint64_t) * static_cast<size_t>(size[1]);
+    for (int y = 0; y < size[1]; y++)
+        append(&header, firstBlock + blockSize * static_cast<uint64_t>(y));
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.good())
+        return false;
+    stream.write(reinterpret_cast<const char *>(header.data()),
+                 static_cast<std::streamsize>(header.size()));
+
+    // The values of each channel of a line are stored together.
+    std::vector<uint16_t> halfPixels(width * channels);
+    std::vector<uint8_t> block;
+    block.reserve(blockSize);
+    for (int y = 0; y < size[1]; y++)
+    {
+        image_processing::convertToHalf(
+            pixels + static_cast<size_t>(y) * width * channels, width,
+            channels, channels, halfPixels.data());
+        block.clear();
+        append(&block, static_cast<int32_t>(y));
+        append(&block, static_cast<int32_t>(lineDataSize));
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            for (size_t x = 0; x < width; x++)
+                append(&block, halfPixels[x * channels + indices[c]]);
+        }
+        stream.write(reinterpret_cast<const char *>(block.data()),
+                     static_cast<std::streamsize>(block.size()));
+    }
+    return stream.good();
+}
+
+bool kirana::scene::image_writer::writePNG(const std::string &path,
+                                           const uint8_t *pixels,
+                                           const std::array<int, 2> &size,
+                                           uint32_t channels)
+{
+    if (channels < 1 || channels > 4 || size[0] <= 0 || size[1] <= 0)
+        return false;
+
+    std::vector<uint8_t> header;
+    appendBigEndian(&header, static_cast<uint32_t>(size[0]));
+    appendBigEndian(&header, static_cast<uint32_t>(size[1]));
+    // Bit depth, color type, compression, filter and interlace methods.
+    header.insert(header.end(),
+                  {8, PNG_COLOR_TYPES[channels - 1], 0, 0, 0});
+
+    // Each line starts with its filter type, 0 for no filtering.
+    const size_t lineSize = static_cast<size_t>(size[0]) * channels;
+    std::vector<uint8_t> lines;
+    lines.reserve((lineSize + 1) * static_cast<size_t>(size[1]));
+    for (int y = 0; y < size[1]; y++)
+    {
+        const uint8_t *line = pixels + static_cast<size_t>(y) * lineSize;
+        lines.emplace_back(0);
+        lines.insert(lines.end(), line, line + lineSize);
+    }
+
+    // A zlib stream of uncompressed deflate blocks, each with its final flag,
+    // its size and the complement of its size.
+    std::vector<uint8_t> data{0x78, 0x01};
+    data.reserve(lines.size() + lines.size() / DEFLATE_BLOCK_SIZE * 5 + 12);
+    for (size_t first = 0; first < lines.size(); first += DEFLATE_BLOCK_SIZE)
+    {
+        const size_t blockSize =
+            std::min(DEFLATE_BLOCK_SIZE, lines.size() - first);
+        const bool isFinal = first + blockSize == lines.size();
+        data.emplace_back(isFinal ? 1 : 0);
+        append(&data, static_cast<uint16_t>(blockSize));
+        append(&data, static_cast<uint16_t>(~blockSize));
+        data.insert(data.end(), lines.begin() + first,
+                    lines.begin() + first + blockSize);
+    }
+    appendBigEndian(&data, adler32(lines.data(), lines.size()));
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.good())
+        return false;
+    stream.write(reinterpret_cast<const char *>(PNG_SIGNATURE),
+                 sizeof(PNG_SIGNATURE));
+    writePNGChunk(&stream, "IHDR", header);
+    writePNGChunk(&stream, "IDAT", data);
+    writePNGChunk(&stream, "IEND", {});
+    return stream.good();
+}
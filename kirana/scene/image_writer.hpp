@@ -0,0 +1,40 @@
+#ifndef KIRANA_SCENE_IMAGE_WRITER_HPP
+#define KIRANA_SCENE_IMAGE_WRITER_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * Writes pixel data to image files, such as the images rendered by the CPU
+ * path tracer. Only the parts of the formats needed for valid files are
+ * written, so the pixel data isn't compressed.
+ */
+namespace kirana::scene::image_writer
+{
+/**
+ * Writes an OpenEXR image with half float channels. Channels are named Y, or
+ * R, G, B and A, as they're ordered in the pixel data.
+ * @param path The path of the file.
+ * @param pixels The FLOAT32 pixel data, with rows from top to bottom.
+ * @param size The size of the image.
+ * @param channels The number of channels per pixel, from 1 to 4.
+ * @return true if the file was written.
+ */
+bool writeEXR(const std::string &path, const float *pixels,
+              const std::array<int, 2> &size, uint32_t channels);
+
+/**
+ * Writes a PNG image with 8-bit channels. Images with 1 or 2 channels are
+ * written as grayscale, with alpha in the second one.
+ * @param path The path of the file.
+ * @param pixels The UINT8 pixel data, with rows from top to bottom.
+ * @param size The size of the image.
+ * @param channels The number of channels per pixel, from 1 to 4.
+ * @return true if the file was written.
+ */
+bool writePNG(const std::string &path, const uint8_t *pixels,
+              const std::array<int, 2> &size, uint32_t channels);
+} // namespace kirana::scene::image_writer
+
+#endif // KIRANA_SCENE_IMAGE_WRITER_HPP
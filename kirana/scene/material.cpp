@@ -93,7 +93,8 @@ void kirana::scene::Material::setParametersFromAiMaterial(
     const std::string &scenePath, const aiMaterial *material)
 {
     // TODO: Use constant parameter names.
-    auto getImage = [&](aiTextureType type) -> Image * {
+    auto getImage = [&](aiTextureType type,
+                        const ImageProperties &properties = {}) -> Image * {
         if (material->GetTextureCount(type) <= 0)
             return nullptr;
         aiString aiPath;
@@ -102,7 +103,8 @@ void kirana::scene::Material::setParametersFromAiMaterial(
         {
             const std::string path = utils::filesystem::combinePath(
                 utils::filesystem::getFolder(scenePath), {aiPath.C_Str()});
-            const int index = ImageManager::get().addImage(path);
+            const int index =
+                ImageManager::get().addImage(path, "", properties);
             if (index < 0)
                 return nullptr;
             else
@@ -124,7 +126,11 @@ void kirana::scene::Material::setParametersFromAiMaterial(
         setParameter("_EmissiveMap", static_cast<int>(imgPtr->getIndex()));
         m_images.push_back(imgPtr);
     }
-    imgPtr = getImage(aiTextureType_NORMALS);
+    // Normal maps hold vectors, not colors.
+    ImageProperties normalMapProperties;
+    normalMapProperties.colorSpace = ColorSpace::Linear;
+    normalMapProperties.usage = ImageUsage::NORMAL;
+    imgPtr = getImage(aiTextureType_NORMALS, normalMapProperties);
     if (imgPtr)
     {
         setParameter("_NormalMap", static_cast<int>(imgPtr->getIndex()));
@@ -189,6 +195,26 @@ kirana::scene::Material::Material(const std::string &scenePath,
     setParametersFromAiMaterial(scenePath, material);
 }
 
+kirana::scene::Material::Material(
+    std::string materialName, const std::vector<MaterialParameter> &parameters,
+    std::vector<Image *> images)
+    : MaterialProperties{RasterPipelineData{CullMode::BACK,
+                                            SurfaceType::OPAQUE,
+                                            true,
+                                            true,
+                                            CompareOperation::LESS_OR_EQUAL,
+                                            {true}},
+                         RaytracePipelineData{},
+                         DEFAULT_PRINCIPLED_MATERIAL_PARAMETERS},
+      m_shaderName{constants::DEFAULT_SCENE_MATERIAL_SHADER_NAME},
+      m_name{std::move(materialName)}, m_isEditorMaterial{false},
+      m_images{std::move(images)}
+{
+    setShaderData();
+    for (const auto &p : parameters)
+        setParameter(p.id, p.value);
+}
+
 kirana::scene::Material::Material(
     std::string shaderName, std::string materialName,
     const RasterPipelineData &rasterData,
@@ -37,6 +37,17 @@ class Material : public MaterialProperties
 
     Material();
     explicit Material(const std::string &scenePath, const aiMaterial *material);
+    /**
+     * Creates a scene material from previously imported data (Eg: the scene
+     * cache). Parameters not present in the default parameter list of the
+     * scene shader are ignored.
+     * @param materialName Name of the material.
+     * @param parameters Parameter values to set.
+     * @param images Images referenced by the texture parameters.
+     */
+    explicit Material(std::string materialName,
+                      const std::vector<MaterialParameter> &parameters,
+                      std::vector<Image *> images);
     explicit Material(std::string shaderName, std::string materialName,
                       const RasterPipelineData &rasterData,
                       const RaytracePipelineData &raytraceData,
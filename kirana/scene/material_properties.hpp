@@ -53,6 +53,12 @@ class MaterialProperties
         return m_raytraceData;
     }
 
+    [[nodiscard]] inline const std::vector<MaterialParameter> &getParameters()
+        const
+    {
+        return m_parameters;
+    }
+
     bool setParameter(const std::string &paramName, const std::any &value)
     {
         if (m_parameterIndices.find(paramName) == m_parameterIndices.end())
@@ -1,20 +1,64 @@
 #include "mesh.hpp"
 #include "material.hpp"
+#include "mesh_optimizer.hpp"
 #include <assimp/scene.h>
 #include <constants.h>
 #include <logger.hpp>
+#include <hash.hpp>
 #include <utility>
+#include <cstring>
 
 typedef kirana::utils::Logger Logger;
 typedef kirana::utils::LogSeverity LogSeverity;
 namespace constants = kirana::utils::constants;
 
+namespace
+{
+static_assert(sizeof(kirana::scene::INDEX_TYPE) == sizeof(unsigned int),
+              "Assimp face indices must match the scene index type");
+
+/**
+ * Copies a tightly packed Assimp attribute array (aiVector3D, aiColor4D) into
+ * the given member of every vertex.
+ * @tparam ComponentCount Number of float components copied per vertex.
+ * @param src Assimp attribute array with at least ComponentCount floats per
+ * element.
+ * @param count Number of vertices.
+ * @param offset Byte offset of the attribute within the Vertex struct.
+ * @param vertices Destination vertices.
+ */
+template <size_t ComponentCount, typename T>
+void copyVertexAttribute(const T *src, size_t count, size_t offset,
+                         kirana::scene::Vertex *vertices)
+{
+    static_assert(sizeof(T) >= ComponentCount * sizeof(float),
+                  "Source attribute is smaller than the copied components");
+    const auto *srcBytes = reinterpret_cast<const uint8_t *>(src);
+    auto *dstBytes = reinterpret_cast<uint8_t *>(vertices) + offset;
+    for (size_t i = 0; i < count; i++)
+        std::memcpy(dstBytes + i * sizeof(kirana::scene::Vertex),
+                    srcBytes + i * sizeof(T), ComponentCount * sizeof(float));
+}
+} // namespace
+
 kirana::scene::Mesh::Mesh(std::string name, const math::Bounds3 &bounds,
-                          const std::vector<Vertex> &vertices,
-                          const std::vector<scene::INDEX_TYPE> &indices,
+                          std::vector<Vertex> vertices,
+                          std::vector<scene::INDEX_TYPE> indices,
                           const std::shared_ptr<Material> &material)
     : m_name{std::move(name)}, m_bounds{bounds},
-      m_vertices{vertices}, m_indices{indices}, m_material{material}
+      m_vertices{std::move(vertices)}, m_indices{std::move(indices)},
+      m_material{material}
+{
+}
+
+kirana::scene::Mesh::Mesh(std::string name, const math::Bounds3 &bounds,
+                          utils::ArrayView<const Vertex> vertices,
+                          utils::ArrayView<const scene::INDEX_TYPE> indices,
+                          std::shared_ptr<const void> dataOwner,
+                          const std::shared_ptr<Material> &material)
+    : m_name{std::move(name)}, m_bounds{bounds}, m_material{material},
+      m_externalData{std::move(dataOwner)}, m_externalVertices{vertices},
+      m_externalIndices{indices}
 {
 }
 
@@ -31,74 +75,38 @@ kirana::scene::Mesh::Mesh(const aiMesh *mesh,
     if ((mesh->mPrimitiveTypes & aiPrimitiveType::aiPrimitiveType_TRIANGLE) ==
         aiPrimitiveType::aiPrimitiveType_TRIANGLE)
     {
-        m_vertices.resize(mesh->mNumVertices);
+        // Every attribute is copied in its own linear pass over the vertex
+        // arrays, so each vertex is written once and the loops have no
+        // branches.
+        const size_t vertexCount = mesh->mNumVertices;
+        m_vertices.resize(vertexCount);
+        copyVertexAttribute<3>(mesh->mVertices, vertexCount,
+                               offsetof(Vertex, position), m_vertices.data());
+        if (mesh->HasNormals())
+            copyVertexAttribute<3>(mesh->mNormals, vertexCount,
+                                   offsetof(Vertex, normal), m_vertices.data());
+        if (mesh->HasVertexColors(0))
+            copyVertexAttribute<4>(mesh->mColors[0], vertexCount,
+                                   offsetof(Vertex, color), m_vertices.data());
+        if (mesh->HasTextureCoords(0))
+            copyVertexAttribute<2>(mesh->mTextureCoords[0], vertexCount,
+                                   offsetof(Vertex, texCoords),
+                                   m_vertices.data());
+
+        // Assimp stores each face separately, so the indices are gathered
+        // into a pre-sized buffer. Non-triangle faces (points and lines of
+        // meshes with mixed primitive types) are skipped.
+        m_indices.resize(static_cast<size_t>(mesh->mNumFaces) * 3);
+        scene::INDEX_TYPE *indices = m_indices.data();
         for (size_t i = 0; i < mesh->mNumFaces; i++)
         {
             const aiFace &face = mesh->mFaces[i];
-            const scene::INDEX_TYPE v1 = face.mIndices[0];
-            const scene::INDEX_TYPE v2 = face.mIndices[1];
-            const scene::INDEX_TYPE v3 = face.mIndices[2];
-            m_indices.push_back(v1);
-            m_indices.push_back(v2);
-            m_indices.push_back(v3);
-
-            m_vertices[v1].position[0] = mesh->mVertices[v1].x;
-            m_vertices[v1].position[1] = mesh->mVertices[v1].y;
-            m_vertices[v1].position[2] = mesh->mVertices[v1].z;
-
-            m_vertices[v2].position[0] = mesh->mVertices[v2].x;
-            m_vertices[v2].position[1] = mesh->mVertices[v2].y;
-            m_vertices[v2].position[2] = mesh->mVertices[v2].z;
-
-            m_vertices[v3].position[0] = mesh->mVertices[v3].x;
-            m_vertices[v3].position[1] = mesh->mVertices[v3].y;
-            m_vertices[v3].position[2] = mesh->mVertices[v3].z;
-
-            if (mesh->HasNormals())
-            {
-                m_vertices[v1].normal[0] = mesh->mNormals[v1].x;
-                m_vertices[v1].normal[1] = mesh->mNormals[v1].y;
-                m_vertices[v1].normal[2] = mesh->mNormals[v1].z;
-
-                m_vertices[v2].normal[0] = mesh->mNormals[v2].x;
-                m_vertices[v2].normal[1] = mesh->mNormals[v2].y;
-                m_vertices[v2].normal[2] = mesh->mNormals[v2].z;
-
-                m_vertices[v3].normal[0] = mesh->mNormals[v3].x;
-                m_vertices[v3].normal[1] = mesh->mNormals[v3].y;
-                m_vertices[v3].normal[2] = mesh->mNormals[v3].z;
-            }
-
-            if (mesh->HasVertexColors(0))
-            {
-                m_vertices[v1].color[0] = mesh->mColors[0][v1].r;
-                m_vertices[v1].color[1] = mesh->mColors[0][v1].g;
-                m_vertices[v1].color[2] = mesh->mColors[0][v1].b;
-                m_vertices[v1].color[3] = mesh->mColors[0][v1].a;
-
-                m_vertices[v2].color[0] = mesh->mColors[0][v2].r;
-                m_vertices[v2].color[1] = mesh->mColors[0][v2].g;
-                m_vertices[v2].color[2] = mesh->mColors[0][v2].b;
-                m_vertices[v2].color[3] = mesh->mColors[0][v2].a;
-
-                m_vertices[v3].color[0] = mesh->mColors[0][v3].r;
-                m_vertices[v3].color[1] = mesh->mColors[0][v3].g;
-                m_vertices[v3].color[2] = mesh->mColors[0][v3].b;
-                m_vertices[v3].color[3] = mesh->mColors[0][v3].a;
-            }
-
-            if (mesh->HasTextureCoords(0))
-            {
-                m_vertices[v1].texCoords[0] = mesh->mTextureCoords[0][v1].x;
-                m_vertices[v1].texCoords[1] = mesh->mTextureCoords[0][v1].y;
-
-                m_vertices[v2].texCoords[0] = mesh->mTextureCoords[0][v2].x;
-                m_vertices[v2].texCoords[1] = mesh->mTextureCoords[0][v2].y;
-
-                m_vertices[v3].texCoords[0] = mesh->mTextureCoords[0][v3].x;
-                m_vertices[v3].texCoords[1] = mesh->mTextureCoords[0][v3].y;
-            }
+            if (face.mNumIndices != 3)
+                continue;
+            std::memcpy(indices, face.mIndices, 3 * sizeof(scene::INDEX_TYPE));
+            indices += 3;
         }
+        m_indices.resize(indices - m_indices.data());
     }
     else
     {
@@ -106,3 +114,120 @@ kirana::scene::Mesh::Mesh(const aiMesh *mesh,
                           "Mesh: " + m_name + " does not have triangle faces");
     }
 }
+
+void kirana::scene::Mesh::optimize(const SceneImportSettings &importSettings)
+{
+    if (m_externalData || m_indices.empty())
+        return;
+
+    if (importSettings.optimizeVertexCache)
+        mesh_optimizer::optimizeVertexCache(&m_indices, m_vertices.size());
+    if (importSettings.optimizeOverdraw)
+        mesh_optimizer::optimizeOverdraw(&m_indices, m_vertices);
+    if (importSettings.optimizeVertexFetch)
+        mesh_optimizer::optimizeVertexFetch(&m_vertices, &m_indices);
+}
+
+void kirana::scene::Mesh::generateLODs(
+    const SceneImportSettings &importSettings)
+{
+    m_lods.clear();
+    m_lodIndices.clear();
+    m_externalLODIndices = {};
+    const auto vertices = getVertices();
+    auto previous = getIndices();
+    float previousError = 0.0f;
+    for (uint32_t lod = 0; lod < constants::SCENE_MESH_LOD_MAX_COUNT; lod++)
+    {
+        const size_t targetTriangleCount = static_cast<size_t>(
+            static_cast<float>(previous.size() / 3) *
+            constants::SCENE_MESH_LOD_REDUCTION);
+        if (targetTriangleCount <
+                constants::SCENE_MESH_LOD_MIN_TRIANGLE_COUNT ||
+            previousError >= constants::SCENE_MESH_LOD_MAX_ERROR)
+            break;
+
+        // Each level is simplified from the previous one, which is much faster
+        // than starting from the full mesh. The errors add up.
+        float error = 0.0f;
+        std::vector<INDEX_TYPE> indices = mesh_optimizer::simplify(
+            previous, vertices, targetTriangleCount * 3,
+            constants::SCENE_MESH_LOD_MAX_ERROR - previousError, &error);
+        // Stop if the mesh can't be simplified much further.
+        if (indices.size() > (previous.size() + targetTriangleCount * 3) / 2)
+            break;
+        if (importSettings.optimizeVertexCache)
+            mesh_optimizer::optimizeVertexCache(&indices, vertices.size());
+
+        previousError += error;
+        m_lods.emplace_back(
+            MeshLOD{static_cast<uint32_t>(m_lodIndices.size()),
+                    static_cast<uint32_t>(indices.size()), previousError});
+        m_lodIndices.insert(m_lodIndices.end(), indices.begin(),
+                            indices.end());
+        previous = utils::ArrayView<const INDEX_TYPE>(
+            m_lodIndices.data() + m_lods.back().firstIndex,
+            m_lods.back().indexCount);
+    }
+}
+
+void kirana::scene::Mesh::buildMeshlets()
+{
+    m_meshlets = mesh_optimizer::buildMeshlets(
+        getIndices(), getVertices(), constants::SCENE_MESHLET_MAX_VERTICES,
+        constants::SCENE_MESHLET_MAX_TRIANGLES);
+}
+
+void kirana::scene::Mesh::setLODs(std::vector<MeshLOD> lods,
+                                  std::vector<scene::INDEX_TYPE> indices)
+{
+    m_lods = std::move(lods);
+    m_lodIndices = std::move(indices);
+    m_externalLODIndices = {};
+}
+
+void kirana::scene::Mesh::setLODs(
+    std::vector<MeshLOD> lods,
+    utils::ArrayView<const scene::INDEX_TYPE> indices)
+{
+    m_lods = std::move(lods);
+    m_lodIndices.clear();
+    m_externalLODIndices = indices;
+}
+
+kirana::utils::ArrayView<const kirana::scene::INDEX_TYPE> kirana::scene::Mesh::
+    getLODIndices(size_t lod) const
+{
+    if (lod == 0)
+        return getIndices();
+    const MeshLOD &meshLOD = m_lods[lod - 1];
+    return utils::ArrayView<const INDEX_TYPE>(
+        getLODIndexData().data() + meshLOD.firstIndex, meshLOD.indexCount);
+}
+
+uint64_t kirana::scene::Mesh::getContentHash() const
+{
+    const auto vertices = getVertices();
+    const auto indices = getIndices();
+    uint64_t hash = utils::hash::fnv1aValue(m_material.get());
+    hash = utils::hash::fnv1aValue(vertices.size(), hash);
+    hash = utils::hash::fnv1aWords(vertices.data(), vertices.sizeInBytes(),
+                                   hash);
+    return utils::hash::fnv1aWords(indices.data(), indices.sizeInBytes(),
+                                   hash);
+}
+
+bool kirana::scene::Mesh::hasSameContent(const Mesh &mesh) const
+{
+    const auto vertices = getVertices();
+    const auto indices = getIndices();
+    const auto otherVertices = mesh.getVertices();
+    const auto otherIndices = mesh.getIndices();
+    return m_material == mesh.m_material &&
+           vertices.size() == otherVertices.size() &&
+           indices.size() == otherIndices.size() &&
+           std::memcmp(vertices.data(), otherVertices.data(),
+                       vertices.sizeInBytes()) == 0 &&
+           std::memcmp(indices.data(), otherIndices.data(),
+                       indices.sizeInBytes()) == 0;
+}
@@ -2,6 +2,7 @@
 #define MESH_HPP
 
 #include <bounds3.hpp>
+#include <array_view.hpp>
 #include <vector>
 #include <string>
 #include <memory>
@@ -22,11 +23,39 @@ class Mesh
     std::vector<scene::INDEX_TYPE> m_indices;
     std::shared_ptr<Material> m_material;
 
+    /// Owner of externally stored vertex/index data (Eg: a memory-mapped
+    /// scene cache). When set, the external views are used instead of the
+    /// owned vectors.
+    std::shared_ptr<const void> m_externalData;
+    utils::ArrayView<const Vertex> m_externalVertices;
+    utils::ArrayView<const scene::INDEX_TYPE> m_externalIndices;
+
+    /// Simplified levels of detail. Their indices are stored one after the
+    /// other in the LOD index data.
+    std::vector<MeshLOD> m_lods;
+    std::vector<scene::INDEX_TYPE> m_lodIndices;
+    utils::ArrayView<const scene::INDEX_TYPE> m_externalLODIndices;
+
+    /// Triangle clusters of the mesh indices.
+    std::vector<Meshlet> m_meshlets;
+
   public:
     Mesh() = default;
     Mesh(std::string name, const math::Bounds3 &bounds,
-         const std::vector<Vertex> &vertices,
-         const std::vector<scene::INDEX_TYPE> &indices,
+         std::vector<Vertex> vertices, std::vector<scene::INDEX_TYPE> indices,
+         const std::shared_ptr<Material> &material);
+    /**
+     * Creates a mesh which references vertex and index data it doesn't own.
+     * No data is copied.
+     * @param vertices View of the vertex data.
+     * @param indices View of the index data.
+     * @param dataOwner Object owning the memory of the views. It is kept alive
+     * for the lifetime of the mesh.
+     */
+    Mesh(std::string name, const math::Bounds3 &bounds,
+         utils::ArrayView<const Vertex> vertices,
+         utils::ArrayView<const scene::INDEX_TYPE> indices,
+         std::shared_ptr<const void> dataOwner,
          const std::shared_ptr<Material> &material);
     Mesh(const aiMesh *mesh, std::shared_ptr<Material> material);
     virtual ~Mesh() = default;
@@ -37,13 +66,19 @@ class Mesh
     {
         return m_name;
     }
-    [[nodiscard]] inline const std::vector<Vertex> &getVertices() const
+    [[nodiscard]] inline utils::ArrayView<const Vertex> getVertices() const
+    {
+        return m_externalData ? m_externalVertices : m_vertices;
+    }
+    [[nodiscard]] inline utils::ArrayView<const scene::INDEX_TYPE> getIndices()
+        const
     {
-        return m_vertices;
+        return m_externalData ? m_externalIndices : m_indices;
     }
-    [[nodiscard]] inline const std::vector<scene::INDEX_TYPE> &getIndices() const
+    /// Returns true if the vertex/index data is not owned by the mesh.
+    [[nodiscard]] inline bool hasExternalData() const
     {
-        return m_indices;
+        return m_externalData != nullptr;
     }
     /// Returns local bounding-box of the mesh
     [[nodiscard]] inline const math::Bounds3 &getBounds() const
@@ -54,6 +89,83 @@ class Mesh
     {
         return m_material;
     }
+
+    /**
+     * Runs the mesh optimization passes enabled in the import settings on the
+     * owned vertex and index data. Meshes with external data are not changed.
+     */
+    void optimize(const SceneImportSettings &importSettings);
+
+    /**
+     * Generates the simplified levels of detail of the mesh. Each level has
+     * about half the triangles of the previous one.
+     * @param importSettings The import settings. The indices of the levels are
+     * optimized for the vertex cache if it's enabled.
+     */
+    void generateLODs(const SceneImportSettings &importSettings);
+    /**
+     * Sets the levels of detail of the mesh.
+     * @param lods The levels of detail, excluding the mesh itself.
+     * @param indices The indices of all the levels.
+     */
+    void setLODs(std::vector<MeshLOD> lods,
+                 std::vector<scene::INDEX_TYPE> indices);
+    /**
+     * Sets the levels of detail of the mesh to index data it doesn't own. The
+     * data has to be kept alive by the owner of the external vertex data.
+     */
+    void setLODs(std::vector<MeshLOD> lods,
+                 utils::ArrayView<const scene::INDEX_TYPE> indices);
+
+    /// Number of levels of detail, including the mesh itself (level 0).
+    [[nodiscard]] inline size_t getLODCount() const
+    {
+        return m_lods.size() + 1;
+    }
+    /// The simplified levels of detail, excluding the mesh itself.
+    [[nodiscard]] inline const std::vector<MeshLOD> &getLODs() const
+    {
+        return m_lods;
+    }
+    /// Indices of all the simplified levels of detail.
+    [[nodiscard]] inline utils::ArrayView<const scene::INDEX_TYPE>
+        getLODIndexData() const
+    {
+        return m_externalLODIndices.empty() ? m_lodIndices
+                                            : m_externalLODIndices;
+    }
+    /// Returns the indices of the given level of detail. Level 0 is the mesh
+    /// itself.
+    [[nodiscard]] utils::ArrayView<const scene::INDEX_TYPE> getLODIndices(
+        size_t lod) const;
+    /// Returns the simplification error of the given level of detail relative
+    /// to the extents of the mesh.
+    [[nodiscard]] inline float getLODError(size_t lod) const
+    {
+        return lod == 0 ? 0.0f : m_lods[lod - 1].error;
+    }
+
+    /**
+     * Splits the mesh into clusters of consecutive triangles with bounding
+     * volumes and normal cones for culling.
+     */
+    void buildMeshlets();
+    inline void setMeshlets(std::vector<Meshlet> meshlets)
+    {
+        m_meshlets = std::move(meshlets);
+    }
+    [[nodiscard]] inline const std::vector<Meshlet> &getMeshlets() const
+    {
+        return m_meshlets;
+    }
+
+    /// Hash of the vertex data, index data and material of the mesh.
+    [[nodiscard]] uint64_t getContentHash() const;
+    /**
+     * Compares the content of two meshes. The names are ignored.
+     * @return true if both meshes have the same vertices, indices and material.
+     */
+    [[nodiscard]] bool hasSameContent(const Mesh &mesh) const;
 };
 } // namespace kirana::scene
 #endif
\ No newline at end of file
@@ -0,0 +1,874 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+// Tuning values from the "Linear-Speed Vertex Cache Optimisation" paper.
+constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+// Cache size used to find the cluster boundaries of the overdraw pass.
+constexpr uint32_t OVERDRAW_CACHE_SIZE = 16;
+
+// Vertices with a higher valence use the score of this valence.
+constexpr uint32_t FORSYTH_MAX_VALENCE = 32;
+
+struct VertexScoreTable
+{
+    float cache[FORSYTH_CACHE_SIZE];
+    float valence[FORSYTH_MAX_VALENCE + 1];
+
+    VertexScoreTable()
+    {
+        for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; i++)
+        {
+            // The vertices of the last triangle get a fixed score, so that the
+            // next triangle doesn't just reuse the same edge.
+            if (i < 3)
+                cache[i] = FORSYTH_LAST_TRIANGLE_SCORE;
+            else
+            {
+                const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                cache[i] =
+                    std::pow(1.0f - static_cast<float>(i - 3) * scaler,
+                             FORSYTH_CACHE_DECAY_POWER);
+            }
+        }
+        // Boost vertices with few triangles left, to get rid of lone
+        // triangles.
+        valence[0] = 0.0f;
+        for (uint32_t i = 1; i <= FORSYTH_MAX_VALENCE; i++)
+            valence[i] =
+                FORSYTH_VALENCE_BOOST_SCALE *
+                std::pow(static_cast<float>(i), -FORSYTH_VALENCE_BOOST_POWER);
+    }
+};
+
+float getVertexScore(int32_t cachePosition, uint32_t remainingValence)
+{
+    static const VertexScoreTable table;
+
+    // Vertices without remaining triangles are never used again.
+    if (remainingValence == 0)
+        return -1.0f;
+
+    const float cacheScore = cachePosition >= 0 ? table.cache[cachePosition]
+                                                : 0.0f;
+    return cacheScore +
+           table.valence[std::min(remainingValence, FORSYTH_MAX_VALENCE)];
+}
+
+/// FIFO vertex cache simulation using timestamps.
+class VertexCacheSimulator
+{
+  public:
+    VertexCacheSimulator(size_t vertexCount, uint32_t cacheSize)
+        : m_cacheSize{cacheSize}, m_timestamps(vertexCount, 0),
+          m_time{cacheSize + 1}
+    {
+    }
+
+    /// Returns the number of cache misses of the triangle.
+    uint32_t addTriangle(const kirana::scene::INDEX_TYPE *triangle)
+    {
+        uint32_t misses = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            if (m_time - m_timestamps[triangle[i]] > m_cacheSize)
+            {
+                m_timestamps[triangle[i]] = m_time++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+
+    void reset()
+    {
+        m_time += m_cacheSize + 1;
+    }
+
+  private:
+    uint32_t m_cacheSize;
+    std::vector<uint32_t> m_timestamps;
+    uint32_t m_time;
+};
+
+/// Symmetric 4x4 error quadric of Garland and Heckbert, accumulated from
+/// weighted triangle planes.
+struct Quadric
+{
+    double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0, c = 0.0;
+    double weight = 0.0;
+
+    void addPlane(const double *n, double d, double w)
+    {
+        a00 += w * n[0] * n[0];
+        a11 += w * n[1] * n[1];
+        a22 += w * n[2] * n[2];
+        a01 += w * n[0] * n[1];
+        a02 += w * n[0] * n[2];
+        a12 += w * n[1] * n[2];
+        b0 += w * n[0] * d;
+        b1 += w * n[1] * d;
+        b2 += w * n[2] * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric &q)
+    {
+        a00 += q.a00;
+        a11 += q.a11;
+        a22 += q.a22;
+        a01 += q.a01;
+        a02 += q.a02;
+        a12 += q.a12;
+        b0 += q.b0;
+        b1 += q.b1;
+        b2 += q.b2;
+        c += q.c;
+        weight += q.weight;
+    }
+
+    /// Returns the weighted mean squared distance of the point to the planes.
+    [[nodiscard]] double getError(const float *p) const
+    {
+        const double x = p[0], y = p[1], z = p[2];
+        const double error = a00 * x * x + a11 * y * y + a22 * z * z +
+                             2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                             2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::abs(error) / weight : 0.0;
+    }
+};
+
+/// Orders vertices by position and then by the remaining attributes.
+int compareVertices(const kirana::scene::Vertex &v1,
+                    const kirana::scene::Vertex &v2)
+{
+    int result = std::memcmp(v1.position.data(), v2.position.data(),
+                             3 * sizeof(float));
+    if (result == 0)
+        result = std::memcmp(v1.normal.data(), v2.normal.data(),
+                             3 * sizeof(float));
+    if (result == 0)
+        result = std::memcmp(v1.color.data(), v2.color.data(),
+                             4 * sizeof(float));
+    if (result == 0)
+        result = std::memcmp(v1.texCoords.data(), v2.texCoords.data(),
+                             2 * sizeof(float));
+    return result;
+}
+
+/**
+ * Computes the bounding box, bounding sphere and normal cone of the meshlet
+ * from its triangles. The cone is computed as in meshoptimizer: its axis is
+ * the average triangle normal and its apex is moved back along the axis until
+ * it's behind all the triangles.
+ */
+void computeMeshletBounds(
+    kirana::utils::ArrayView<const kirana::scene::Vertex> vertices,
+    const kirana::scene::INDEX_TYPE *indices, kirana::scene::Meshlet *meshlet)
+{
+    using kirana::math::Vector3;
+
+    meshlet->bounds = kirana::math::Bounds3(vertices[indices[0]].position);
+    for (uint32_t i = 1; i < meshlet->indexCount; i++)
+        meshlet->bounds.encapsulate(vertices[indices[i]].position);
+    meshlet->center = meshlet->bounds.getCenter();
+    float radiusSquared = 0.0f;
+    for (uint32_t i = 0; i < meshlet->indexCount; i++)
+    {
+        const Vector3 offset = vertices[indices[i]].position - meshlet->center;
+        radiusSquared = std::max(radiusSquared, Vector3::dot(offset, offset));
+    }
+    meshlet->radius = std::sqrt(radiusSquared);
+
+    // Unit normals of the non-degenerate triangles.
+    std::vector<Vector3> normals;
+    normals.reserve(meshlet->indexCount / 3);
+    std::vector<const Vector3 *> normalPositions;
+    normalPositions.reserve(meshlet->indexCount / 3);
+    Vector3 axis;
+    for (uint32_t i = 0; i < meshlet->indexCount; i += 3)
+    {
+        const Vector3 &p0 = vertices[indices[i]].position;
+        const Vector3 normal =
+            Vector3::cross(vertices[indices[i + 1]].position - p0,
+                           vertices[indices[i + 2]].position - p0);
+        const float length = normal.length();
+        if (length == 0.0f)
+            continue;
+        normals.emplace_back(normal / length);
+        normalPositions.emplace_back(&p0);
+        axis += normals.back();
+    }
+    meshlet->coneApex = meshlet->center;
+    meshlet->coneAxis = Vector3::ZERO;
+    meshlet->coneCutoff = 1.0f;
+    const float axisLength = axis.length();
+    if (normals.empty() || axisLength == 0.0f)
+        return;
+    axis = axis / axisLength;
+
+    // Cones wider than ~85 degrees can't cull anything useful.
+    float minDot = 1.0f;
+    for (const Vector3 &n : normals)
+        minDot = std::min(minDot, Vector3::dot(n, axis));
+    if (minDot <= 0.1f)
+        return;
+
+    // Find the point on the axis behind the planes of all the triangles.
+    float maxT = 0.0f;
+    for (size_t i = 0; i < normals.size(); i++)
+    {
+        const float dc =
+            Vector3::dot(meshlet->center - *normalPositions[i], normals[i]);
+        const float dn = Vector3::dot(axis, normals[i]);
+        maxT = std::max(maxT, dc / dn);
+    }
+    meshlet->coneApex = meshlet->center - axis * maxT;
+    meshlet->coneAxis = axis;
+    meshlet->coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+/// Returns the (unnormalized) normal of the triangle.
+void getTriangleNormal(const float *p0, const float *p1, const float *p2,
+                       float *normal)
+{
+    const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+} // namespace
+
+void kirana::scene::mesh_optimizer::optimizeVertexCache(
+    std::vector<INDEX_TYPE> *indices, size_t vertexCount)
+{
+    const std::vector<INDEX_TYPE> &input = *indices;
+    const size_t triangleCount = input.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Triangles adjacent to each vertex. The first remainingValence[v] entries
+    // of the range of vertex v are the triangles that are not emitted yet.
+    std::vector<uint32_t> remainingValence(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        remainingValence[input[i]]++;
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingValence[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(),
+                                   adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[fill[input[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = getVertexScore(-1, remainingValence[v]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    size_t bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        triangleScores[t] = vertexScores[input[t * 3]] +
+                            vertexScores[input[t * 3 + 1]] +
+                            vertexScores[input[t * 3 + 2]];
+        if (triangleScores[t] > triangleScores[bestTriangle])
+            bestTriangle = t;
+    }
+
+    std::vector<INDEX_TYPE> output(triangleCount * 3);
+    std::vector<INDEX_TYPE> cache;
+    std::vector<INDEX_TYPE> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    for (size_t outputTriangle = 0; outputTriangle < triangleCount;
+         outputTriangle++)
+    {
+        const INDEX_TYPE *triangle = &input[bestTriangle * 3];
+        std::copy(triangle, triangle + 3, output.begin() + outputTriangle * 3);
+        emitted[bestTriangle] = true;
+
+        // Remove the triangle from the adjacency of its vertices.
+        newCache.clear();
+        for (int i = 0; i < 3; i++)
+        {
+            const INDEX_TYPE v = triangle[i];
+            uint32_t *begin = &adjacency[adjacencyOffsets[v]];
+            uint32_t *end = begin + remainingValence[v];
+            uint32_t *it = std::find(begin, end, bestTriangle);
+            if (it != end)
+            {
+                std::swap(*it, *(end - 1));
+                remainingValence[v]--;
+            }
+            if (std::find(newCache.begin(), newCache.end(), v) ==
+                newCache.end())
+                newCache.push_back(v);
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache.
+        for (const INDEX_TYPE v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache.push_back(v);
+        }
+
+        // Update the scores of the vertices whose cache position changed.
+        for (size_t i = 0; i < newCache.size(); i++)
+        {
+            const INDEX_TYPE v = newCache[i];
+            cachePositions[v] =
+                i < FORSYTH_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            const float score =
+                getVertexScore(cachePositions[v], remainingValence[v]);
+            const float scoreDelta = score - vertexScores[v];
+            vertexScores[v] = score;
+
+            const uint32_t *adjacent = &adjacency[adjacencyOffsets[v]];
+            for (uint32_t a = 0; a < remainingValence[v]; a++)
+                triangleScores[adjacent[a]] += scoreDelta;
+        }
+        newCache.resize(std::min<size_t>(newCache.size(), FORSYTH_CACHE_SIZE));
+        std::swap(cache, newCache);
+
+        // Pick the best triangle around the cached vertices.
+        float bestScore = -std::numeric_limits<float>::max();
+        bool foundTriangle = false;
+        for (const INDEX_TYPE v : cache)
+        {
+            const uint32_t *adjacent = &adjacency[adjacencyOffsets[v]];
+            for (uint32_t a = 0; a < remainingValence[v]; a++)
+            {
+                if (triangleScores[adjacent[a]] > bestScore)
+                {
+                    bestScore = triangleScores[adjacent[a]];
+                    bestTriangle = adjacent[a];
+                    foundTriangle = true;
+                }
+            }
+        }
+
+        // No triangle touches the cache, continue with the next unused one.
+        if (!foundTriangle)
+        {
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                scanCursor++;
+            bestTriangle = scanCursor;
+        }
+    }
+    *indices = std::move(output);
+}
+
+void kirana::scene::mesh_optimizer::optimizeOverdraw(
+    std::vector<INDEX_TYPE> *indices, utils::ArrayView<const Vertex> vertices,
+    float threshold)
+{
+    const std::vector<INDEX_TYPE> &input = *indices;
+    const size_t triangleCount = input.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Hard boundaries: triangles where all vertices miss the cache. Triangles
+    // can be reordered here without changing the cache efficiency.
+    VertexCacheSimulator cache(vertices.size(), OVERDRAW_CACHE_SIZE);
+    std::vector<uint32_t> hardBoundaries;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (cache.addTriangle(&input[t * 3]) == 3 || t == 0)
+            hardBoundaries.push_back(static_cast<uint32_t>(t));
+    }
+    hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Soft boundaries: split each hard cluster wherever the ACMR since the
+    // last split is within the threshold of the ACMR of the whole cluster.
+    std::vector<uint32_t> clusters;
+    for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+    {
+        const uint32_t start = hardBoundaries[c];
+        const uint32_t end = hardBoundaries[c + 1];
+
+        cache.reset();
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = start; t < end; t++)
+            clusterMisses += cache.addTriangle(&input[t * 3]);
+        const float clusterThreshold =
+            threshold * static_cast<float>(clusterMisses) /
+            static_cast<float>(end - start);
+
+        cache.reset();
+        clusters.push_back(start);
+        uint32_t misses = 0;
+        uint32_t clusterStart = start;
+        for (uint32_t t = start; t < end; t++)
+        {
+            misses += cache.addTriangle(&input[t * 3]);
+            const float acmr = static_cast<float>(misses) /
+                               static_cast<float>(t - clusterStart + 1);
+            if (acmr <= clusterThreshold && t + 1 < end)
+            {
+                clusters.push_back(t + 1);
+                clusterStart = t + 1;
+                misses = 0;
+                cache.reset();
+            }
+        }
+    }
+    const size_t clusterCount = clusters.size();
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Area weighted centroid and normal of every cluster.
+    std::vector<float> clusterData(clusterCount * 6, 0.0f);
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float *centroid = &clusterData[c * 6];
+        float *normal = &clusterData[c * 6 + 3];
+        float clusterArea = 0.0f;
+        for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            const float *p0 = vertices[input[t * 3]].position.data();
+            const float *p1 = vertices[input[t * 3 + 1]].position.data();
+            const float *p2 = vertices[input[t * 3 + 2]].position.data();
+            const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                                e1[2] * e2[0] - e1[0] * e2[2],
+                                e1[0] * e2[1] - e1[1] * e2[0]};
+            const float area =
+                std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int i = 0; i < 3; i++)
+            {
+                centroid[i] += (p0[i] + p1[i] + p2[i]) * (area / 3.0f);
+                normal[i] += n[i];
+            }
+            clusterArea += area;
+        }
+        for (int i = 0; i < 3; i++)
+            meshCentroid[i] += centroid[i];
+        meshArea += clusterArea;
+
+        const float invArea = clusterArea > 0.0f ? 1.0f / clusterArea : 0.0f;
+        for (int i = 0; i < 3; i++)
+            centroid[i] *= invArea;
+    }
+    const float invMeshArea = meshArea > 0.0f ? 1.0f / meshArea : 0.0f;
+    for (float &m : meshCentroid)
+        m *= invMeshArea;
+
+    // Clusters facing away from the mesh center are likely to occlude the
+    // others, so they are drawn first.
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        const float *centroid = &clusterData[c * 6];
+        const float *normal = &clusterData[c * 6 + 3];
+        const float length = std::sqrt(normal[0] * normal[0] +
+                                       normal[1] * normal[1] +
+                                       normal[2] * normal[2]);
+        const float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+        float key = 0.0f;
+        for (int i = 0; i < 3; i++)
+            key += (centroid[i] - meshCentroid[i]) * normal[i] * invLength;
+        sortKeys[c] = key;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<INDEX_TYPE> output;
+    output.reserve(triangleCount * 3);
+    for (const uint32_t c : order)
+        output.insert(output.end(), input.begin() + clusters[c] * 3,
+                      input.begin() + clusters[c + 1] * 3);
+    *indices = std::move(output);
+}
+
+void kirana::scene::mesh_optimizer::optimizeVertexFetch(
+    std::vector<Vertex> *vertices, std::vector<INDEX_TYPE> *indices)
+{
+    constexpr INDEX_TYPE UNUSED = std::numeric_limits<INDEX_TYPE>::max();
+    std::vector<INDEX_TYPE> remap(vertices->size(), UNUSED);
+    std::vector<Vertex> output;
+    output.reserve(vertices->size());
+    for (INDEX_TYPE &index : *indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = static_cast<INDEX_TYPE>(output.size());
+            output.push_back((*vertices)[index]);
+        }
+        index = remap[index];
+    }
+    *vertices = std::move(output);
+}
+
+kirana::scene::mesh_optimizer::VertexCacheStatistics kirana::scene::
+    mesh_optimizer::analyzeVertexCache(
+        utils::ArrayView<const INDEX_TYPE> indices, size_t vertexCount,
+        uint32_t cacheSize)
+{
+    VertexCacheStatistics statistics;
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return statistics;
+
+    VertexCacheSimulator cache(vertexCount, cacheSize);
+    size_t misses = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+        misses += cache.addTriangle(&indices[t * 3]);
+
+    statistics.acmr =
+        static_cast<float>(misses) / static_cast<float>(triangleCount);
+    statistics.atvr =
+        static_cast<float>(misses) / static_cast<float>(vertexCount);
+    return statistics;
+}
+
+std::vector<kirana::scene::INDEX_TYPE> kirana::scene::mesh_optimizer::simplify(
+    utils::ArrayView<const INDEX_TYPE> indices,
+    utils::ArrayView<const Vertex> vertices, size_t targetIndexCount,
+    float targetError, float *resultError)
+{
+    if (resultError)
+        *resultError = 0.0f;
+    const size_t vertexCount = vertices.size();
+    std::vector<INDEX_TYPE> result(indices.begin(), indices.end());
+    if (result.size() <= targetIndexCount || vertexCount == 0)
+        return result;
+
+    // Weld the vertices. Vertices with the same position share a position
+    // index. Vertices which are identical share a wedge index, the others are
+    // on an attribute seam (Eg: UV seams and hard edges).
+    std::vector<INDEX_TYPE> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](INDEX_TYPE v1, INDEX_TYPE v2) {
+        const int comparison = compareVertices(vertices[v1], vertices[v2]);
+        return comparison < 0 || (comparison == 0 && v1 < v2);
+    });
+    std::vector<INDEX_TYPE> positionIndex(vertexCount);
+    std::vector<INDEX_TYPE> wedgeIndex(vertexCount);
+    std::vector<uint8_t> isSeam(vertexCount, 0);
+    for (size_t start = 0; start < vertexCount;)
+    {
+        const float *position = vertices[order[start]].position.data();
+        size_t end = start + 1;
+        while (end < vertexCount &&
+               std::memcmp(vertices[order[end]].position.data(), position,
+                           3 * sizeof(float)) == 0)
+            end++;
+
+        bool seam = false;
+        INDEX_TYPE wedge = order[start];
+        for (size_t i = start; i < end; i++)
+        {
+            if (compareVertices(vertices[order[i]], vertices[wedge]) != 0)
+            {
+                wedge = order[i];
+                seam = true;
+            }
+            positionIndex[order[i]] = order[start];
+            wedgeIndex[order[i]] = wedge;
+        }
+        for (size_t i = start; i < end; i++)
+            isSeam[order[i]] = seam;
+        start = end;
+    }
+    for (INDEX_TYPE &index : result)
+        index = wedgeIndex[index];
+
+    // Lock the vertices on seams, borders and non-manifold edges. An edge is
+    // on a border if the opposite (directed) edge doesn't exist.
+    std::vector<uint8_t> isLocked(isSeam);
+    std::vector<uint64_t> edges;
+    edges.reserve(result.size());
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        for (size_t e = 0; e < 3; e++)
+        {
+            const uint64_t v1 = positionIndex[result[i + e]];
+            const uint64_t v2 = positionIndex[result[i + (e + 1) % 3]];
+            edges.push_back((v1 << 32) | v2);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        const auto v1 = static_cast<INDEX_TYPE>(edges[i] >> 32);
+        const auto v2 = static_cast<INDEX_TYPE>(edges[i] & 0xFFFFFFFFu);
+        const bool isDuplicate = (i > 0 && edges[i - 1] == edges[i]) ||
+                                 (i + 1 < edges.size() &&
+                                  edges[i + 1] == edges[i]);
+        const uint64_t opposite =
+            (static_cast<uint64_t>(v2) << 32) | static_cast<uint64_t>(v1);
+        if (isDuplicate ||
+            !std::binary_search(edges.begin(), edges.end(), opposite))
+        {
+            isLocked[v1] = 1;
+            isLocked[v2] = 1;
+        }
+    }
+
+    // Area weighted plane quadrics of the triangles around every position.
+    std::vector<Quadric> quadrics(vertexCount);
+    float boundsMin[3] = {std::numeric_limits<float>::max(),
+                          std::numeric_limits<float>::max(),
+                          std::numeric_limits<float>::max()};
+    float boundsMax[3] = {std::numeric_limits<float>::lowest(),
+                          std::numeric_limits<float>::lowest(),
+                          std::numeric_limits<float>::lowest()};
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const float *p[3] = {vertices[result[i]].position.data(),
+                             vertices[result[i + 1]].position.data(),
+                             vertices[result[i + 2]].position.data()};
+        float normal[3];
+        getTriangleNormal(p[0], p[1], p[2], normal);
+        const double length = std::sqrt(
+            static_cast<double>(normal[0]) * normal[0] +
+            static_cast<double>(normal[1]) * normal[1] +
+            static_cast<double>(normal[2]) * normal[2]);
+        for (int k = 0; k < 3; k++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], p[k][axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], p[k][axis]);
+            }
+        }
+        if (length == 0.0)
+            continue;
+        const double n[3] = {normal[0] / length, normal[1] / length,
+                             normal[2] / length};
+        const double d = -(n[0] * p[0][0] + n[1] * p[0][1] + n[2] * p[0][2]);
+        for (int k = 0; k < 3; k++)
+            quadrics[positionIndex[result[i + k]]].addPlane(n, d,
+                                                            length * 0.5);
+    }
+    const double extent =
+        std::max({boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1],
+                  boundsMax[2] - boundsMin[2], 0.0f});
+    const double errorLimit = (targetError * extent) * (targetError * extent);
+
+    // Collapse the edges with the smallest error in passes. Every vertex takes
+    // part in at most one collapse per pass, so the triangles around a
+    // collapse are up to date when it's validated. Unlocked vertices are never
+    // on a seam, so their position and wedge indices are the same and the
+    // collapsed vertex can be replaced by the target in every triangle.
+    struct Collapse
+    {
+        double error;
+        INDEX_TYPE from;
+        INDEX_TYPE to;
+    };
+    std::vector<Collapse> collapses;
+    std::vector<INDEX_TYPE> remap(vertexCount);
+    std::iota(remap.begin(), remap.end(), 0);
+    std::vector<uint8_t> isCollapsed(vertexCount);
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    const size_t targetTriangleCount = targetIndexCount / 3;
+    size_t triangleCount = result.size() / 3;
+    double maxError = 0.0;
+    while (triangleCount > targetTriangleCount)
+    {
+        // Triangles around every vertex.
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (const INDEX_TYPE index : result)
+            adjacencyOffsets[index + 1]++;
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(),
+                         adjacencyOffsets.begin());
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(),
+                                       adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++)
+                adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (size_t e = 0; e < 3; e++)
+            {
+                const INDEX_TYPE v1 = result[i + e];
+                const INDEX_TYPE v2 = result[i + (e + 1) % 3];
+                for (const auto &[from, to] : {std::make_pair(v1, v2),
+                                               std::make_pair(v2, v1)})
+                {
+                    if (from == to || isLocked[from] || isSeam[to])
+                        continue;
+                    Quadric quadric = quadrics[from];
+                    quadric.add(quadrics[to]);
+                    collapses.push_back(Collapse{
+                        quadric.getError(vertices[to].position.data()), from,
+                        to});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &c1, const Collapse &c2) {
+                      return c1.error < c2.error;
+                  });
+
+        std::fill(isCollapsed.begin(), isCollapsed.end(), 0);
+        size_t collapseCount = 0;
+        for (const Collapse &collapse : collapses)
+        {
+            if (collapse.error > errorLimit ||
+                triangleCount <= targetTriangleCount)
+                break;
+            if (isCollapsed[collapse.from] || isCollapsed[collapse.to])
+                continue;
+
+            // Reject collapses which flip or degenerate the triangles which
+            // are kept.
+            bool isValid = true;
+            size_t removedCount = 0;
+            for (uint32_t a = adjacencyOffsets[collapse.from];
+                 a < adjacencyOffsets[collapse.from + 1] && isValid; a++)
+            {
+                const size_t t = adjacency[a] * 3;
+                INDEX_TYPE triangle[3] = {remap[result[t]],
+                                          remap[result[t + 1]],
+                                          remap[result[t + 2]]};
+                if (triangle[0] == triangle[1] || triangle[1] == triangle[2] ||
+                    triangle[0] == triangle[2])
+                    continue;
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to ||
+                    triangle[2] == collapse.to)
+                {
+                    removedCount++;
+                    continue;
+                }
+                float before[3], after[3];
+                getTriangleNormal(vertices[triangle[0]].position.data(),
+                                  vertices[triangle[1]].position.data(),
+                                  vertices[triangle[2]].position.data(),
+                                  before);
+                for (INDEX_TYPE &v : triangle)
+                    v = v == collapse.from ? collapse.to : v;
+                getTriangleNormal(vertices[triangle[0]].position.data(),
+                                  vertices[triangle[1]].position.data(),
+                                  vertices[triangle[2]].position.data(),
+                                  after);
+                const float dot = before[0] * after[0] +
+                                  before[1] * after[1] + before[2] * after[2];
+                const float lengths =
+                    std::sqrt((before[0] * before[0] + before[1] * before[1] +
+                               before[2] * before[2]) *
+                              (after[0] * after[0] + after[1] * after[1] +
+                               after[2] * after[2]));
+                isValid = lengths > 0.0f && dot >= 0.25f * lengths;
+            }
+            if (!isValid)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            isCollapsed[collapse.from] = 1;
+            isCollapsed[collapse.to] = 1;
+            triangleCount -= std::min(removedCount, triangleCount);
+            maxError = std::max(maxError, collapse.error);
+            collapseCount++;
+        }
+        if (collapseCount == 0)
+            break;
+
+        // Apply the collapses and remove the degenerate triangles.
+        size_t writeIndex = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            const INDEX_TYPE v0 = remap[result[i]];
+            const INDEX_TYPE v1 = remap[result[i + 1]];
+            const INDEX_TYPE v2 = remap[result[i + 2]];
+            if (v0 == v1 || v1 == v2 || v0 == v2)
+                continue;
+            result[writeIndex++] = v0;
+            result[writeIndex++] = v1;
+            result[writeIndex++] = v2;
+        }
+        result.resize(writeIndex);
+        triangleCount = result.size() / 3;
+    }
+
+    if (resultError && extent > 0.0)
+        *resultError = static_cast<float>(std::sqrt(maxError) / extent);
+    return result;
+}
+
+std::vector<kirana::scene::Meshlet> kirana::scene::mesh_optimizer::
+    buildMeshlets(utils::ArrayView<const INDEX_TYPE> indices,
+                  utils::ArrayView<const Vertex> vertices,
+                  uint32_t maxVertices, uint32_t maxTriangles)
+{
+    std::vector<Meshlet> meshlets;
+    if (indices.size() < 3)
+        return meshlets;
+
+    // Vertices are marked with the index of the last meshlet using them, so
+    // the unique vertices are counted without clearing anything.
+    constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> vertexMeshlet(vertices.size(), UNUSED);
+    uint32_t meshletIndex = 0;
+    Meshlet meshlet;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const INDEX_TYPE *triangle = &indices[i];
+        uint32_t newVertexCount = 0;
+        for (size_t k = 0; k < 3; k++)
+        {
+            const bool isRepeated = (k > 0 && triangle[0] == triangle[k]) ||
+                                    (k > 1 && triangle[1] == triangle[k]);
+            if (vertexMeshlet[triangle[k]] != meshletIndex && !isRepeated)
+                newVertexCount++;
+        }
+        if (meshlet.indexCount > 0 &&
+            (meshlet.vertexCount + newVertexCount > maxVertices ||
+             meshlet.indexCount / 3 >= maxTriangles))
+        {
+            computeMeshletBounds(vertices, &indices[meshlet.firstIndex],
+                                 &meshlet);
+            meshlets.emplace_back(meshlet);
+            meshlet = Meshlet{};
+            meshlet.firstIndex = static_cast<uint32_t>(i);
+            meshletIndex++;
+        }
+        for (size_t k = 0; k < 3; k++)
+        {
+            if (vertexMeshlet[triangle[k]] != meshletIndex)
+            {
+                vertexMeshlet[triangle[k]] = meshletIndex;
+                meshlet.vertexCount++;
+            }
+        }
+        meshlet.indexCount += 3;
+    }
+    computeMeshletBounds(vertices, &indices[meshlet.firstIndex], &meshlet);
+    meshlets.emplace_back(meshlet);
+    return meshlets;
+}
@@ -0,0 +1,104 @@
+#ifndef KIRANA_SCENE_MESH_OPTIMIZER_HPP
+#define KIRANA_SCENE_MESH_OPTIMIZER_HPP
+
+#include "scene_types.hpp"
+
+#include <array_view.hpp>
+#include <vector>
+
+/**
+ * Reorders the triangles and vertices of indexed triangle meshes for faster
+ * rasterization. The passes are meant to run in this order: vertex cache,
+ * overdraw and then vertex fetch. Also simplifies meshes to generate their
+ * levels of detail and splits them into clusters (meshlets).
+ */
+namespace kirana::scene::mesh_optimizer
+{
+/// Post-transform vertex cache efficiency of an index buffer.
+struct VertexCacheStatistics
+{
+    /// Average cache miss ratio: transformed vertices per triangle (0.5 - 3).
+    float acmr = 0.0f;
+    /// Average transform to vertex ratio: transformed vertices per vertex (1+).
+    float atvr = 0.0f;
+};
+
+/**
+ * Reorders the triangles to reduce post-transform vertex cache misses, using
+ * Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+ * @param indices Triangle list indices. Reordered in place.
+ * @param vertexCount Number of vertices referenced by the indices.
+ */
+void optimizeVertexCache(std::vector<INDEX_TYPE> *indices, size_t vertexCount);
+
+/**
+ * Reorders clusters of triangles so that the triangles facing outwards are
+ * drawn first, which reduces overdraw from any view direction. Clusters are
+ * split at vertex cache boundaries, so the vertex cache efficiency is kept
+ * within the given threshold. Expects indices optimized by
+ * optimizeVertexCache().
+ * @param indices Triangle list indices. Reordered in place.
+ * @param vertices Vertices referenced by the indices.
+ * @param threshold Allowed ACMR increase per cluster (Eg: 1.05 = 5%).
+ */
+void optimizeOverdraw(std::vector<INDEX_TYPE> *indices,
+                      utils::ArrayView<const Vertex> vertices,
+                      float threshold = 1.05f);
+
+/**
+ * Reorders the vertices in the order they are first used by the indices, so
+ * vertex fetches are sequential. Unreferenced vertices are removed.
+ * @param vertices The vertices to reorder.
+ * @param indices Triangle list indices. Remapped to the new vertex order.
+ */
+void optimizeVertexFetch(std::vector<Vertex> *vertices,
+                         std::vector<INDEX_TYPE> *indices);
+
+/**
+ * Simplifies the mesh by collapsing edges in the order of their quadric error
+ * (Garland and Heckbert, "Surface Simplification Using Quadric Error
+ * Metrics"). Vertices are only moved onto other existing vertices, so the
+ * returned indices reference the same vertex data. Vertices on borders and
+ * attribute seams are kept in place.
+ * @param indices Triangle list indices.
+ * @param vertices Vertices referenced by the indices.
+ * @param targetIndexCount The number of indices to reduce the mesh to.
+ * @param targetError The maximum error relative to the mesh extents
+ * (Eg: 0.01 = 1%). The simplification stops early when it's reached.
+ * @param resultError The error of the simplified mesh relative to the mesh
+ * extents. Optional.
+ * @return The indices of the simplified mesh.
+ */
+std::vector<INDEX_TYPE> simplify(utils::ArrayView<const INDEX_TYPE> indices,
+                                 utils::ArrayView<const Vertex> vertices,
+                                 size_t targetIndexCount, float targetError,
+                                 float *resultError = nullptr);
+
+/**
+ * Splits the mesh into clusters of consecutive triangles and computes their
+ * bounding boxes, bounding spheres and normal cones. The index order is kept,
+ * so it should be optimized for the vertex cache first to get compact
+ * clusters.
+ * @param indices Triangle list indices.
+ * @param vertices Vertices referenced by the indices.
+ * @param maxVertices Maximum number of unique vertices per cluster.
+ * @param maxTriangles Maximum number of triangles per cluster.
+ * @return The clusters in index order.
+ */
+std::vector<Meshlet> buildMeshlets(utils::ArrayView<const INDEX_TYPE> indices,
+                                   utils::ArrayView<const Vertex> vertices,
+                                   uint32_t maxVertices,
+                                   uint32_t maxTriangles);
+
+/**
+ * Simulates a FIFO post-transform vertex cache over the given indices.
+ * @param indices Triangle list indices.
+ * @param vertexCount Number of vertices referenced by the indices.
+ * @param cacheSize Number of vertices in the simulated cache.
+ */
+VertexCacheStatistics analyzeVertexCache(
+    utils::ArrayView<const INDEX_TYPE> indices, size_t vertexCount,
+    uint32_t cacheSize = 16);
+} // namespace kirana::scene::mesh_optimizer
+
+#endif // KIRANA_SCENE_MESH_OPTIMIZER_HPP
@@ -22,18 +22,32 @@ kirana::scene::Object::Object(std::string name, std::shared_ptr<Mesh> mesh,
                               const TransformHierarchy &m_transform,
                               const math::Bounds3 &meshBounds)
     : m_name{std::move(name)}, m_meshes{std::move(mesh)},
-      m_transform{std::make_unique<TransformHierarchy>(m_transform)},
-      m_objectBounds{meshBounds}, m_hierarchyBounds{m_objectBounds}
+      m_objectBounds{meshBounds}, m_hierarchyBounds{m_objectBounds},
+      m_transform{m_transform}
 {
 }
 
 kirana::scene::Object::Object(const aiNode *node,
                               std::vector<std::shared_ptr<Mesh>> meshes,
                               const math::Bounds3 &objectBounds,
-                              math::TransformHierarchy *parent)
+                              math::TransformHierarchy *parent,
+                              std::shared_ptr<math::TransformStore> store)
     : m_name{node->mName.C_Str()}, m_meshes{std::move(meshes)},
       m_objectBounds{objectBounds}, m_hierarchyBounds{m_objectBounds},
-      m_transform{std::make_unique<TransformHierarchy>(getMatrixFromNode(node), parent)}
+      m_transform{getMatrixFromNode(node), parent, std::move(store)}
+{
+}
+
+kirana::scene::Object::Object(std::string name,
+                              std::vector<std::shared_ptr<Mesh>> meshes,
+                              const math::Matrix4x4 &localMatrix,
+                              const math::Bounds3 &objectBounds,
+                              const math::Bounds3 &hierarchyBounds,
+                              math::TransformHierarchy *parent,
+                              std::shared_ptr<math::TransformStore> store)
+    : m_name{std::move(name)}, m_meshes{std::move(meshes)},
+      m_objectBounds{objectBounds}, m_hierarchyBounds{hierarchyBounds},
+      m_transform{localMatrix, parent, std::move(store)}
 {
 }
 
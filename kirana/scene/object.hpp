@@ -14,16 +14,18 @@ namespace kirana::scene
 {
 class Mesh;
 class Scene;
+class SceneCache;
 class Object
 {
     friend class Scene;
+    friend class SceneCache;
 
   protected:
     std::string m_name;
     std::vector<std::shared_ptr<Mesh>> m_meshes;
     math::Bounds3 m_objectBounds;
     math::Bounds3 m_hierarchyBounds;
-    std::unique_ptr<math::TransformHierarchy> m_transform = nullptr;
+    math::TransformHierarchy m_transform;
 
     static math::Matrix4x4 getMatrixFromNode(const aiNode *node);
 
@@ -35,20 +37,27 @@ class Object
   public:
     Object()
         : m_name{"Object"}, m_meshes{},
-          m_transform{std::make_unique<math::TransformHierarchy>()}, m_objectBounds{},
-          m_hierarchyBounds{} {};
+          m_objectBounds{}, m_hierarchyBounds{}, m_transform{} {};
     explicit Object(std::string name, std::shared_ptr<Mesh> mesh,
                     const math::TransformHierarchy &m_transform,
                     const math::Bounds3 &meshBounds);
     explicit Object(const aiNode *node,
                     std::vector<std::shared_ptr<Mesh>> meshes,
                     const math::Bounds3 &objectBounds,
-                    math::TransformHierarchy *parent = nullptr);
+                    math::TransformHierarchy *parent = nullptr,
+                    std::shared_ptr<math::TransformStore> store = nullptr);
+    explicit Object(std::string name,
+                    std::vector<std::shared_ptr<Mesh>> meshes,
+                    const math::Matrix4x4 &localMatrix,
+                    const math::Bounds3 &objectBounds,
+                    const math::Bounds3 &hierarchyBounds,
+                    math::TransformHierarchy *parent = nullptr,
+                    std::shared_ptr<math::TransformStore> store = nullptr);
     virtual ~Object() = default;
 
     Object(const Object &object) = delete;
 
-    math::TransformHierarchy *const transform = m_transform.get();
+    math::TransformHierarchy *const transform = &m_transform;
 
     [[nodiscard]] inline const std::string &getName() const
     {
@@ -64,13 +73,13 @@ class Object
     /// the object's position.
     [[nodiscard]] inline math::Bounds3 getObjectBounds() const
     {
-        return m_transform->transformBounds(m_objectBounds);
+        return m_transform.transformBounds(m_objectBounds);
     }
     /// Returns the world-space bounding-box of the entire hierarchy of this
     /// object.
     [[nodiscard]] inline math::Bounds3 getHierarchyBounds() const
     {
-        return m_transform->transformBounds(m_hierarchyBounds);
+        return m_transform.transformBounds(m_hierarchyBounds);
     }
 
 
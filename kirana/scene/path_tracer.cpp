@@ -0,0 +1,536 @@
+#include "path_tracer.hpp"
+
+#include "camera.hpp"
+#include "image_writer.hpp"
+#include "material.hpp"
+#include "mesh.hpp"
+#include "object.hpp"
+#include "scene.hpp"
+#include "scene_bvh.hpp"
+#include "scene_types.hpp"
+
+#include <math_utils.hpp>
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using kirana::math::Vector3;
+using kirana::math::Vector4;
+
+namespace
+{
+// Constants of shaders/raytrace/common/globals.glsl.
+constexpr float PI = static_cast<float>(kirana::math::PI);
+constexpr float TWO_PI = 2.0f * PI;
+constexpr float ONE_BY_PI = 1.0f / PI;
+constexpr float EPSILON = 0.0001f;
+// Gamma of linearTosRGB() in tonemapping.glsl.
+constexpr float GAMMA = 2.2f;
+// Colors of the sky at the bottom and the top of the image, which the
+// principled shading uses for rays that miss the scene.
+const Vector3 SKY_BOTTOM_COLOR{1.0f, 1.0f, 1.0f};
+const Vector3 SKY_TOP_COLOR{0.0f, 0.47f, 0.99f};
+
+// Random numbers of random.glsl. The seed of each pixel is hashed with the
+// Tiny Encryption Algorithm, and the numbers are generated with PCG.
+uint32_t seed(uint32_t value0, uint32_t value1)
+{
+    uint32_t v0 = value0;
+    uint32_t v1 = value1;
+    uint32_t s0 = 0;
+    for (int n = 0; n < 16; n++)
+    {
+        s0 += 0x9e3779b9u;
+        v0 += ((v1 << 4) + 0xa341316cu) ^ (v1 + s0) ^ ((v1 >> 5) + 0xc8013ea4u);
+        v1 += ((v0 << 4) + 0xad90777du) ^ (v0 + s0) ^ ((v0 >> 5) + 0x7e95761eu);
+    }
+    return v0;
+}
+
+inline float random(uint32_t *state)
+{
+    const uint32_t previous = *state * 747796405u + 2891336453u;
+    const uint32_t word =
+        ((previous >> ((previous >> 28u) + 4u)) ^ previous) * 277803737u;
+    *state = previous;
+    // The 23 high bits of the number as the mantissa of a float in [1, 2).
+    const uint32_t bits = 0x3f800000u | (((word >> 22u) ^ word) >> 9u);
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value - 1.0f;
+}
+
+inline Vector3 multiply(const Vector3 &lhs, const Vector3 &rhs)
+{
+    return Vector3(lhs[0] * rhs[0], lhs[1] * rhs[1], lhs[2] * rhs[2]);
+}
+
+inline float saturate(float value)
+{
+    return kirana::math::clampf(value, 0.0f, 1.0f);
+}
+
+/// Orthonormal basis of the normal, in the order tangent, binormal and
+/// normal, as getCoordinateFrame_Duff() in utils.glsl.
+void getCoordinateFrame(const Vector3 &normal, Vector3 frame[3])
+{
+    const float sign = normal[2] >= 0.0f ? 1.0f : -1.0f;
+    const float a = -1.0f / (sign + normal[2]);
+    const float b = normal[0] * normal[1] * a;
+    frame[0] = Vector3(b, sign + normal[1] * normal[1] * a, -normal[1]);
+    frame[1] = Vector3(1.0f + sign * normal[0] * normal[0] * a, sign * b,
+                       -sign * normal[0]);
+    frame[2] = normal;
+}
+
+inline Vector3 toFrame(const Vector3 frame[3], float x, float y, float z)
+{
+    return frame[0] * x + frame[1] * y + frame[2] * z;
+}
+
+/// Moves the origin of a ray off the surface it starts from, by a number of
+/// ULPs which grows with the distance from the origin of the world, as
+/// offsetRay() in utils.glsl.
+Vector3 offsetRay(const Vector3 &position, const Vector3 &normal)
+{
+    constexpr float INT_SCALE = 256.0f;
+    constexpr float FLOAT_SCALE = 1.0f / 65536.0f;
+    constexpr float ORIGIN = 1.0f / 32.0f;
+    Vector3 offsetPosition;
+    for (int i = 0; i < 3; i++)
+    {
+        const float p = position[i];
+        if (std::fabs(p) < ORIGIN)
+        {
+            offsetPosition[i] = p + FLOAT_SCALE * normal[i];
+            continue;
+        }
+        const auto offset = static_cast<int32_t>(INT_SCALE * normal[i]);
+        int32_t bits;
+        std::memcpy(&bits, &p, sizeof(float));
+        bits += p < 0.0f ? -offset : offset;
+        std::memcpy(&offsetPosition[i], &bits, sizeof(float));
+    }
+    return offsetPosition;
+}
+
+/// @return A direction with a cosine-weighted distribution around the normal,
+/// and its pdf, as cosineSampleHemisphere() in sampling.glsl.
+Vector3 cosineSampleHemisphere(float random0, float random1,
+                               const Vector3 frame[3], float *pdf)
+{
+    const float r = std::sqrt(random0);
+    const float theta = TWO_PI * random1;
+    const float x = r * std::cos(theta);
+    const float y = r * std::sin(theta);
+    const float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+    const Vector3 direction = toFrame(frame, x, y, z);
+    *pdf = saturate(Vector3::dot(frame[2], direction)) * ONE_BY_PI;
+    return direction;
+}
+
+// The GGX specular lobe of bxdf_principled.glsl. The roughness is squared
+// once more by each function, as in the shader.
+float NDF_GGX(float NoH, float roughness)
+{
+    const float a2 = roughness * roughness;
+    const float denominator = NoH * NoH * (a2 - 1.0f) + 1.0f;
+    return a2 / (PI * denominator * denominator);
+}
+
+Vector3 sampleNDF_GGX(float roughness, float random0, float random1,
+                      const Vector3 frame[3])
+{
+    const float a2 = roughness * roughness;
+    const float phi = TWO_PI * random0;
+    const float cosTheta =
+        std::sqrt((1.0f - random1) / (1.0f + (a2 - 1.0f) * random1));
+    const float sinTheta = saturate(std::sqrt(1.0f - cosTheta * cosTheta));
+    return toFrame(frame, sinTheta * std::cos(phi), sinTheta * std::sin(phi),
+                   cosTheta);
+}
+
+float V_SmithGGXCorrelated(float NoV, float NoL, float roughness)
+{
+    const float a2 = roughness * roughness;
+    const float vv = NoL * std::sqrt(NoV * (-NoV * a2 + NoV) + a2);
+    const float vl = NoV * std::sqrt(NoL * (-NoL * a2 + NoL) + a2);
+    return 0.5f / (vv + vl);
+}
+
+Vector3 F_Schlick(float LoH, const Vector3 &f0, float f90)
+{
+    return f0 + (Vector3(f90, f90, f90) - f0) * std::pow(1.0f - LoH, 5.0f);
+}
+} // namespace
+
+struct kirana::scene::PathTracer::TraceContext
+{
+    const SceneBVH &bvh;
+    const WorldData &world;
+    math::Matrix4x4 inverseViewProjection;
+    Vector3 cameraPosition;
+    std::array<uint32_t, 2> resolution;
+    uint32_t maxDepth;
+
+    // The lobes of the principled BxDF. The pdf is only written out if the
+    // light direction is above the surface.
+    static Vector3 evaluateDiffuse(const PrincipledData &material,
+                                   const Vector3 &lightDir,
+                                   const Vector3 &normal, float *pdf)
+    {
+        if (Vector3::dot(normal, lightDir) < 0.0f)
+            return Vector3::ZERO;
+        *pdf = saturate(Vector3::dot(normal, lightDir)) * ONE_BY_PI;
+        return material.color * ((1.0f - material.metallic) * ONE_BY_PI);
+    }
+
+    static Vector3 evaluateSpecular(const PrincipledData &material,
+                                    const Vector3 &viewDir,
+                                    const Vector3 &lightDir,
+                                    const Vector3 &normal,
+                                    const Vector3 &halfVector, float *pdf)
+    {
+        if (Vector3::dot(normal, lightDir) < 0.0f)
+            return Vector3::ZERO;
+        const float roughness =
+            std::max(material.roughness * material.roughness, 0.001f);
+        const float dielectric = 0.16f * material.specular *
+                                 material.specular * (1.0f - material.metallic);
+        const Vector3 f0 = Vector3(dielectric, dielectric, dielectric) +
+                           material.color * material.metallic;
+        const float NoH = saturate(Vector3::dot(normal, halfVector));
+        const float NoV = saturate(Vector3::dot(normal, viewDir));
+        const float NoL = saturate(Vector3::dot(normal, lightDir));
+        const float LoH = saturate(Vector3::dot(lightDir, halfVector));
+
+        const float D = NDF_GGX(NoH, roughness);
+        *pdf = D * NoH / (4.0f * LoH);
+        return F_Schlick(LoH, f0, 1.0f) *
+               (V_SmithGGXCorrelated(NoV, NoL, roughness) * D);
+    }
+
+    /// Evaluates a lobe picked at random, as evaluateBXDF() in
+    /// bxdf_principled.glsl.
+    static Vector3 evaluateBXDF(const PrincipledData &material,
+                                const Vector3 &viewDir, const Vector3 &lightDir,
+                                const Vector3 &normal, uint32_t *seed)
+    {
+        const float diffuseRatio = 0.5f * (1.0f - material.metallic);
+        float pdf = 0.0f;
+        if (random(seed) < diffuseRatio)
+            return evaluateDiffuse(material, lightDir, normal, &pdf);
+        Vector3 halfVector = Vector3::normalize(lightDir + viewDir);
+        if (Vector3::dot(normal, halfVector) < 0.0f)
+            halfVector = -halfVector;
+        return evaluateSpecular(material, viewDir, lightDir, normal,
+                                halfVector, &pdf);
+    }
+
+    /// Samples a light direction from a lobe picked at random, as
+    /// sampleBXDF() in bxdf_principled.glsl.
+    static Vector3 sampleBXDF(const PrincipledData &material,
+                              const Vector3 &viewDir, const Vector3 frame[3],
+                              uint32_t *seed, Vector3 *lightDir, float *pdf)
+    {
+        const float diffuseRatio = 0.5f * (1.0f - material.metallic);
+        *pdf = 0.0f;
+        if (random(seed) < diffuseRatio)
+        {
+            const float random0 = random(seed);
+            const float random1 = random(seed);
+            *lightDir = cosineSampleHemisphere(random0, random1, frame, pdf);
+            const Vector3 f =
+                evaluateDiffuse(material, *lightDir, frame[2], pdf);
+            *pdf *= diffuseRatio;
+            return f;
+        }
+        const float roughness =
+            std::max(material.roughness * material.roughness, 0.001f);
+        const float random0 = random(seed);
+        const float random1 = random(seed);
+        const Vector3 halfVector =
+            sampleNDF_GGX(roughness, random0, random1, frame);
+        *lightDir =
+            Vector3::normalize(Vector3::reflect(-viewDir, halfVector));
+        const Vector3 f = evaluateSpecular(material, viewDir, *lightDir,
+                                           frame[2], halfVector, pdf);
+        *pdf *= 1.0f - diffuseRatio;
+        return f;
+    }
+};
+
+bool kirana::scene::PathTracer::render(Scene &scene, const Camera &camera,
+                                       const WorldData &world,
+                                       const Settings &settings)
+{
+    if (!scene.isInitialized())
+        return false;
+    scene.updateTransforms();
+    return render(scene.getBVH(), camera, world, settings);
+}
+
+bool kirana::scene::PathTracer::render(const SceneBVH &bvh,
+                                       const Camera &camera,
+                                       const WorldData &world,
+                                       const Settings &settings)
+{
+    if (settings.resolution[0] == 0 || settings.resolution[1] == 0 ||
+        settings.sampleCount == 0 || settings.tileSize == 0)
+        return false;
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    setMaterials(bvh);
+    m_resolution = settings.resolution;
+    m_pixels.assign(static_cast<size_t>(m_resolution[0]) * m_resolution[1],
+                    Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    const TraceContext context{
+        bvh,
+        world,
+        math::Matrix4x4::inverse(camera.getViewProjectionMatrix()),
+        camera.getTransform().getPosition(),
+        m_resolution,
+        settings.maxDepth};
+    const uint32_t tileSize = settings.tileSize;
+    const uint32_t tileCountX = (m_resolution[0] + tileSize - 1) / tileSize;
+    const uint32_t tileCountY = (m_resolution[1] + tileSize - 1) / tileSize;
+    std::atomic<uint64_t> rayCount{0};
+    utils::ThreadPool::get().parallelFor(
+        static_cast<size_t>(tileCountX) * tileCountY, [&](size_t tile) {
+            const uint32_t firstX = static_cast<uint32_t>(tile % tileCountX) *
+                                    tileSize;
+            const uint32_t firstY = static_cast<uint32_t>(tile / tileCountX) *
+                                    tileSize;
+            const uint32_t lastX = std::min(firstX + tileSize, m_resolution[0]);
+            const uint32_t lastY = std::min(firstY + tileSize, m_resolution[1]);
+            uint64_t tileRayCount = 0;
+            for (uint32_t y = firstY; y < lastY; y++)
+            {
+                for (uint32_t x = firstX; x < lastX; x++)
+                {
+                    // Seeded as in Principled.rgen, and shared by the samples
+                    // of the pixel.
+                    uint32_t pixelSeed = seed(x + x * y, settings.frameIndex);
+                    Vector3 color;
+                    for (uint32_t s = 0; s < settings.sampleCount; s++)
+                        color += samplePixel(context, x, y, &pixelSeed,
+                                             &tileRayCount);
+                    color /= static_cast<float>(settings.sampleCount);
+                    m_pixels[static_cast<size_t>(y) * m_resolution[0] + x] =
+                        Vector4(color, 1.0f);
+                }
+            }
+            rayCount += tileRayCount;
+        });
+
+    m_lastRenderStats.rayCount = rayCount;
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::high_resolution_clock::now() - startTime;
+    m_lastRenderStats.time = duration.count();
+    return true;
+}
+
+bool kirana::scene::PathTracer::writeEXR(const std::string &path) const
+{
+    if (m_pixels.empty())
+        return false;
+    std::vector<float> pixels(m_pixels.size() * 4);
+    for (size_t i = 0; i < m_pixels.size(); i++)
+        std::memcpy(&pixels[i * 4], m_pixels[i].data(), sizeof(float) * 4);
+    return image_writer::writeEXR(
+        path, pixels.data(),
+        {static_cast<int>(m_resolution[0]), static_cast<int>(m_resolution[1])},
+        4);
+}
+
+bool kirana::scene::PathTracer::writePNG(const std::string &path) const
+{
+    if (m_pixels.empty())
+        return false;
+    std::vector<uint8_t> pixels(m_pixels.size() * 4);
+    for (size_t i = 0; i < m_pixels.size(); i++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            const float value =
+                c < 3 ? std::pow(std::max(m_pixels[i][c], 0.0f), 1.0f / GAMMA)
+                      : m_pixels[i][c];
+            pixels[i * 4 + c] =
+                static_cast<uint8_t>(saturate(value) * 255.0f + 0.5f);
+        }
+    }
+    return image_writer::writePNG(
+        path, pixels.data(),
+        {static_cast<int>(m_resolution[0]), static_cast<int>(m_resolution[1])},
+        4);
+}
+
+void kirana::scene::PathTracer::setMaterials(const SceneBVH &bvh)
+{
+    // The parameters missing from a material, such as from a basic shaded
+    // one, keep the values of the default principled material.
+    m_materials.clear();
+    for (const Object *o : bvh.getObjects())
+    {
+        for (const auto &m : o->getMeshes())
+        {
+            const Material *material = m->getMaterial().get();
+            if (m_materials.find(material) != m_materials.end())
+                continue;
+            Vector4 color;
+            Vector4 emissiveColor;
+            float emissiveIntensity = 0.0f;
+            PrincipledData &data = m_materials[material];
+            const auto setParameter = [&](const MaterialParameter &p) {
+                if (const auto *value = std::any_cast<Vector4>(&p.value))
+                {
+                    if (p.id == "_BaseColor")
+                        color = *value;
+                    else if (p.id == "_EmissiveColor")
+                        emissiveColor = *value;
+                }
+                else if (const auto *value = std::any_cast<float>(&p.value))
+                {
+                    if (p.id == "_Metallic")
+                        data.metallic = *value;
+                    else if (p.id == "_Specular")
+                        data.specular = *value;
+                    else if (p.id == "_Roughness")
+                        data.roughness = *value;
+                    else if (p.id == "_EmissiveIntensity")
+                        emissiveIntensity = *value;
+                }
+            };
+            for (const auto &p : DEFAULT_PRINCIPLED_MATERIAL_PARAMETERS)
+                setParameter(p);
+            if (material != nullptr)
+            {
+                for (const auto &p : material->getParameters())
+                    setParameter(p);
+            }
+            data.color = static_cast<Vector3>(color);
+            data.emission =
+                static_cast<Vector3>(emissiveColor) * emissiveIntensity;
+        }
+    }
+}
+
+Vector3 kirana::scene::PathTracer::samplePixel(const TraceContext &context,
+                                               uint32_t x, uint32_t y,
+                                               uint32_t *seed,
+                                               uint64_t *rayCount) const
+{
+    Vector3 radiance;
+    Vector3 throughput(1.0f, 1.0f, 1.0f);
+
+    // A random point within the pixel, for anti-aliasing, on the far plane.
+    // The ray goes from the camera through it, as screenPositionToRay().
+    const float ndcX = (static_cast<float>(x) + random(seed)) /
+                           static_cast<float>(m_resolution[0]) * 2.0f -
+                       1.0f;
+    const float ndcY = (static_cast<float>(y) + random(seed)) /
+                           static_cast<float>(m_resolution[1]) * 2.0f -
+                       1.0f;
+    Vector4 farPoint =
+        context.inverseViewProjection * Vector4(ndcX, ndcY, 1.0f, 1.0f);
+    farPoint /= farPoint[3];
+    math::Ray ray(context.cameraPosition,
+                  Vector3::normalize(static_cast<Vector3>(farPoint) -
+                                     context.cameraPosition));
+    const Vector3 lightDir =
+        Vector3::normalize(-context.world.sunDirection);
+    const Vector3 lightColor =
+        static_cast<Vector3>(context.world.sunColor) *
+        context.world.sunIntensity;
+
+    for (uint32_t i = 0; i < context.maxDepth; i++)
+    {
+        SceneBVH::Hit hit;
+        ++*rayCount;
+        // Triangles are hit from both sides, like in the TLAS of the
+        // viewport, whose instances don't cull back faces.
+        if (!context.bvh.intersectNearest(ray, false, &hit))
+        {
+            const float height =
+                1.0f -
+                static_cast<float>(y) / static_cast<float>(m_resolution[1]);
+            const Vector3 skyColor =
+                Vector3::lerp(SKY_BOTTOM_COLOR, SKY_TOP_COLOR, height);
+            return radiance +
+                   multiply(skyColor, throughput) * (i == 0 ? 1.0f : 0.5f);
+        }
+
+        // The normal is interpolated in the space of the object, at the
+        // barycentric coordinates of the hit, and transformed into world
+        // space by the inverse transpose of the world matrix.
+        const Vector3 position =
+            ray.getOrigin() + ray.getDirection() * hit.distance;
+        const auto vertices = hit.mesh->getVertices();
+        const auto indices = hit.mesh->getIndices();
+        const Vertex &v0 = vertices[indices[hit.triangle * 3]];
+        const Vertex &v1 = vertices[indices[hit.triangle * 3 + 1]];
+        const Vertex &v2 = vertices[indices[hit.triangle * 3 + 2]];
+        const math::Matrix4x4 &worldToObject = *hit.worldToObject;
+        const Vector3 edge1 = v1.position - v0.position;
+        const Vector3 edge2 = v2.position - v0.position;
+        const Vector3 toHit =
+            static_cast<Vector3>(worldToObject * Vector4(position, 1.0f)) -
+            v0.position;
+        const float d00 = Vector3::dot(edge1, edge1);
+        const float d01 = Vector3::dot(edge1, edge2);
+        const float d11 = Vector3::dot(edge2, edge2);
+        const float d20 = Vector3::dot(toHit, edge1);
+        const float d21 = Vector3::dot(toHit, edge2);
+        const float denominator = d00 * d11 - d01 * d01;
+        const float b1 = (d11 * d20 - d01 * d21) / denominator;
+        const float b2 = (d00 * d21 - d01 * d20) / denominator;
+        const Vector3 localNormal =
+            v0.normal * (1.0f - b1 - b2) + v1.normal * b1 + v2.normal * b2;
+        Vector3 meshNormal;
+        for (int r = 0; r < 3; r++)
+            for (int c = 0; c < 3; c++)
+                meshNormal[c] += worldToObject[r][c] * localNormal[r];
+        meshNormal.normalize();
+
+        const Vector3 viewDir = -ray.getDirection();
+        Vector3 frame[3];
+        getCoordinateFrame(Vector3::dot(viewDir, meshNormal) < 0.0f
+                               ? -meshNormal
+                               : meshNormal,
+                           frame);
+        const Vector3 &normal = frame[2];
+        const PrincipledData &material =
+            m_materials.at(hit.mesh->getMaterial().get());
+
+        // The next rays start off the surface, on the side of the mesh
+        // normal.
+        const Vector3 newRayOrigin = offsetRay(position, meshNormal);
+        Vector3 newRayDir;
+        float pdf = 0.0f;
+        const Vector3 bxdf = TraceContext::sampleBXDF(
+            material, viewDir, frame, seed, &newRayDir, &pdf);
+        radiance += multiply(material.emission, throughput);
+        if (pdf < EPSILON)
+            break;
+
+        // Direct light from the sun.
+        ++*rayCount;
+        if (!context.bvh.intersectAny(math::Ray(newRayOrigin, lightDir),
+                                      false))
+        {
+            const Vector3 f = TraceContext::evaluateBXDF(
+                material, viewDir, lightDir, normal, seed);
+            radiance += multiply(multiply(f, lightColor), throughput) *
+                        std::fabs(Vector3::dot(normal, lightDir));
+        }
+
+        throughput = multiply(throughput, bxdf) *
+                     (std::fabs(Vector3::dot(normal, newRayDir)) / pdf);
+        ray = math::Ray(newRayOrigin, newRayDir);
+    }
+    return radiance;
+}
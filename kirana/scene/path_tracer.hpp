@@ -0,0 +1,136 @@
+#ifndef KIRANA_SCENE_PATH_TRACER_HPP
+#define KIRANA_SCENE_PATH_TRACER_HPP
+
+#include <vector3.hpp>
+#include <vector4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kirana::scene
+{
+class Camera;
+class Material;
+class Scene;
+class SceneBVH;
+struct WorldData;
+
+/**
+ * CPU reference of the path tracer of the viewport, with the principled
+ * shading of shaders/raytrace/common/pathtrace.glsl and bxdf_principled.glsl.
+ * The same paths are traced, with the same random numbers, sampling and BxDF,
+ * through the BVH of the scene instead of the acceleration structure of the
+ * GPU. The images are used as a reference for the viewport, and to measure
+ * the throughput of the BVH without a GPU.
+ *
+ * The image is split into tiles, which the threads of the thread pool render
+ * in turn. The random numbers of a pixel only depend on its position and the
+ * frame index, so the image is the same with any number of threads.
+ * Textures aren't sampled. The base color and emissive factors of the
+ * materials are used instead, and the normal maps are ignored.
+ */
+class PathTracer
+{
+  public:
+    struct Settings
+    {
+        /// Size of the image in pixels.
+        std::array<uint32_t, 2> resolution{1280, 720};
+        /// Maximum number of rays of a path, before shadow rays.
+        uint32_t maxDepth = 4;
+        /// Number of paths traced per pixel.
+        uint32_t sampleCount = 1;
+        /// Seeds the random numbers, as the frame index of the viewport.
+        uint32_t frameIndex = 0;
+        /// Width and height of the tiles the threads take.
+        uint32_t tileSize = 16;
+    };
+
+    struct Stats
+    {
+        /// Number of rays traced, shadow rays included.
+        uint64_t rayCount = 0;
+        /// Time taken to render, in milliseconds.
+        double time = 0.0;
+    };
+
+    PathTracer() = default;
+    ~PathTracer() = default;
+
+    PathTracer(const PathTracer &pathTracer) = delete;
+    PathTracer &operator=(const PathTracer &pathTracer) = delete;
+    PathTracer(PathTracer &&pathTracer) = default;
+    PathTracer &operator=(PathTracer &&pathTracer) = default;
+
+    /**
+     * Renders the scene after updating its transforms. Scenes don't import
+     * their cameras yet, so the camera is given, such as the one of the
+     * viewport.
+     * @param scene The scene to render. Its BVH has to be built.
+     * @param camera The camera to render from.
+     * @param world The sun of the scene.
+     * @param settings The settings of the render.
+     * @return true if the image was rendered, false if the scene isn't
+     * initialized.
+     */
+    bool render(Scene &scene, const Camera &camera, const WorldData &world,
+                const Settings &settings);
+    /**
+     * Renders the objects of the BVH.
+     * @param bvh The BVH of the objects to render. It has to be up to date
+     * with their transforms.
+     * @param camera The camera to render from.
+     * @param world The sun of the scene.
+     * @param settings The settings of the render.
+     * @return true if the image was rendered.
+     */
+    bool render(const SceneBVH &bvh, const Camera &camera,
+                const WorldData &world, const Settings &settings);
+
+    /// @return Linear RGBA pixels of the last image, rows from top to bottom.
+    [[nodiscard]] inline const std::vector<math::Vector4> &getPixels() const
+    {
+        return m_pixels;
+    }
+    [[nodiscard]] inline const std::array<uint32_t, 2> &getResolution() const
+    {
+        return m_resolution;
+    }
+    [[nodiscard]] inline const Stats &getLastRenderStats() const
+    {
+        return m_lastRenderStats;
+    }
+
+    /// Writes the last image as half float OpenEXR, in linear space.
+    bool writeEXR(const std::string &path) const;
+    /// Writes the last image as 8-bit PNG, with the gamma of the viewport.
+    bool writePNG(const std::string &path) const;
+
+  private:
+    // Factors of a principled material, without its textures.
+    struct PrincipledData
+    {
+        math::Vector3 color;
+        float metallic;
+        float specular;
+        float roughness;
+        math::Vector3 emission;
+    };
+    struct TraceContext;
+
+    std::array<uint32_t, 2> m_resolution{0, 0};
+    std::vector<math::Vector4> m_pixels;
+    std::unordered_map<const Material *, PrincipledData> m_materials;
+    Stats m_lastRenderStats;
+
+    void setMaterials(const SceneBVH &bvh);
+    math::Vector3 samplePixel(const TraceContext &context, uint32_t x,
+                              uint32_t y, uint32_t *seed,
+                              uint64_t *rayCount) const;
+};
+} // namespace kirana::scene
+
+#endif // KIRANA_SCENE_PATH_TRACER_HPP
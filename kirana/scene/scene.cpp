@@ -6,14 +6,62 @@
 #include <assimp/scene.h>
 #include <constants.h>
 #include <logger.hpp>
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
 
 typedef kirana::utils::Logger Logger;
 typedef kirana::utils::LogSeverity LogSeverity;
 namespace constants = kirana::utils::constants;
 
+void kirana::scene::Scene::deduplicateMeshes(
+    std::vector<uint32_t> *meshIndexMap)
+{
+    std::vector<uint64_t> hashes(m_meshes.size());
+    utils::ThreadPool::get().parallelFor(m_meshes.size(), [&](size_t i) {
+        hashes[i] = m_meshes[i]->getContentHash();
+    });
+
+    // Meshes with the same hash are compared fully to rule out collisions.
+    std::unordered_map<uint64_t, std::vector<uint32_t>> hashTable;
+    hashTable.reserve(m_meshes.size());
+    std::vector<std::shared_ptr<Mesh>> uniqueMeshes;
+    meshIndexMap->resize(m_meshes.size());
+    for (size_t i = 0; i < m_meshes.size(); i++)
+    {
+        auto &candidates = hashTable[hashes[i]];
+        const auto it = std::find_if(
+            candidates.begin(), candidates.end(), [&](uint32_t index) {
+                return uniqueMeshes[index]->hasSameContent(*m_meshes[i]);
+            });
+        if (it != candidates.end())
+        {
+            (*meshIndexMap)[i] = *it;
+            continue;
+        }
+        const auto index = static_cast<uint32_t>(uniqueMeshes.size());
+        candidates.push_back(index);
+        (*meshIndexMap)[i] = index;
+        uniqueMeshes.emplace_back(std::move(m_meshes[i]));
+    }
+
+    if (uniqueMeshes.size() != m_meshes.size())
+    {
+        Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
+                          "Merged " +
+                              std::to_string(m_meshes.size() -
+                                             uniqueMeshes.size()) +
+                              " duplicate meshes");
+    }
+    m_meshes = std::move(uniqueMeshes);
+}
+
 void kirana::scene::Scene::getMeshesFromNode(
-    const aiNode *node, std::vector<std::shared_ptr<Mesh>> *nodeMeshes,
-    math::Bounds3 *bounds)
+    const aiNode *node, const std::vector<uint32_t> &meshIndexMap,
+    std::vector<std::shared_ptr<Mesh>> *nodeMeshes, math::Bounds3 *bounds)
 {
     nodeMeshes->clear();
     if (node->mNumMeshes > 0)
@@ -21,7 +69,7 @@ void kirana::scene::Scene::getMeshesFromNode(
         nodeMeshes->resize(node->mNumMeshes);
         for (size_t i = 0; i < node->mNumMeshes; i++)
         {
-            (*nodeMeshes)[i] = m_meshes[node->mMeshes[i]];
+            (*nodeMeshes)[i] = m_meshes[meshIndexMap[node->mMeshes[i]]];
             bounds->encapsulate((*nodeMeshes)[i]->getBounds());
         }
     }
@@ -34,30 +82,33 @@ void kirana::scene::Scene::getMeshesFromNode(
 }
 
 void kirana::scene::Scene::initializeChildObjects(
-    std::shared_ptr<Object> parent, uint32_t childCount, aiNode **children)
+    std::shared_ptr<Object> parent, uint32_t childCount, aiNode **children,
+    const std::vector<uint32_t> &meshIndexMap)
 {
 
     for (size_t i = 0; i < childCount; i++)
     {
         std::vector<std::shared_ptr<Mesh>> meshes;
         math::Bounds3 objectBounds;
-        getMeshesFromNode(children[i], &meshes, &objectBounds);
+        getMeshesFromNode(children[i], meshIndexMap, &meshes, &objectBounds);
 
         m_objects.emplace_back(std::make_shared<Object>(
             children[i], meshes, objectBounds,
-            parent != nullptr ? parent->m_transform.get() : nullptr));
+            parent != nullptr ? parent->transform : nullptr, m_transforms));
 
         if (parent != nullptr)
             parent->m_addHierarchyBounds(objectBounds);
 
         if (children[i]->mNumChildren > 0)
             initializeChildObjects(m_objects.back(), children[i]->mNumChildren,
-                                   children[i]->mChildren);
+                                   children[i]->mChildren, meshIndexMap);
     }
 }
 
-void kirana::scene::Scene::initFromAiScene(const std::string &path,
-                                           const aiScene *scene)
+void kirana::scene::Scene::initFromAiScene(
+    const std::string &path, const aiScene *scene,
+    const SceneImportSettings &importSettings,
+    const SceneLoadProgressCallback &onProgress)
 {
     m_path = path;
     // Initialize scene name
@@ -69,14 +120,31 @@ void kirana::scene::Scene::initFromAiScene(const std::string &path,
 
     // TODO: Populate scene cameras
 
-    // Create Material objects for all the materials in the scene.
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    utils::ThreadPool &threadPool = utils::ThreadPool::get();
+
+    // Each created material and mesh counts as one step of the processing
+    // stage.
+    const size_t stepCount = scene->mNumMaterials + scene->mNumMeshes;
+    std::atomic<size_t> completedSteps{0};
+    const auto reportStep = [&]() {
+        const size_t completed = ++completedSteps;
+        if (onProgress)
+            onProgress(SceneLoadProgress{
+                SceneLoadStage::PROCESSING,
+                static_cast<float>(completed) / static_cast<float>(stepCount)});
+    };
+
+    // Create Material objects for all the materials in the scene. Each
+    // material (and mesh below) is written to its own slot, so the order
+    // matches the Assimp scene regardless of which thread created it.
     m_materials.clear();
     m_materials.resize(scene->mNumMaterials);
-    for (size_t i = 0; i < scene->mNumMaterials; i++)
-    {
+    threadPool.parallelFor(scene->mNumMaterials, [&](size_t i) {
         m_materials[i] =
-            std::move(std::make_shared<Material>(m_path, scene->mMaterials[i]));
-    }
+            std::make_shared<Material>(m_path, scene->mMaterials[i]);
+        reportStep();
+    });
 
     Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
                       "Material count: " + std::to_string(m_materials.size()));
@@ -84,18 +152,36 @@ void kirana::scene::Scene::initFromAiScene(const std::string &path,
     // Create Mesh objects for all the meshes in the scene.
     m_meshes.clear();
     m_meshes.resize(scene->mNumMeshes);
-    for (size_t i = 0; i < scene->mNumMeshes; i++)
-        m_meshes[i] = std::move(std::make_shared<Mesh>(
-            scene->mMeshes[i], m_materials[scene->mMeshes[i]->mMaterialIndex]));
-
+    threadPool.parallelFor(scene->mNumMeshes, [&](size_t i) {
+        m_meshes[i] = std::make_shared<Mesh>(
+            scene->mMeshes[i], m_materials[scene->mMeshes[i]->mMaterialIndex]);
+        m_meshes[i]->optimize(importSettings);
+        if (importSettings.generateLODs)
+            m_meshes[i]->generateLODs(importSettings);
+        if (importSettings.buildMeshlets)
+            m_meshes[i]->buildMeshlets();
+        reportStep();
+    });
+
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::high_resolution_clock::now() - startTime;
     Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
-                      "Scene Mesh count: " + std::to_string(scene->mNumMeshes));
+                      "Scene Mesh count: " + std::to_string(scene->mNumMeshes) +
+                          " (Materials and meshes created in " +
+                          std::to_string(duration.count()) + " ms on " +
+                          std::to_string(threadPool.getThreadCount() + 1) +
+                          " threads)");
+
+    // Share identical meshes, so that they are instanced by the renderer.
+    std::vector<uint32_t> meshIndexMap;
+    deduplicateMeshes(&meshIndexMap);
 
     // Recursively initialize child objects of the scene, starting with the root
     // node.
     m_objects.clear();
+    m_transforms = std::make_shared<math::TransformStore>();
     aiNode *nodes[1] = {scene->mRootNode};
-    initializeChildObjects(nullptr, 1, nodes);
+    initializeChildObjects(nullptr, 1, nodes, meshIndexMap);
 
     Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
                       "Object count: " + std::to_string(m_objects.size()));
@@ -103,6 +189,33 @@ void kirana::scene::Scene::initFromAiScene(const std::string &path,
     m_isInitialized = true;
 }
 
+void kirana::scene::Scene::updateTransforms()
+{
+    m_transforms->update();
+    // Refitting every frame keeps the cost of dragging an object out of the
+    // next pick.
+    if (!m_bvh.update() || !m_bvh.getLastUpdateStats().isRebuilt)
+        return;
+    const SceneBVH::UpdateStats &stats = m_bvh.getLastUpdateStats();
+    Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
+                      "Scene BVH rebuilt after refitting degraded it, in " +
+                          std::to_string(stats.time) + " ms (" +
+                          std::to_string(stats.movedObjectCount) +
+                          " objects moved)");
+}
+
+void kirana::scene::Scene::buildBVH()
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    m_bvh.build(m_objects, m_meshes, m_transforms);
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::high_resolution_clock::now() - startTime;
+    Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
+                      "Scene BVH built in " + std::to_string(duration.count()) +
+                          " ms (" + std::to_string(m_bvh.getObjectCount()) +
+                          " objects)");
+}
+
 
 std::vector<kirana::math::TransformHierarchy *> kirana::scene::Scene::
     getTransformsForMesh(const Mesh *const mesh) const
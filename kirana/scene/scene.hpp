@@ -5,6 +5,7 @@
 #include "mesh.hpp"
 #include "material.hpp"
 #include "camera.hpp"
+#include "scene_bvh.hpp"
 
 #include <memory>
 #include <vector>
@@ -17,10 +18,12 @@ namespace kirana::scene
 {
 class SceneImporter;
 class SceneManager;
+class SceneCache;
 class Scene
 {
     friend class SceneImporter;
     friend class SceneManager;
+    friend class SceneCache;
 
   private:
     bool m_isInitialized = false;
@@ -31,21 +34,40 @@ class Scene
     std::vector<std::shared_ptr<Mesh>> m_meshes;
     std::vector<std::shared_ptr<Object>>
         m_objects; // Also contains root object.
+    // Transforms of all the objects.
+    std::shared_ptr<math::TransformStore> m_transforms =
+        std::make_shared<math::TransformStore>();
     std::vector<std::shared_ptr<Material>> m_materials;
     std::vector<Camera> m_cameras;
+    SceneBVH m_bvh;
 
+    /**
+     * Removes meshes with the same vertices, indices and material from
+     * m_meshes, so that identical meshes are shared (and instanced) by all
+     * objects using them.
+     * @param meshIndexMap Maps the original mesh indices to the indices of the
+     * remaining meshes.
+     */
+    void deduplicateMeshes(std::vector<uint32_t> *meshIndexMap);
     void getMeshesFromNode(const aiNode *node,
+                           const std::vector<uint32_t> &meshIndexMap,
                            std::vector<std::shared_ptr<Mesh>> *nodeMeshes,
                            math::Bounds3 *bounds);
     void initializeChildObjects(std::shared_ptr<Object> parent,
-                                uint32_t childCount, aiNode **children);
-    void initFromAiScene(const std::string &path, const aiScene *scene);
+                                uint32_t childCount, aiNode **children,
+                                const std::vector<uint32_t> &meshIndexMap);
+    void initFromAiScene(const std::string &path, const aiScene *scene,
+                         const SceneImportSettings &importSettings,
+                         const SceneLoadProgressCallback &onProgress = nullptr);
 
   public:
     Scene() = default;
     ~Scene() = default;
 
     Scene(const Scene &scene) = delete;
+    // Scenes are loaded in the background and then moved into the viewport.
+    Scene(Scene &&scene) = default;
+    Scene &operator=(Scene &&scene) = default;
 
     // Getters-Setters
     [[nodiscard]] inline bool isInitialized() const
@@ -70,6 +92,11 @@ class Scene
     {
         return m_objects;
     }
+    [[nodiscard]] inline const std::shared_ptr<math::TransformStore>
+        &getTransforms() const
+    {
+        return m_transforms;
+    }
     [[nodiscard]] inline const std::vector<std::shared_ptr<Material>>
         &getMaterials() const
     {
@@ -80,6 +107,30 @@ class Scene
         // TODO: Replace with current active camera.
         return m_cameras[0];
     }
+    /// @return The BVH of the scene. Only up to date with the transforms
+    /// after updateTransforms().
+    [[nodiscard]] inline const SceneBVH &getBVH() const
+    {
+        return m_bvh;
+    }
+
+    /// Recalculates the world matrices of the objects that moved since the
+    /// last update, and refits the BVH to them.
+    void updateTransforms();
+
+    /// Builds the BVH used for ray queries, once the scene is loaded.
+    void buildBVH();
+    /**
+     * Finds the nearest object hit by the ray, using the BVH of the scene.
+     * @param ray The world-space ray to test.
+     * @param distance Distance of the hit along the ray. Written out only if
+     * an object is hit.
+     * @return The nearest object, nullptr if none is hit.
+     */
+    const Object *intersectRay(const math::Ray &ray, float *distance = nullptr)
+    {
+        return m_bvh.intersect(ray, distance);
+    }
 
     // Helper-Functions
     [[nodiscard]] std::vector<math::TransformHierarchy *> getTransformsForMesh(
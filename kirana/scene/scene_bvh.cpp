@@ -0,0 +1,288 @@
+#include "scene_bvh.hpp"
+
+#include "mesh.hpp"
+#include "object.hpp"
+#include "scene_types.hpp"
+
+#include <thread_pool.hpp>
+#include <triangle.hpp>
+
+#include <chrono>
+
+// The triangles of a leaf are tested with a single SIMD test.
+static_assert(kirana::math::BVH::MAX_LEAF_SIZE <=
+              kirana::math::Triangle::WIDTH);
+
+void kirana::scene::SceneBVH::build(
+    const std::vector<std::shared_ptr<Object>> &objects,
+    const std::vector<std::shared_ptr<Mesh>> &meshes,
+    std::shared_ptr<math::TransformStore> transforms)
+{
+    clear();
+    m_transforms = std::move(transforms);
+
+    // The map is filled in first, so that the threads only write to their
+    // own BVH.
+    std::vector<std::pair<const Mesh *, math::BVH *>> meshBVHs;
+    meshBVHs.reserve(meshes.size());
+    for (const auto &m : meshes)
+        meshBVHs.emplace_back(m.get(), &m_meshBVHs[m.get()]);
+    utils::ThreadPool::get().parallelFor(meshBVHs.size(), [&](size_t i) {
+        const auto vertices = meshBVHs[i].first->getVertices();
+        const auto indices = meshBVHs[i].first->getIndices();
+        std::vector<math::Bounds3> triangleBounds(indices.size() / 3);
+        for (size_t t = 0; t < triangleBounds.size(); t++)
+        {
+            math::Bounds3 &bounds = triangleBounds[t];
+            bounds = math::Bounds3(vertices[indices[t * 3]].position);
+            bounds.encapsulate(vertices[indices[t * 3 + 1]].position);
+            bounds.encapsulate(vertices[indices[t * 3 + 2]].position);
+        }
+        meshBVHs[i].second->build(triangleBounds);
+    });
+
+    for (const auto &o : objects)
+    {
+        bool hasTriangles = false;
+        for (const auto &m : o->getMeshes())
+        {
+            const auto it = m_meshBVHs.find(m.get());
+            hasTriangles = hasTriangles ||
+                           (it != m_meshBVHs.end() && !it->second.empty());
+        }
+        if (hasTriangles)
+            m_objects.emplace_back(o.get());
+    }
+    calculateObjectBounds();
+    buildObjectBVH();
+}
+
+void kirana::scene::SceneBVH::clear()
+{
+    m_objects.clear();
+    m_objectBounds.clear();
+    m_worldToObjectMatrices.clear();
+    m_objectIndices.clear();
+    m_objectBVH.clear();
+    m_builtCost = 0.0f;
+    m_meshBVHs.clear();
+    m_transforms.reset();
+    m_transformGeneration = 0;
+    m_lastUpdateStats = UpdateStats();
+}
+
+bool kirana::scene::SceneBVH::update()
+{
+    if (m_transforms == nullptr ||
+        m_transforms->getGeneration() == m_transformGeneration)
+        return false;
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    m_lastUpdateStats = UpdateStats();
+
+    // Only the bounds of the objects that moved, including the ones moved by
+    // their parents, are recalculated.
+    m_transforms->getMovedTransforms(m_transformGeneration,
+                                     &m_movedTransforms);
+    m_transformGeneration = m_transforms->getGeneration();
+    std::vector<uint32_t> movedObjects;
+    for (const auto t : m_movedTransforms)
+    {
+        const auto it = m_objectIndices.find(t);
+        if (it == m_objectIndices.end())
+            continue;
+        updateObject(it->second);
+        movedObjects.emplace_back(it->second);
+    }
+
+    if (!movedObjects.empty())
+    {
+        m_objectBVH.refit(m_objectBounds, movedObjects);
+        if (m_objectBVH.getCost() > m_builtCost * REBUILD_COST_RATIO)
+        {
+            buildObjectBVH();
+            m_lastUpdateStats.isRebuilt = true;
+        }
+    }
+    m_lastUpdateStats.movedObjectCount = movedObjects.size();
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::high_resolution_clock::now() - startTime;
+    m_lastUpdateStats.time = duration.count();
+    return true;
+}
+
+void kirana::scene::SceneBVH::buildObjectBVH()
+{
+    m_objectBVH.build(m_objectBounds);
+    m_builtCost = m_objectBVH.getCost();
+}
+
+void kirana::scene::SceneBVH::calculateObjectBounds()
+{
+    m_objectBounds.resize(m_objects.size());
+    m_worldToObjectMatrices.resize(m_objects.size());
+    m_objectIndices.reserve(m_objects.size());
+    for (size_t i = 0; i < m_objects.size(); i++)
+    {
+        updateObject(static_cast<uint32_t>(i));
+        m_objectIndices[m_objects[i]->transform] = static_cast<uint32_t>(i);
+    }
+    if (m_transforms != nullptr)
+        m_transformGeneration = m_transforms->getGeneration();
+}
+
+void kirana::scene::SceneBVH::updateObject(uint32_t object)
+{
+    m_objectBounds[object] = m_objects[object]->getObjectBounds();
+    m_worldToObjectMatrices[object] = math::Matrix4x4::affineInverse(
+        m_objects[object]->transform->getMatrix());
+}
+
+const kirana::scene::Object *kirana::scene::SceneBVH::intersect(
+    const math::Ray &ray, float *distance)
+{
+    update();
+    Hit hit;
+    if (!intersectNearest(ray, false, &hit))
+        return nullptr;
+    if (distance != nullptr)
+        *distance = hit.distance;
+    return hit.object;
+}
+
+bool kirana::scene::SceneBVH::intersectNearest(const math::Ray &ray,
+                                               bool cullBackFaces,
+                                               Hit *hit) const
+{
+    // Every object hit is nearer than the ones hit before it, so the last
+    // one written out is the nearest.
+    Hit nearestHit;
+    const uint32_t nearest = m_objectBVH.intersectNearest(
+        ray, [&](uint32_t object, float *objectDistance) {
+            return intersectObject(object, ray, cullBackFaces, false,
+                                   objectDistance, &nearestHit);
+        });
+    if (nearest == math::BVH::INVALID_INDEX)
+        return false;
+    *hit = nearestHit;
+    return true;
+}
+
+bool kirana::scene::SceneBVH::intersectAny(const math::Ray &ray,
+                                           bool cullBackFaces) const
+{
+    const uint32_t object = m_objectBVH.intersectAnyInLeaves(
+        ray, [&](const uint32_t *objects, uint32_t count, float *distance) {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (intersectObject(objects[i], ray, cullBackFaces, true,
+                                    distance, nullptr))
+                    return objects[i];
+            }
+            return math::BVH::INVALID_INDEX;
+        });
+    return object != math::BVH::INVALID_INDEX;
+}
+
+bool kirana::scene::SceneBVH::intersectObject(uint32_t object,
+                                              const math::Ray &ray,
+                                              bool cullBackFaces,
+                                              bool isAnyHit, float *distance,
+                                              Hit *hit) const
+{
+    // The direction isn't normalized, so that distances along the
+    // local-space ray are the same as in world space.
+    const math::Matrix4x4 &worldToObject = m_worldToObjectMatrices[object];
+    const math::Ray localRay(
+        static_cast<math::Vector3>(worldToObject *
+                                   math::Vector4(ray.getOrigin(), 1.0f)),
+        static_cast<math::Vector3>(worldToObject *
+                                   math::Vector4(ray.getDirection(), 0.0f)),
+        *distance);
+    bool isHit = false;
+    for (const auto &m : m_objects[object]->getMeshes())
+    {
+        const auto it = m_meshBVHs.find(m.get());
+        if (it == m_meshBVHs.end())
+            continue;
+        const uint32_t triangle = intersectMesh(
+            *m, it->second, localRay, cullBackFaces, isAnyHit, distance);
+        if (triangle == math::BVH::INVALID_INDEX)
+            continue;
+        isHit = true;
+        if (hit != nullptr)
+        {
+            hit->object = m_objects[object];
+            hit->mesh = m.get();
+            hit->triangle = triangle;
+            hit->distance = *distance;
+            hit->worldToObject = &worldToObject;
+        }
+        if (isAnyHit)
+            break;
+    }
+    return isHit;
+}
+
+uint32_t kirana::scene::SceneBVH::intersectMesh(const Mesh &mesh,
+                                                const math::BVH &bvh,
+                                                const math::Ray &ray,
+                                                bool cullBackFaces,
+                                                bool isAnyHit,
+                                                float *distance) const
+{
+    const auto vertices = mesh.getVertices();
+    const auto indices = mesh.getIndices();
+    const math::Vector3 direction = ray.getDirection();
+    const math::TriangleRay triangleRay(ray);
+    const auto intersectLeaf = [&](const uint32_t *triangles, uint32_t count,
+                                   float *leafDistance) {
+        // The triangles of the leaf are tested at once. Unused lanes
+        // repeat the first triangle, and are masked out.
+        float positions[3][3][math::Triangle::WIDTH];
+        for (int i = 0; i < math::Triangle::WIDTH; i++)
+        {
+            const uint32_t first = triangles[i < count ? i : 0] * 3;
+            for (int v = 0; v < 3; v++)
+            {
+                const math::Vector3 &position =
+                    vertices[indices[first + v]].position;
+                for (int axis = 0; axis < 3; axis++)
+                    positions[v][axis][i] = position[axis];
+            }
+        }
+        float distances[math::Triangle::WIDTH];
+        int mask = math::Triangle::intersect(triangleRay, positions,
+                                             *leafDistance, distances) &
+                   ((1 << count) - 1);
+        // Back faces are found from the winding of the triangles hit, as
+        // seen along the ray.
+        for (int i = 0; cullBackFaces && i < math::Triangle::WIDTH; i++)
+        {
+            if ((mask & (1 << i)) == 0)
+                continue;
+            math::Vector3 v[3];
+            for (int j = 0; j < 3; j++)
+                v[j] = math::Vector3(positions[j][0][i], positions[j][1][i],
+                                     positions[j][2][i]);
+            const math::Vector3 normal =
+                math::Vector3::cross(v[1] - v[0], v[2] - v[0]);
+            if (math::Vector3::dot(normal, direction) > 0.0f)
+                mask &= ~(1 << i);
+        }
+        uint32_t nearestTriangle = math::BVH::INVALID_INDEX;
+        for (uint32_t i = 0; mask != 0; i++, mask >>= 1)
+        {
+            if ((mask & 1) != 0 && distances[i] <= *leafDistance)
+            {
+                nearestTriangle = triangles[i];
+                *leafDistance = distances[i];
+            }
+        }
+        return nearestTriangle;
+    };
+    const math::Ray maxDistanceRay(ray.getOrigin(), direction, *distance);
+    if (isAnyHit)
+        return bvh.intersectAnyInLeaves(maxDistanceRay, intersectLeaf);
+    return bvh.intersectNearestInLeaves(maxDistanceRay, intersectLeaf,
+                                        distance);
+}
@@ -0,0 +1,185 @@
+#ifndef KIRANA_SCENE_SCENE_BVH_HPP
+#define KIRANA_SCENE_SCENE_BVH_HPP
+
+#include <bvh.hpp>
+#include <transform_store.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace kirana::scene
+{
+class Mesh;
+class Object;
+
+/**
+ * Two-level bounding volume hierarchy of a scene, used for ray queries such
+ * as picking and path tracing. The top level is a BVH over the world-space
+ * bounds of the objects, and the bottom level is a BVH over the triangles of
+ * each mesh, in object space. Meshes shared by many objects are only built
+ * once, and moving objects only needs the top level to be refitted, along the
+ * paths from the moved objects to the root. Refitting degrades the top level
+ * as objects move further, so it's rebuilt once its SAH cost grows past
+ * REBUILD_COST_RATIO times the cost it was built with.
+ *
+ * Rays are transformed into the space of each object they reach, and hit the
+ * triangles exactly, with a watertight test. The triangles of each leaf are
+ * tested together with SIMD.
+ */
+class SceneBVH
+{
+  public:
+    /// Ratio of the SAH cost of the refitted top level to its cost when it
+    /// was built, past which it's rebuilt.
+    static constexpr float REBUILD_COST_RATIO = 1.5f;
+
+    struct UpdateStats
+    {
+        /// Number of objects whose bounds were recalculated.
+        size_t movedObjectCount = 0;
+        /// Whether the top level was rebuilt instead of refitted.
+        bool isRebuilt = false;
+        /// Time taken by the update, in milliseconds.
+        double time = 0.0;
+    };
+
+    /// Triangle hit by a ray.
+    struct Hit
+    {
+        const Object *object = nullptr;
+        const Mesh *mesh = nullptr;
+        /// Index of the triangle in the mesh, whose vertex indices are at
+        /// [triangle * 3, triangle * 3 + 3) in the indices of the mesh.
+        uint32_t triangle = math::BVH::INVALID_INDEX;
+        /// Distance of the hit along the ray.
+        float distance = 0.0f;
+        /// Transforms world-space points into the space of the object.
+        const math::Matrix4x4 *worldToObject = nullptr;
+    };
+
+    SceneBVH() = default;
+    ~SceneBVH() = default;
+
+    SceneBVH(const SceneBVH &bvh) = delete;
+    SceneBVH &operator=(const SceneBVH &bvh) = delete;
+    SceneBVH(SceneBVH &&bvh) = default;
+    SceneBVH &operator=(SceneBVH &&bvh) = default;
+
+    /**
+     * Builds the BVHs of the meshes on the thread pool, and the BVH of the
+     * objects with meshes.
+     * @param objects The objects of the scene. They have to outlive the BVH.
+     * @param meshes The meshes used by the objects.
+     * @param transforms The transform store of the objects.
+     */
+    void build(const std::vector<std::shared_ptr<Object>> &objects,
+               const std::vector<std::shared_ptr<Mesh>> &meshes,
+               std::shared_ptr<math::TransformStore> transforms);
+    void clear();
+
+    /**
+     * Refits the BVH of the objects to the world-space bounds of the ones
+     * that moved since the last update, or rebuilds it if refitting degraded
+     * it too much. Returns immediately if no transform changed.
+     * @return true if any transform changed, in which case
+     * getLastUpdateStats() describes the update.
+     */
+    bool update();
+
+    /**
+     * Finds the nearest object hit by the ray. Updates the BVH of the objects
+     * first if any of them moved.
+     * @param ray The world-space ray to test.
+     * @param distance Distance of the nearest hit along the ray. Written out
+     * only if an object is hit.
+     * @return The nearest object, nullptr if none is hit.
+     */
+    const Object *intersect(const math::Ray &ray, float *distance = nullptr);
+    /**
+     * Finds the nearest triangle hit by the ray. Unlike intersect(), the BVH
+     * isn't updated, so it can be called from many threads at once, as long
+     * as update() isn't.
+     * @param ray The world-space ray to test.
+     * @param cullBackFaces If true, triangles facing away from the ray, whose
+     * vertices are clockwise as seen from its origin, are ignored.
+     * @param hit The nearest hit. Written out only if a triangle is hit.
+     * @return true if a triangle is hit.
+     */
+    bool intersectNearest(const math::Ray &ray, bool cullBackFaces,
+                          Hit *hit) const;
+    /**
+     * Tests whether the ray hits any triangle within its maximum distance,
+     * such as for shadow rays. Thread-safe like intersectNearest().
+     * @param ray The world-space ray to test.
+     * @param cullBackFaces If true, triangles facing away from the ray are
+     * ignored.
+     * @return true if a triangle is hit.
+     */
+    bool intersectAny(const math::Ray &ray, bool cullBackFaces) const;
+
+    /// @return The objects with meshes, in the order the BVH indexes them.
+    [[nodiscard]] inline const std::vector<const Object *> &getObjects() const
+    {
+        return m_objects;
+    }
+    [[nodiscard]] inline size_t getObjectCount() const
+    {
+        return m_objects.size();
+    }
+    /// @return The SAH cost of the BVH of the objects.
+    [[nodiscard]] inline float getCost() const
+    {
+        return m_objectBVH.getCost();
+    }
+    /// @return Statistics of the last update that found a changed
+    /// transform.
+    [[nodiscard]] inline const UpdateStats &getLastUpdateStats() const
+    {
+        return m_lastUpdateStats;
+    }
+
+  private:
+    std::vector<const Object *> m_objects;
+    std::vector<math::Bounds3> m_objectBounds;
+    // Inverse of the world matrix of each object, so that rays aren't
+    // transformed through the transform store.
+    std::vector<math::Matrix4x4> m_worldToObjectMatrices;
+    // Index of the object of each transform, to find the objects that moved.
+    std::unordered_map<const math::TransformHierarchy *, uint32_t>
+        m_objectIndices;
+    math::BVH m_objectBVH;
+    // SAH cost of the BVH of the objects when it was last built.
+    float m_builtCost = 0.0f;
+    std::unordered_map<const Mesh *, math::BVH> m_meshBVHs;
+
+    std::shared_ptr<math::TransformStore> m_transforms;
+    // Generation of the transform store the object bounds were calculated
+    // for.
+    uint64_t m_transformGeneration = 0;
+    std::vector<math::TransformHierarchy *> m_movedTransforms;
+    UpdateStats m_lastUpdateStats;
+
+    void buildObjectBVH();
+    void calculateObjectBounds();
+    /// Recalculates the bounds and the inverse world matrix of the object.
+    void updateObject(uint32_t object);
+    /**
+     * Finds the triangle of the object hit by the world-space ray, nearer
+     * than the distance. With isAnyHit, the first triangle found is
+     * returned, which isn't necessarily the nearest.
+     * @return true if a triangle is hit.
+     */
+    bool intersectObject(uint32_t object, const math::Ray &ray,
+                         bool cullBackFaces, bool isAnyHit, float *distance,
+                         Hit *hit) const;
+    /// @return The index of the triangle of the mesh hit by the local-space
+    /// ray, INVALID_INDEX if none is hit.
+    uint32_t intersectMesh(const Mesh &mesh, const math::BVH &bvh,
+                           const math::Ray &ray, bool cullBackFaces,
+                           bool isAnyHit, float *distance) const;
+};
+} // namespace kirana::scene
+
+#endif // KIRANA_SCENE_SCENE_BVH_HPP
@@ -0,0 +1,886 @@
+#include "scene_cache.hpp"
+
+#include "scene.hpp"
+#include "image_manager.hpp"
+
+#include <constants.h>
+#include <logger.hpp>
+#include <file_system.hpp>
+#include <compression.hpp>
+#include <hash.hpp>
+#include <mapped_file.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
+
+using kirana::utils::Logger;
+using kirana::utils::LogSeverity;
+namespace constants = kirana::utils::constants;
+
+namespace
+{
+const char SCENE_CACHE_MAGIC[4] = {'K', 'S', 'C', 'N'};
+const size_t SCENE_CACHE_BLOB_ALIGNMENT = 16;
+// LZ4 can't expand the data by more than this, which bounds the size of the
+// compressed arrays by the size of the file.
+const size_t LZ4_MAX_COMPRESSION_RATIO = 255;
+
+// Smallest size of the elements of the arrays in the file, which bounds their
+// counts by the remaining size of the file before anything is allocated.
+const size_t MIN_STRING_SIZE = sizeof(uint32_t);
+const size_t MIN_BLOB_SIZE = 2 * sizeof(uint64_t);
+const size_t BOUNDS_SIZE = 6 * sizeof(float);
+const size_t MIN_PARAMETER_SIZE = MIN_STRING_SIZE + sizeof(uint32_t);
+const size_t MIN_MATERIAL_SIZE = MIN_STRING_SIZE + sizeof(uint32_t);
+const size_t MIN_MESH_SIZE = MIN_STRING_SIZE + BOUNDS_SIZE + sizeof(int32_t) +
+                             3 * sizeof(uint64_t) + 3 * MIN_BLOB_SIZE +
+                             2 * sizeof(uint32_t);
+const size_t LOD_SIZE = 2 * sizeof(uint32_t) + sizeof(float);
+const size_t MESHLET_SIZE =
+    3 * sizeof(uint32_t) + BOUNDS_SIZE + 11 * sizeof(float);
+const size_t MIN_OBJECT_SIZE = MIN_STRING_SIZE + sizeof(int32_t) +
+                               16 * sizeof(float) + 2 * BOUNDS_SIZE +
+                               sizeof(uint32_t);
+
+class CacheWriter
+{
+  public:
+    explicit CacheWriter(const std::string &path)
+        : m_stream{path, std::ios::binary | std::ios::trunc}
+    {
+    }
+
+    [[nodiscard]] inline bool good() const
+    {
+        return m_stream.good();
+    }
+
+    inline void writeBytes(const void *data, size_t size)
+    {
+        if (size > 0)
+            m_stream.write(reinterpret_cast<const char *>(data),
+                           static_cast<std::streamsize>(size));
+        m_position += size;
+    }
+
+    /// Pads the file with zeroes until the current position is a multiple of
+    /// the given alignment.
+    inline void align(size_t alignment)
+    {
+        static const uint8_t padding[SCENE_CACHE_BLOB_ALIGNMENT]{};
+        writeBytes(padding, (alignment - (m_position % alignment)) % alignment);
+    }
+
+    template <typename T> inline void write(const T &value)
+    {
+        static_assert(std::is_arithmetic_v<T>);
+        writeBytes(&value, sizeof(T));
+    }
+
+    inline void writeString(const std::string &value)
+    {
+        write(static_cast<uint32_t>(value.size()));
+        writeBytes(value.data(), value.size());
+    }
+
+    inline void writeFloats(const float *values, size_t count)
+    {
+        writeBytes(values, sizeof(float) * count);
+    }
+
+    inline void writeBounds(const kirana::math::Bounds3 &bounds)
+    {
+        writeFloats(bounds.getMin().data(), 3);
+        writeFloats(bounds.getMax().data(), 3);
+    }
+
+    /**
+     * Writes a blob preceded by its size and stored size. The data is
+     * aligned so that uncompressed blobs can be referenced in place from a
+     * memory-mapped cache file.
+     * @param compress If true, the blob is LZ4 compressed when that makes it
+     * smaller.
+     */
+    bool writeBlob(const void *data, size_t size, bool compress)
+    {
+        const void *storedData = data;
+        size_t storedSize = size;
+        if (compress)
+        {
+            if (!kirana::utils::compression::compress(data, size,
+                                                      &m_compressed))
+                return false;
+            if (m_compressed.size() < size)
+            {
+                storedData = m_compressed.data();
+                storedSize = m_compressed.size();
+            }
+        }
+        write(static_cast<uint64_t>(size));
+        write(static_cast<uint64_t>(storedSize));
+        align(SCENE_CACHE_BLOB_ALIGNMENT);
+        writeBytes(storedData, storedSize);
+        return true;
+    }
+
+  private:
+    std::ofstream m_stream;
+    size_t m_position = 0;
+    std::vector<uint8_t> m_compressed;
+};
+
+class CacheReader
+{
+  public:
+    explicit CacheReader(const uint8_t *data, size_t size)
+        : m_begin{data}, m_current{data}, m_end{data + size}
+    {
+    }
+
+    [[nodiscard]] inline bool good() const
+    {
+        return m_good;
+    }
+
+    /// Marks the data as invalid. All subsequent reads fail.
+    inline void fail()
+    {
+        m_good = false;
+    }
+
+    bool readBytes(void *data, size_t size)
+    {
+        if (!m_good || static_cast<size_t>(m_end - m_current) < size)
+        {
+            m_good = false;
+            return false;
+        }
+        if (size > 0)
+            memcpy(data, m_current, size);
+        m_current += size;
+        return true;
+    }
+
+    template <typename T> inline T read()
+    {
+        static_assert(std::is_arithmetic_v<T>);
+        T value{};
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+
+    /**
+     * Reads the number of elements of an array.
+     * @param minElementSize Smallest size of an element in the data.
+     * @return The number of elements, 0 if the remaining data is too small
+     * to hold them, in which case the data is marked as invalid.
+     */
+    size_t readCount(size_t minElementSize)
+    {
+        const auto count = static_cast<size_t>(read<uint32_t>());
+        if (!m_good ||
+            count > static_cast<size_t>(m_end - m_current) / minElementSize)
+        {
+            m_good = false;
+            return 0;
+        }
+        return count;
+    }
+
+    std::string readString()
+    {
+        const auto size = read<uint32_t>();
+        if (!m_good || static_cast<size_t>(m_end - m_current) < size)
+        {
+            m_good = false;
+            return "";
+        }
+        std::string value(reinterpret_cast<const char *>(m_current), size);
+        m_current += size;
+        return value;
+    }
+
+    inline void readFloats(float *values, size_t count)
+    {
+        readBytes(values, sizeof(float) * count);
+    }
+
+    kirana::math::Bounds3 readBounds()
+    {
+        float values[6]{0.0f};
+        readFloats(values, 6);
+        return kirana::math::Bounds3(
+            kirana::math::Vector3(values[0], values[1], values[2]),
+            kirana::math::Vector3(values[3], values[4], values[5]));
+    }
+
+    kirana::math::Vector3 readVector3()
+    {
+        float values[3]{0.0f};
+        readFloats(values, 3);
+        return kirana::math::Vector3(values[0], values[1], values[2]);
+    }
+
+    inline void align(size_t alignment)
+    {
+        const auto position = static_cast<size_t>(m_current - m_begin);
+        const size_t padding = (alignment - (position % alignment)) % alignment;
+        if (!m_good || static_cast<size_t>(m_end - m_current) < padding)
+        {
+            m_good = false;
+            return;
+        }
+        m_current += padding;
+    }
+
+    /**
+     * Reads an array written by CacheWriter::writeBlob. Uncompressed data is
+     * not copied, the returned view points into the source data instead.
+     * Compressed data is decompressed into the given storage.
+     * @param count Expected number of elements.
+     * @param view View of the data if it's stored uncompressed.
+     * @param storage Decompressed data if it's stored compressed.
+     * @return true if the array was read.
+     */
+    template <typename T>
+    bool readArray(size_t count, kirana::utils::ArrayView<const T> *view,
+                   std::vector<T> *storage)
+    {
+        const auto blobSize = read<uint64_t>();
+        const auto storedSize = read<uint64_t>();
+        align(SCENE_CACHE_BLOB_ALIGNMENT);
+        // The count is checked before it's multiplied, so that it can't
+        // overflow, and the sizes before anything is allocated.
+        if (!m_good ||
+            count > std::numeric_limits<size_t>::max() / sizeof(T) ||
+            blobSize != count * sizeof(T) ||
+            static_cast<size_t>(m_end - m_current) < storedSize ||
+            blobSize / LZ4_MAX_COMPRESSION_RATIO > storedSize)
+        {
+            m_good = false;
+            return false;
+        }
+        if (storedSize == blobSize)
+        {
+            *view = kirana::utils::ArrayView<const T>(
+                reinterpret_cast<const T *>(m_current), count);
+        }
+        else
+        {
+            storage->resize(count);
+            if (!kirana::utils::compression::decompress(
+                    m_current, static_cast<size_t>(storedSize),
+                    storage->data(), static_cast<size_t>(blobSize)))
+            {
+                m_good = false;
+                return false;
+            }
+        }
+        m_current += storedSize;
+        return true;
+    }
+
+  private:
+    const uint8_t *m_begin;
+    const uint8_t *m_current;
+    const uint8_t *m_end;
+    bool m_good = true;
+};
+
+/// Returns true if the parameter value can be stored in the scene cache.
+bool isParameterCacheable(const kirana::scene::MaterialParameter &param)
+{
+    using kirana::scene::MaterialParameterType;
+    switch (param.type)
+    {
+    case MaterialParameterType::MAT_2x2:
+    case MaterialParameterType::MAT_3x3:
+    case MaterialParameterType::MAT_3x4:
+        return false;
+    default:
+        return param.value.has_value();
+    }
+}
+
+void writeParameter(CacheWriter *writer,
+                    const kirana::scene::MaterialParameter &param)
+{
+    using kirana::scene::ImageManager;
+    using kirana::scene::ImageProperties;
+    using kirana::scene::MaterialParameterType;
+
+    writer->writeString(param.id);
+    writer->write(static_cast<uint32_t>(param.type));
+    switch (param.type)
+    {
+    case MaterialParameterType::BOOL:
+        writer->write(static_cast<uint8_t>(std::any_cast<bool>(param.value)));
+        break;
+    case MaterialParameterType::INT:
+        writer->write(std::any_cast<int>(param.value));
+        break;
+    case MaterialParameterType::UINT:
+        writer->write(std::any_cast<uint32_t>(param.value));
+        break;
+    case MaterialParameterType::FLOAT:
+        writer->write(std::any_cast<float>(param.value));
+        break;
+    case MaterialParameterType::TEX_1D:
+    case MaterialParameterType::TEX_2D:
+    case MaterialParameterType::TEX_3D: {
+        // Image indices are only valid for the current session, so the image
+        // path is stored instead.
+        const int index = std::any_cast<int>(param.value);
+        const kirana::scene::Image *image =
+            index < 0 ? nullptr
+                      : ImageManager::get().getImage(
+                            static_cast<uint32_t>(index));
+        writer->writeString(image != nullptr ? image->getFilepath() : "");
+        const ImageProperties properties =
+            image != nullptr ? image->getProperties() : ImageProperties{};
+        writer->write(static_cast<uint8_t>(properties.colorSpace));
+        writer->write(static_cast<uint8_t>(properties.usage));
+    }
+    break;
+    case MaterialParameterType::INT64:
+        writer->write(std::any_cast<int64_t>(param.value));
+        break;
+    case MaterialParameterType::UINT64:
+        writer->write(std::any_cast<uint64_t>(param.value));
+        break;
+    case MaterialParameterType::DOUBLE:
+        writer->write(std::any_cast<double>(param.value));
+        break;
+    case MaterialParameterType::VEC_2:
+        writer->writeFloats(
+            std::any_cast<kirana::math::Vector2>(&param.value)->data(), 2);
+        break;
+    case MaterialParameterType::VEC_3:
+        writer->writeFloats(
+            std::any_cast<kirana::math::Vector3>(&param.value)->data(), 3);
+        break;
+    case MaterialParameterType::VEC_4:
+        writer->writeFloats(
+            std::any_cast<kirana::math::Vector4>(&param.value)->data(), 4);
+        break;
+    case MaterialParameterType::MAT_4x4:
+        writer->writeFloats(
+            std::any_cast<kirana::math::Matrix4x4>(&param.value)
+                ->data()
+                ->data(),
+            16);
+        break;
+    default:
+        break;
+    }
+}
+
+kirana::scene::MaterialParameter readParameter(
+    CacheReader *reader, std::vector<kirana::scene::Image *> *images)
+{
+    using kirana::scene::ColorSpace;
+    using kirana::scene::ImageManager;
+    using kirana::scene::ImageProperties;
+    using kirana::scene::ImageUsage;
+    using kirana::scene::MaterialParameterType;
+
+    kirana::scene::MaterialParameter param;
+    param.id = reader->readString();
+    param.type = static_cast<MaterialParameterType>(reader->read<uint32_t>());
+    switch (param.type)
+    {
+    case MaterialParameterType::BOOL:
+        param.value = reader->read<uint8_t>() != 0;
+        break;
+    case MaterialParameterType::INT:
+        param.value = reader->read<int>();
+        break;
+    case MaterialParameterType::UINT:
+        param.value = reader->read<uint32_t>();
+        break;
+    case MaterialParameterType::FLOAT:
+        param.value = reader->read<float>();
+        break;
+    case MaterialParameterType::TEX_1D:
+    case MaterialParameterType::TEX_2D:
+    case MaterialParameterType::TEX_3D: {
+        const std::string path = reader->readString();
+        ImageProperties properties;
+        properties.colorSpace =
+            static_cast<ColorSpace>(reader->read<uint8_t>());
+        properties.usage = static_cast<ImageUsage>(reader->read<uint8_t>());
+        int index = -1;
+        if (!path.empty())
+            index = ImageManager::get().addImage(path, "", properties);
+        if (index >= 0)
+            images->push_back(
+                ImageManager::get().getImage(static_cast<uint32_t>(index)));
+        param.value = index;
+    }
+    break;
+    case MaterialParameterType::INT64:
+        param.value = reader->read<int64_t>();
+        break;
+    case MaterialParameterType::UINT64:
+        param.value = reader->read<uint64_t>();
+        break;
+    case MaterialParameterType::DOUBLE:
+        param.value = reader->read<double>();
+        break;
+    case MaterialParameterType::VEC_2: {
+        float v[2]{0.0f};
+        reader->readFloats(v, 2);
+        param.value = kirana::math::Vector2(v[0], v[1]);
+    }
+    break;
+    case MaterialParameterType::VEC_3: {
+        float v[3]{0.0f};
+        reader->readFloats(v, 3);
+        param.value = kirana::math::Vector3(v[0], v[1], v[2]);
+    }
+    break;
+    case MaterialParameterType::VEC_4: {
+        float v[4]{0.0f};
+        reader->readFloats(v, 4);
+        param.value = kirana::math::Vector4(v[0], v[1], v[2], v[3]);
+    }
+    break;
+    case MaterialParameterType::MAT_4x4: {
+        float m[16]{0.0f};
+        reader->readFloats(m, 16);
+        param.value = kirana::math::Matrix4x4(
+            m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10],
+            m[11], m[12], m[13], m[14], m[15]);
+    }
+    break;
+    default:
+        // Unknown parameter type. The rest of the file can't be parsed.
+        reader->fail();
+        break;
+    }
+    return param;
+}
+} // namespace
+
+uint32_t kirana::scene::SceneCache::getImportSettingsMask(
+    const SceneImportSettings &importSettings)
+{
+    const bool settings[] = {importSettings.calculateTangentSpace,
+                             importSettings.joinIdenticalVertices,
+                             importSettings.triangulate,
+                             importSettings.generateNormals,
+                             importSettings.generateSmoothNormals,
+                             importSettings.improveCacheLocality,
+                             importSettings.optimizeMesh,
+                             importSettings.preTransformVertices,
+                             importSettings.generateBoundingBoxes,
+                             importSettings.generateUVs,
+                             importSettings.transformUVs,
+                             importSettings.flipUVs,
+                             importSettings.optimizeVertexCache,
+                             importSettings.optimizeOverdraw,
+                             importSettings.optimizeVertexFetch,
+                             importSettings.generateLODs,
+                             importSettings.buildMeshlets};
+    uint32_t mask = 0;
+    for (size_t i = 0; i < std::size(settings); i++)
+        mask |= settings[i] ? (1u << i) : 0u;
+    return mask;
+}
+
+uint64_t kirana::scene::SceneCache::getCacheKey(
+    const std::string &path, int64_t lastWriteTime,
+    const SceneImportSettings &importSettings)
+{
+    uint64_t key = utils::hash::fnv1a(path);
+    key = utils::hash::fnv1aValue(lastWriteTime, key);
+    key = utils::hash::fnv1aValue(getImportSettingsMask(importSettings), key);
+    key = utils::hash::fnv1aValue(constants::SCENE_CACHE_VERSION, key);
+    return key;
+}
+
+std::string kirana::scene::SceneCache::getCachePath(
+    const std::string &path, const SceneImportSettings &importSettings) const
+{
+    const int64_t lastWriteTime = utils::filesystem::getLastWriteTime(path);
+    if (lastWriteTime == 0)
+        return "";
+
+    std::stringstream filename;
+    filename << utils::filesystem::getFilename(path).first << "_"
+             << std::hex << std::setw(16) << std::setfill('0')
+             << getCacheKey(path, lastWriteTime, importSettings);
+    return utils::filesystem::combinePath(
+        constants::CACHE_DIR_PATH,
+        {constants::SCENE_CACHE_DIR_NAME, filename.str()},
+        constants::SCENE_CACHE_EXTENSION);
+}
+
+bool kirana::scene::SceneCache::loadScene(
+    const std::string &path, const SceneImportSettings &importSettings,
+    Scene *scene)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    const std::string cachePath = getCachePath(path, importSettings);
+    if (cachePath.empty() || !utils::filesystem::fileExists(cachePath))
+        return false;
+
+    // Geometry stored uncompressed is referenced directly from the mapping,
+    // so the mapped file is shared by all meshes of the scene.
+    auto mappedFile = std::make_shared<utils::MappedFile>();
+    if (!mappedFile->open(cachePath))
+        return false;
+
+    CacheReader reader(mappedFile->data(), mappedFile->size());
+
+    // Header
+    char magic[4]{};
+    reader.readBytes(magic, sizeof(magic));
+    const auto version = reader.read<uint32_t>();
+    const auto key = reader.read<uint64_t>();
+    const auto vertexSize = reader.read<uint32_t>();
+    const auto indexSize = reader.read<uint32_t>();
+    if (!reader.good() || memcmp(magic, SCENE_CACHE_MAGIC, 4) != 0 ||
+        version != constants::SCENE_CACHE_VERSION ||
+        key != getCacheKey(path, utils::filesystem::getLastWriteTime(path),
+                           importSettings) ||
+        vertexSize != sizeof(Vertex) || indexSize != sizeof(INDEX_TYPE))
+    {
+        Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::warning,
+                          "Ignoring outdated scene cache: " + cachePath);
+        return false;
+    }
+    const std::string sceneName = reader.readString();
+
+    // Materials
+    std::vector<std::shared_ptr<Material>> materials(
+        reader.readCount(MIN_MATERIAL_SIZE));
+    for (auto &m : materials)
+    {
+        const std::string name = reader.readString();
+        std::vector<MaterialParameter> parameters(
+            reader.readCount(MIN_PARAMETER_SIZE));
+        std::vector<Image *> images;
+        for (auto &p : parameters)
+            p = readParameter(&reader, &images);
+        if (!reader.good())
+            break;
+        m = std::make_shared<Material>(name, parameters, images);
+    }
+
+    // Meshes
+    std::vector<std::shared_ptr<Mesh>> meshes(
+        reader.readCount(MIN_MESH_SIZE));
+    for (auto &m : meshes)
+    {
+        const std::string name = reader.readString();
+        const math::Bounds3 bounds = reader.readBounds();
+        const auto materialIndex = reader.read<int32_t>();
+        const auto vertexCount = static_cast<size_t>(reader.read<uint64_t>());
+        const auto indexCount = static_cast<size_t>(reader.read<uint64_t>());
+        utils::ArrayView<const Vertex> vertexView;
+        utils::ArrayView<const INDEX_TYPE> indexView;
+        std::vector<Vertex> vertices;
+        std::vector<INDEX_TYPE> indices;
+        reader.readArray(vertexCount, &vertexView, &vertices);
+        reader.readArray(indexCount, &indexView, &indices);
+        std::vector<MeshLOD> lods(reader.readCount(LOD_SIZE));
+        for (auto &lod : lods)
+        {
+            lod.firstIndex = reader.read<uint32_t>();
+            lod.indexCount = reader.read<uint32_t>();
+            lod.error = reader.read<float>();
+        }
+        const auto lodIndexCount =
+            static_cast<size_t>(reader.read<uint64_t>());
+        utils::ArrayView<const INDEX_TYPE> lodIndexView;
+        std::vector<INDEX_TYPE> lodIndices;
+        reader.readArray(lodIndexCount, &lodIndexView, &lodIndices);
+        for (const auto &lod : lods)
+        {
+            if (static_cast<size_t>(lod.firstIndex) + lod.indexCount >
+                lodIndexCount)
+                reader.fail();
+        }
+        std::vector<Meshlet> meshlets(reader.readCount(MESHLET_SIZE));
+        for (auto &meshlet : meshlets)
+        {
+            meshlet.firstIndex = reader.read<uint32_t>();
+            meshlet.indexCount = reader.read<uint32_t>();
+            meshlet.vertexCount = reader.read<uint32_t>();
+            meshlet.bounds = reader.readBounds();
+            meshlet.center = reader.readVector3();
+            meshlet.radius = reader.read<float>();
+            meshlet.coneApex = reader.readVector3();
+            meshlet.coneAxis = reader.readVector3();
+            meshlet.coneCutoff = reader.read<float>();
+            if (static_cast<size_t>(meshlet.firstIndex) + meshlet.indexCount >
+                indexCount)
+                reader.fail();
+        }
+        if (!reader.good() ||
+            (materialIndex >= 0 &&
+             static_cast<size_t>(materialIndex) >= materials.size()))
+        {
+            reader.fail();
+            break;
+        }
+        const std::shared_ptr<Material> material =
+            materialIndex >= 0 ? materials[materialIndex] : nullptr;
+
+        // Arrays which were stored compressed are decompressed into owned
+        // storage.
+        const bool verticesMapped = vertices.size() != vertexCount;
+        const bool indicesMapped = indices.size() != indexCount;
+        if (verticesMapped && indicesMapped)
+        {
+            m = std::make_shared<Mesh>(name, bounds, vertexView, indexView,
+                                       mappedFile, material);
+        }
+        else
+        {
+            if (verticesMapped)
+                vertices.assign(vertexView.begin(), vertexView.end());
+            if (indicesMapped)
+                indices.assign(indexView.begin(), indexView.end());
+            m = std::make_shared<Mesh>(name, bounds, std::move(vertices),
+                                       std::move(indices), material);
+        }
+        // The LOD indices are referenced in place as long as the mesh keeps
+        // the mapped file alive.
+        const bool lodIndicesMapped = lodIndices.size() != lodIndexCount;
+        if (lodIndicesMapped && m->hasExternalData())
+            m->setLODs(std::move(lods), lodIndexView);
+        else
+        {
+            if (lodIndicesMapped)
+                lodIndices.assign(lodIndexView.begin(), lodIndexView.end());
+            m->setLODs(std::move(lods), std::move(lodIndices));
+        }
+        m->setMeshlets(std::move(meshlets));
+    }
+
+    // Objects. Parents are always stored before their children.
+    const auto transforms = std::make_shared<math::TransformStore>();
+    std::vector<std::shared_ptr<Object>> objects(
+        reader.readCount(MIN_OBJECT_SIZE));
+    for (size_t i = 0; i < objects.size() && reader.good(); i++)
+    {
+        const std::string name = reader.readString();
+        const auto parentIndex = reader.read<int32_t>();
+        float m[16]{0.0f};
+        reader.readFloats(m, 16);
+        const math::Matrix4x4 localMatrix(m[0], m[1], m[2], m[3], m[4], m[5],
+                                          m[6], m[7], m[8], m[9], m[10], m[11],
+                                          m[12], m[13], m[14], m[15]);
+        const math::Bounds3 objectBounds = reader.readBounds();
+        const math::Bounds3 hierarchyBounds = reader.readBounds();
+        std::vector<std::shared_ptr<Mesh>> objectMeshes(
+            reader.readCount(sizeof(uint32_t)));
+        for (auto &om : objectMeshes)
+        {
+            const auto meshIndex = reader.read<uint32_t>();
+            if (meshIndex >= meshes.size())
+            {
+                reader.fail();
+                break;
+            }
+            om = meshes[meshIndex];
+        }
+        if (!reader.good() || parentIndex >= static_cast<int32_t>(i))
+        {
+            reader.fail();
+            break;
+        }
+        objects[i] = std::make_shared<Object>(
+            name, objectMeshes, localMatrix, objectBounds, hierarchyBounds,
+            parentIndex >= 0 ? objects[parentIndex]->transform : nullptr,
+            transforms);
+    }
+
+    if (!reader.good() || objects.empty())
+    {
+        Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::warning,
+                          "Failed to read scene cache: " + cachePath);
+        return false;
+    }
+
+    scene->m_path = path;
+    scene->m_name = sceneName;
+    scene->m_materials = std::move(materials);
+    scene->m_meshes = std::move(meshes);
+    scene->m_objects = std::move(objects);
+    scene->m_transforms = transforms;
+    scene->m_isInitialized = true;
+
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::high_resolution_clock::now() - startTime;
+    Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
+                      "Loaded Scene from cache: " + cachePath + " (" +
+                          std::to_string(duration.count()) + " ms)");
+    return true;
+}
+
+bool kirana::scene::SceneCache::saveScene(
+    const std::string &path, const SceneImportSettings &importSettings,
+    const Scene &scene) const
+{
+    if (!scene.isInitialized() || scene.m_objects.empty())
+        return false;
+
+    const std::string cachePath = getCachePath(path, importSettings);
+    if (cachePath.empty() ||
+        !utils::filesystem::createDirectory(
+            utils::filesystem::getFolder(cachePath)))
+        return false;
+
+    // Write to a temporary file first so that a failed write never leaves a
+    // partial cache file behind.
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        CacheWriter writer(tempPath);
+        if (!writer.good())
+            return false;
+
+        // Header
+        writer.writeBytes(SCENE_CACHE_MAGIC, sizeof(SCENE_CACHE_MAGIC));
+        writer.write(constants::SCENE_CACHE_VERSION);
+        writer.write(getCacheKey(
+            path, utils::filesystem::getLastWriteTime(path), importSettings));
+        writer.write(static_cast<uint32_t>(sizeof(Vertex)));
+        writer.write(static_cast<uint32_t>(sizeof(INDEX_TYPE)));
+        writer.writeString(scene.m_name);
+
+        // Materials
+        std::unordered_map<const Material *, int32_t> materialIndices;
+        writer.write(static_cast<uint32_t>(scene.m_materials.size()));
+        for (size_t i = 0; i < scene.m_materials.size(); i++)
+        {
+            const Material &material = *scene.m_materials[i];
+            materialIndices[&material] = static_cast<int32_t>(i);
+
+            std::vector<const MaterialParameter *> parameters;
+            for (const auto &p : material.getParameters())
+            {
+                if (isParameterCacheable(p))
+                    parameters.push_back(&p);
+            }
+            writer.writeString(material.getName());
+            writer.write(static_cast<uint32_t>(parameters.size()));
+            for (const auto &p : parameters)
+                writeParameter(&writer, *p);
+        }
+
+        // Meshes
+        std::unordered_map<const Mesh *, uint32_t> meshIndices;
+        writer.write(static_cast<uint32_t>(scene.m_meshes.size()));
+        for (size_t i = 0; i < scene.m_meshes.size(); i++)
+        {
+            const Mesh &mesh = *scene.m_meshes[i];
+            meshIndices[&mesh] = static_cast<uint32_t>(i);
+
+            const auto matIt = materialIndices.find(mesh.getMaterial().get());
+            writer.writeString(mesh.getName());
+            writer.writeBounds(mesh.getBounds());
+            writer.write(matIt != materialIndices.end() ? matIt->second : -1);
+            writer.write(static_cast<uint64_t>(mesh.getVertices().size()));
+            writer.write(static_cast<uint64_t>(mesh.getIndices().size()));
+            if (!writer.writeBlob(mesh.getVertices().data(),
+                                  mesh.getVertices().sizeInBytes(),
+                                  constants::SCENE_CACHE_COMPRESS_GEOMETRY) ||
+                !writer.writeBlob(mesh.getIndices().data(),
+                                  mesh.getIndices().sizeInBytes(),
+                                  constants::SCENE_CACHE_COMPRESS_GEOMETRY))
+            {
+                Logger::get().log(constants::LOG_CHANNEL_SCENE,
+                                  LogSeverity::error,
+                                  "Failed to compress mesh: " +
+                                      mesh.getName());
+                return false;
+            }
+            writer.write(static_cast<uint32_t>(mesh.getLODs().size()));
+            for (const auto &lod : mesh.getLODs())
+            {
+                writer.write(lod.firstIndex);
+                writer.write(lod.indexCount);
+                writer.write(lod.error);
+            }
+            writer.write(static_cast<uint64_t>(mesh.getLODIndexData().size()));
+            if (!writer.writeBlob(mesh.getLODIndexData().data(),
+                                  mesh.getLODIndexData().sizeInBytes(),
+                                  constants::SCENE_CACHE_COMPRESS_GEOMETRY))
+            {
+                Logger::get().log(constants::LOG_CHANNEL_SCENE,
+                                  LogSeverity::error,
+                                  "Failed to compress mesh: " +
+                                      mesh.getName());
+                return false;
+            }
+            writer.write(static_cast<uint32_t>(mesh.getMeshlets().size()));
+            for (const auto &meshlet : mesh.getMeshlets())
+            {
+                writer.write(meshlet.firstIndex);
+                writer.write(meshlet.indexCount);
+                writer.write(meshlet.vertexCount);
+                writer.writeBounds(meshlet.bounds);
+                writer.writeFloats(meshlet.center.data(), 3);
+                writer.write(meshlet.radius);
+                writer.writeFloats(meshlet.coneApex.data(), 3);
+                writer.writeFloats(meshlet.coneAxis.data(), 3);
+                writer.write(meshlet.coneCutoff);
+            }
+        }
+
+        // Objects
+        std::unordered_map<const math::TransformHierarchy *, int32_t>
+            objectIndices;
+        writer.write(static_cast<uint32_t>(scene.m_objects.size()));
+        for (size_t i = 0; i < scene.m_objects.size(); i++)
+        {
+            const Object &object = *scene.m_objects[i];
+            objectIndices[object.transform] = static_cast<int32_t>(i);
+
+            const auto parentIt =
+                objectIndices.find(object.transform->getParent());
+            const math::Matrix4x4 localMatrix = object.transform->getMatrix(
+                math::TransformHierarchy::Space::Local);
+
+            writer.writeString(object.getName());
+            writer.write(parentIt != objectIndices.end() ? parentIt->second
+                                                         : -1);
+            writer.writeFloats(localMatrix.data()->data(), 16);
+            writer.writeBounds(object.m_objectBounds);
+            writer.writeBounds(object.m_hierarchyBounds);
+            writer.write(static_cast<uint32_t>(object.getMeshes().size()));
+            for (const auto &m : object.getMeshes())
+                writer.write(meshIndices.at(m.get()));
+        }
+
+        if (!writer.good())
+        {
+            Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::error,
+                              "Failed to write scene cache: " + tempPath);
+            return false;
+        }
+    }
+
+    std::remove(cachePath.c_str());
+    if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
+                      "Scene cache written: " + cachePath);
+    return true;
+}
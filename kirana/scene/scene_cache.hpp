@@ -0,0 +1,78 @@
+#ifndef KIRANA_SCENE_SCENE_CACHE_HPP
+#define KIRANA_SCENE_SCENE_CACHE_HPP
+
+#include "scene_types.hpp"
+
+#include <string>
+
+namespace kirana::scene
+{
+class Scene;
+
+/**
+ * Stores imported scenes in a versioned binary format so that re-opening a
+ * scene skips Assimp entirely. A cache file contains the vertex, index and
+ * level of detail data of every mesh, the flattened object hierarchy, the
+ * material parameters and the paths of the referenced images. Cache files are
+ * keyed by the source path, the last write time of the source file and the
+ * import settings, so editing the source file or changing the settings
+ * invalidates the cache.
+ *
+ * Cache files are memory-mapped when loaded. Uncompressed vertex and index
+ * data is aligned in the file and referenced by the meshes in place, so it is
+ * never copied into separate CPU buffers.
+ */
+class SceneCache
+{
+  public:
+    SceneCache(const SceneCache &sceneCache) = delete;
+
+    static SceneCache &get()
+    {
+        static SceneCache instance;
+        return instance;
+    }
+
+    /**
+     * Returns the path of the cache file for the given scene.
+     * @param path Path of the source scene file.
+     * @param importSettings The import settings used to import the scene.
+     * @return Path of the cache file. Empty if the source file doesn't exist.
+     */
+    [[nodiscard]] std::string getCachePath(
+        const std::string &path,
+        const SceneImportSettings &importSettings) const;
+
+    /**
+     * Initializes the scene from its cache file.
+     * @param path Path of the source scene file.
+     * @param importSettings The import settings used to import the scene.
+     * @param scene The scene to initialize. Left untouched on failure.
+     * @return true if a valid cache file was found and read.
+     */
+    bool loadScene(const std::string &path,
+                   const SceneImportSettings &importSettings, Scene *scene);
+
+    /**
+     * Writes the given (imported) scene to its cache file.
+     * @param path Path of the source scene file.
+     * @param importSettings The import settings used to import the scene.
+     * @param scene The initialized scene.
+     * @return true if the cache file was written.
+     */
+    bool saveScene(const std::string &path,
+                   const SceneImportSettings &importSettings,
+                   const Scene &scene) const;
+
+  private:
+    SceneCache() = default;
+    ~SceneCache() = default;
+
+    static uint32_t getImportSettingsMask(
+        const SceneImportSettings &importSettings);
+    static uint64_t getCacheKey(const std::string &path, int64_t lastWriteTime,
+                                const SceneImportSettings &importSettings);
+};
+} // namespace kirana::scene
+
+#endif // KIRANA_SCENE_SCENE_CACHE_HPP
@@ -5,15 +5,43 @@
 
 #include <assimp/DefaultLogger.hpp>
 #include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <algorithm>
 #include <string>
 
 using kirana::utils::Logger;
 using kirana::utils::LogSeverity;
 namespace constants = kirana::utils::constants;
 
+namespace
+{
+/// Forwards the file reading and post-processing progress of Assimp.
+class ImportProgressHandler : public Assimp::ProgressHandler
+{
+  private:
+    const kirana::scene::SceneLoadProgressCallback &m_onProgress;
+
+  public:
+    explicit ImportProgressHandler(
+        const kirana::scene::SceneLoadProgressCallback &onProgress)
+        : m_onProgress{onProgress}
+    {
+    }
+
+    bool Update(float percentage) override
+    {
+        if (percentage >= 0.0f)
+            m_onProgress(kirana::scene::SceneLoadProgress{
+                kirana::scene::SceneLoadStage::READING,
+                std::min(percentage, 1.0f)});
+        return true;
+    }
+};
+} // namespace
+
 uint32_t kirana::scene::SceneImporter::getPostProcessMask(
     const SceneImportSettings &importSettings)
 {
@@ -47,9 +75,13 @@ uint32_t kirana::scene::SceneImporter::getPostProcessMask(
 }
 
 bool kirana::scene::SceneImporter::loadSceneFromFile(
-    const char *path, const SceneImportSettings &importSettings, Scene *scene)
+    const char *path, const SceneImportSettings &importSettings, Scene *scene,
+    const SceneLoadProgressCallback &onProgress)
 {
     Assimp::Importer importer;
+    // The importer takes ownership of the handler.
+    if (onProgress)
+        importer.SetProgressHandler(new ImportProgressHandler(onProgress));
 
     const aiScene *aiScene = importer.ReadFile(
         path, getPostProcessMask(importSettings));
@@ -62,6 +94,6 @@ bool kirana::scene::SceneImporter::loadSceneFromFile(
         return false;
     }
 
-    scene->initFromAiScene(path, aiScene);
+    scene->initFromAiScene(path, aiScene, importSettings, onProgress);
     return true;
 }
\ No newline at end of file
@@ -24,7 +24,8 @@ class SceneImporter
     }
 
     bool loadSceneFromFile(const char *path,
-                           const SceneImportSettings &importSettings, Scene *scene);
+                           const SceneImportSettings &importSettings, Scene *scene,
+                           const SceneLoadProgressCallback &onProgress = nullptr);
 };
 } // namespace kirana::scene
 #endif
\ No newline at end of file
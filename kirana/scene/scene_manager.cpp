@@ -1,6 +1,7 @@
 #include "scene_manager.hpp"
 
 #include "scene_importer.hpp"
+#include "scene_cache.hpp"
 #include "scene_types.hpp"
 #include <file_system.hpp>
 #include <logger.hpp>
@@ -171,18 +172,13 @@ void kirana::scene::SceneManager::checkForObjectSelection(bool multiSelect)
     const math::Ray &ray =
         m_viewportCamera.screenPositionToRay(m_inputManager.getMousePosition());
 
-    // TODO: Write an efficient object selection using BVH
-    for (size_t i = 0; i < m_viewportScene.m_currentScene.m_objects.size(); i++)
+    const Object *nearest = m_viewportScene.m_currentScene.intersectRay(ray);
+    if (nearest != nullptr)
     {
-        const auto &o = m_viewportScene.m_currentScene.m_objects[i];
-        if (o->getObjectBounds().intersectWithRay(ray))
-        {
-            m_viewportScene.toggleObjectSelection(o->getName(), multiSelect);
-            Logger::get().log(constants::LOG_CHANNEL_VIEWPORT,
-                              LogSeverity::trace,
-                              "Object Selected: " + o->getName());
-            return;
-        }
+        m_viewportScene.toggleObjectSelection(nearest->getName(), multiSelect);
+        Logger::get().log(constants::LOG_CHANNEL_VIEWPORT, LogSeverity::trace,
+                          "Object Selected: " + nearest->getName());
+        return;
     }
 
     if (!multiSelect)
@@ -226,6 +222,78 @@ kirana::scene::SceneManager::SceneManager()
     resetViewportCamera();
 }
 
+bool kirana::scene::SceneManager::readScene(
+    const std::string &path, const SceneImportSettings &importSettings,
+    Scene *scene, const SceneLoadProgressCallback &onProgress)
+{
+    // The BVH refers to the objects of the scene, which are replaced.
+    scene->m_bvh.clear();
+    if (!constants::SCENE_CACHE_ENABLED ||
+        !SceneCache::get().loadScene(path, importSettings, scene))
+    {
+        if (!SceneImporter::get().loadSceneFromFile(
+                path.c_str(), importSettings, scene, onProgress))
+            return false;
+        if (constants::SCENE_CACHE_ENABLED)
+            SceneCache::get().saveScene(path, importSettings, *scene);
+    }
+    if (scene->isInitialized())
+        scene->buildBVH();
+    return scene->isInitialized();
+}
+
+void kirana::scene::SceneManager::onLoadProgress(
+    const SceneLoadProgress &progress)
+{
+    // Called from the load job (and its worker threads), possibly out of
+    // order, so the progress is only ever moved forward.
+    std::lock_guard<std::mutex> lock(m_loadProgressMutex);
+    if (progress.stage > m_loadProgress.stage ||
+        (progress.stage == m_loadProgress.stage &&
+         progress.progress > m_loadProgress.progress))
+        m_loadProgress = progress;
+}
+
+void kirana::scene::SceneManager::updateSceneLoad()
+{
+    SceneLoadProgress progress;
+    {
+        std::lock_guard<std::mutex> lock(m_loadProgressMutex);
+        progress = m_loadProgress;
+    }
+    if (progress.stage != m_reportedLoadProgress.stage ||
+        progress.progress != m_reportedLoadProgress.progress)
+    {
+        m_reportedLoadProgress = progress;
+        m_onSceneLoadProgress(m_reportedLoadProgress);
+    }
+
+    if (m_sceneLoadJob.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready)
+        return;
+
+    const bool result = m_sceneLoadJob.get();
+    if (result)
+        m_viewportScene.m_currentScene = std::move(*m_loadingScene);
+    m_loadingScene.reset();
+    m_viewportScene.onSceneLoaded();
+
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::steady_clock::now() - m_loadStartTime;
+    if (result)
+        Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::debug,
+                          "Loaded scene in background in " +
+                              std::to_string(duration.count()) +
+                              " ms: " + m_loadingScenePath);
+    else
+        Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::error,
+                          "Failed to load scene: " + m_loadingScenePath);
+
+    m_reportedLoadProgress = SceneLoadProgress{
+        result ? SceneLoadStage::FINISHED : SceneLoadStage::FAILED, 1.0f};
+    m_onSceneLoadProgress(m_reportedLoadProgress);
+}
+
 bool kirana::scene::SceneManager::loadScene(
     std::string path, const SceneImportSettings &importSettings)
 {
@@ -233,13 +301,44 @@ bool kirana::scene::SceneManager::loadScene(
         path = utils::filesystem::combinePath(constants::DATA_DIR_PATH,
                                               {constants::DEFAULT_MODEL_NAME});
 
-    scene::SceneImporter::get().loadSceneFromFile(
-        path.c_str(), importSettings, &m_viewportScene.m_currentScene);
-
+    readScene(path, importSettings, &m_viewportScene.m_currentScene);
     m_viewportScene.onSceneLoaded();
     return m_viewportScene.m_currentScene.isInitialized();
 }
 
+bool kirana::scene::SceneManager::loadSceneAsync(
+    std::string path, const SceneImportSettings &importSettings)
+{
+    if (isLoadingScene())
+    {
+        Logger::get().log(constants::LOG_CHANNEL_SCENE, LogSeverity::warning,
+                          "A scene is already being loaded: " +
+                              m_loadingScenePath);
+        return false;
+    }
+    if (path.empty())
+        path = utils::filesystem::combinePath(constants::DATA_DIR_PATH,
+                                              {constants::DEFAULT_MODEL_NAME});
+
+    m_loadingScenePath = path;
+    m_loadingScene = std::make_unique<Scene>();
+    m_loadProgress = SceneLoadProgress{};
+    m_reportedLoadProgress = SceneLoadProgress{};
+    m_onSceneLoadProgress(m_reportedLoadProgress);
+    m_loadStartTime = std::chrono::steady_clock::now();
+
+    // The settings are copied, since the job outlives the caller's arguments.
+    m_sceneLoadJob = std::async(
+        std::launch::async,
+        [this, path, importSettings, scene = m_loadingScene.get()]() {
+            return readScene(path, importSettings, scene,
+                             [this](const SceneLoadProgress &progress) {
+                                 onLoadProgress(progress);
+                             });
+        });
+    return true;
+}
+
 void kirana::scene::SceneManager::init()
 {
     resetViewportCamera();
@@ -248,8 +347,17 @@ void kirana::scene::SceneManager::init()
 void kirana::scene::SceneManager::update()
 {
     handleViewportCameraMovement();
+    if (isLoadingScene())
+        updateSceneLoad();
+    m_viewportScene.m_currentScene.updateTransforms();
+    math::TransformStore::getDefault()->update();
 }
 
 void kirana::scene::SceneManager::clean()
 {
+    // Wait for the load job, since it writes to the scene being loaded.
+    if (m_sceneLoadJob.valid())
+        m_sceneLoadJob.wait();
+    m_sceneLoadJob = std::future<bool>();
+    m_loadingScene.reset();
 }
\ No newline at end of file
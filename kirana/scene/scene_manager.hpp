@@ -5,6 +5,10 @@
 
 #include <input_manager.hpp>
 #include <time.hpp>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 
 namespace kirana::scene
@@ -30,6 +34,24 @@ class SceneManager
     Camera &m_viewportCamera;
     ViewportCameraData m_viewportCamData;
 
+    mutable utils::Event<const SceneLoadProgress &> m_onSceneLoadProgress;
+    // The scene being loaded in the background. Moved into the viewport scene
+    // once the load job has finished.
+    std::future<bool> m_sceneLoadJob;
+    std::unique_ptr<Scene> m_loadingScene;
+    std::string m_loadingScenePath;
+    std::chrono::steady_clock::time_point m_loadStartTime;
+    // Written by the load job and read on the main thread.
+    std::mutex m_loadProgressMutex;
+    SceneLoadProgress m_loadProgress;
+    SceneLoadProgress m_reportedLoadProgress;
+
+    static bool readScene(const std::string &path,
+                          const SceneImportSettings &importSettings,
+                          Scene *scene,
+                          const SceneLoadProgressCallback &onProgress = nullptr);
+    void onLoadProgress(const SceneLoadProgress &progress);
+    void updateSceneLoad();
     void resetViewportCamera();
     void handleViewportCameraMovement();
     void checkForObjectSelection(bool multiSelect = false);
@@ -51,6 +73,37 @@ class SceneManager
                            const SceneImportSettings &importSettings =
                                DEFAULT_SCENE_IMPORT_SETTINGS);
 
+    /**
+     * Loads the scene on a background thread, so the viewport keeps rendering
+     * while the scene file is read and its meshes are processed. The progress
+     * is reported through the scene load progress event, which is fired from
+     * update() on the main thread. The loaded scene replaces the current
+     * scene in update() once the load has finished.
+     * @param path Path of the scene file. The default scene is loaded if
+     * empty.
+     * @param importSettings The import settings.
+     * @return false if another scene is still being loaded.
+     */
+    bool loadSceneAsync(std::string path = "",
+                        const SceneImportSettings &importSettings =
+                            DEFAULT_SCENE_IMPORT_SETTINGS);
+
+    [[nodiscard]] inline bool isLoadingScene() const
+    {
+        return m_sceneLoadJob.valid();
+    }
+
+    inline uint32_t addOnSceneLoadProgressEventListener(
+        const std::function<void(const SceneLoadProgress &)> &callback) const
+    {
+        return m_onSceneLoadProgress.addListener(callback);
+    }
+    inline void removeOnSceneLoadProgressEventListener(
+        uint32_t callbackID) const
+    {
+        m_onSceneLoadProgress.removeListener(callbackID);
+    }
+
     inline ViewportScene &getViewportScene()
     {
         return m_viewportScene;
@@ -1,10 +1,1571 @@
+#include "image_cache.hpp"
+#include "image_compression.hpp"
+#include "image_manager.hpp"
+#include "image_processing.hpp"
 #include "material_properties.hpp"
+#include "mesh.hpp"
+#include "mesh_optimizer.hpp"
+#include "object.hpp"
+#include "path_tracer.hpp"
+#include "perspective_camera.hpp"
+#include "scene.hpp"
+#include "scene_bvh.hpp"
+#include "scene_cache.hpp"
+#include "scene_importer.hpp"
+#include "scene_types.hpp"
+
+#include <assimp/mesh.h>
+#include <constants.h>
+#include <file_system.hpp>
+#include <math_utils.hpp>
+#include <thread_pool.hpp>
+#include <triangle.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 
 using kirana::math::Vector4;
+using kirana::scene::ColorSpace;
+using kirana::scene::Image;
+using kirana::scene::ImageCache;
+using kirana::scene::ImageCompression;
+using kirana::scene::ImageManager;
 using kirana::scene::MaterialParameter;
 using kirana::scene::MaterialParameterType;
 using kirana::scene::MaterialProperties;
+using kirana::scene::Mesh;
+using kirana::scene::Object;
+using kirana::scene::PixelDataType;
+using kirana::scene::Vertex;
+using kirana::utils::ThreadPool;
+
+/**
+ * Creates a triangulated grid mesh with normals, colors and texture
+ * coordinates, similar to what Assimp outputs after post-processing.
+ */
+std::unique_ptr<aiMesh> createGridMesh(unsigned int resolution)
+{
+    const unsigned int rowVertices = resolution + 1;
+    auto mesh = std::make_unique<aiMesh>();
+    mesh->mName = aiString("Grid_" + std::to_string(resolution));
+    mesh->mPrimitiveTypes = aiPrimitiveType::aiPrimitiveType_TRIANGLE;
+    mesh->mNumVertices = rowVertices * rowVertices;
+    mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+    mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+    mesh->mColors[0] = new aiColor4D[mesh->mNumVertices];
+    mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+    mesh->mNumUVComponents[0] = 2;
+    for (unsigned int y = 0; y < rowVertices; y++)
+    {
+        for (unsigned int x = 0; x < rowVertices; x++)
+        {
+            const unsigned int i = y * rowVertices + x;
+            const float u = static_cast<float>(x) / resolution;
+            const float v = static_cast<float>(y) / resolution;
+            mesh->mVertices[i] = aiVector3D(u, 0.0f, v);
+            mesh->mNormals[i] = aiVector3D(0.0f, 1.0f, 0.0f);
+            mesh->mColors[0][i] = aiColor4D(u, v, 1.0f, 1.0f);
+            mesh->mTextureCoords[0][i] = aiVector3D(u, v, 0.0f);
+        }
+    }
+    mesh->mAABB.mMin = aiVector3D(0.0f, 0.0f, 0.0f);
+    mesh->mAABB.mMax = aiVector3D(1.0f, 0.0f, 1.0f);
+
+    mesh->mNumFaces = resolution * resolution * 2;
+    mesh->mFaces = new aiFace[mesh->mNumFaces];
+    unsigned int f = 0;
+    for (unsigned int y = 0; y < resolution; y++)
+    {
+        for (unsigned int x = 0; x < resolution; x++)
+        {
+            const unsigned int i = y * rowVertices + x;
+            const unsigned int quad[2][3] = {
+                {i, i + rowVertices, i + 1},
+                {i + 1, i + rowVertices, i + rowVertices + 1}};
+            for (const auto &triangle : quad)
+            {
+                aiFace &face = mesh->mFaces[f++];
+                face.mNumIndices = 3;
+                face.mIndices = new unsigned int[3]{triangle[0], triangle[1],
+                                                    triangle[2]};
+            }
+        }
+    }
+    return mesh;
+}
+
+/**
+ * Compares serial and parallel conversion of Assimp meshes, the way
+ * Scene::initFromAiScene creates them.
+ */
+void benchmarkMeshConversion(size_t meshCount, unsigned int resolution)
+{
+    std::vector<std::unique_ptr<aiMesh>> aiMeshes(meshCount);
+    for (auto &m : aiMeshes)
+        m = createGridMesh(resolution);
+
+    std::vector<std::shared_ptr<Mesh>> meshes(meshCount);
+    const auto serialStart = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < meshCount; i++)
+        meshes[i] = std::make_shared<Mesh>(aiMeshes[i].get(), nullptr);
+    const std::chrono::duration<double, std::milli> serialTime =
+        std::chrono::high_resolution_clock::now() - serialStart;
+
+    meshes.clear();
+    meshes.resize(meshCount);
+    const auto parallelStart = std::chrono::high_resolution_clock::now();
+    ThreadPool::get().parallelFor(meshCount, [&](size_t i) {
+        meshes[i] = std::make_shared<Mesh>(aiMeshes[i].get(), nullptr);
+    });
+    const std::chrono::duration<double, std::milli> parallelTime =
+        std::chrono::high_resolution_clock::now() - parallelStart;
+
+    bool ordered = true;
+    for (size_t i = 0; i < meshCount; i++)
+        ordered &= meshes[i]->getName() == aiMeshes[i]->mName.C_Str();
+
+    std::cout << "Mesh conversion (" << meshCount << " meshes, "
+              << resolution * resolution * 2 << " triangles each)"
+              << std::endl;
+    std::cout << "Serial: " << serialTime.count() << " ms" << std::endl;
+    std::cout << "Parallel (" << ThreadPool::get().getThreadCount() + 1
+              << " threads on " << std::thread::hardware_concurrency()
+              << " cores): " << parallelTime.count() << " ms" << std::endl;
+    std::cout << "Speedup: " << serialTime.count() / parallelTime.count()
+              << "x, Order preserved: " << (ordered ? "yes" : "no")
+              << std::endl;
+}
+
+/**
+ * Throws from the body of parallelFor() at the first and at the last index,
+ * which run on different threads, and checks that the exception reaches the
+ * caller and that the pool still works afterwards.
+ */
+void testParallelForExceptions()
+{
+    ThreadPool pool(3);
+    bool passed = true;
+    for (const size_t throwingIndex : {size_t{0}, size_t{4095}})
+    {
+        std::atomic<size_t> callCount{0};
+        try
+        {
+            pool.parallelFor(4096, [&](size_t i) {
+                callCount++;
+                if (i == throwingIndex)
+                    throw std::runtime_error(std::to_string(i));
+            });
+            passed = false;
+        }
+        catch (const std::runtime_error &e)
+        {
+            passed = passed && e.what() == std::to_string(throwingIndex);
+        }
+        passed = passed && callCount <= 4096;
+    }
+
+    std::atomic<size_t> sum{0};
+    pool.parallelFor(4096, [&](size_t i) { sum += i; }, 16);
+    passed = passed && sum == size_t{4096} * 4095 / 2;
+    std::cout << "ThreadPool::parallelFor exceptions on "
+              << pool.getThreadCount() + 1 << " threads "
+              << (passed ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * The previous per-face aiMesh conversion, kept as a baseline for
+ * benchmarkLinearMeshConversion.
+ */
+void convertMeshPerFace(const aiMesh *mesh, std::vector<Vertex> *vertices,
+                        std::vector<kirana::scene::INDEX_TYPE> *indices)
+{
+    vertices->resize(mesh->mNumVertices);
+    for (size_t i = 0; i < mesh->mNumFaces; i++)
+    {
+        const aiFace &face = mesh->mFaces[i];
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            const unsigned int v = face.mIndices[c];
+            indices->push_back(v);
+            Vertex &vertex = (*vertices)[v];
+            vertex.position[0] = mesh->mVertices[v].x;
+            vertex.position[1] = mesh->mVertices[v].y;
+            vertex.position[2] = mesh->mVertices[v].z;
+            if (mesh->HasNormals())
+            {
+                vertex.normal[0] = mesh->mNormals[v].x;
+                vertex.normal[1] = mesh->mNormals[v].y;
+                vertex.normal[2] = mesh->mNormals[v].z;
+            }
+            if (mesh->HasVertexColors(0))
+            {
+                vertex.color[0] = mesh->mColors[0][v].r;
+                vertex.color[1] = mesh->mColors[0][v].g;
+                vertex.color[2] = mesh->mColors[0][v].b;
+                vertex.color[3] = mesh->mColors[0][v].a;
+            }
+            if (mesh->HasTextureCoords(0))
+            {
+                vertex.texCoords[0] = mesh->mTextureCoords[0][v].x;
+                vertex.texCoords[1] = mesh->mTextureCoords[0][v].y;
+            }
+        }
+    }
+}
+
+/**
+ * Compares the linear aiMesh to Mesh conversion against the per-face
+ * conversion on a mesh with about a million triangles.
+ */
+void benchmarkLinearMeshConversion(unsigned int resolution, int iterations)
+{
+    const std::unique_ptr<aiMesh> aiGrid = createGridMesh(resolution);
+
+    double perFaceTime = 0.0;
+    double linearTime = 0.0;
+    bool identical = true;
+    for (int i = 0; i < iterations; i++)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<kirana::scene::INDEX_TYPE> indices;
+        auto start = std::chrono::high_resolution_clock::now();
+        convertMeshPerFace(aiGrid.get(), &vertices, &indices);
+        perFaceTime += std::chrono::duration<double, std::milli>(
+                           std::chrono::high_resolution_clock::now() - start)
+                           .count();
+
+        start = std::chrono::high_resolution_clock::now();
+        const Mesh mesh(aiGrid.get(), nullptr);
+        linearTime += std::chrono::duration<double, std::milli>(
+                          std::chrono::high_resolution_clock::now() - start)
+                          .count();
+
+        identical &= mesh.getVertices().size() == vertices.size() &&
+                     mesh.getIndices().size() == indices.size() &&
+                     std::equal(indices.begin(), indices.end(),
+                                mesh.getIndices().begin()) &&
+                     memcmp(vertices.data(), mesh.getVertices().data(),
+                            mesh.getVertices().sizeInBytes()) == 0;
+    }
+
+    std::cout << "aiMesh conversion (" << aiGrid->mNumFaces << " triangles, "
+              << aiGrid->mNumVertices << " vertices)" << std::endl;
+    std::cout << "Per-face: " << perFaceTime / iterations << " ms" << std::endl;
+    std::cout << "Linear: " << linearTime / iterations << " ms" << std::endl;
+    std::cout << "Speedup: " << perFaceTime / linearTime
+              << "x, Identical: " << (identical ? "yes" : "no") << std::endl;
+}
+
+/**
+ * Packs random unit normals into compact vertices and reports the size and the
+ * largest decoding error.
+ */
+void testCompactVertexPacking(size_t vertexCount)
+{
+    std::vector<Vertex> vertices(vertexCount);
+    uint32_t state = 1;
+    const auto random = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) / 16777216.0f * 2.0f - 1.0f;
+    };
+    for (auto &v : vertices)
+    {
+        const kirana::math::Vector3 n{random(), random(), random()};
+        v.normal = kirana::math::Vector3::normalize(n);
+        v.texCoords = kirana::math::Vector2(random(), random());
+    }
+
+    std::vector<kirana::scene::CompactVertex> compact(vertexCount);
+    kirana::scene::CompactVertex::pack(vertices.data(), vertexCount,
+                                       compact.data());
+
+    float maxAngle = 0.0f;
+    float maxUVError = 0.0f;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        // Same decoding as decodeOctahedralNormal() in the shaders.
+        const float x = std::fmax(compact[i].normal[0] / 32767.0f, -1.0f);
+        const float y = std::fmax(compact[i].normal[1] / 32767.0f, -1.0f);
+        kirana::math::Vector3 n{x, y, 1.0f - std::fabs(x) - std::fabs(y)};
+        const float t = std::fmax(-n[2], 0.0f);
+        n[0] += n[0] >= 0.0f ? -t : t;
+        n[1] += n[1] >= 0.0f ? -t : t;
+        n = kirana::math::Vector3::normalize(n);
+        const float cosAngle = std::fmin(
+            kirana::math::Vector3::dot(n, vertices[i].normal), 1.0f);
+        maxAngle = std::fmax(maxAngle, std::acos(cosAngle));
+        maxUVError = std::fmax(
+            maxUVError,
+            std::fabs(kirana::math::halfToFloat(compact[i].texCoords[0]) -
+                      vertices[i].texCoords[0]));
+    }
+
+    std::cout << "Compact vertex size: " << sizeof(kirana::scene::CompactVertex)
+              << " bytes (Vertex: " << sizeof(Vertex) << " bytes)" << std::endl;
+    std::cout << "Max normal error: " << kirana::math::degrees(maxAngle)
+              << " degrees, Max UV error: " << maxUVError << std::endl;
+}
+
+/**
+ * Checks that meshes with the same content but different names are detected
+ * as duplicates.
+ */
+void testMeshDeduplication()
+{
+    const std::unique_ptr<aiMesh> grid = createGridMesh(64);
+    const std::unique_ptr<aiMesh> gridCopy = createGridMesh(64);
+    gridCopy->mName = aiString("Grid_Copy");
+    const std::unique_ptr<aiMesh> otherGrid = createGridMesh(65);
+
+    const Mesh mesh(grid.get(), nullptr);
+    const Mesh meshCopy(gridCopy.get(), nullptr);
+    const Mesh otherMesh(otherGrid.get(), nullptr);
+
+    const bool duplicateFound =
+        mesh.getContentHash() == meshCopy.getContentHash() &&
+        mesh.hasSameContent(meshCopy);
+    const bool differentFound =
+        mesh.getContentHash() != otherMesh.getContentHash() &&
+        !mesh.hasSameContent(otherMesh);
+    std::cout << "Mesh deduplication: "
+              << (duplicateFound && differentFound ? "passed" : "failed")
+              << std::endl;
+}
+
+/**
+ * Shuffles the triangles of a dense grid and reports the vertex cache
+ * efficiency after each mesh optimization pass.
+ */
+void benchmarkMeshOptimization(unsigned int resolution)
+{
+    namespace optimizer = kirana::scene::mesh_optimizer;
+    const std::unique_ptr<aiMesh> aiGrid = createGridMesh(resolution);
+    const Mesh grid(aiGrid.get(), nullptr);
+    std::vector<Vertex> vertices(grid.getVertices().begin(),
+                                 grid.getVertices().end());
+    std::vector<kirana::scene::INDEX_TYPE> indices(grid.getIndices().begin(),
+                                                   grid.getIndices().end());
+
+    std::vector<std::array<kirana::scene::INDEX_TYPE, 3>> triangles(
+        indices.size() / 3);
+    std::memcpy(triangles.data(), indices.data(),
+                indices.size() * sizeof(kirana::scene::INDEX_TYPE));
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+    std::memcpy(indices.data(), triangles.data(),
+                indices.size() * sizeof(kirana::scene::INDEX_TYPE));
+
+    const auto printStatistics = [&](const std::string &pass, double time) {
+        const auto stats = optimizer::analyzeVertexCache(
+            {indices.data(), indices.size()}, vertices.size());
+        std::cout << pass << ": ACMR " << stats.acmr << ", ATVR "
+                  << stats.atvr << " (" << time << " ms)" << std::endl;
+    };
+    const auto measure = [](const auto &function) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        function();
+        return std::chrono::duration<double, std::milli>(
+                   std::chrono::high_resolution_clock::now() - start)
+            .count();
+    };
+
+    std::cout << "Mesh optimization (" << indices.size() / 3
+              << " shuffled triangles)" << std::endl;
+    printStatistics("Unoptimized", 0.0);
+    printStatistics("Vertex cache", measure([&]() {
+                        optimizer::optimizeVertexCache(&indices,
+                                                       vertices.size());
+                    }));
+    printStatistics("Overdraw", measure([&]() {
+                        optimizer::optimizeOverdraw(&indices, vertices);
+                    }));
+    printStatistics("Vertex fetch", measure([&]() {
+                        optimizer::optimizeVertexFetch(&vertices, &indices);
+                    }));
+}
+
+/**
+ * Generates the levels of detail of a curved grid, both indexed and as a
+ * triangle soup, and checks that every level is smaller than the previous one
+ * and references valid vertices.
+ */
+void testMeshLODGeneration(unsigned int resolution)
+{
+    const std::unique_ptr<aiMesh> aiGrid = createGridMesh(resolution);
+    for (unsigned int i = 0; i < aiGrid->mNumVertices; i++)
+    {
+        aiVector3D &p = aiGrid->mVertices[i];
+        p.y = 0.05f * std::sin(p.x * 6.0f) * std::cos(p.z * 6.0f);
+    }
+    Mesh grid(aiGrid.get(), nullptr);
+
+    // The same grid with separate vertices for every triangle, like the
+    // meshes Assimp imports without joinIdenticalVertices.
+    std::vector<Vertex> soupVertices;
+    std::vector<kirana::scene::INDEX_TYPE> soupIndices;
+    for (const auto index : grid.getIndices())
+    {
+        soupIndices.push_back(
+            static_cast<kirana::scene::INDEX_TYPE>(soupVertices.size()));
+        soupVertices.push_back(grid.getVertices()[index]);
+    }
+    Mesh soup("Soup", grid.getBounds(), std::move(soupVertices),
+              std::move(soupIndices), nullptr);
+
+    for (Mesh *mesh : {&grid, &soup})
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        mesh->generateLODs(kirana::scene::DEFAULT_SCENE_IMPORT_SETTINGS);
+        const std::chrono::duration<double, std::milli> duration =
+            std::chrono::high_resolution_clock::now() - start;
+
+        bool isValid = mesh->getLODCount() > 1;
+        std::cout << "Mesh LODs of " << mesh->getName() << " ("
+                  << duration.count() << " ms):";
+        for (size_t lod = 0; lod < mesh->getLODCount(); lod++)
+        {
+            const auto indices = mesh->getLODIndices(lod);
+            std::cout << " " << indices.size() / 3 << " ("
+                      << mesh->getLODError(lod) * 100.0f << "%)";
+            for (const auto index : indices)
+                isValid = isValid && index < mesh->getVertices().size();
+            if (lod > 0)
+            {
+                isValid = isValid &&
+                          indices.size() <
+                              mesh->getLODIndices(lod - 1).size() &&
+                          mesh->getLODError(lod) >=
+                              mesh->getLODError(lod - 1);
+            }
+        }
+        std::cout << (isValid ? " passed" : " failed") << std::endl;
+    }
+}
+
+
+/**
+ * Splits a grid into meshlets and checks the limits, the index coverage, the
+ * bounding spheres and the normal cones of the meshlets.
+ */
+void testMeshletBuild(unsigned int resolution)
+{
+    const std::unique_ptr<aiMesh> aiGrid = createGridMesh(resolution);
+    Mesh grid(aiGrid.get(), nullptr);
+    grid.optimize(kirana::scene::DEFAULT_SCENE_IMPORT_SETTINGS);
+    grid.buildMeshlets();
+
+    const auto vertices = grid.getVertices();
+    const auto indices = grid.getIndices();
+    const auto &meshlets = grid.getMeshlets();
+    // The grid faces up, so it's back-facing when viewed from below.
+    const kirana::math::Vector3 above(0.5f, 1.0f, 0.5f);
+    const kirana::math::Vector3 below(0.5f, -1.0f, 0.5f);
+
+    bool isValid = !meshlets.empty();
+    uint32_t nextIndex = 0;
+    size_t culledBelow = 0;
+    size_t culledAbove = 0;
+    for (const auto &meshlet : meshlets)
+    {
+        isValid = isValid && meshlet.firstIndex == nextIndex &&
+                  meshlet.vertexCount <=
+                      kirana::utils::constants::SCENE_MESHLET_MAX_VERTICES &&
+                  meshlet.indexCount / 3 <=
+                      kirana::utils::constants::SCENE_MESHLET_MAX_TRIANGLES;
+        nextIndex = meshlet.firstIndex + meshlet.indexCount;
+        for (uint32_t i = 0; i < meshlet.indexCount; i++)
+        {
+            const auto &position =
+                vertices[indices[meshlet.firstIndex + i]].position;
+            isValid = isValid && meshlet.bounds.contains(position) &&
+                      (position - meshlet.center).length() <=
+                          meshlet.radius * 1.0001f;
+        }
+        culledBelow += meshlet.isBackFacing(below) ? 1 : 0;
+        culledAbove += meshlet.isBackFacing(above) ? 1 : 0;
+    }
+    isValid = isValid && nextIndex == indices.size() &&
+              culledBelow == meshlets.size() && culledAbove == 0;
+
+    std::cout << "Meshlets: " << meshlets.size() << " for "
+              << indices.size() / 3 << " triangles ("
+              << static_cast<float>(indices.size() / 3) / meshlets.size()
+              << " triangles per meshlet) "
+              << (isValid ? "passed" : "failed") << std::endl;
+}
+
+
+/**
+ * Finds the nearest object hit by a ray by testing the triangles of every
+ * object whose bounds are hit, one at a time. Used as the reference for the
+ * BVH.
+ */
+const Object *intersectLinear(
+    const std::vector<std::shared_ptr<Object>> &objects,
+    const kirana::math::Ray &ray, float *distance)
+{
+    const Object *nearest = nullptr;
+    float nearestDistance = ray.getMaxDistance();
+    for (const auto &o : objects)
+    {
+        if (!o->getObjectBounds().intersectWithRay(ray))
+            continue;
+        const kirana::math::TriangleRay localRay(o->transform->transformRay(
+            ray, kirana::math::TransformHierarchy::Space::Local));
+        for (const auto &m : o->getMeshes())
+        {
+            const auto vertices = m->getVertices();
+            const auto indices = m->getIndices();
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                if (kirana::math::Triangle::intersect(
+                        localRay, vertices[indices[i]].position,
+                        vertices[indices[i + 1]].position,
+                        vertices[indices[i + 2]].position, nearestDistance,
+                        &nearestDistance))
+                    nearest = o.get();
+            }
+        }
+    }
+    if (nearest != nullptr)
+        *distance = nearestDistance;
+    return nearest;
+}
+
+/**
+ * Picks randomly scattered grid objects through a SceneBVH and compares the
+ * hits with testing every object, before and after moving some of the
+ * objects.
+ */
+void testScenePicking(size_t objectCount, size_t rayCount)
+{
+    using kirana::math::Matrix4x4;
+    using kirana::math::Vector3;
+
+    const std::unique_ptr<aiMesh> aiGrid = createGridMesh(4);
+    const std::vector<std::shared_ptr<Mesh>> meshes{
+        std::make_shared<Mesh>(aiGrid.get(), nullptr)};
+    const float sceneSize = 2.0f * std::cbrt(static_cast<float>(objectCount));
+
+    std::mt19937 random(17);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const auto randomVector = [&](float min, float max) {
+        return Vector3(min + (max - min) * unit(random),
+                       min + (max - min) * unit(random),
+                       min + (max - min) * unit(random));
+    };
+    const auto store = std::make_shared<kirana::math::TransformStore>();
+    std::vector<std::shared_ptr<Object>> objects(objectCount);
+    for (auto &o : objects)
+    {
+        const Matrix4x4 localMatrix =
+            Matrix4x4::translation(randomVector(0.0f, sceneSize)) *
+            Matrix4x4::rotation(randomVector(0.0f, 360.0f)) *
+            Matrix4x4::scale(randomVector(0.5f, 2.0f));
+        o = std::make_shared<Object>("Grid", meshes, localMatrix,
+                                     meshes[0]->getBounds(),
+                                     meshes[0]->getBounds(), nullptr, store);
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    kirana::scene::SceneBVH bvh;
+    bvh.build(objects, meshes, store);
+    const std::chrono::duration<double, std::milli> buildDuration =
+        std::chrono::high_resolution_clock::now() - startTime;
+
+    // Rays from outside the scene towards random points inside it.
+    std::vector<kirana::math::Ray> rays;
+    for (size_t i = 0; i < rayCount; i++)
+    {
+        const Vector3 origin = randomVector(-sceneSize, 2.0f * sceneSize);
+        const Vector3 target =
+            randomVector(-0.25f * sceneSize, 1.25f * sceneSize);
+        rays.emplace_back(origin, Vector3::normalize(target - origin));
+    }
+
+    bool passed = true;
+    size_t hitCount = 0;
+    std::chrono::duration<double, std::milli> bvhDuration{0};
+    std::chrono::duration<double, std::milli> linearDuration{0};
+    for (int pass = 0; pass < 2; pass++)
+    {
+        if (pass == 1)
+        {
+            // Move every 100th object, which refits the BVH on the next pick.
+            for (size_t i = 0; i < objects.size(); i += 100)
+                objects[i]->transform->translate(randomVector(-2.0f, 2.0f));
+        }
+        for (const auto &ray : rays)
+        {
+            float distance = 0.0f;
+            float linearDistance = 0.0f;
+            startTime = std::chrono::high_resolution_clock::now();
+            const Object *nearest = bvh.intersect(ray, &distance);
+            bvhDuration +=
+                std::chrono::high_resolution_clock::now() - startTime;
+
+            startTime = std::chrono::high_resolution_clock::now();
+            const Object *linearNearest =
+                intersectLinear(objects, ray, &linearDistance);
+            linearDuration +=
+                std::chrono::high_resolution_clock::now() - startTime;
+
+            hitCount += nearest != nullptr ? 1 : 0;
+            passed =
+                passed && (nearest == nullptr) == (linearNearest == nullptr);
+            if (nearest != nullptr && linearNearest != nullptr)
+                passed = passed && std::fabs(distance - linearDistance) <=
+                                       1e-3f * std::max(1.0f, linearDistance);
+        }
+    }
+
+    const auto pickCount = static_cast<double>(rays.size() * 2);
+    std::cout << "Scene picking of " << objectCount << " objects: "
+              << buildDuration.count() << " ms build, "
+              << bvhDuration.count() / pickCount << " ms per pick ("
+              << linearDuration.count() / pickCount << " ms testing every "
+              << "object), " << hitCount << "/" << rays.size() * 2
+              << " hits " << (passed ? "passed" : "failed") << std::endl;
+}
+
+
+/**
+ * Updates a SceneBVH every frame while objects move: first dragging an object
+ * with a child, which only refits the paths from them to the root, then
+ * scattering many objects, until the refitted BVH is degraded enough to be
+ * rebuilt. Picks are compared with testing every object afterwards.
+ */
+void testSceneRefit(size_t objectCount, int frameCount)
+{
+    using kirana::math::Matrix4x4;
+    using kirana::math::Vector3;
+
+    const std::unique_ptr<aiMesh> aiGrid = createGridMesh(4);
+    const std::vector<std::shared_ptr<Mesh>> meshes{
+        std::make_shared<Mesh>(aiGrid.get(), nullptr)};
+    const float sceneSize = 2.0f * std::cbrt(static_cast<float>(objectCount));
+
+    std::mt19937 random(31);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const auto randomVector = [&](float min, float max) {
+        return Vector3(min + (max - min) * unit(random),
+                       min + (max - min) * unit(random),
+                       min + (max - min) * unit(random));
+    };
+    const auto store = std::make_shared<kirana::math::TransformStore>();
+    std::vector<std::shared_ptr<Object>> objects(objectCount);
+    for (size_t i = 0; i < objectCount; i++)
+    {
+        // The second object is a child of the first, so that it's moved by
+        // its parent.
+        objects[i] = std::make_shared<Object>(
+            "Grid", meshes,
+            Matrix4x4::translation(i == 1 ? Vector3(2.0f, 0.0f, 0.0f)
+                                          : randomVector(0.0f, sceneSize)),
+            meshes[0]->getBounds(), meshes[0]->getBounds(),
+            i == 1 ? objects[0]->transform : nullptr, store);
+    }
+    kirana::scene::SceneBVH bvh;
+    bvh.build(objects, meshes, store);
+    const float builtCost = bvh.getCost();
+
+    bool passed = true;
+    double dragTime = 0.0;
+    for (int f = 0; f < frameCount; f++)
+    {
+        objects[0]->transform->translate(Vector3(0.1f, 0.0f, 0.0f));
+        // The world matrices are updated first, as Scene::updateTransforms()
+        // does, so that only the BVH update is timed.
+        store->update();
+        passed = passed && bvh.update() &&
+                 bvh.getLastUpdateStats().movedObjectCount == 2 &&
+                 !bvh.getLastUpdateStats().isRebuilt;
+        dragTime += bvh.getLastUpdateStats().time;
+    }
+    const float dragCost = bvh.getCost();
+    passed = passed && !bvh.update();
+
+    const size_t scatterCount = objectCount / 10000;
+    double scatterTime = 0.0;
+    int refitFrameCount = 0;
+    double rebuildTime = 0.0;
+    float degradedCost = dragCost;
+    for (int f = 0; f < frameCount && rebuildTime == 0.0; f++)
+    {
+        for (size_t i = 0; i < scatterCount; i++)
+            objects[random() % objectCount]->transform->setPosition(
+                randomVector(0.0f, sceneSize));
+        store->update();
+        bvh.update();
+        if (bvh.getLastUpdateStats().isRebuilt)
+        {
+            rebuildTime = bvh.getLastUpdateStats().time;
+            continue;
+        }
+        degradedCost = bvh.getCost();
+        scatterTime += bvh.getLastUpdateStats().time;
+        refitFrameCount++;
+    }
+    passed = passed && rebuildTime > 0.0 &&
+             degradedCost <=
+                 builtCost * kirana::scene::SceneBVH::REBUILD_COST_RATIO;
+
+    for (int i = 0; i < 32; i++)
+    {
+        const Vector3 origin = randomVector(-sceneSize, 2.0f * sceneSize);
+        const Vector3 target = randomVector(0.0f, sceneSize);
+        const kirana::math::Ray ray(origin,
+                                    Vector3::normalize(target - origin));
+        float distance = 0.0f;
+        float linearDistance = 0.0f;
+        const Object *nearest = bvh.intersect(ray, &distance);
+        const Object *linearNearest =
+            intersectLinear(objects, ray, &linearDistance);
+        passed = passed && (nearest == nullptr) == (linearNearest == nullptr);
+        if (nearest != nullptr && linearNearest != nullptr)
+            passed = passed && std::fabs(distance - linearDistance) <=
+                                   1e-3f * std::max(1.0f, linearDistance);
+    }
+
+    std::cout << "Scene BVH refit of " << objectCount << " objects: "
+              << dragTime / frameCount << " ms per frame dragging 2 objects, "
+              << scatterTime / std::max(refitFrameCount, 1)
+              << " ms per frame scattering " << scatterCount
+              << ", rebuilt after " << refitFrameCount << " frames in "
+              << rebuildTime << " ms, SAH cost " << builtCost << " built, "
+              << degradedCost << " refitted " << (passed ? "passed" : "failed")
+              << std::endl;
+}
+
+/**
+ * Picks a grid mesh with millions of triangles through a SceneBVH, with rays
+ * aimed at the vertices of the grid, which the watertight test must not let
+ * through, and compares the hits with testing every triangle.
+ */
+void benchmarkMeshPicking(unsigned int resolution, size_t rayCount)
+{
+    using kirana::math::Vector3;
+
+    const std::unique_ptr<aiMesh> aiGrid = createGridMesh(resolution);
+    const std::vector<std::shared_ptr<Mesh>> meshes{
+        std::make_shared<Mesh>(aiGrid.get(), nullptr)};
+    const auto store = std::make_shared<kirana::math::TransformStore>();
+    const std::vector<std::shared_ptr<Object>> objects{std::make_shared<Object>(
+        "Grid", meshes, kirana::math::Matrix4x4::IDENTITY,
+        meshes[0]->getBounds(), meshes[0]->getBounds(), nullptr, store)};
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    kirana::scene::SceneBVH bvh;
+    bvh.build(objects, meshes, store);
+    const std::chrono::duration<double, std::milli> buildDuration =
+        std::chrono::high_resolution_clock::now() - startTime;
+
+    std::mt19937 random(23);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<unsigned int> vertex(1, resolution - 1);
+    bool passed = true;
+    size_t hitCount = 0;
+    std::chrono::duration<double, std::milli> bvhDuration{0};
+    std::chrono::duration<double, std::milli> linearDuration{0};
+    for (size_t i = 0; i < rayCount; i++)
+    {
+        const Vector3 origin(unit(random), 0.5f + unit(random), unit(random));
+        const Vector3 target(
+            static_cast<float>(vertex(random)) / static_cast<float>(resolution),
+            0.0f,
+            static_cast<float>(vertex(random)) /
+                static_cast<float>(resolution));
+        const kirana::math::Ray ray(origin, target - origin);
+
+        float distance = 0.0f;
+        float linearDistance = 0.0f;
+        startTime = std::chrono::high_resolution_clock::now();
+        const Object *nearest = bvh.intersect(ray, &distance);
+        bvhDuration += std::chrono::high_resolution_clock::now() - startTime;
+        startTime = std::chrono::high_resolution_clock::now();
+        const Object *linearNearest =
+            intersectLinear(objects, ray, &linearDistance);
+        linearDuration += std::chrono::high_resolution_clock::now() - startTime;
+
+        hitCount += nearest != nullptr ? 1 : 0;
+        passed = passed && nearest != nullptr && linearNearest != nullptr &&
+                 std::fabs(distance - linearDistance) <= 1e-4f;
+    }
+
+    std::cout << "Mesh picking of " << aiGrid->mNumFaces << " triangles: "
+              << buildDuration.count() << " ms build ("
+              << static_cast<double>(aiGrid->mNumFaces) /
+                     (buildDuration.count() * 1000.0)
+              << " Mtriangles/s), " << bvhDuration.count() / rayCount
+              << " ms per pick (" << linearDuration.count() / rayCount
+              << " ms testing every triangle), " << hitCount << "/"
+              << rayCount << " hits " << (passed ? "passed" : "failed")
+              << std::endl;
+}
+
+/**
+ * Renders a ground with floating grids over it on the CPU path tracer, and
+ * checks that the image doesn't depend on the tiles, that rays missing the
+ * scene see the sky of the viewport, that single-sided grids seen from behind
+ * still hide it, and that shadow rays agree with the nearest hits. Also
+ * renders a scene imported from an OBJ file through the Scene overload.
+ */
+void testPathTracer(uint32_t width, uint32_t height, uint32_t sampleCount)
+{
+    using kirana::math::Matrix4x4;
+    using kirana::math::TransformHierarchy;
+    using kirana::math::Vector3;
+    using kirana::scene::PathTracer;
+
+    const std::unique_ptr<aiMesh> aiGround = createGridMesh(16);
+    const std::unique_ptr<aiMesh> aiGrid = createGridMesh(4);
+    const std::vector<std::shared_ptr<Mesh>> meshes{
+        std::make_shared<Mesh>(aiGround.get(), nullptr),
+        std::make_shared<Mesh>(aiGrid.get(), nullptr)};
+    const auto store = std::make_shared<kirana::math::TransformStore>();
+    std::vector<std::shared_ptr<Object>> objects{std::make_shared<Object>(
+        "Ground", std::vector<std::shared_ptr<Mesh>>{meshes[0]},
+        Matrix4x4::translation(Vector3(-10.0f, 0.0f, -10.0f)) *
+            Matrix4x4::scale(Vector3(20.0f, 1.0f, 20.0f)),
+        meshes[0]->getBounds(), meshes[0]->getBounds(), nullptr, store)};
+    std::mt19937 random(37);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < 64; i++)
+    {
+        objects.emplace_back(std::make_shared<Object>(
+            "Grid", std::vector<std::shared_ptr<Mesh>>{meshes[1]},
+            Matrix4x4::translation(Vector3(-8.0f + 16.0f * unit(random),
+                                           1.0f + 2.0f * unit(random),
+                                           -8.0f + 16.0f * unit(random))),
+            meshes[1]->getBounds(), meshes[1]->getBounds(), nullptr, store));
+    }
+    store->update();
+    kirana::scene::SceneBVH bvh;
+    bvh.build(objects, meshes, store);
+
+    // The camera of the viewport, whose first image row is the top.
+    kirana::scene::PerspectiveCamera camera({width, height}, 50.0f, 0.01f,
+                                            1000.0f, true, true);
+    camera.setTransform(
+        TransformHierarchy(Matrix4x4::translation(Vector3(0.0f, 8.0f, 14.0f))));
+    camera.lookAt(Vector3(0.0f, 0.0f, 0.0f));
+    const kirana::scene::WorldData world;
+
+    PathTracer::Settings settings;
+    settings.resolution = {width, height};
+    settings.sampleCount = sampleCount;
+    PathTracer pathTracer;
+    bool passed = pathTracer.render(bvh, camera, world, settings);
+    const PathTracer::Stats stats = pathTracer.getLastRenderStats();
+    const std::vector<Vector4> pixels = pathTracer.getPixels();
+    for (const auto &p : pixels)
+    {
+        passed = passed && std::isfinite(p[0]) && std::isfinite(p[1]) &&
+                 std::isfinite(p[2]);
+    }
+
+    settings.tileSize = 5;
+    passed = passed && pathTracer.render(bvh, camera, world, settings);
+    for (size_t i = 0; i < pixels.size() && passed; i++)
+    {
+        for (int c = 0; c < 4; c++)
+            passed = passed && pixels[i][c] == pathTracer.getPixels()[i][c];
+    }
+
+    camera.lookAt(Vector3(0.0f, 100.0f, -20.0f));
+    passed = passed && pathTracer.render(bvh, camera, world, settings);
+    for (uint32_t y = 0; y < height && passed; y++)
+    {
+        const Vector3 sky = Vector3::lerp(
+            Vector3(1.0f, 1.0f, 1.0f), Vector3(0.0f, 0.47f, 0.99f),
+            1.0f - static_cast<float>(y) / static_cast<float>(height));
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const Vector4 &p = pathTracer.getPixels()[y * width + x];
+            for (int c = 0; c < 3; c++)
+                passed = passed && std::fabs(p[c] - sky[c]) <= 1e-5f;
+        }
+    }
+
+    // A roof over the camera, which faces away from it, has to hide the sky
+    // like in the viewport, whose TLAS doesn't cull back faces.
+    const std::vector<std::shared_ptr<Object>> roof{std::make_shared<Object>(
+        "Roof", std::vector<std::shared_ptr<Mesh>>{meshes[1]},
+        Matrix4x4::translation(Vector3(-200.0f, 20.0f, -200.0f)) *
+            Matrix4x4::scale(Vector3(400.0f, 1.0f, 400.0f)),
+        meshes[1]->getBounds(), meshes[1]->getBounds(), nullptr, store)};
+    store->update();
+    kirana::scene::SceneBVH roofBVH;
+    roofBVH.build(roof, {meshes[1]}, store);
+    const kirana::math::Ray upRay(Vector3(0.0f, 8.0f, 14.0f),
+                                  Vector3(0.0f, 1.0f, 0.0f));
+    kirana::scene::SceneBVH::Hit roofHit;
+    passed = passed && !roofBVH.intersectNearest(upRay, true, &roofHit) &&
+             roofBVH.intersectNearest(upRay, false, &roofHit);
+    passed = passed && pathTracer.render(roofBVH, camera, world, settings);
+    for (uint32_t y = 0; y < height && passed; y++)
+    {
+        const Vector3 sky = Vector3::lerp(
+            Vector3(1.0f, 1.0f, 1.0f), Vector3(0.0f, 0.47f, 0.99f),
+            1.0f - static_cast<float>(y) / static_cast<float>(height));
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const Vector4 &p = pathTracer.getPixels()[y * width + x];
+            passed = passed && (std::fabs(p[0] - sky[0]) > 1e-5f ||
+                                std::fabs(p[1] - sky[1]) > 1e-5f ||
+                                std::fabs(p[2] - sky[2]) > 1e-5f);
+        }
+    }
+
+    // Scenes don't import their cameras, so they're rendered from the given
+    // one, and only once they're loaded. The image has to be the same as
+    // rendering their BVH.
+    kirana::scene::Scene scene;
+    passed = passed && !pathTracer.render(scene, camera, world, settings);
+    const std::string objPath = "path_tracer_test.obj";
+    std::ofstream obj(objPath);
+    obj << "v -1000 0 -1000\nv -1000 0 1000\nv 1000 0 1000\nv 1000 0 -1000\n"
+        << "vn 0 1 0\nf 1//1 2//1 3//1\nf 1//1 3//1 4//1\n";
+    obj.close();
+    const kirana::scene::SceneImportSettings importSettings;
+    passed = passed && kirana::scene::SceneImporter::get().loadSceneFromFile(
+                           objPath.c_str(), importSettings, &scene);
+    std::remove(objPath.c_str());
+    if (passed)
+    {
+        scene.buildBVH();
+        camera.lookAt(Vector3(0.0f, 0.0f, 0.0f));
+        passed = scene.intersectRay(kirana::math::Ray(
+                     Vector3(0.0f, 8.0f, 14.0f),
+                     Vector3(0.0f, -8.0f, -14.0f))) != nullptr &&
+                 pathTracer.render(scene, camera, world, settings);
+    }
+    const std::vector<Vector4> imported = pathTracer.getPixels();
+    passed = passed &&
+             pathTracer.render(scene.getBVH(), camera, world, settings);
+    for (size_t i = 0; i < imported.size() && passed; i++)
+    {
+        for (int c = 0; c < 4; c++)
+            passed = passed && imported[i][c] == pathTracer.getPixels()[i][c];
+    }
+
+    size_t shadowedCount = 0;
+    for (int i = 0; i < 4096; i++)
+    {
+        const Vector3 origin(-10.0f + 20.0f * unit(random),
+                             0.1f + 4.0f * unit(random),
+                             -10.0f + 20.0f * unit(random));
+        const Vector3 direction(unit(random) - 0.5f, unit(random) - 0.5f,
+                                unit(random) - 0.5f);
+        const kirana::math::Ray ray(origin, Vector3::normalize(direction));
+        kirana::scene::SceneBVH::Hit hit;
+        const bool isHit = bvh.intersectNearest(ray, true, &hit);
+        passed = passed && isHit == bvh.intersectAny(ray, true);
+        shadowedCount += isHit ? 1 : 0;
+    }
+
+    const std::string exrPath = "path_tracer_test.exr";
+    const std::string pngPath = "path_tracer_test.png";
+    passed = passed && pathTracer.writeEXR(exrPath) &&
+             pathTracer.writePNG(pngPath);
+    std::ifstream png(pngPath, std::ios::binary);
+    char signature[8] = {};
+    png.read(signature, sizeof(signature));
+    passed = passed && png.good() && signature[1] == 'P' &&
+             signature[2] == 'N' && signature[3] == 'G';
+    png.close();
+    // Each line is its y coordinate, its size and 4 half float channels,
+    // after its offset in the table.
+    std::ifstream exr(exrPath, std::ios::binary | std::ios::ate);
+    const auto exrSize = static_cast<size_t>(exr.tellg());
+    passed = passed && exrSize > height * (width * 8 + 16);
+    exr.close();
+    std::remove(exrPath.c_str());
+    std::remove(pngPath.c_str());
+
+    std::cout << "Path tracing " << width << "x" << height << " with "
+              << sampleCount << " samples: " << stats.time << " ms, "
+              << stats.rayCount << " rays ("
+              << static_cast<double>(stats.rayCount) / (stats.time * 1000.0)
+              << " Mrays/s), " << shadowedCount << "/4096 shadow rays hit "
+              << (passed ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * Saves the scene cache of a scene imported from an OBJ file, and loads it
+ * back with every 4 bytes of it set to 0xFF in turn. Damaged counts have to
+ * be rejected before anything is allocated, so loading never throws, and the
+ * count of the materials, which is past the header, always fails it.
+ */
+void testSceneCacheValidation()
+{
+    using kirana::scene::SceneCache;
+
+    const std::string objPath = "scene_cache_test.obj";
+    std::ofstream obj(objPath);
+    obj << "v 0 0 0\nv 0 0 1\nv 1 0 1\nv 1 0 0\nvn 0 1 0\n"
+        << "f 1//1 2//1 3//1\nf 1//1 3//1 4//1\n";
+    obj.close();
+    const kirana::scene::SceneImportSettings importSettings;
+    kirana::scene::Scene scene;
+    bool passed = kirana::scene::SceneImporter::get().loadSceneFromFile(
+                      objPath.c_str(), importSettings, &scene) &&
+                  SceneCache::get().saveScene(objPath, importSettings, scene);
+    const std::string cachePath =
+        SceneCache::get().getCachePath(objPath, importSettings);
+    std::vector<char> data;
+    if (passed)
+    {
+        std::ifstream cache(cachePath, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(cache),
+                    std::istreambuf_iterator<char>());
+        kirana::scene::Scene cachedScene;
+        passed = SceneCache::get().loadScene(objPath, importSettings,
+                                             &cachedScene);
+    }
+
+    // The header is followed by the name of the scene and the count of the
+    // materials.
+    const size_t headerSize = 24;
+    uint32_t nameSize = 0;
+    if (data.size() >= headerSize + sizeof(nameSize))
+        memcpy(&nameSize, data.data() + headerSize, sizeof(nameSize));
+    const size_t materialCountOffset = headerSize + sizeof(nameSize) + nameSize;
+    size_t rejectedCount = 0;
+    for (size_t offset = 0; offset + 4 <= data.size() && passed; offset++)
+    {
+        std::vector<char> damaged = data;
+        memset(damaged.data() + offset, 0xFF, 4);
+        std::ofstream cache(cachePath, std::ios::binary | std::ios::trunc);
+        cache.write(damaged.data(),
+                    static_cast<std::streamsize>(damaged.size()));
+        cache.close();
+        try
+        {
+            kirana::scene::Scene cachedScene;
+            const bool isLoaded = SceneCache::get().loadScene(
+                objPath, importSettings, &cachedScene);
+            rejectedCount += isLoaded ? 0 : 1;
+            passed = !isLoaded || offset != materialCountOffset;
+        }
+        catch (const std::exception &)
+        {
+            passed = false;
+        }
+    }
+    std::remove(cachePath.c_str());
+    std::remove(objPath.c_str());
+
+    std::cout << "Scene cache validation of " << data.size()
+              << " bytes: " << rejectedCount << " damaged files rejected "
+              << (passed ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * Compares decoding the images of the FlightHelmet sample one after the other
+ * with decoding them on the thread pool through the ImageManager.
+ */
+void benchmarkImageDecoding()
+{
+    namespace filesystem = kirana::utils::filesystem;
+    const std::string directory = filesystem::combinePath(
+        kirana::utils::constants::DATA_DIR_PATH, {"FlightHelmet"});
+    if (!filesystem::fileExists(directory))
+    {
+        std::cout << "Image decoding: skipped, FlightHelmet sample not found"
+                  << std::endl;
+        return;
+    }
+
+    std::vector<std::string> paths;
+    for (const auto &path : filesystem::listFilesInPath(directory))
+    {
+        const std::string extension = filesystem::getFilename(path).second;
+        if (extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+            paths.push_back(path);
+    }
+
+    // Both runs decode the images instead of reading them from the cache.
+    const auto removeCachedImages = [&paths]() {
+        for (uint32_t i = 0; i < paths.size(); i++)
+        {
+            const Image image(paths[i], "", i,
+                              kirana::scene::ImageProperties{});
+            std::remove(ImageCache::get().getCachePath(image).c_str());
+        }
+    };
+
+    removeCachedImages();
+    std::unordered_map<std::string, size_t> serialSizes;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < paths.size(); i++)
+    {
+        Image image(paths[i], "", i, kirana::scene::ImageProperties{});
+        serialSizes[paths[i]] =
+            image.load() != nullptr ? image.getPixelDataSize() : 0;
+    }
+    const std::chrono::duration<double, std::milli> serialDuration =
+        std::chrono::high_resolution_clock::now() - startTime;
+
+    std::vector<Image *> images;
+    for (const auto &path : paths)
+        images.push_back(ImageManager::get().getImage(
+            static_cast<uint32_t>(ImageManager::get().addImage(path))));
+
+    removeCachedImages();
+    bool isValid = !images.empty();
+    startTime = std::chrono::high_resolution_clock::now();
+    ImageManager::get().loadImages(images, [&](Image *image) {
+        isValid = isValid && image->isLoaded() &&
+                  image->getPixelDataSize() ==
+                      serialSizes[image->getFilepath()];
+        ImageManager::get().freeImage(image);
+    });
+    const std::chrono::duration<double, std::milli> parallelDuration =
+        std::chrono::high_resolution_clock::now() - startTime;
+
+    std::cout << "Image decoding of " << images.size()
+              << " FlightHelmet images: " << serialDuration.count()
+              << " ms serial, " << parallelDuration.count() << " ms on "
+              << ThreadPool::get().getThreadCount() << " threads on "
+              << std::thread::hardware_concurrency() << " cores ("
+              << serialDuration.count() / parallelDuration.count()
+              << "x) " << (isValid ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * Generates mip chains of 4 and 3 channel images with the same colors. 4
+ * channel images take the SIMD path where it's available and 3 channel images
+ * take the scalar path, so their color channels have to match. The alpha of
+ * the 4 channel images is checked against 2 channel images the same way.
+ */
+void testMipChainGeneration()
+{
+    namespace image_processing = kirana::scene::image_processing;
+    const std::array<int, 2> size{37, 20};
+    const size_t pixelCount = static_cast<size_t>(size[0]) * size[1];
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    std::vector<uint8_t> rgba8(pixelCount * 4);
+    std::vector<uint8_t> rgb8(pixelCount * 3);
+    std::vector<float> rgba32(pixelCount * 4);
+    std::vector<float> rgb32(pixelCount * 3);
+    std::vector<uint8_t> grayAlpha8(pixelCount * 2);
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        for (size_t c = 0; c < 4; c++)
+        {
+            rgba8[i * 4 + c] = static_cast<uint8_t>(distribution(random));
+            rgba32[i * 4 + c] = static_cast<float>(rgba8[i * 4 + c]) / 255.0f;
+            if (c < 3)
+            {
+                rgb8[i * 3 + c] = rgba8[i * 4 + c];
+                rgb32[i * 3 + c] = rgba32[i * 4 + c];
+            }
+        }
+        grayAlpha8[i * 2] = rgba8[i * 4];
+        grayAlpha8[i * 2 + 1] = rgba8[i * 4 + 3];
+    }
+
+    // Returns the largest difference between the color channels of the 4 and
+    // 3 channel mip chains.
+    const auto compare = [&size](const void *rgba, const void *rgb,
+                                 PixelDataType dataType,
+                                 ColorSpace colorSpace) {
+        std::vector<uint8_t> rgbaChain, rgbChain;
+        const auto rgbaLevels = image_processing::generateMipChain(
+            rgba, size, 4, dataType, colorSpace, 0, &rgbaChain);
+        const auto rgbLevels = image_processing::generateMipChain(
+            rgb, size, 3, dataType, colorSpace, 0, &rgbChain);
+        if (rgbaLevels.size() != 6 || rgbLevels.size() != 6 ||
+            rgbaLevels[1].size != std::array<int, 2>{18, 10} ||
+            rgbaLevels[5].size != std::array<int, 2>{1, 1} ||
+            rgbaChain.size() != rgbaLevels[5].offset + rgbaLevels[5].dataSize)
+            return 1.0f;
+
+        float maxDifference = 0.0f;
+        for (size_t l = 0; l < rgbaLevels.size(); l++)
+        {
+            const size_t levelPixels =
+                static_cast<size_t>(rgbaLevels[l].size[0]) *
+                rgbaLevels[l].size[1];
+            for (size_t i = 0; i < levelPixels; i++)
+            {
+                for (size_t c = 0; c < 3; c++)
+                {
+                    float a, b;
+                    if (dataType == PixelDataType::FLOAT32)
+                    {
+                        a = reinterpret_cast<const float *>(
+                            rgbaChain.data() + rgbaLevels[l].offset)[i * 4 + c];
+                        b = reinterpret_cast<const float *>(
+                            rgbChain.data() + rgbLevels[l].offset)[i * 3 + c];
+                    }
+                    else
+                    {
+                        a = rgbaChain[rgbaLevels[l].offset + i * 4 + c] /
+                            255.0f;
+                        b = rgbChain[rgbLevels[l].offset + i * 3 + c] / 255.0f;
+                    }
+                    maxDifference = std::max(maxDifference, std::abs(a - b));
+                }
+            }
+        }
+        return maxDifference;
+    };
+
+    const float srgbDifference =
+        compare(rgba8.data(), rgb8.data(), PixelDataType::UNORM8,
+                ColorSpace::sRGB);
+    const float unormDifference =
+        compare(rgba8.data(), rgb8.data(), PixelDataType::UNORM8,
+                ColorSpace::Linear);
+    const float floatDifference =
+        compare(rgba32.data(), rgb32.data(), PixelDataType::FLOAT32,
+                ColorSpace::Linear);
+
+    // Returns the number of alpha values of the 4 channel mip chain that
+    // differ from the 2 channel one.
+    const auto compareAlpha = [&](ColorSpace colorSpace) {
+        std::vector<uint8_t> rgbaChain, grayAlphaChain;
+        const auto rgbaLevels = image_processing::generateMipChain(
+            rgba8.data(), size, 4, PixelDataType::UNORM8, colorSpace, 0,
+            &rgbaChain);
+        const auto grayAlphaLevels = image_processing::generateMipChain(
+            grayAlpha8.data(), size, 2, PixelDataType::UNORM8, colorSpace, 0,
+            &grayAlphaChain);
+        size_t differenceCount = 0;
+        for (size_t l = 0; l < rgbaLevels.size(); l++)
+        {
+            const size_t levelPixels =
+                static_cast<size_t>(rgbaLevels[l].size[0]) *
+                rgbaLevels[l].size[1];
+            for (size_t i = 0; i < levelPixels; i++)
+            {
+                differenceCount +=
+                    rgbaChain[rgbaLevels[l].offset + i * 4 + 3] !=
+                            grayAlphaChain[grayAlphaLevels[l].offset + i * 2 +
+                                           1]
+                        ? 1
+                        : 0;
+            }
+        }
+        return differenceCount;
+    };
+    const size_t alphaDifferenceCount =
+        compareAlpha(ColorSpace::sRGB) + compareAlpha(ColorSpace::Linear);
+
+    // A black and white checkerboard averages to 50% linear gray, which is
+    // 188 in sRGB. Averaging in sRGB space would give 128. Its rows alternate
+    // between alpha 0 and 1, which averages to 0.5 and rounds up to 1.
+    const std::array<int, 2> checkerSize{4, 4};
+    std::vector<uint8_t> checker(16 * 4);
+    for (size_t i = 0; i < 16; i++)
+    {
+        const uint8_t value = (i % 4 + i / 4) % 2 == 0 ? 255 : 0;
+        std::fill_n(checker.begin() + i * 4, 3, value);
+        checker[i * 4 + 3] = static_cast<uint8_t>(i / 4 % 2);
+    }
+    std::vector<uint8_t> checkerChain;
+    const auto checkerLevels = image_processing::generateMipChain(
+        checker.data(), checkerSize, 4, PixelDataType::UNORM8,
+        ColorSpace::sRGB, 0, &checkerChain);
+    const uint8_t *gray = checkerChain.data() + checkerLevels.back().offset;
+
+    const bool passed = srgbDifference <= 1.0f / 255.0f &&
+                        unormDifference <= 1.0f / 255.0f &&
+                        floatDifference <= 1e-6f &&
+                        alphaDifferenceCount == 0 &&
+                        std::abs(gray[0] - 188) <= 1 && gray[3] == 1 &&
+                        image_processing::getMipLevelCount({1, 1}) == 1 &&
+                        image_processing::getMipLevelCount({1024, 512}) == 11;
+    std::cout << "Mip chain generation: sRGB "
+              << srgbDifference * 255.0f << ", UNORM "
+              << unormDifference * 255.0f << ", FLOAT " << floatDifference
+              << " max difference, " << alphaDifferenceCount
+              << " alpha differences, checker gray "
+              << static_cast<int>(gray[0]) << " "
+              << (passed ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * Block compresses an image with gradients, edges and noise to every format,
+ * decompresses it again and checks the peak signal-to-noise ratio of the
+ * channels each format stores.
+ */
+void testBlockCompression()
+{
+    namespace image_compression = kirana::scene::image_compression;
+    // Not a multiple of the block size, so the edges are padded.
+    const std::array<int, 2> size{254, 250};
+
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int> noise(-4, 4);
+    std::vector<uint8_t> pixels(static_cast<size_t>(size[0]) * size[1] * 4);
+    for (int y = 0; y < size[1]; y++)
+    {
+        for (int x = 0; x < size[0]; x++)
+        {
+            uint8_t *pixel = pixels.data() + (y * size[0] + x) * 4;
+            const int edge = (x / 32 + y / 32) % 2 == 0 ? 48 : 0;
+            const int values[4] = {x + edge, y, (x + y) / 2, 255 - x / 2};
+            for (int c = 0; c < 4; c++)
+                pixel[c] = static_cast<uint8_t>(
+                    std::clamp(values[c] + noise(random), 0, 255));
+        }
+    }
+
+    bool passed = true;
+    std::cout << "Block compression of " << size[0] << "x" << size[1] << ":";
+    const std::array<std::pair<ImageCompression, const char *>, 4> formats{
+        {{ImageCompression::BC1, "BC1"},
+         {ImageCompression::BC3, "BC3"},
+         {ImageCompression::BC5, "BC5"},
+         {ImageCompression::BC7, "BC7"}}};
+    for (const auto &[compression, name] : formats)
+    {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<uint8_t> blocks(
+            image_compression::getCompressedSize(size, compression));
+        image_compression::compress(pixels.data(), size, 4, compression,
+                                    blocks.data());
+        const std::chrono::duration<double, std::milli> duration =
+            std::chrono::high_resolution_clock::now() - startTime;
+
+        // The channels stored by each format.
+        const uint32_t channelCount =
+            compression == ImageCompression::BC1   ? 3
+            : compression == ImageCompression::BC5 ? 2
+                                                   : 4;
+        const int blockCountX = (size[0] + 3) / 4;
+        const size_t blockSize = image_compression::getBlockSize(compression);
+        double squaredError = 0.0;
+        for (int y = 0; y < size[1]; y++)
+        {
+            for (int x = 0; x < size[0]; x++)
+            {
+                uint8_t block[64];
+                passed = passed &&
+                         image_compression::decompressBlock(
+                             blocks.data() +
+                                 (y / 4 * blockCountX + x / 4) * blockSize,
+                             compression, block);
+                const uint8_t *decoded = block + ((y % 4) * 4 + x % 4) * 4;
+                const uint8_t *pixel = pixels.data() + (y * size[0] + x) * 4;
+                for (uint32_t c = 0; c < channelCount; c++)
+                {
+                    const double d = decoded[c] - pixel[c];
+                    squaredError += d * d;
+                }
+            }
+        }
+        const double meanSquaredError =
+            squaredError / (static_cast<double>(size[0]) * size[1] *
+                            channelCount);
+        const double psnr =
+            10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+        passed = passed && psnr > (compression == ImageCompression::BC1 ||
+                                           compression == ImageCompression::BC3
+                                       ? 34.0
+                                       : 38.0);
+        std::cout << " " << name << " " << psnr << " dB ("
+                  << duration.count() << " ms)";
+    }
+
+    // Without GPU support, images keep their uncompressed mip chain.
+    const kirana::scene::ImageProperties properties;
+    passed = passed && image_compression::getCompression(
+                           properties, PixelDataType::UNORM8) !=
+                           ImageCompression::NONE;
+    image_compression::setEnabled(false);
+    passed = passed && image_compression::getCompression(
+                           properties, PixelDataType::UNORM8) ==
+                           ImageCompression::NONE;
+    image_compression::setEnabled(true);
+    std::cout << " " << (passed ? "passed" : "failed") << std::endl;
+}
+
+/**
+ * Loads the FlightHelmet images with a memory budget which only fits a few of
+ * them, and checks that the least recently used images are evicted and loaded
+ * again on demand.
+ */
+void testImageMemoryBudget()
+{
+    namespace filesystem = kirana::utils::filesystem;
+    const std::string directory = filesystem::combinePath(
+        kirana::utils::constants::DATA_DIR_PATH, {"FlightHelmet"});
+    if (!filesystem::fileExists(directory))
+    {
+        std::cout << "Image memory budget: skipped, FlightHelmet sample not "
+                     "found"
+                  << std::endl;
+        return;
+    }
+
+    std::vector<Image *> images;
+    for (const auto &path : filesystem::listFilesInPath(directory))
+    {
+        const std::string extension = filesystem::getFilename(path).second;
+        if (extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+            images.push_back(ImageManager::get().getImage(
+                static_cast<uint32_t>(ImageManager::get().addImage(path))));
+    }
+    if (images.size() < 4 || !ImageManager::get().loadImage(images[0]))
+    {
+        std::cout << "Image memory budget: failed" << std::endl;
+        return;
+    }
+
+    // Budget for 3 images of the size of the first one.
+    const auto initialStatistics = ImageManager::get().getMemoryStatistics();
+    ImageManager::get().setMemoryBudget(3 * images[0]->getPixelDataSize());
+    bool passed = true;
+    size_t peakMemory = 0;
+    for (Image *image : images)
+    {
+        passed = ImageManager::get().loadImage(image) && passed;
+        peakMemory = std::max(peakMemory,
+                              ImageManager::get().getMemoryStatistics()
+                                  .usedMemory);
+    }
+    // The first image was evicted, the last one is still loaded.
+    passed = passed && !images.front()->isLoaded() &&
+             images.back()->isLoaded();
+    ImageManager::get().loadImage(images.back());
+    ImageManager::get().loadImage(images.front());
+    passed = passed && images.front()->isLoaded();
+
+    const auto statistics = ImageManager::get().getMemoryStatistics();
+    const uint64_t hits = statistics.hits - initialStatistics.hits;
+    const uint64_t misses = statistics.misses - initialStatistics.misses;
+    const uint64_t evictions =
+        statistics.evictions - initialStatistics.evictions;
+    passed = passed && hits == 2 && misses == images.size() &&
+             evictions >= images.size() - 3 &&
+             statistics.usedMemory <= statistics.memoryBudget;
+
+    for (Image *image : images)
+        ImageManager::get().freeImage(image);
+    ImageManager::get().setMemoryBudget(initialStatistics.memoryBudget);
+    std::cout << "Image memory budget of " << statistics.memoryBudget
+              << " bytes: peak " << peakMemory << " bytes, " << hits
+              << " hits, " << misses << " misses, " << evictions
+              << " evictions " << (passed ? "passed" : "failed")
+              << std::endl;
+}
+
+/**
+ * Converts floats to half floats with the SIMD path and checks the results
+ * against known bit patterns, math::floatToHalf() on random bit patterns, the
+ * round trip error and RGB to RGBA expansion.
+ */
+void benchmarkHalfFloatConversion()
+{
+    namespace image_processing = kirana::scene::image_processing;
+    const auto fromBits = [](uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    };
+    const std::vector<std::pair<float, uint16_t>> knownValues{
+        {0.0f, 0x0000},      {-0.0f, 0x8000},    {1.0f, 0x3c00},
+        {-2.5f, 0xc100},     {0.1f, 0x2e66},     {65504.0f, 0x7bff},
+        {65520.0f, 0x7c00},  {1e-5f, 0x00a8},    {5.96e-8f, 0x0001},
+        {1e-9f, 0x0000},     {1e10f, 0x7c00},    {-1e10f, 0xfc00},
+        {std::numeric_limits<float>::quiet_NaN(), 0x7e00},
+        {std::numeric_limits<float>::infinity(), 0x7c00},
+        {-std::numeric_limits<float>::infinity(), 0xfc00},
+        {fromBits(0x7f802037), 0x7e00},
+        {fromBits(0xffc12345), 0xfe00},
+        {2.0f, 0x4000}};
+    // Converted as 6 RGB pixels to RGBA, so that the SIMD path converts the
+    // first 5 and the scalar path the last one.
+    std::vector<float> values;
+    for (const auto &v : knownValues)
+        values.push_back(v.first);
+    const size_t knownPixelCount = values.size() / 3;
+    std::vector<uint16_t> halfs(knownPixelCount * 4);
+    image_processing::convertToHalf(values.data(), knownPixelCount, 3, 4,
+                                    halfs.data());
+    bool passed = true;
+    for (size_t i = 0; i < knownPixelCount; i++)
+    {
+        for (size_t c = 0; c < 3; c++)
+        {
+            passed = passed &&
+                     halfs[i * 4 + c] == knownValues[i * 3 + c].second &&
+                     kirana::math::floatToHalf(values[i * 3 + c]) ==
+                         halfs[i * 4 + c];
+        }
+        passed = passed && halfs[i * 4 + 3] == 0x3c00;
+    }
+
+    // Random bit patterns, which include NaNs with payloads, denormals and
+    // values too large for half floats.
+    std::mt19937 random(13);
+    std::vector<float> patterns(1 << 20);
+    for (auto &p : patterns)
+        p = fromBits(static_cast<uint32_t>(random()));
+    std::vector<uint16_t> patternHalfs(patterns.size());
+    image_processing::convertToHalf(patterns.data(), patterns.size(), 1, 1,
+                                    patternHalfs.data());
+    size_t patternDifferenceCount = 0;
+    for (size_t i = 0; i < patterns.size(); i++)
+        patternDifferenceCount +=
+            patternHalfs[i] != kirana::math::floatToHalf(patterns[i]) ? 1 : 0;
+    passed = passed && patternDifferenceCount == 0;
+
+    const size_t pixelCount = 1 << 20;
+    std::uniform_real_distribution<float> distribution(-1000.0f, 1000.0f);
+    std::vector<float> pixels(pixelCount * 3);
+    for (auto &p : pixels)
+        p = distribution(random);
+
+    std::vector<uint16_t> halfPixels(pixelCount * 4);
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    image_processing::convertToHalf(pixels.data(), pixelCount, 3, 4,
+                                    halfPixels.data());
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::high_resolution_clock::now() - startTime;
+
+    // Half floats have 11 significant bits.
+    float maxRelativeError = 0.0f;
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        for (size_t c = 0; c < 3; c++)
+        {
+            const float value = pixels[i * 3 + c];
+            const uint16_t half = halfPixels[i * 4 + c];
+            maxRelativeError = std::max(
+                maxRelativeError,
+                std::abs(kirana::math::halfToFloat(half) - value) /
+                    std::max(std::abs(value), 1e-3f));
+            passed = passed && half == kirana::math::floatToHalf(value);
+        }
+        passed = passed && halfPixels[i * 4 + 3] == 0x3c00;
+    }
+    passed = passed && maxRelativeError <= 1.0f / 2048.0f;
+    std::cout << "Half float conversion of " << pixelCount
+              << " RGB pixels to RGBA: " << duration.count() << " ms, "
+              << maxRelativeError << " max relative error, "
+              << patternDifferenceCount << " random patterns differ "
+              << (passed ? "passed" : "failed") << std::endl;
+}
 
 
 int main(int argc, char **argv)
@@ -54,5 +1615,24 @@ int main(int argc, char **argv)
     std::cout << "Color: " << color << std::endl;
     std::cout << "Roughness: " << roughness << std::endl;
 
+    benchmarkMeshConversion(4000, 32);
+    testParallelForExceptions();
+    benchmarkLinearMeshConversion(708, 5);
+    testCompactVertexPacking(100000);
+    testMeshDeduplication();
+    benchmarkMeshOptimization(512);
+    testMeshLODGeneration(256);
+    testMeshletBuild(128);
+    testScenePicking(100000, 64);
+    testSceneRefit(100000, 64);
+    benchmarkMeshPicking(1024, 32);
+    testPathTracer(320, 180, 4);
+    testSceneCacheValidation();
+    benchmarkImageDecoding();
+    testMipChainGeneration();
+    testBlockCompression();
+    testImageMemoryBudget();
+    benchmarkHalfFloatConversion();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "scene_types.hpp"
+
+#include <math_utils.hpp>
+
+namespace
+{
+int16_t packSnorm16(float value)
+{
+    return static_cast<int16_t>(
+        std::lround(kirana::math::clampf(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+uint8_t packUnorm8(float value)
+{
+    return static_cast<uint8_t>(
+        std::lround(kirana::math::clampf(value, 0.0f, 1.0f) * 255.0f));
+}
+} // namespace
+
+void kirana::scene::CompactVertex::pack(const Vertex *vertices, size_t count,
+                                        CompactVertex *compactVertices)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const Vertex &v = vertices[i];
+        CompactVertex &c = compactVertices[i];
+
+        c.position[0] = v.position[0];
+        c.position[1] = v.position[1];
+        c.position[2] = v.position[2];
+
+        // Octahedral encoding: project the normal onto the octahedron
+        // |x| + |y| + |z| = 1 and fold the lower hemisphere over the upper one.
+        const float l1Norm =
+            std::fabs(v.normal[0]) + std::fabs(v.normal[1]) +
+            std::fabs(v.normal[2]);
+        float x = l1Norm > 0.0f ? v.normal[0] / l1Norm : 0.0f;
+        float y = l1Norm > 0.0f ? v.normal[1] / l1Norm : 0.0f;
+        if (v.normal[2] < 0.0f)
+        {
+            const float foldedX =
+                (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float foldedY =
+                (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+        c.normal[0] = packSnorm16(x);
+        c.normal[1] = packSnorm16(y);
+
+        c.texCoords[0] = math::floatToHalf(v.texCoords[0]);
+        c.texCoords[1] = math::floatToHalf(v.texCoords[1]);
+
+        for (int j = 0; j < 4; j++)
+            c.color[j] = packUnorm8(v.color[j]);
+    }
+}
@@ -1,6 +1,7 @@
 #ifndef SCENE_UTILS_HPP
 #define SCENE_UTILS_HPP
 
+#include <functional>
 #include <vector>
 #include <vector2.hpp>
 #include <transform_hierarchy.hpp>
@@ -14,6 +15,20 @@ enum class VertexDataFormat
 {
     INT = 0,
     FLOAT = 1,
+    HALF_FLOAT = 2,
+    /// 16-bit signed integer normalized to [-1, 1].
+    SNORM16 = 3,
+    /// 8-bit unsigned integer normalized to [0, 1].
+    UNORM8 = 4,
+};
+
+/// Memory layout of vertices in the vertex buffers.
+enum class VertexLayout
+{
+    /// Full precision Vertex (64 bytes).
+    STANDARD = 0,
+    /// Quantized CompactVertex (24 bytes).
+    COMPACT = 1,
 };
 
 struct VertexInfo
@@ -23,6 +38,43 @@ struct VertexInfo
     size_t structOffset;
 };
 
+struct Vertex;
+
+/**
+ * Quantized vertex used by VertexLayout::COMPACT. The position is kept at full
+ * precision, the normal is octahedral-encoded into two snorm16 values, the
+ * texture coordinates are half floats and the color is unorm8.
+ */
+struct CompactVertex
+{
+    float position[3];
+    int16_t normal[2];
+    uint16_t texCoords[2];
+    uint8_t color[4];
+
+    /// Vertex attribute information to create vertex bindings.
+    static std::vector<VertexInfo> getVertexInfo()
+    {
+        return {
+            {VertexDataFormat::FLOAT, 3, offsetof(CompactVertex, position)},
+            {VertexDataFormat::SNORM16, 2, offsetof(CompactVertex, normal)},
+            {VertexDataFormat::UNORM8, 4, offsetof(CompactVertex, color)},
+            {VertexDataFormat::HALF_FLOAT, 2,
+             offsetof(CompactVertex, texCoords)},
+        };
+    }
+
+    /**
+     * Quantizes the given vertices.
+     * @param vertices The vertices to quantize.
+     * @param count Number of vertices.
+     * @param compactVertices Output array with space for count vertices.
+     */
+    static void pack(const Vertex *vertices, size_t count,
+                     CompactVertex *compactVertices);
+};
+static_assert(sizeof(CompactVertex) == 24, "CompactVertex must be packed");
+
 struct Vertex
 {
     math::Vector3 position;
@@ -30,9 +82,16 @@ struct Vertex
     alignas(16) math::Vector4 color;
     math::Vector2 texCoords;
 
-    /// Vertex attribute information to create vertex bindings.
-    static std::vector<VertexInfo> getVertexInfo()
+    /**
+     * Vertex attribute information to create vertex bindings.
+     * @param layout The layout of the vertex buffer. The attributes are always
+     * in the order: position, normal, color, texCoords.
+     */
+    static std::vector<VertexInfo> getVertexInfo(
+        VertexLayout layout = VertexLayout::STANDARD)
     {
+        if (layout == VertexLayout::COMPACT)
+            return CompactVertex::getVertexInfo();
         return {
             {VertexDataFormat::FLOAT, 3, offsetof(Vertex, position)},
             {VertexDataFormat::FLOAT, 3, offsetof(Vertex, normal)},
@@ -41,6 +100,13 @@ struct Vertex
         };
     }
 
+    /// Size of a single vertex in the given layout.
+    static constexpr size_t getSize(VertexLayout layout)
+    {
+        return layout == VertexLayout::COMPACT ? sizeof(CompactVertex)
+                                               : sizeof(Vertex);
+    }
+
     /// Vertex information of the biggest attribute
     static VertexInfo getLargestVertexInfo()
     {
@@ -50,6 +116,51 @@ struct Vertex
 
 typedef uint32_t INDEX_TYPE;
 
+/// A simplified level of detail of a mesh. The levels share the vertices of
+/// the mesh and only have their own indices.
+struct MeshLOD
+{
+    /// Offset of the first index of the level in the LOD index data.
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    /// Simplification error relative to the extents of the mesh.
+    float error = 0.0f;
+};
+
+/**
+ * A cluster of consecutive triangles of a mesh with bounds for culling. The
+ * clusters are built along the index order of the mesh, so every cluster can
+ * be drawn as a range of the mesh indices.
+ */
+struct Meshlet
+{
+    /// Offset of the first index of the cluster in the mesh indices.
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    /// Number of unique vertices referenced by the cluster.
+    uint32_t vertexCount = 0;
+    math::Bounds3 bounds;
+    /// Bounding sphere of the cluster.
+    math::Vector3 center;
+    float radius = 0.0f;
+    /// Normal cone of the cluster. A cutoff of 1 means the triangles face too
+    /// many directions for the cluster to be culled.
+    math::Vector3 coneApex;
+    math::Vector3 coneAxis;
+    float coneCutoff = 1.0f;
+
+    /// Returns true if all the triangles of the cluster face away from the
+    /// given view position.
+    [[nodiscard]] inline bool isBackFacing(
+        const math::Vector3 &viewPosition) const
+    {
+        return coneCutoff < 1.0f &&
+               math::Vector3::dot(
+                   math::Vector3::normalize(coneApex - viewPosition),
+                   coneAxis) >= coneCutoff;
+    }
+};
+
 struct WorldData
 {
     math::Vector4 ambientColor{0.1f, 0.1f, 0.1f, 1.0f};
@@ -106,10 +217,43 @@ struct SceneImportSettings
     bool generateUVs = true;
     bool transformUVs = false;
     bool flipUVs = false;
+    /// Reorder triangles for the post-transform vertex cache.
+    bool optimizeVertexCache = true;
+    /// Reorder triangle clusters to reduce overdraw.
+    bool optimizeOverdraw = true;
+    /// Reorder vertices in the order they are used by the indices.
+    bool optimizeVertexFetch = true;
+    /// Generate simplified levels of detail of the meshes.
+    bool generateLODs = true;
+    /// Split the meshes into triangle clusters with culling bounds.
+    bool buildMeshlets = true;
 };
 
 static const SceneImportSettings DEFAULT_SCENE_IMPORT_SETTINGS{
-    false, false, true, false, false, true, true, false, true, true, true, true};
+    false, false, true, false, false, true, true, false, true, true, true, true,
+    true, true, true, true, true};
+
+enum class SceneLoadStage
+{
+    /// Reading the scene file or its cache file.
+    READING = 0,
+    /// Creating the materials and converting and optimizing the meshes.
+    PROCESSING = 1,
+    FINISHED = 2,
+    FAILED = 3
+};
+
+struct SceneLoadProgress
+{
+    SceneLoadStage stage = SceneLoadStage::READING;
+    /// Progress of the current stage in [0, 1].
+    float progress = 0.0f;
+};
+
+/// Called with the progress of a scene being loaded. Can be called from any
+/// thread.
+typedef std::function<void(const SceneLoadProgress &)>
+    SceneLoadProgressCallback;
 
 } // namespace kirana::scene
 
@@ -90,6 +90,11 @@ class ViewportScene
         return m_worldData;
     }
 
+    [[nodiscard]] inline const Camera &getCamera() const
+    {
+        return *m_camera;
+    }
+
     [[nodiscard]] inline CameraData getCameraData() const
     {
         return CameraData{
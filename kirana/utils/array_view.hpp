@@ -0,0 +1,68 @@
+#ifndef ARRAY_VIEW_HPP
+#define ARRAY_VIEW_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace kirana::utils
+{
+/**
+ * Non-owning view of a contiguous array. Used to expose data that can either
+ * be owned by a std::vector or live in externally managed memory (Eg: a
+ * memory-mapped file) through the same interface.
+ */
+template <typename T> class ArrayView
+{
+  public:
+    ArrayView() = default;
+    ArrayView(T *data, size_t size) : m_data{data}, m_size{size}
+    {
+    }
+    template <typename U>
+    ArrayView(std::vector<U> &vector)
+        : m_data{vector.data()}, m_size{vector.size()}
+    {
+    }
+    template <typename U>
+    ArrayView(const std::vector<U> &vector)
+        : m_data{vector.data()}, m_size{vector.size()}
+    {
+    }
+
+    [[nodiscard]] inline T *data() const
+    {
+        return m_data;
+    }
+    [[nodiscard]] inline size_t size() const
+    {
+        return m_size;
+    }
+    [[nodiscard]] inline size_t sizeInBytes() const
+    {
+        return m_size * sizeof(T);
+    }
+    [[nodiscard]] inline bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    inline T &operator[](size_t i) const
+    {
+        return m_data[i];
+    }
+
+    [[nodiscard]] inline T *begin() const
+    {
+        return m_data;
+    }
+    [[nodiscard]] inline T *end() const
+    {
+        return m_data + m_size;
+    }
+
+  private:
+    T *m_data = nullptr;
+    size_t m_size = 0;
+};
+} // namespace kirana::utils
+#endif
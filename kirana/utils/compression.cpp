@@ -0,0 +1,45 @@
+#include "compression.hpp"
+
+#include <lz4.h>
+#include <limits>
+
+bool kirana::utils::compression::compress(const void *data, size_t size,
+                                          std::vector<uint8_t> *compressedData)
+{
+    compressedData->clear();
+    if (size == 0)
+        return true;
+    if (size > static_cast<size_t>(LZ4_MAX_INPUT_SIZE))
+        return false;
+
+    const int srcSize = static_cast<int>(size);
+    compressedData->resize(static_cast<size_t>(LZ4_compressBound(srcSize)));
+    const int compressedSize = LZ4_compress_default(
+        reinterpret_cast<const char *>(data),
+        reinterpret_cast<char *>(compressedData->data()), srcSize,
+        static_cast<int>(compressedData->size()));
+    if (compressedSize <= 0)
+    {
+        compressedData->clear();
+        return false;
+    }
+    compressedData->resize(static_cast<size_t>(compressedSize));
+    return true;
+}
+
+bool kirana::utils::compression::decompress(const void *compressedData,
+                                            size_t compressedSize, void *data,
+                                            size_t size)
+{
+    if (size == 0)
+        return compressedSize == 0;
+    if (compressedSize > static_cast<size_t>(std::numeric_limits<int>::max()) ||
+        size > static_cast<size_t>(std::numeric_limits<int>::max()))
+        return false;
+
+    const int decompressedSize = LZ4_decompress_safe(
+        reinterpret_cast<const char *>(compressedData),
+        reinterpret_cast<char *>(data), static_cast<int>(compressedSize),
+        static_cast<int>(size));
+    return decompressedSize == static_cast<int>(size);
+}
@@ -0,0 +1,31 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace kirana::utils::compression
+{
+/**
+ * Compresses the given data using LZ4.
+ * @param data Pointer to the source data.
+ * @param size Size of the source data in bytes.
+ * @param compressedData The compressed output. Resized to the compressed size.
+ * @return true if the data was compressed successfully.
+ */
+bool compress(const void *data, size_t size,
+              std::vector<uint8_t> *compressedData);
+
+/**
+ * Decompresses LZ4 compressed data into a pre-allocated buffer.
+ * @param compressedData Pointer to the compressed data.
+ * @param compressedSize Size of the compressed data in bytes.
+ * @param data Destination buffer. Must be at least `size` bytes.
+ * @param size Size of the original (uncompressed) data in bytes.
+ * @return true if exactly `size` bytes were decompressed.
+ */
+bool decompress(const void *compressedData, size_t compressedSize, void *data,
+                size_t size);
+} // namespace kirana::utils::compression
+#endif
@@ -40,6 +40,15 @@ static const uint64_t VULKAN_INDEX_BUFFER_BATCH_SIZE_LIMIT =
     134217728; // 128 MB
 static const uint64_t VULKAN_MATERIAL_DATA_BUFFER_BATCH_SIZE_LIMIT =
     1048576; // 1 MB
+// Vertex and index data uploaded per frame while a scene is being loaded.
+static const uint64_t VULKAN_SCENE_UPLOAD_SIZE_PER_FRAME = 33554432; // 32 MB
+// Upload quantized 24-byte vertices instead of the 64-byte scene vertices.
+static const bool VULKAN_USE_COMPACT_VERTEX_LAYOUT = false;
+// Shader specialization constant ID of the compact vertex layout flag.
+static const uint32_t VULKAN_SPECIALIZATION_COMPACT_VERTEX_LAYOUT_ID = 0;
+// The coarsest mesh level of detail whose simplification error projects to
+// fewer pixels than this is drawn.
+static const float VULKAN_MESH_LOD_PIXEL_ERROR = 1.0f;
 static const uint32_t VULKAN_MAX_IDLE_FRAME_COUNT = 0;
 static const uint32_t VULKAN_RAYTRACING_MAX_SAMPLES = 512;
 static const uint32_t VULKAN_RAYTRACING_AA_MULTIPLIER = 8;
@@ -82,6 +91,37 @@ static const char *const DATA_DIR_PATH = DATA_DIR;
 // static const char *const DEFAULT_MODEL_NAME = "DamagedHelmet/DamagedHelmet.gltf";
 //  static const char *const DEFAULT_MODEL_NAME = "FlightHelmet/FlightHelmet.gltf";
 
+static const char *const CACHE_DIR_PATH = CACHE_DIR;
+static const bool SCENE_CACHE_ENABLED = true;
+static const uint32_t SCENE_CACHE_VERSION = 6;
+// Compressed geometry has to be decompressed into memory on load, while
+// uncompressed geometry is referenced straight from the mapped cache file.
+static const bool SCENE_CACHE_COMPRESS_GEOMETRY = false;
+static const char *const SCENE_CACHE_DIR_NAME = "scenes";
+static const char *const SCENE_CACHE_EXTENSION = ".kscene";
+// Decoded images are cached together with their mip chain.
+static const bool IMAGE_CACHE_ENABLED = true;
+static const uint32_t IMAGE_CACHE_VERSION = 3;
+static const char *const IMAGE_CACHE_DIR_NAME = "images";
+static const char *const IMAGE_CACHE_EXTENSION = ".kimage";
+// Maximum size of the decoded pixel data kept in memory. Least recently used
+// images are freed (and loaded again on demand) when it's exceeded.
+static const size_t IMAGE_MEMORY_BUDGET = 536870912; // 512 MB
+// 8-bit images are block compressed when they are loaded. Color is compressed
+// to BC7, or to BC1 and BC3 (with alpha) which are faster to encode and BC1
+// takes half the memory.
+static const bool IMAGE_COMPRESSION_ENABLED = true;
+static const bool IMAGE_COMPRESSION_PREFER_BC7 = true;
+// Every level of detail targets this fraction of the triangles of the previous
+// level. Generation stops at the maximum count, the maximum error (relative to
+// the mesh extents) or when a mesh can't be simplified any further.
+static const uint32_t SCENE_MESH_LOD_MAX_COUNT = 4;
+static const float SCENE_MESH_LOD_REDUCTION = 0.5f;
+static const float SCENE_MESH_LOD_MAX_ERROR = 0.05f;
+static const uint32_t SCENE_MESH_LOD_MIN_TRIANGLE_COUNT = 128;
+// Meshlet limits commonly used by mesh shaders.
+static const uint32_t SCENE_MESHLET_MAX_VERTICES = 64;
+static const uint32_t SCENE_MESHLET_MAX_TRIANGLES = 124;
 
 static const float VIEWPORT_SELECTED_OBJECT_OUTLINE_WIDTH = 0.025f;
 static const std::array<float, 3> VIEWPORT_SELECTED_OBJECT_OUTLINE_COLOR = {
@@ -10,6 +10,23 @@ bool kirana::utils::filesystem::fileExists(const std::string &path)
     return stat(path.c_str(), &buffer) == 0;
 }
 
+bool kirana::utils::filesystem::createDirectory(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path), error);
+    return std::filesystem::is_directory(std::filesystem::path(path), error);
+}
+
+int64_t kirana::utils::filesystem::getLastWriteTime(const std::string &path)
+{
+    std::error_code error;
+    const auto time =
+        std::filesystem::last_write_time(std::filesystem::path(path), error);
+    if (error)
+        return 0;
+    return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
 std::pair<std::string, std::string> kirana::utils::filesystem::getFilename(
     const std::string &absolutePath, bool includePeriodsInName)
 {
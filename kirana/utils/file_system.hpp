@@ -4,10 +4,18 @@
 #include <vector>
 #include <string>
 #include <initializer_list>
+#include <cstdint>
 
 namespace kirana::utils::filesystem
 {
 bool fileExists(const std::string &path);
+/// Creates the directory (and any missing parents). Returns true if the
+/// directory exists after the call.
+bool createDirectory(const std::string &path);
+/// Returns the last modification time of the file as a raw tick count, or 0 if
+/// the file does not exist. Only meant to be compared against other values
+/// returned by this function.
+int64_t getLastWriteTime(const std::string &path);
 
 std::pair<std::string, std::string> getFilename(
     const std::string &absolutePath, bool includePeriodsInName = true);
@@ -0,0 +1,77 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace kirana::utils::hash
+{
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+/**
+ * 64-bit FNV-1a hash of the given bytes.
+ * @param data Pointer to the data.
+ * @param size Size of the data in bytes.
+ * @param seed Hash to continue from. Allows hashing multiple ranges.
+ * @return The hash value.
+ */
+inline uint64_t fnv1a(const void *data, size_t size,
+                      uint64_t seed = FNV_OFFSET_BASIS)
+{
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<uint64_t>(bytes[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * 64-bit hash of the given bytes which consumes 8 bytes per FNV-1a step, with
+ * an extra shift to mix the high bits back into the low bits. Much faster than
+ * fnv1a() for large buffers (Eg: vertex data), but gives different values.
+ * @param data Pointer to the data.
+ * @param size Size of the data in bytes.
+ * @param seed Hash to continue from. Allows hashing multiple ranges.
+ * @return The hash value.
+ */
+inline uint64_t fnv1aWords(const void *data, size_t size,
+                           uint64_t seed = FNV_OFFSET_BASIS)
+{
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data);
+    uint64_t hash = seed;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * FNV_PRIME;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; i++)
+    {
+        hash ^= static_cast<uint64_t>(bytes[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a(const std::string &value,
+                      uint64_t seed = FNV_OFFSET_BASIS)
+{
+    return fnv1a(value.data(), value.size(), seed);
+}
+
+/// Hashes the object representation of a trivially copyable value.
+template <typename T>
+inline uint64_t fnv1aValue(const T &value, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    return fnv1a(&value, sizeof(T), seed);
+}
+} // namespace kirana::utils::hash
+#endif
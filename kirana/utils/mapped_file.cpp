@@ -0,0 +1,103 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+kirana::utils::MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool kirana::utils::MappedFile::open(const std::string &path)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_data = reinterpret_cast<const uint8_t *>(data);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileStat
+    {
+    };
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    const auto fileSize = static_cast<size_t>(fileStat.st_size);
+    void *data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(file);
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = reinterpret_cast<const uint8_t *>(data);
+    m_size = fileSize;
+#endif
+    m_path = path;
+    return true;
+}
+
+void kirana::utils::MappedFile::close()
+{
+    if (m_data == nullptr)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(reinterpret_cast<HANDLE>(m_mappingHandle));
+    CloseHandle(reinterpret_cast<HANDLE>(m_fileHandle));
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_path.clear();
+}
@@ -0,0 +1,58 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace kirana::utils
+{
+/**
+ * Read-only memory-mapped view of a file. The mapping stays valid for the
+ * lifetime of the object.
+ */
+class MappedFile
+{
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &file) = delete;
+    MappedFile &operator=(const MappedFile &file) = delete;
+
+    /**
+     * Maps the entire file into memory. Any previously mapped file is closed.
+     * @param path Path of the file to map.
+     * @return true if the file was mapped.
+     */
+    bool open(const std::string &path);
+    void close();
+
+    [[nodiscard]] inline bool isOpen() const
+    {
+        return m_data != nullptr;
+    }
+    [[nodiscard]] inline const uint8_t *data() const
+    {
+        return m_data;
+    }
+    [[nodiscard]] inline size_t size() const
+    {
+        return m_size;
+    }
+    [[nodiscard]] inline const std::string &getPath() const
+    {
+        return m_path;
+    }
+
+  private:
+    std::string m_path;
+    const uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void *m_fileHandle = nullptr;
+    void *m_mappingHandle = nullptr;
+#endif
+};
+} // namespace kirana::utils
+#endif
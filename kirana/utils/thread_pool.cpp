@@ -0,0 +1,140 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+kirana::utils::ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount =
+            std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+        m_workers.emplace_back([this]() { workerLoop(); });
+}
+
+kirana::utils::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for (auto &w : m_workers)
+        w.join();
+}
+
+void kirana::utils::ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock,
+                             [this]() { return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+        task();
+    }
+}
+
+std::future<void> kirana::utils::ThreadPool::submit(
+    std::function<void()> task)
+{
+    std::packaged_task<void()> packagedTask(std::move(task));
+    std::future<void> future = packagedTask.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace(std::move(packagedTask));
+    }
+    m_condition.notify_one();
+    return future;
+}
+
+void kirana::utils::ThreadPool::parallelFor(
+    size_t count, const std::function<void(size_t)> &function,
+    size_t grainSize)
+{
+    if (count == 0)
+        return;
+    grainSize = std::max(grainSize, static_cast<size_t>(1));
+    const size_t batchCount = (count + grainSize - 1) / grainSize;
+    if (m_workers.empty() || batchCount == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            function(i);
+        return;
+    }
+
+    // The state is shared with the helper tasks, since helpers which start
+    // after all the work is done may outlive this call.
+    struct State
+    {
+        std::atomic<size_t> nextIndex{0};
+        std::atomic<size_t> processedCount{0};
+        std::atomic<bool> isFailed{false};
+        // First exception thrown by the function, rethrown by the caller.
+        std::exception_ptr exception;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<State>();
+
+    const auto processBatches = [state, count, grainSize, &function]() {
+        while (true)
+        {
+            const size_t start = state->nextIndex.fetch_add(grainSize);
+            if (start >= count)
+                return;
+            const size_t end = std::min(start + grainSize, count);
+            // A batch which throws still counts as processed, and the
+            // batches after it are skipped, so that the caller doesn't wait
+            // forever and only returns once the function isn't used anymore.
+            try
+            {
+                for (size_t i = start; i < end && !state->isFailed; i++)
+                    function(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->isFailed.exchange(true))
+                    state->exception = std::current_exception();
+            }
+            if (state->processedCount.fetch_add(end - start) + (end - start) ==
+                count)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helperCount =
+        std::min(static_cast<size_t>(m_workers.size()), batchCount - 1);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < helperCount; i++)
+            m_tasks.emplace(processBatches);
+    }
+    m_condition.notify_all();
+
+    // The calling thread works too, which also guarantees progress when
+    // called from inside a worker thread.
+    processBatches();
+
+    // Only wait for the batches which have been claimed, not for the helpers,
+    // since a helper which hasn't started yet has nothing left to do.
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(
+        lock, [&state, count]() { return state->processedCount == count; });
+    if (state->exception)
+        std::rethrow_exception(state->exception);
+}
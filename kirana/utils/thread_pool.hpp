@@ -0,0 +1,75 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace kirana::utils
+{
+/**
+ * Fixed-size pool of worker threads. Use ThreadPool::get() for the shared
+ * application-wide pool.
+ */
+class ThreadPool
+{
+  public:
+    /**
+     * @param threadCount Number of worker threads. If 0, one less than the
+     * number of hardware threads is used, since the calling thread takes part
+     * in parallelFor().
+     */
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &threadPool) = delete;
+    ThreadPool &operator=(const ThreadPool &threadPool) = delete;
+
+    static ThreadPool &get()
+    {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    [[nodiscard]] inline uint32_t getThreadCount() const
+    {
+        return static_cast<uint32_t>(m_workers.size());
+    }
+
+    /**
+     * Queues a task to be run on one of the worker threads.
+     * @param task The task to run.
+     * @return Future which becomes ready when the task has finished.
+     */
+    std::future<void> submit(std::function<void()> task);
+
+    /**
+     * Calls the given function for every index in [0, count) across the worker
+     * threads and the calling thread. Indices are handed out dynamically in
+     * batches of grainSize, so uneven work is balanced automatically. Blocks
+     * until all indices have been processed. Safe to call from inside a task.
+     * If the function throws, the remaining indices are skipped, and the
+     * first exception is rethrown once no thread is calling it anymore.
+     * @param count Number of indices.
+     * @param function Function called with each index.
+     * @param grainSize Number of consecutive indices processed per batch.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &function,
+                     size_t grainSize = 1);
+
+  private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::packaged_task<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+
+    void workerLoop();
+};
+} // namespace kirana::utils
+#endif
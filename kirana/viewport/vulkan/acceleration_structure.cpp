@@ -64,10 +64,14 @@ void kirana::viewport::vulkan::AccelerationStructure::createBLAS(
         BLASData blasData{};
         for (const auto &m : mObj.meshes)
         {
+            // Both vertex layouts start with a float3 position, only the
+            // stride differs.
             const vk::AccelerationStructureGeometryTrianglesDataKHR triangles{
-                vk::Format::eR32G32B32A32Sfloat,
+                VERTEX_LAYOUT == scene::VertexLayout::COMPACT
+                    ? vk::Format::eR32G32B32Sfloat
+                    : vk::Format::eR32G32B32A32Sfloat,
                 sceneData.getVertexBufferAddress(m.vertexBufferIndex),
-                sizeof(scene::Vertex),
+                scene::Vertex::getSize(VERTEX_LAYOUT),
                 static_cast<uint32_t>(m.vertexCount),
                 vk::IndexType::eUint32,
                 sceneData.getIndexBufferAddress(m.indexBufferIndex),
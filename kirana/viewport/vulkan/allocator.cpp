@@ -183,8 +183,8 @@ bool kirana::viewport::vulkan::Allocator::allocateImage(
     AllocatedImage *image, vk::ImageCreateInfo imageCreateInfo,
     vk::ImageLayout layout, vk::ImageSubresourceRange subresourceRange,
     AllocationType allocationType, const void *data, size_t dataSize,
-    std::array<uint32_t, 3> imageOffset,
-    std::array<uint32_t, 3> imageSize) const
+    std::array<uint32_t, 3> imageOffset, std::array<uint32_t, 3> imageSize,
+    const std::vector<vk::BufferImageCopy> &copyRegions) const
 {
     if (data != nullptr && allocationType == AllocationType::GPU_READ_ONLY)
     {
@@ -226,6 +226,9 @@ bool kirana::viewport::vulkan::Allocator::allocateImage(
         if (data == nullptr)
             transitionImageLayout(*image->image, subresourceRange,
                                   vk::ImageLayout::eUndefined, layout);
+        else if (!copyRegions.empty())
+            return copyDataToImage(*image, layout, subresourceRange, data,
+                                   dataSize, copyRegions);
         else
             return copyDataToImage(*image, layout, subresourceRange, data,
                                    dataSize, imageOffset, imageSize);
@@ -300,6 +303,26 @@ bool kirana::viewport::vulkan::Allocator::copyDataToImage(
     vk::ImageSubresourceRange subresourceRange, const void *data,
     size_t dataSize, std::array<uint32_t, 3> imageOffset,
     std::array<uint32_t, 3> imageSize) const
+{
+    const vk::BufferImageCopy copyRegion{
+        0,
+        0,
+        0,
+        vk::ImageSubresourceLayers{
+            subresourceRange.aspectMask, subresourceRange.baseMipLevel,
+            subresourceRange.baseArrayLayer, subresourceRange.layerCount},
+        vk::Offset3D{static_cast<int32_t>(imageOffset[0]),
+                     static_cast<int32_t>(imageOffset[1]),
+                     static_cast<int32_t>(imageOffset[2])},
+        vk::Extent3D{imageSize[0], imageSize[1], imageSize[2]}};
+    return copyDataToImage(image, layout, subresourceRange, data, dataSize,
+                           std::vector<vk::BufferImageCopy>{copyRegion});
+}
+
+bool kirana::viewport::vulkan::Allocator::copyDataToImage(
+    const AllocatedImage &image, vk::ImageLayout layout,
+    vk::ImageSubresourceRange subresourceRange, const void *data,
+    size_t dataSize, const std::vector<vk::BufferImageCopy> &copyRegions) const
 {
     vma::AllocationInfo stagingAllocInfo{};
     auto stagingBufferData = m_current->createBuffer(
@@ -315,25 +338,12 @@ bool kirana::viewport::vulkan::Allocator::copyDataToImage(
     memcpy(stagingAllocInfo.pMappedData, data, dataSize);
     m_current->flushAllocation(stagingBufferData.second, 0, VK_WHOLE_SIZE);
 
-
-    const vk::BufferImageCopy copyRegion{
-        0,
-        0,
-        0,
-        vk::ImageSubresourceLayers{
-            subresourceRange.aspectMask, subresourceRange.baseMipLevel,
-            subresourceRange.baseArrayLayer, subresourceRange.layerCount},
-        vk::Offset3D{static_cast<int32_t>(imageOffset[0]),
-                     static_cast<int32_t>(imageOffset[1]),
-                     static_cast<int32_t>(imageOffset[2])},
-        vk::Extent3D{imageSize[0], imageSize[1], imageSize[2]}};
-
     // Copy pixel data to image from the staging buffer.
     m_device->current.resetFences(m_commandFence);
     m_commandPool->reset();
     m_commandBuffers->begin();
     m_commandBuffers->copyBufferToImage(stagingBufferData.first, *image.image,
-                                        subresourceRange, layout, {copyRegion});
+                                        subresourceRange, layout, copyRegions);
     m_commandBuffers->end();
     m_device->transferSubmit(m_commandBuffers->current, m_commandFence);
     VK_HANDLE_RESULT(
@@ -83,7 +83,8 @@ class Allocator
         AllocationType allocationType = AllocationType::GPU_WRITEABLE,
         const void *data = nullptr, size_t dataSize = 0,
         std::array<uint32_t, 3> imageOffset = {0, 0, 0},
-        std::array<uint32_t, 3> imageSize = {0, 0, 0}) const;
+        std::array<uint32_t, 3> imageSize = {0, 0, 0},
+        const std::vector<vk::BufferImageCopy> &copyRegions = {}) const;
     bool copyDataToBuffer(const AllocatedBuffer &buffer, const void *data,
                           size_t dataOffset, size_t dataSize) const;
     bool copyDataToImage(const AllocatedImage &image, vk::ImageLayout layout,
@@ -91,6 +92,13 @@ class Allocator
                          const void *data, size_t dataSize = 0,
                          std::array<uint32_t, 3> imageOffset = {0, 0, 0},
                          std::array<uint32_t, 3> imageSize = {0, 0, 0}) const;
+    /// Copies the data to multiple regions of the image (Eg: Mip levels)
+    /// with a single staging buffer.
+    bool copyDataToImage(
+        const AllocatedImage &image, vk::ImageLayout layout,
+        vk::ImageSubresourceRange subresourceRange, const void *data,
+        size_t dataSize,
+        const std::vector<vk::BufferImageCopy> &copyRegions) const;
     [[nodiscard]] bool copyBuffer(const vk::Buffer &stagingBuffer,
                                   const vk::Buffer &destBuffer,
                                   vk::DeviceSize size,
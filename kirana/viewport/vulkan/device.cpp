@@ -164,6 +164,11 @@ bool kirana::viewport::vulkan::Device::selectIdealGPU()
                           "Failed to find GPU with the necessary feature set");
         return false;
     }
+    m_isBlockCompressionSupported = features.features.textureCompressionBC;
+    if (!m_isBlockCompressionSupported)
+        Logger::get().log(constants::LOG_CHANNEL_VULKAN, LogSeverity::warning,
+                          "GPU doesn't support BC textures, textures will be "
+                          "uploaded uncompressed");
 
     // Set Extension properties.
     m_accelStructProperties = getAccelerationStructureProperties(m_gpu);
@@ -188,8 +193,9 @@ bool kirana::viewport::vulkan::Device::createLogicalDevice()
         queueCreateInfos.push_back(createInfo);
     }
 
-    const vk::PhysicalDeviceFeatures2 reqFeatures =
+    vk::PhysicalDeviceFeatures2 reqFeatures =
         vulkan::getRequiredDeviceFeatures();
+    reqFeatures.features.textureCompressionBC = m_isBlockCompressionSupported;
     const vk::DeviceCreateInfo createInfo(
         {}, queueCreateInfos, REQUIRED_VALIDATION_LAYERS,
         REQUIRED_DEVICE_EXTENSIONS, &reqFeatures.features, reqFeatures.pNext);
@@ -22,6 +22,8 @@ class Device
     vk::PhysicalDeviceAccelerationStructurePropertiesKHR
         m_accelStructProperties;
     vk::PhysicalDeviceRayTracingPipelinePropertiesKHR m_raytracingProperties;
+    // Optional, textures are uploaded uncompressed without it.
+    bool m_isBlockCompressionSupported = false;
 
     const Instance *const m_instance;
     const Surface *const m_surface;
@@ -63,6 +65,7 @@ class Device
         &accelStructProperties = m_accelStructProperties;
     const vk::PhysicalDeviceRayTracingPipelinePropertiesKHR
         &raytracingProperties = m_raytracingProperties;
+    const bool &isBlockCompressionSupported = m_isBlockCompressionSupported;
 
     [[nodiscard]] SwapchainSupportInfo getSwapchainSupportInfo() const;
 
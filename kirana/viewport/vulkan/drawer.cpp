@@ -130,15 +130,6 @@ void kirana::viewport::vulkan::Drawer::rasterizeMeshes(const FrameData &frame,
                     0);
                 lastVertexBufferIndex = mesh.vertexBufferIndex;
             }
-            if (mesh.indexBufferIndex > -1 &&
-                mesh.indexBufferIndex != lastIndexBufferIndex)
-            {
-                frame.commandBuffers->bindIndexBuffer(
-                    m_scene->getIndexBuffer(drawEditorMeshes, mObj.index,
-                                            mesh.index),
-                    0);
-                lastIndexBufferIndex = mesh.indexBufferIndex;
-            }
             const auto &pipeline = m_scene->getCurrentPipeline(
                 drawEditorMeshes, false, mObj.index, mesh.index);
             if (lastPipeline != pipeline.name)
@@ -149,6 +140,18 @@ void kirana::viewport::vulkan::Drawer::rasterizeMeshes(const FrameData &frame,
 
             for (uint32_t i = 0; i < mObj.instances.size(); i++)
             {
+                // Every instance draws the level of detail that fits its
+                // size on screen. The levels can be in other index buffers.
+                const MeshLODData lod = mesh.getLOD(m_scene->getMeshLOD(
+                    drawEditorMeshes, mObj.index, mesh.index, i));
+                if (lod.indexBufferIndex > -1 &&
+                    lod.indexBufferIndex != lastIndexBufferIndex)
+                {
+                    frame.commandBuffers->bindIndexBuffer(
+                        m_scene->getIndexBuffer(lod.indexBufferIndex), 0);
+                    lastIndexBufferIndex = lod.indexBufferIndex;
+                }
+
                 const auto &pushConstantData =
                     m_scene->getPushConstantRasterData(
                         drawEditorMeshes, false, mObj.index, mesh.index, i);
@@ -156,7 +159,7 @@ void kirana::viewport::vulkan::Drawer::rasterizeMeshes(const FrameData &frame,
                     rPipelineLayout, pushConstantData);
 
                 frame.commandBuffers->drawIndexed(
-                    mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset,
+                    lod.indexCount, 1, lod.firstIndex, mesh.vertexOffset,
                     mObj.getGlobalInstanceIndex(i));
 
                 // TODO: Find better way to render outline
@@ -173,7 +176,7 @@ void kirana::viewport::vulkan::Drawer::rasterizeMeshes(const FrameData &frame,
                         rPipelineLayout, outlinePC);
 
                     frame.commandBuffers->drawIndexed(
-                        mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset,
+                        lod.indexCount, 1, lod.firstIndex, mesh.vertexOffset,
                         mObj.getGlobalInstanceIndex(i));
                 }
             }
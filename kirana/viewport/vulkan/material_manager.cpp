@@ -27,6 +27,12 @@ vk::Format kirana::viewport::vulkan::MaterialManager::
         {
         case scene::VertexDataFormat::INT:
             return vk::Format::eR32Sint;
+        case scene::VertexDataFormat::HALF_FLOAT:
+            return vk::Format::eR16Sfloat;
+        case scene::VertexDataFormat::SNORM16:
+            return vk::Format::eR16Snorm;
+        case scene::VertexDataFormat::UNORM8:
+            return vk::Format::eR8Unorm;
         case scene::VertexDataFormat::FLOAT:
         default:
             return vk::Format::eR32Sfloat;
@@ -38,6 +44,12 @@ vk::Format kirana::viewport::vulkan::MaterialManager::
         {
         case scene::VertexDataFormat::INT:
             return vk::Format::eR32G32Sint;
+        case scene::VertexDataFormat::HALF_FLOAT:
+            return vk::Format::eR16G16Sfloat;
+        case scene::VertexDataFormat::SNORM16:
+            return vk::Format::eR16G16Snorm;
+        case scene::VertexDataFormat::UNORM8:
+            return vk::Format::eR8G8Unorm;
         case scene::VertexDataFormat::FLOAT:
         default:
             return vk::Format::eR32G32Sfloat;
@@ -49,6 +61,12 @@ vk::Format kirana::viewport::vulkan::MaterialManager::
         {
         case scene::VertexDataFormat::INT:
             return vk::Format::eR32G32B32Sint;
+        case scene::VertexDataFormat::HALF_FLOAT:
+            return vk::Format::eR16G16B16Sfloat;
+        case scene::VertexDataFormat::SNORM16:
+            return vk::Format::eR16G16B16Snorm;
+        case scene::VertexDataFormat::UNORM8:
+            return vk::Format::eR8G8B8Unorm;
         case scene::VertexDataFormat::FLOAT:
         default:
             return vk::Format::eR32G32B32Sfloat;
@@ -60,6 +78,12 @@ vk::Format kirana::viewport::vulkan::MaterialManager::
         {
         case scene::VertexDataFormat::INT:
             return vk::Format::eR32G32B32A32Sint;
+        case scene::VertexDataFormat::HALF_FLOAT:
+            return vk::Format::eR16G16B16A16Sfloat;
+        case scene::VertexDataFormat::SNORM16:
+            return vk::Format::eR16G16B16A16Snorm;
+        case scene::VertexDataFormat::UNORM8:
+            return vk::Format::eR8G8B8A8Unorm;
         case scene::VertexDataFormat::FLOAT:
         default:
             return vk::Format::eR32G32B32A32Sfloat;
@@ -73,17 +97,24 @@ kirana::viewport::vulkan::MaterialManager::VertexInputDescription kirana::
     viewport::vulkan::MaterialManager::getVertexInputDescription(
         const scene::RasterPipelineData &rasterData)
 {
+    // The material attributes describe the standard vertex. With the compact
+    // layout, the vertex buffers hold CompactVertex data instead.
+    const std::vector<scene::VertexInfo> &attributeInfo =
+        VERTEX_LAYOUT == scene::VertexLayout::COMPACT
+            ? scene::Vertex::getVertexInfo(VERTEX_LAYOUT)
+            : rasterData.vertexAttributeInfo;
+
     VertexInputDescription desc{};
-    desc.bindings = {{0, sizeof(scene::Vertex), vk::VertexInputRate::eVertex}};
-    desc.attributes.resize(rasterData.vertexAttributeInfo.size());
+    desc.bindings = {
+        {0, static_cast<uint32_t>(scene::Vertex::getSize(VERTEX_LAYOUT)),
+         vk::VertexInputRate::eVertex}};
+    desc.attributes.resize(attributeInfo.size());
 
-    for (uint32_t i = 0; i < rasterData.vertexAttributeInfo.size(); i++)
+    for (uint32_t i = 0; i < attributeInfo.size(); i++)
     {
         desc.attributes[i] = vk::VertexInputAttributeDescription{
-            i, 0,
-            getFormatFromVertexAttribInfo(rasterData.vertexAttributeInfo[i]),
-            static_cast<uint32_t>(
-                rasterData.vertexAttributeInfo[i].structOffset)};
+            i, 0, getFormatFromVertexAttribInfo(attributeInfo[i]),
+            static_cast<uint32_t>(attributeInfo[i].structOffset)};
     }
     return desc;
 }
@@ -397,6 +428,16 @@ uint32_t kirana::viewport::vulkan::MaterialManager::addMaterial(
     return m_materialIndexTable[materialName];
 }
 
+bool kirana::viewport::vulkan::MaterialManager::addTextures(
+    const std::vector<std::shared_ptr<scene::Material>> &materials)
+{
+    std::vector<scene::Image *> images;
+    for (const auto &m : materials)
+        images.insert(images.end(), m->getImages().begin(),
+                      m->getImages().end());
+    return m_textureManager->addTextures(images);
+}
+
 vk::DeviceAddress kirana::viewport::vulkan::MaterialManager::
     getMaterialDataBufferAddress(uint32_t materialIndex) const
 {
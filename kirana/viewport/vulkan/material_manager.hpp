@@ -82,6 +82,10 @@ class MaterialManager
 
     uint32_t addMaterial(const RenderPass &renderPass,
                          const scene::Material &material);
+    /// Decodes and uploads the images of the materials in parallel, before
+    /// the materials are added.
+    bool addTextures(
+        const std::vector<std::shared_ptr<scene::Material>> &materials);
 
     inline int getMaterialIndexFromName(const std::string &materialName) const
     {
@@ -15,7 +15,8 @@ bool kirana::viewport::vulkan::RasterPipeline::build()
     for (const auto &stage : m_shader->getAllModules())
         for (const auto &m : stage.second)
             shaderStages.emplace_back(vk::PipelineShaderStageCreateInfo(
-                {}, stage.first, m, constants::VULKAN_SHADER_MAIN_FUNC_NAME));
+                {}, stage.first, m, constants::VULKAN_SHADER_MAIN_FUNC_NAME,
+                &SHADER_SPECIALIZATION_INFO));
 
     const vk::PipelineVertexInputStateCreateInfo vertexInput(
         {}, m_properties.vertexBindings, m_properties.vertexAttributes);
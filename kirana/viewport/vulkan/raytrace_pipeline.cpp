@@ -28,7 +28,8 @@ bool kirana::viewport::vulkan::RaytracePipeline::build()
         for (const auto &m : stage.second)
         {
             m_shaderStages.emplace_back(vk::PipelineShaderStageCreateInfo(
-                {}, stage.first, m, constants::VULKAN_SHADER_MAIN_FUNC_NAME));
+                {}, stage.first, m, constants::VULKAN_SHADER_MAIN_FUNC_NAME,
+                &SHADER_SPECIALIZATION_INFO));
 
             switch (stage.first)
             {
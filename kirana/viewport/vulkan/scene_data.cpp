@@ -13,6 +13,9 @@
 #include "vulkan_utils.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <hash.hpp>
 #include <viewport_scene.hpp>
 
 void kirana::viewport::vulkan::SceneData::onWorldChanged()
@@ -48,8 +51,11 @@ void kirana::viewport::vulkan::SceneData::onSceneLoaded(bool result)
     if (result)
     {
         createMaterials(false);
-        createMeshes(false);
-        createObjectBuffer();
+        // The meshes are uploaded in slices by update().
+        m_isUploadingScene = true;
+        m_sceneUploadIndex = 0;
+        m_sceneMeshObjectTable.clear();
+        m_sceneMeshObjectTable.reserve(m_scene.getSceneRenderables().size());
     }
     m_onSceneDataChange();
 }
@@ -72,7 +78,7 @@ void kirana::viewport::vulkan::SceneData::onObjectChanged()
                 m.vertexOffset});
         }
     }
-    if (!objData.empty())
+    if (!objData.empty() && m_objectDataBuffer.buffer)
         m_allocator->copyDataToBuffer(m_objectDataBuffer, objData.data(), 0,
                                       sizeof(vulkan::ObjectData) *
                                           objData.size());
@@ -130,10 +136,23 @@ void kirana::viewport::vulkan::SceneData::createCameraBuffer()
 }
 
 std::pair<int, int> kirana::viewport::vulkan::SceneData::
-    createVertexAndIndexBuffer(const std::vector<scene::Vertex> &vertices,
-                               const std::vector<scene::INDEX_TYPE> &indices)
+    createVertexAndIndexBuffer(
+        utils::ArrayView<const scene::Vertex> vertices,
+        utils::ArrayView<const scene::INDEX_TYPE> indices)
 {
-    const size_t totalVertexSize = vertices.size() * sizeof(scene::Vertex);
+    // Quantize the vertices if the compact layout is used.
+    std::vector<scene::CompactVertex> compactVertices;
+    const void *vertexData = vertices.data();
+    if (VERTEX_LAYOUT == scene::VertexLayout::COMPACT)
+    {
+        compactVertices.resize(vertices.size());
+        scene::CompactVertex::pack(vertices.data(), vertices.size(),
+                                   compactVertices.data());
+        vertexData = compactVertices.data();
+    }
+
+    const size_t totalVertexSize =
+        vertices.size() * scene::Vertex::getSize(VERTEX_LAYOUT);
     if (m_vertexBuffers.empty() ||
         ((totalVertexSize + m_vertexBuffers.back().currentSize) >
          constants::VULKAN_VERTEX_BUFFER_BATCH_SIZE_LIMIT))
@@ -162,12 +181,20 @@ std::pair<int, int> kirana::viewport::vulkan::SceneData::
     auto &vBuffer = m_vertexBuffers.back();
 
 
-    m_allocator->copyDataToBuffer(vBuffer.buffer, vertices.data(),
+    m_allocator->copyDataToBuffer(vBuffer.buffer, vertexData,
                                   vBuffer.currentSize, totalVertexSize);
     vBuffer.currentSize += totalVertexSize;
     vBuffer.currentDataCount += vertices.size();
 
+    const int indexBufferIndex = createIndexBuffer(indices);
+    if (indexBufferIndex == -1)
+        return {-1, -1};
+    return {static_cast<int>(m_vertexBuffers.size() - 1), indexBufferIndex};
+}
 
+int kirana::viewport::vulkan::SceneData::createIndexBuffer(
+    utils::ArrayView<const scene::INDEX_TYPE> indices)
+{
     const size_t totalIndexSize = indices.size() * sizeof(scene::INDEX_TYPE);
 
     if (m_indexBuffers.empty() ||
@@ -185,7 +212,7 @@ std::pair<int, int> kirana::viewport::vulkan::SceneData::
                     vk::BufferUsageFlagBits::eStorageBuffer |
                     RaytraceData::VERTEX_INDEX_BUFFER_USAGE_FLAGS,
                 Allocator::AllocationType::GPU_WRITEABLE))
-            return {-1, -1};
+            return -1;
 
         m_device->setDebugObjectName(*buffer.buffer.buffer,
                                      "IndexBuffer_" +
@@ -202,14 +229,14 @@ std::pair<int, int> kirana::viewport::vulkan::SceneData::
     iBuffer.currentSize += totalIndexSize;
     iBuffer.currentDataCount += indices.size();
 
-    return {static_cast<int>(m_vertexBuffers.size() - 1),
-            static_cast<int>(m_indexBuffers.size() - 1)};
+    return static_cast<int>(m_indexBuffers.size() - 1);
 }
 
 void kirana::viewport::vulkan::SceneData::createMaterials(bool isEditor)
 {
     const auto &mats =
         isEditor ? m_scene.getEditorMaterials() : m_scene.getSceneMaterials();
+    m_materialManager->addTextures(mats);
     for (const auto &em : mats)
         m_materialManager->addMaterial(*m_renderPass, *em);
 
@@ -222,28 +249,16 @@ void kirana::viewport::vulkan::SceneData::createMaterials(bool isEditor)
 }
 
 
-int kirana::viewport::vulkan::SceneData::getMeshObject(
-    const std::vector<MeshObjectData> &meshObjects,
-    const std::vector<std::shared_ptr<scene::Mesh>> &meshes)
+size_t kirana::viewport::vulkan::SceneData::MeshListHash::operator()(
+    const std::vector<const scene::Mesh *> &meshes) const
 {
-    const auto it =
-        std::find_if(meshObjects.begin(), meshObjects.end(),
-                     [&meshes](const MeshObjectData &mObj) {
-                         if (mObj.meshes.size() != meshes.size())
-                             return false;
-                         for (uint32_t i = 0; i < meshes.size(); i++)
-                             if (mObj.meshes[i].name != meshes[i]->getName())
-                                 return false;
-                         return true;
-                     });
-
-    if (it == meshObjects.end())
-        return -1;
-
-    return static_cast<int>(it->index);
+    return static_cast<size_t>(utils::hash::fnv1a(
+        meshes.data(), meshes.size() * sizeof(const scene::Mesh *)));
 }
 
-bool kirana::viewport::vulkan::SceneData::createMeshes(bool isEditor)
+uint32_t kirana::viewport::vulkan::SceneData::uploadMeshes(
+    bool isEditor, uint32_t firstRenderable, size_t maxUploadSize,
+    MeshObjectTable *meshObjectTable)
 {
     std::vector<MeshObjectData> &currMeshObjects =
         isEditor ? m_editorMeshes : m_sceneMeshes;
@@ -251,8 +266,9 @@ bool kirana::viewport::vulkan::SceneData::createMeshes(bool isEditor)
     const std::vector<scene::Renderable> &renderables =
         isEditor ? m_scene.getEditorRenderables()
                  : m_scene.getSceneRenderables();
-    uint32_t meshObjIndex = 0;
-    for (uint32_t rIndex = 0; rIndex < renderables.size(); rIndex++)
+    size_t uploadSize = 0;
+    uint32_t rIndex = firstRenderable;
+    for (; rIndex < renderables.size() && uploadSize < maxUploadSize; rIndex++)
     {
         auto &renderable = renderables[rIndex];
         auto &meshes = renderable.object->getMeshes();
@@ -260,9 +276,17 @@ bool kirana::viewport::vulkan::SceneData::createMeshes(bool isEditor)
         if (meshes.empty()) // Ignore empty objects
             continue;
 
-        const int foundMeshObjIndex = getMeshObject(currMeshObjects, meshes);
-        if (foundMeshObjIndex > -1)
+        std::vector<const scene::Mesh *> meshList(meshes.size());
+        std::transform(meshes.begin(), meshes.end(), meshList.begin(),
+                       [](const auto &m) { return m.get(); });
+        // Identical meshes are shared by the scene, so objects referencing the
+        // same meshes are instances of one MeshObject.
+        const auto [tableIt, isNewMeshObject] = meshObjectTable->emplace(
+            std::move(meshList),
+            static_cast<uint32_t>(currMeshObjects.size()));
+        if (!isNewMeshObject)
         {
+            const uint32_t foundMeshObjIndex = tableIt->second;
             // If there's already an existing MeshObject with same meshes,
             // create a new instance.
             const uint32_t instanceIndex = static_cast<uint32_t>(
@@ -275,7 +299,7 @@ bool kirana::viewport::vulkan::SceneData::createMeshes(bool isEditor)
         else
         {
             MeshObjectData meshObject;
-            meshObject.index = meshObjIndex++;
+            meshObject.index = static_cast<uint32_t>(currMeshObjects.size());
             meshObject.name = renderable.object->getName();
             meshObject.instances.emplace_back(InstanceData{
                 0, renderable.object->transform, &renderable.viewportVisible,
@@ -288,14 +312,19 @@ bool kirana::viewport::vulkan::SceneData::createMeshes(bool isEditor)
                 meshData.index = mIndex;
                 meshData.name = mesh->getName();
 
-                const auto &meshVertices = mesh->getVertices();
-                const auto &meshIndices = mesh->getIndices();
+                // For cached scenes the views point into the memory-mapped
+                // cache file, so the data is copied straight into staging.
+                const auto meshVertices = mesh->getVertices();
+                const auto meshIndices = mesh->getIndices();
                 meshData.vertexCount =
                     static_cast<uint32_t>(meshVertices.size());
                 meshData.indexCount = static_cast<uint32_t>(meshIndices.size());
 
                 auto bufferIndices =
                     createVertexAndIndexBuffer(meshVertices, meshIndices);
+                uploadSize += meshVertices.size() *
+                                  scene::Vertex::getSize(VERTEX_LAYOUT) +
+                              meshIndices.size() * sizeof(scene::INDEX_TYPE);
                 if (bufferIndices.first == -1 || bufferIndices.second == -1)
                 {
                     Logger::get().log(constants::LOG_CHANNEL_VULKAN,
@@ -315,6 +344,29 @@ bool kirana::viewport::vulkan::SceneData::createMeshes(bool isEditor)
                     m_indexBuffers[bufferIndices.second].currentDataCount -
                     meshData.indexCount);
 
+                // The levels of detail are appended to the index buffers and
+                // reference the vertices of the mesh.
+                for (size_t lod = 1; lod < mesh->getLODCount(); lod++)
+                {
+                    const auto lodIndices = mesh->getLODIndices(lod);
+                    const int lodBufferIndex = createIndexBuffer(lodIndices);
+                    if (lodBufferIndex == -1)
+                        break;
+                    uploadSize += lodIndices.size() * sizeof(scene::INDEX_TYPE);
+                    meshData.lods.emplace_back(MeshLODData{
+                        lodBufferIndex,
+                        static_cast<uint32_t>(
+                            m_indexBuffers[lodBufferIndex].currentDataCount -
+                            lodIndices.size()),
+                        static_cast<uint32_t>(lodIndices.size()),
+                        mesh->getLODError(lod)});
+                }
+                const math::Bounds3 &bounds = mesh->getBounds();
+                const math::Vector3 size = bounds.getMax() - bounds.getMin();
+                meshData.boundsCenter = bounds.getCenter();
+                meshData.boundsExtent =
+                    std::max({size[0], size[1], size[2], 0.0f});
+
                 int matIndex = m_materialManager->getMaterialIndexFromName(
                     mesh->getMaterial()->getName());
                 if (matIndex == -1)
@@ -330,6 +382,14 @@ bool kirana::viewport::vulkan::SceneData::createMeshes(bool isEditor)
             currMeshObjects.emplace_back(std::move(meshObject));
         }
     }
+    return rIndex;
+}
+
+bool kirana::viewport::vulkan::SceneData::createMeshes(bool isEditor)
+{
+    MeshObjectTable meshObjectTable;
+    uploadMeshes(isEditor, 0, std::numeric_limits<size_t>::max(),
+                 &meshObjectTable);
     return true;
 }
 
@@ -462,9 +522,40 @@ void kirana::viewport::vulkan::SceneData::setShadingPipeline(
     vulkan::ShadingPipeline pipeline)
 {
     m_currentShadingPipeline = pipeline;
+    // While the scene is uploaded, ray tracing is initialized once all the
+    // meshes are uploaded.
+    if (m_currentShadingPipeline == ShadingPipeline::RAYTRACE &&
+        !m_isRaytracingInitialized && !m_isUploadingScene)
+        m_isRaytracingInitialized = m_raytraceData->initialize(*this);
+    m_onSceneDataChange();
+}
+
+void kirana::viewport::vulkan::SceneData::update()
+{
+    if (!m_isUploadingScene)
+        return;
+
+    m_sceneUploadIndex =
+        uploadMeshes(false, m_sceneUploadIndex,
+                     constants::VULKAN_SCENE_UPLOAD_SIZE_PER_FRAME,
+                     &m_sceneMeshObjectTable);
+    if (m_sceneUploadIndex < m_scene.getSceneRenderables().size())
+    {
+        m_onSceneDataChange();
+        return;
+    }
+
+    m_isUploadingScene = false;
+    m_sceneMeshObjectTable = MeshObjectTable();
+    createObjectBuffer();
     if (m_currentShadingPipeline == ShadingPipeline::RAYTRACE &&
         !m_isRaytracingInitialized)
         m_isRaytracingInitialized = m_raytraceData->initialize(*this);
+
+    Logger::get().log(constants::LOG_CHANNEL_VULKAN, LogSeverity::trace,
+                      "Uploaded scene meshes: " +
+                          std::to_string(m_sceneMeshes.size()) +
+                          " mesh objects");
     m_onSceneDataChange();
 }
 
@@ -563,6 +654,34 @@ kirana::viewport::vulkan::SceneData::getPushConstantRasterData(
         vulkan::PUSH_CONSTANT_RASTER_SHADER_STAGES);
 }
 
+uint32_t kirana::viewport::vulkan::SceneData::getMeshLOD(
+    bool isEditor, uint32_t objIndex, uint32_t meshIndex,
+    uint32_t instanceIndex) const
+{
+    const MeshObjectData &meshObjectData =
+        isEditor ? m_editorMeshes[objIndex] : m_sceneMeshes[objIndex];
+    const MeshData &meshData = meshObjectData.meshes[meshIndex];
+    if (meshData.lods.empty())
+        return 0;
+
+    // The LOD errors are relative to the mesh extents, so project the extents
+    // (scaled by the largest axis scale of the instance) onto the screen.
+    const math::Matrix4x4 world =
+        meshObjectData.instances[instanceIndex].transform->getMatrix();
+    float scale = 0.0f;
+    for (size_t i = 0; i < 3; i++)
+    {
+        scale = std::max(scale,
+                         std::sqrt(world[0][i] * world[0][i] +
+                                   world[1][i] * world[1][i] +
+                                   world[2][i] * world[2][i]));
+    }
+    const float extentPixels = m_scene.getCamera().getProjectedSize(
+        world * meshData.boundsCenter, meshData.boundsExtent * scale);
+    return meshData.selectLOD(extentPixels,
+                              constants::VULKAN_MESH_LOD_PIXEL_ERROR);
+}
+
 kirana::viewport::vulkan::PushConstant<
     kirana::viewport::vulkan::PushConstantRaytrace>
 kirana::viewport::vulkan::SceneData::getPushConstantRaytraceData() const
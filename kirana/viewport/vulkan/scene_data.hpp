@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <array_view.hpp>
 #include "vulkan_types.hpp"
 
 namespace kirana::scene
@@ -55,9 +56,26 @@ class SceneData
 
     MaterialManager *m_materialManager = nullptr;
 
+    /// Hashes the list of meshes of an object. Objects with the same list of
+    /// meshes are instances of the same MeshObject.
+    struct MeshListHash
+    {
+        size_t operator()(const std::vector<const scene::Mesh *> &meshes) const;
+    };
+    /// Maps the list of meshes of an object to the index of its MeshObject.
+    typedef std::unordered_map<std::vector<const scene::Mesh *>, uint32_t,
+                               MeshListHash>
+        MeshObjectTable;
+
     std::vector<MeshObjectData> m_editorMeshes;
     std::vector<MeshObjectData> m_sceneMeshes;
 
+    // The scene meshes are uploaded over multiple frames in update(), so that
+    // loading a large scene doesn't stall the viewport.
+    bool m_isUploadingScene = false;
+    uint32_t m_sceneUploadIndex = 0;
+    MeshObjectTable m_sceneMeshObjectTable;
+
     AllocatedBuffer m_cameraBuffer;
     AllocatedBuffer m_worldDataBuffer;
     AllocatedBuffer m_objectDataBuffer;
@@ -77,14 +95,25 @@ class SceneData
     void createCameraBuffer();
 
     std::pair<int, int> createVertexAndIndexBuffer(
-        const std::vector<scene::Vertex> &vertices,
-        const std::vector<scene::INDEX_TYPE> &indices);
-
+        utils::ArrayView<const scene::Vertex> vertices,
+        utils::ArrayView<const scene::INDEX_TYPE> indices);
+    /// Appends the indices to the current index buffer batch and returns the
+    /// index of the batch, or -1 if the buffer couldn't be allocated.
+    int createIndexBuffer(utils::ArrayView<const scene::INDEX_TYPE> indices);
 
     void createMaterials(bool isEditor);
-    static int getMeshObject(
-        const std::vector<MeshObjectData> &meshObjects,
-        const std::vector<std::shared_ptr<scene::Mesh>> &meshes);
+    /**
+     * Uploads the meshes of the renderables starting at firstRenderable, until
+     * the size of the uploaded vertex and index data reaches maxUploadSize.
+     * @param isEditor Whether to upload the editor or the scene renderables.
+     * @param firstRenderable Index of the first renderable to upload.
+     * @param maxUploadSize Size in bytes after which the upload stops.
+     * @param meshObjectTable The MeshObjects created so far.
+     * @return Index of the first renderable that wasn't uploaded.
+     */
+    uint32_t uploadMeshes(bool isEditor, uint32_t firstRenderable,
+                          size_t maxUploadSize,
+                          MeshObjectTable *meshObjectTable);
     bool createMeshes(bool isEditor = false);
     void createObjectBuffer();
 
@@ -101,6 +130,10 @@ class SceneData
 
     const bool &isInitialized = m_isInitialized;
     const bool &isRaytracingInitialized = m_isRaytracingInitialized;
+    const bool &isUploadingScene = m_isUploadingScene;
+
+    /// Uploads the next slice of the scene meshes while a scene is uploaded.
+    void update();
 
     [[nodiscard]] inline uint32_t addOnSceneDataChangeListener(
         const std::function<void()> &callback) const
@@ -214,6 +247,11 @@ class SceneData
                                    .buffer.buffer;
     }
 
+    inline const vk::Buffer &getIndexBuffer(int bufferIndex) const
+    {
+        return *m_indexBuffers[bufferIndex].buffer.buffer;
+    }
+
     [[nodiscard]] inline vk::DeviceAddress getVertexBufferAddress(
         int bufferIndex) const
     {
@@ -233,6 +271,14 @@ class SceneData
         uint32_t instanceIndex) const;
     [[nodiscard]] PushConstant<PushConstantRaytrace>
     getPushConstantRaytraceData() const;
+
+    /**
+     * Selects the level of detail of a mesh instance for the current camera.
+     * @return The index of the level of detail. 0 is the full mesh.
+     */
+    [[nodiscard]] uint32_t getMeshLOD(bool isEditor, uint32_t objIndex,
+                                      uint32_t meshIndex,
+                                      uint32_t instanceIndex) const;
 };
 } // namespace kirana::viewport::vulkan
 #endif
\ No newline at end of file
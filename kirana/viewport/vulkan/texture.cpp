@@ -31,13 +31,11 @@ bool kirana::viewport::vulkan::Texture::createImageView()
     return false;
 }
 
-kirana::viewport::vulkan::Texture::Texture(const Device *const device,
-                                           const Allocator *const allocator,
-                                           const Properties &properties,
-                                           const TextureSampler *const sampler,
-                                           std::string name, uint32_t index,
-                                           const void *pixelData,
-                                           size_t pixelDataSize)
+kirana::viewport::vulkan::Texture::Texture(
+    const Device *const device, const Allocator *const allocator,
+    const Properties &properties, const TextureSampler *const sampler,
+    std::string name, uint32_t index, const void *pixelData,
+    size_t pixelDataSize, const std::vector<MipLevel> &mipLevels)
     : m_isInitialized{false}, m_device{device}, m_allocator{allocator},
       m_properties{properties}, m_sampler{sampler}, m_name{std::move(name)},
       m_index{index}
@@ -53,14 +51,28 @@ kirana::viewport::vulkan::Texture::Texture(const Device *const device,
     m_subresourceRange = vk::ImageSubresourceRange(m_properties.aspect, 0,
                                                    m_properties.numMipLevels, 0,
                                                    m_properties.numLayers);
+    // Every mip level is copied from its own offset within the pixel data.
+    std::vector<vk::BufferImageCopy> copyRegions;
+    copyRegions.reserve(mipLevels.size());
+    for (size_t i = 0; i < mipLevels.size(); i++)
+    {
+        copyRegions.emplace_back(
+            mipLevels[i].dataOffset, 0, 0,
+            vk::ImageSubresourceLayers{m_properties.aspect,
+                                       static_cast<uint32_t>(i), 0,
+                                       m_properties.numLayers},
+            vk::Offset3D{0, 0, 0},
+            vk::Extent3D{mipLevels[i].size[0], mipLevels[i].size[1],
+                         mipLevels[i].size[2]});
+    }
+
     bool allocated = false;
-    // TODO: Copy Pixel data if it exits to vk::Image
     allocated = m_allocator->allocateImage(
         &m_allocatedImage, imgCreateInfo, m_properties.layout,
         m_subresourceRange,
         pixelData == nullptr ? Allocator::AllocationType::GPU_READ_ONLY
                              : Allocator::AllocationType::GPU_WRITEABLE,
-        pixelData, pixelDataSize, {0, 0, 0}, m_properties.size);
+        pixelData, pixelDataSize, {0, 0, 0}, m_properties.size, copyRegions);
     if (allocated)
     {
         m_image = *m_allocatedImage.image;
@@ -26,6 +26,14 @@ class Texture
         uint32_t numLayers = 1;
     };
 
+    /// Location of the pixel data of a mip level within the pixel data of
+    /// the texture.
+    struct MipLevel
+    {
+        size_t dataOffset = 0;
+        std::array<uint32_t, 3> size;
+    };
+
   private:
     bool m_isInitialized = false;
     const Device *const m_device;
@@ -50,7 +58,8 @@ class Texture
                      std::string name = "Texture",
                      uint32_t index = 0,
                      const void *pixelData = nullptr,
-                     size_t pixelDataSize = 0);
+                     size_t pixelDataSize = 0,
+                     const std::vector<MipLevel> &mipLevels = {});
     explicit Texture(const Device *device, const vk::Image &image,
                      const Properties &properties,
                      const TextureSampler *sampler = nullptr,
@@ -4,11 +4,19 @@
 #include "vulkan_utils.hpp"
 
 #include <image.hpp>
+#include <image_compression.hpp>
+#include <image_manager.hpp>
+
+#include <chrono>
+#include <unordered_set>
 
 kirana::viewport::vulkan::TextureManager::TextureManager(
     const Device *device, const Allocator *allocator)
     : m_device{device}, m_allocator{allocator}
 {
+    // Images are only block compressed on load if the GPU can sample them,
+    // otherwise their uncompressed RGBA8 mip chain is uploaded.
+    scene::image_compression::setEnabled(m_device->isBlockCompressionSupported);
 }
 
 kirana::viewport::vulkan::TextureManager::~TextureManager()
@@ -50,26 +58,51 @@ const kirana::viewport::vulkan::TextureSampler *kirana::viewport::vulkan::
 }
 
 vk::Format kirana::viewport::vulkan::TextureManager::getTextureFormat(
-    scene::Channels channels, scene::ColorSpace colorSpace) const
+    const scene::Image &image) const
 {
-    switch (channels)
+    const bool isSRGB =
+        image.getProperties().colorSpace == scene::ColorSpace::sRGB;
+    switch (image.getCompression())
+    {
+    case scene::ImageCompression::BC1:
+        return isSRGB ? vk::Format::eBc1RgbSrgbBlock
+                      : vk::Format::eBc1RgbUnormBlock;
+    case scene::ImageCompression::BC3:
+        return isSRGB ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock;
+    case scene::ImageCompression::BC5:
+        return vk::Format::eBc5UnormBlock;
+    case scene::ImageCompression::BC7:
+        return isSRGB ? vk::Format::eBc7SrgbBlock : vk::Format::eBc7UnormBlock;
+    default:
+        break;
+    }
+
+    // HDR images are converted to half floats with RGB expanded to RGBA.
+    if (image.getDataType() == scene::PixelDataType::FLOAT16)
+    {
+        switch (image.getChannels())
+        {
+        case scene::Channels::GRAYSCALE:
+            return vk::Format::eR16Sfloat;
+        case scene::Channels::GRAYSCALE_ALPHA:
+            return vk::Format::eR16G16Sfloat;
+        case scene::Channels::RGBA:
+        default:
+            return vk::Format::eR16G16B16A16Sfloat;
+        }
+    }
+
+    switch (image.getChannels())
     {
     case scene::Channels::GRAYSCALE:
-        return colorSpace == scene::ColorSpace::sRGB ? vk::Format::eR8Srgb
-                                                     : vk::Format::eR16Sfloat;
+        return isSRGB ? vk::Format::eR8Srgb : vk::Format::eR8Unorm;
     case scene::Channels::GRAYSCALE_ALPHA:
-        return colorSpace == scene::ColorSpace::sRGB
-                   ? vk::Format::eR8G8Srgb
-                   : vk::Format::eR16G16Sfloat;
+        return isSRGB ? vk::Format::eR8G8Srgb : vk::Format::eR8G8Unorm;
     case scene::Channels::RGB:
-        return colorSpace == scene::ColorSpace::sRGB
-                   ? vk::Format::eR8G8B8Srgb
-                   : vk::Format::eR16G16B16Sfloat;
+        return isSRGB ? vk::Format::eR8G8B8Srgb : vk::Format::eR8G8B8Unorm;
     case scene::Channels::RGBA:
     default:
-        return colorSpace == scene::ColorSpace::sRGB
-                   ? vk::Format::eR8G8B8A8Srgb
-                   : vk::Format::eR16G16B16A16Sfloat;
+        return isSRGB ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
     }
 }
 
@@ -79,30 +112,39 @@ bool kirana::viewport::vulkan::TextureManager::addTexture(scene::Image *image)
         m_textureIndexTable.end())
         return true;
 
-    void *pixelData = image->load();
-    if (pixelData == nullptr)
+    // The image may have already been decoded by addTextures().
+    if (!scene::ImageManager::get().loadImage(image))
         return false;
+    const void *pixelData = image->getPixelData();
     const size_t pixelDataSize = image->getPixelDataSize();
 
     const scene::ImageProperties imageProps = image->getProperties();
     const auto &sampler = getSampler(imageProps);
 
-    // TODO: Add Mip-Mapping
+    // The mip chain is generated and block compressed on the CPU when the
+    // image is loaded, or read from the image cache.
+    std::vector<Texture::MipLevel> mipLevels;
+    for (const auto &l : image->getMipLevels())
+        mipLevels.emplace_back(Texture::MipLevel{
+            l.offset,
+            {static_cast<uint32_t>(l.size[0]),
+             static_cast<uint32_t>(l.size[1]), 1}});
 
     const std::array<int, 2> &texSize = image->getSize();
-    const Texture::Properties texProps{
+    Texture::Properties texProps{
         {static_cast<uint32_t>(texSize[0]), static_cast<uint32_t>(texSize[1]),
          1},
-        getTextureFormat(imageProps.channels, imageProps.colorSpace),
+        getTextureFormat(*image),
         vk::ImageUsageFlagBits::eSampled,
         vk::ImageAspectFlagBits::eColor,
         vk::ImageLayout::eShaderReadOnlyOptimal,
         vk::ImageType::e2D};
+    texProps.numMipLevels = static_cast<uint32_t>(mipLevels.size());
 
-    m_textures.emplace_back(
-        new Texture(m_device, m_allocator, texProps, sampler, image->getName(),
-                    image->getIndex(), pixelData, pixelDataSize));
-    image->free();
+    m_textures.emplace_back(new Texture(
+        m_device, m_allocator, texProps, sampler, image->getName(),
+        image->getIndex(), pixelData, pixelDataSize, mipLevels));
+    scene::ImageManager::get().freeImage(image);
     if (m_textures.back()->isInitialized)
     {
         const uint32_t texIndex = static_cast<uint32_t>(m_textures.size() - 1);
@@ -113,6 +155,41 @@ bool kirana::viewport::vulkan::TextureManager::addTexture(scene::Image *image)
         return false;
 }
 
+bool kirana::viewport::vulkan::TextureManager::addTextures(
+    const std::vector<scene::Image *> &images)
+{
+    std::vector<scene::Image *> newImages;
+    std::unordered_set<const scene::Image *> addedImages;
+    for (scene::Image *image : images)
+    {
+        if (m_textureIndexTable.find(image->getFilepath()) ==
+                m_textureIndexTable.end() &&
+            addedImages.insert(image).second)
+            newImages.push_back(image);
+    }
+    if (newImages.empty())
+        return true;
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    bool result = true;
+    scene::ImageManager::get().loadImages(newImages, [&](scene::Image *image) {
+        result = addTexture(image) && result;
+    });
+
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::high_resolution_clock::now() - startTime;
+    const auto statistics = scene::ImageManager::get().getMemoryStatistics();
+    Logger::get().log(constants::LOG_CHANNEL_VULKAN, LogSeverity::debug,
+                      "Decoded and uploaded " +
+                          std::to_string(newImages.size()) + " textures in " +
+                          std::to_string(duration.count()) + " ms (" +
+                          std::to_string(statistics.hits) + " hits, " +
+                          std::to_string(statistics.misses) + " misses, " +
+                          std::to_string(statistics.evictions) +
+                          " evictions)");
+    return result;
+}
+
 const std::vector<kirana::viewport::vulkan::Texture *>
     &kirana::viewport::vulkan::TextureManager::getTextures()
 {
@@ -5,8 +5,6 @@
 
 namespace kirana::scene
 {
-enum class Channels;
-enum class ColorSpace;
 struct ImageProperties;
 class Image;
 } // namespace kirana::scene
@@ -28,6 +26,14 @@ class TextureManager
     TextureManager(const TextureManager &textureManager) = delete;
     TextureManager &operator=(const TextureManager &textureManager) = delete;
     bool addTexture(scene::Image *image);
+    /**
+     * Decodes the images on the thread pool and uploads each one as soon as
+     * it's decoded.
+     * @param images The images to add. Images which already have a texture
+     * are skipped.
+     * @return true if all the textures were created.
+     */
+    bool addTextures(const std::vector<scene::Image *> &images);
 
     const std::vector<Texture *> &getTextures();
 
@@ -41,8 +47,8 @@ class TextureManager
 
     const TextureSampler *getSampler(
         const scene::ImageProperties &imageProperties);
-    [[nodiscard]] vk::Format getTextureFormat(
-        scene::Channels channels, scene::ColorSpace colorSpace) const;
+    /// Picks the format matching the (compressed) pixel data of the image.
+    [[nodiscard]] vk::Format getTextureFormat(const scene::Image &image) const;
 };
 } // namespace kirana::viewport::vulkan
 
@@ -51,6 +51,8 @@ kirana::viewport::vulkan::TextureSampler::TextureSampler(const Device *device,
         m_properties.anisotropicLevel};
     createInfo.borderColor =
         static_cast<vk::BorderColor>(m_properties.borderColor);
+    // Sample every mip level the texture has.
+    createInfo.maxLod = VK_LOD_CLAMP_NONE;
 
     try
     {
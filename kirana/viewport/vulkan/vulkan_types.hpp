@@ -179,6 +179,19 @@ struct InstanceData
     const bool *selected;
 };
 
+/**
+ * Index buffer range of a simplified level of detail of a mesh. The level uses
+ * the vertices of the mesh.
+ */
+struct MeshLODData
+{
+    int indexBufferIndex;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    /// Simplification error relative to the extents of the mesh.
+    float error;
+};
+
 /**
  * Holds the mesh data used by vulkan bindVertexBuffers and draw commands.
  */
@@ -193,6 +206,33 @@ struct MeshData
     uint32_t firstIndex;
     uint32_t vertexOffset;
     uint32_t materialIndex;
+    /// Simplified levels of detail, excluding the mesh itself.
+    std::vector<MeshLODData> lods;
+    /// Local-space center and largest dimension of the bounds of the mesh.
+    math::Vector3 boundsCenter;
+    float boundsExtent;
+
+    /**
+     * Returns the coarsest level of detail whose error is smaller than the
+     * given pixel error on screen. Level 0 is the mesh itself.
+     * @param extentPixels Projected size of the mesh extents in pixels.
+     * @param pixelError The allowed error in pixels.
+     */
+    [[nodiscard]] inline uint32_t selectLOD(float extentPixels,
+                                            float pixelError) const
+    {
+        uint32_t lod = 0;
+        while (lod < lods.size() && lods[lod].error * extentPixels < pixelError)
+            lod++;
+        return lod;
+    }
+    /// Index buffer range of the given level of detail.
+    [[nodiscard]] inline MeshLODData getLOD(uint32_t lod) const
+    {
+        return lod == 0 ? MeshLODData{indexBufferIndex, firstIndex, indexCount,
+                                      0.0f}
+                        : lods[lod - 1];
+    }
 };
 
 struct MeshObjectData
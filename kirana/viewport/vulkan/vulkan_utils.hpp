@@ -9,6 +9,7 @@
 
 #include <constants.h>
 #include <logger.hpp>
+#include <scene_types.hpp>
 #include <iostream>
 namespace kirana::viewport::vulkan
 {
@@ -46,6 +47,20 @@ static vk::PhysicalDeviceShaderClockFeaturesKHR DEVICE_SHADER_CLOCK_FEATURES{};
 static vk::PhysicalDeviceDescriptorIndexingFeatures
     DEVICE_DESCRIPTOR_INDEXING_FEATURES{};
 
+/// Layout of the vertices stored in the vertex buffers.
+static const scene::VertexLayout VERTEX_LAYOUT =
+    constants::VULKAN_USE_COMPACT_VERTEX_LAYOUT ? scene::VertexLayout::COMPACT
+                                                : scene::VertexLayout::STANDARD;
+/// Specialization constants passed to every shader stage.
+static const vk::Bool32 SHADER_SPECIALIZATION_DATA[] = {
+    constants::VULKAN_USE_COMPACT_VERTEX_LAYOUT ? VK_TRUE : VK_FALSE};
+static const vk::SpecializationMapEntry SHADER_SPECIALIZATION_ENTRIES[] = {
+    {constants::VULKAN_SPECIALIZATION_COMPACT_VERTEX_LAYOUT_ID, 0,
+     sizeof(vk::Bool32)}};
+static const vk::SpecializationInfo SHADER_SPECIALIZATION_INFO{
+    1, SHADER_SPECIALIZATION_ENTRIES, sizeof(SHADER_SPECIALIZATION_DATA),
+    SHADER_SPECIALIZATION_DATA};
+
 #ifndef VK_HANDLE_RESULT
 #define VK_HANDLE_RESULT(f, err)                                               \
     {                                                                          \
@@ -20,7 +20,7 @@ void main() {
     OutlineData outline = mat.o[pushConstants.p.materialDataIndex];
 
     float thickness = outline.thickness;
-    vec3 pos = vPosition + vNormal * thickness;
+    vec3 pos = vPosition + getVertexNormal() * thickness;
     gl_Position = vec4(pos, 1.0f) * pushConstants.p.modelMatrix * camBuffer.c.viewProj;
 
     outColor = outline.color;
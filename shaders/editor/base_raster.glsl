@@ -28,6 +28,19 @@ struct Vertex {
     vec2 texCoords;
 };
 
+// True if the vertex buffers contain compact vertices. The normal attribute then
+// holds an octahedral-encoded normal in xy.
+layout (constant_id = 0) const bool COMPACT_VERTEX_LAYOUT = false;
+
+vec3 decodeOctahedralNormal(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    const float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 struct PushConstantData {
     mat4x4 modelMatrix;
     uint64_t vertexBufferAddress;
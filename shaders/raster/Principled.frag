@@ -90,8 +90,11 @@ vec3 getNormal(in PrincipledData matData, in vec3 viewDir, in vec3[3] transformF
 
     if (matData.normalMap > -1)
     {
-        vec3 tsNormal = texture(textures[nonuniformEXT(uint(matData.normalMap))], VSIn.texCoords).rgb;
-        tsNormal = normalize(2.0 * tsNormal - vec3(1.0));
+        // Normal maps may be BC5 compressed, which only stores X and Y.
+        vec3 tsNormal;
+        tsNormal.xy = 2.0 * texture(textures[nonuniformEXT(uint(matData.normalMap))], VSIn.texCoords).rg - vec2(1.0);
+        tsNormal.z = sqrt(max(1.0 - dot(tsNormal.xy, tsNormal.xy), 0.0));
+        tsNormal = normalize(tsNormal);
         finalNormal = mat3(transformFrame[0], transformFrame[1], transformFrame[2]) * tsNormal;
     }
     return finalNormal;
@@ -15,6 +15,11 @@ layout (push_constant) uniform _PushConstantData {
     PushConstantData p;
 } pushConstants;
 
+vec3 getVertexNormal()
+{
+    return COMPACT_VERTEX_LAYOUT ? decodeOctahedralNormal(vNormal.xy) : vNormal;
+}
+
 vec4 getWorldPosition()
 {
     return vec4(vPosition, 1.0f) * pushConstants.p.modelMatrix;
@@ -36,7 +41,7 @@ vec3 getWorldNormal()
     m[0][1] * m[2][0] - m[0][0] * m[2][1],
     m[0][1] * m[1][2] - m[0][2] * m[1][1],
     m[0][2] * m[1][0] - m[0][0] * m[1][2],
-    m[0][0] * m[1][1] - m[0][1] * m[1][0]) * vNormal);
+    m[0][0] * m[1][1] - m[0][1] * m[1][0]) * getVertexNormal());
 }
 
 void getCoordinateFrame(in vec3 normal, out vec3 tangent, out vec3 binormal) {
@@ -35,8 +35,11 @@ vec3 getNormal(in PrincipledData matData, in IntersectionData intersection)
     vec3 normal = intersection.shadingSpace[2];
     if (matData.normalMap > -1)
     {
-        vec3 tsNormal = texture(matTextures[nonuniformEXT(uint(matData.normalMap))], intersection.texCoords).rgb;
-        tsNormal = normalize(2.0 * tsNormal - 1.0);
+        // Normal maps may be BC5 compressed, which only stores X and Y.
+        vec3 tsNormal;
+        tsNormal.xy = 2.0 * texture(matTextures[nonuniformEXT(uint(matData.normalMap))], intersection.texCoords).rg - 1.0;
+        tsNormal.z = sqrt(max(1.0 - dot(tsNormal.xy, tsNormal.xy), 0.0));
+        tsNormal = normalize(tsNormal);
         normal = mat3(intersection.shadingSpace[0], intersection.shadingSpace[1], intersection.shadingSpace[2]) * tsNormal;
     }
     return normal;
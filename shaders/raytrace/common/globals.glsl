@@ -33,6 +33,16 @@ struct Vertex {
     vec2 texCoords;
 };
 
+struct CompactVertex {
+    float position[3];
+    uint normal; // Octahedral-encoded normal as 2x snorm16
+    uint texCoords; // 2x half float
+    uint color; // 4x unorm8
+};
+
+// True if the vertex buffers contain CompactVertex data.
+layout (constant_id = 0) const bool COMPACT_VERTEX_LAYOUT = false;
+
 struct CameraData {
     mat4 view; // Row-major storage
     mat4 proj; // Row-major
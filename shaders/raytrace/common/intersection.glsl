@@ -5,6 +5,9 @@
 layout (buffer_reference) readonly buffer VertexData {
     Vertex v[];
 };
+layout (buffer_reference, std430) readonly buffer CompactVertexData {
+    CompactVertex v[];
+};
 layout (buffer_reference) readonly buffer IndexData {
     uint32_t i[];
 };
@@ -13,6 +16,30 @@ layout (set = 2, binding = 0) readonly buffer _ObjectData {
     ObjectData o[];
 } objBuffer;
 
+vec3 decodeOctahedralNormal(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    const float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+Vertex getVertex(uint64_t vertexBufferAddress, uint32_t index)
+{
+    if (COMPACT_VERTEX_LAYOUT)
+    {
+        const CompactVertex c = CompactVertexData(vertexBufferAddress).v[index];
+        Vertex v;
+        v.position = vec3(c.position[0], c.position[1], c.position[2]);
+        v.normal = decodeOctahedralNormal(unpackSnorm2x16(c.normal));
+        v.color = unpackUnorm4x8(c.color);
+        v.texCoords = unpackHalf2x16(c.texCoords);
+        return v;
+    }
+    return VertexData(vertexBufferAddress).v[index];
+}
+
 vec3 getWorldPosition(const vec3[3] vPositions, const vec3 barycentrics, const mat4x3 objToWorldMat)
 {
     const vec3 pos = vPositions[0] * barycentrics.x + vPositions[1] * barycentrics.y + vPositions[2] * barycentrics.z;
@@ -41,8 +68,9 @@ IntersectionData getIntesectionData(in PathtracePayload hitInfo, in vec3 viewDir
     indices += u32vec3(objData.vertexOffset);
 
     // Get Vertices
-    VertexData vBuffer = VertexData(objData.vertexBufferAddress);
-    Vertex vertices[3] = Vertex[3](vBuffer.v[indices.x], vBuffer.v[indices.y], vBuffer.v[indices.z]);
+    Vertex vertices[3] = Vertex[3](getVertex(objData.vertexBufferAddress, indices.x),
+                                   getVertex(objData.vertexBufferAddress, indices.y),
+                                   getVertex(objData.vertexBufferAddress, indices.z));
     vec3[3] vPositions = vec3[3](vertices[0].position, vertices[1].position, vertices[2].position);
     vec3[3] vNormals = vec3[3](vertices[0].normal, vertices[1].normal, vertices[2].normal);
     vec2[3] vTexCoords = vec2[3](vertices[0].texCoords, vertices[1].texCoords, vertices[2].texCoords);